@@ -0,0 +1,46 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <algorithm>
+
+// Minimal timing helpers shared by the benchmark executables.
+
+namespace Slayer::Benchmark
+{
+    // Runs func the given number of times and returns the fastest run in milliseconds.
+    template <typename Func>
+    double Measure(uint32_t repetitions, Func&& func)
+    {
+        double best = 1e300;
+        for (uint32_t i = 0; i < repetitions; i++)
+        {
+            auto start = std::chrono::high_resolution_clock::now();
+            func();
+            auto end = std::chrono::high_resolution_clock::now();
+            best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+        }
+        return best;
+    }
+
+    inline void PrintHeader(const std::string& title)
+    {
+        std::printf("\n%s\n", title.c_str());
+        std::printf("%-36s %10s %14s %14s %9s\n", "case", "count", "baseline (ms)", "new (ms)", "speedup");
+    }
+
+    inline void PrintResult(const std::string& name, size_t count, double baseline, double result)
+    {
+        std::printf("%-36s %10zu %14.3f %14.3f %8.2fx\n", name.c_str(), count, baseline, result, baseline / std::max(result, 1e-9));
+    }
+
+    // Keeps the optimizer from discarding work whose result is otherwise unused.
+    template <typename T>
+    void Consume(const T& value)
+    {
+        static volatile T sink;
+        sink = value;
+    }
+}
@@ -0,0 +1,186 @@
+#pragma once
+
+#include "Core/Core.h"
+#include "Core/Containers.h"
+#include "Utils.h"
+
+#include <future>
+
+// The original map-based component store, kept as the baseline the benchmarks
+// compare against. Each component type lives in its own vector indexed through a
+// hash map and every archetype keeps a std::set of its entities.
+// The SL_MAX_ENTITIES limit is left out so that it can be measured at larger counts.
+
+namespace Slayer::Legacy
+{
+    using Entity = uint32_t;
+    using ComponentType = uint32_t;
+    using Archetype = uint64_t;
+
+    class ComponentArrayBase
+    {
+    public:
+        virtual void RemoveEntity(Entity entity) = 0;
+
+        ComponentArrayBase() = default;
+        virtual ~ComponentArrayBase() = default;
+    };
+
+    template <typename T>
+    class ComponentArray : public ComponentArrayBase
+    {
+    private:
+        std::vector<T> m_componentArray;
+        std::unordered_map<Entity, size_t> m_entityToIndexMap;
+        size_t m_size = 0;
+
+    public:
+        virtual void RemoveEntity(Entity entity)
+        {
+            m_entityToIndexMap.erase(entity);
+        }
+
+        void InsertData(Entity entity, T component)
+        {
+            m_componentArray.push_back(component);
+            m_entityToIndexMap[entity] = m_size;
+            m_size++;
+        }
+
+        T* GetComponent(Entity entity)
+        {
+            return &m_componentArray[m_entityToIndexMap[entity]];
+        }
+    };
+
+    class ComponentStore
+    {
+    private:
+        struct ComponentRecord
+        {
+            ComponentType type = 0;
+            uint32_t bitIndex = 0;
+            Shared<ComponentArrayBase> componentArray;
+        };
+
+        Entity entityIndex = 0;
+        Dict<Entity, Archetype> m_entityComponentIndexMap;
+        Dict<Archetype, std::set<Entity>> m_archetypeEntityMap;
+        Dict<ComponentType, ComponentRecord> m_components;
+
+        void UpdateArchetype(Entity entity, Archetype oldArchetype, Archetype newArchetype)
+        {
+            if (m_archetypeEntityMap.find(oldArchetype) != m_archetypeEntityMap.end())
+            {
+                m_archetypeEntityMap[oldArchetype].erase(entity);
+            }
+
+            m_archetypeEntityMap[newArchetype].insert(entity);
+            m_entityComponentIndexMap[entity] = newArchetype;
+        }
+
+    public:
+        Entity CreateEntity()
+        {
+            return entityIndex++;
+        }
+
+        template <typename T>
+        void RegisterComponent()
+        {
+            const ComponentType typeHash = HashType<T>();
+            m_components[typeHash] = { typeHash, (uint32_t)m_components.size(), MakeShared<ComponentArray<T>>() };
+        }
+
+        template <typename T>
+        ComponentArray<T>* GetComponentArray()
+        {
+            uint32_t typeHash = HashType<T>();
+
+            if (m_components.find(typeHash) == m_components.end())
+                RegisterComponent<T>();
+
+            return static_cast<ComponentArray<T>*>(m_components[typeHash].componentArray.get());
+        }
+
+        template <typename C>
+        void AddComponent(Entity entity, C component)
+        {
+            GetComponentArray<C>()->InsertData(entity, component);
+            Archetype oldArch = m_entityComponentIndexMap[entity];
+            Archetype newArch = oldArch | (uint64_t(1) << uint64_t(m_components[HashType<C>()].bitIndex));
+            UpdateArchetype(entity, oldArch, newArch);
+        }
+
+        void DestroyEntity(Entity entity)
+        {
+            for (auto& [componentType, componentRecord] : m_components)
+            {
+                componentRecord.componentArray->RemoveEntity(entity);
+            }
+
+            m_entityComponentIndexMap.erase(entity);
+        }
+
+        template <typename T>
+        T* GetComponent(Entity entity)
+        {
+            return GetComponentArray<T>()->GetComponent(entity);
+        }
+
+        template <typename... Ts>
+        Archetype GetArchetype()
+        {
+            const std::vector<uint32_t> hashes = { HashType<Ts>()... };
+
+            Archetype searchArchetype = 0;
+            for (auto& hash : hashes)
+            {
+                searchArchetype |= (uint64_t(1) << m_components[hash].bitIndex);
+            }
+
+            return searchArchetype;
+        }
+
+        template <typename... Ts>
+        void ForEach(auto&& func)
+        {
+            Archetype searchArchetype = GetArchetype<Ts...>();
+
+            for (auto& [archetype, entitySet] : m_archetypeEntityMap)
+            {
+                if ((archetype & searchArchetype) == searchArchetype)
+                {
+                    for (auto& entity : entitySet)
+                    {
+                        func(entity, GetComponent<Ts>(entity)...);
+                    }
+                }
+            }
+        }
+
+        template <typename... Ts>
+        void ForEachAsync(auto&& func)
+        {
+            Archetype searchArchetype = GetArchetype<Ts...>();
+
+            std::vector<std::future<void>> futures;
+
+            for (auto& [archetype, entitySet] : m_archetypeEntityMap)
+            {
+                if ((archetype & searchArchetype) == searchArchetype)
+                {
+                    for (auto& entity : entitySet)
+                    {
+                        futures.push_back(std::async(std::launch::async, func, entity, GetComponent<Ts>(entity)...));
+                    }
+                }
+            }
+
+            for (auto& future : futures)
+            {
+                future.get();
+            }
+        }
+    };
+}
@@ -0,0 +1,338 @@
+#include "Benchmark.h"
+#include "Jobs/ThreadManager.h"
+#include "Resources/AssetPack.h"
+#include "Resources/Compression.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Loading a generated version 2 pack stored as is (baseline) and with LZ4 compressed textures, models and
+// animations, written the way the pack builder writes them. A load maps the pack, decompresses on the workers and
+// copies every asset into a staging buffer, as an upload would. Runs with the pack in the page cache, and evicted
+// from it where the OS allows. Takes the size of the assets in MB, 256 by default.
+
+static constexpr uint32_t s_repetitions = 3;
+
+struct PackAsset
+{
+    Slayer::AssetID id;
+    Slayer::AssetType type;
+    std::string name;
+    std::vector<char> data;
+};
+
+template<typename T>
+static void Append(std::vector<char>& data, const T& value)
+{
+    const char* bytes = (const char*)&value;
+    data.insert(data.end(), bytes, bytes + sizeof(T));
+}
+
+// Textures are smooth gradients with noise, models are vertices on a grid, animations are slowly changing keys
+static std::vector<PackAsset> GenerateAssets(size_t totalBytes)
+{
+    std::mt19937 random(7);
+    std::vector<PackAsset> assets;
+    size_t bytes = 0;
+    for (uint32_t i = 0; bytes < totalBytes; i++)
+    {
+        PackAsset asset;
+        asset.id = ((Slayer::AssetID)random() << 32) | random();
+        asset.name = "asset_" + std::to_string(i);
+        std::vector<char>& data = asset.data;
+
+        switch (i % 6)
+        {
+        case 0:
+        case 1:
+        case 2:
+        {
+            asset.type = Slayer::SL_ASSET_TYPE_TEXTURE;
+            const uint32_t size = 1024;
+            Append(data, size);
+            Append(data, size);
+            Append(data, 4u);
+            Append(data, 0x0DE1u);
+            Append(data, size * size * 4);
+            for (uint32_t y = 0; y < size; y++)
+            {
+                for (uint32_t x = 0; x < size; x++)
+                {
+                    const uint32_t noise = random() & 3;
+                    const uint8_t texel[4] = { (uint8_t)((x >> 2) + noise), (uint8_t)((y >> 2) + noise), (uint8_t)(i * 16), 255 };
+                    data.insert(data.end(), (const char*)texel, (const char*)texel + 4);
+                }
+            }
+            break;
+        }
+        case 3:
+        case 4:
+        {
+            asset.type = Slayer::SL_ASSET_TYPE_MODEL;
+            const uint32_t vertexCount = 32 * 1024, floatsPerVertex = 8;
+            Append(data, 1u);
+            Append(data, vertexCount * floatsPerVertex);
+            for (uint32_t v = 0; v < vertexCount; v++)
+            {
+                const float vertex[8] = { (float)(v % 256) * 0.25f, 0.0f, (float)(v / 256) * 0.25f, (float)(v % 256) / 256.0f,
+                    (float)(v / 256) / 128.0f, 0.0f, 1.0f, 0.0f };
+                data.insert(data.end(), (const char*)vertex, (const char*)(vertex + 8));
+            }
+            Append(data, vertexCount * 3);
+            for (uint32_t index = 0; index < vertexCount * 3; index++)
+            {
+                Append(data, (index / 3 + index % 3) % vertexCount);
+            }
+            break;
+        }
+        default:
+        {
+            asset.type = Slayer::SL_ASSET_TYPE_ANIMATION;
+            const uint32_t frames = 512, channels = 64;
+            Append(data, (float)frames / 30.0f);
+            Append(data, 30.0f);
+            Append(data, channels);
+            Append(data, frames);
+            for (uint32_t frame = 0; frame < frames; frame++)
+            {
+                Append(data, (float)frame / 30.0f);
+            }
+            Append(data, frames * channels * 4);
+            for (uint32_t value = 0; value < frames * channels * 4; value++)
+            {
+                Append(data, (float)((value / 64) % 16) * 0.125f);
+            }
+            break;
+        }
+        }
+
+        bytes += data.size();
+        assets.push_back(std::move(asset));
+    }
+
+    return assets;
+}
+
+// Splits the data into blocks of SL_ASSET_PACK_BLOCK_SIZE, as the pack builder does
+static std::vector<char> CompressAsset(const std::vector<char>& data)
+{
+    const uint32_t blockCount = (uint32_t)((data.size() + SL_ASSET_PACK_BLOCK_SIZE - 1) / SL_ASSET_PACK_BLOCK_SIZE);
+    std::vector<uint32_t> lengths;
+    std::vector<char> blocks;
+    std::vector<char> block(Slayer::Compression::GetLz4Bound(SL_ASSET_PACK_BLOCK_SIZE));
+    for (size_t offset = 0; offset < data.size(); offset += SL_ASSET_PACK_BLOCK_SIZE)
+    {
+        const size_t size = std::min<size_t>(SL_ASSET_PACK_BLOCK_SIZE, data.size() - offset);
+        const size_t length = Slayer::Compression::CompressLz4(data.data() + offset, size, block.data(), block.size());
+        lengths.push_back((uint32_t)length);
+        blocks.insert(blocks.end(), block.begin(), block.begin() + length);
+    }
+
+    std::vector<char> stored;
+    Append(stored, (uint32_t)SL_ASSET_PACK_BLOCK_SIZE);
+    Append(stored, blockCount);
+    for (uint32_t length : lengths)
+    {
+        Append(stored, length);
+    }
+    stored.insert(stored.end(), blocks.begin(), blocks.end());
+    return stored;
+}
+
+static uint64_t Align(uint64_t offset, uint64_t alignment)
+{
+    return (offset + alignment - 1) / alignment * alignment;
+}
+
+// Writes a version 2 pack, returns its size
+static uint64_t WritePack(const std::string& path, std::vector<PackAsset> assets, bool compress)
+{
+    std::sort(assets.begin(), assets.end(), [](const PackAsset& a, const PackAsset& b) { return a.id < b.id; });
+
+    std::string names;
+    std::vector<std::vector<char>> stored(assets.size());
+    std::vector<Slayer::AssetTocEntry> toc(assets.size());
+    for (size_t i = 0; i < assets.size(); i++)
+    {
+        Slayer::AssetTocEntry& entry = toc[i];
+        entry = {};
+        entry.id = assets[i].id;
+        entry.type = assets[i].type;
+        entry.alignment = 16;
+        entry.nameOffset = (uint32_t)names.size();
+        entry.nameLength = (uint16_t)assets[i].name.size();
+        entry.nameHash = Slayer::AssetPack::HashName(assets[i].name.data(), assets[i].name.size());
+        entry.uncompressedLength = (uint32_t)assets[i].data.size();
+        names += assets[i].name;
+
+        stored[i] = compress ? CompressAsset(assets[i].data) : assets[i].data;
+        entry.compression = (uint8_t)(compress ? Slayer::AssetCompression::LZ4 : Slayer::AssetCompression::None);
+        entry.dataLength = (uint32_t)stored[i].size();
+        entry.checksum = Slayer::AssetPack::Checksum(stored[i].data(), stored[i].size());
+    }
+
+    const uint64_t headerSize = 6 + 4 + 4 + 2 + 4 + 8 + 8;
+    const uint64_t tocOffset = Align(headerSize, 8);
+    const uint64_t namesOffset = tocOffset + toc.size() * sizeof(Slayer::AssetTocEntry);
+    uint64_t offset = namesOffset + names.size();
+    for (size_t i = 0; i < assets.size(); i++)
+    {
+        offset = Align(offset, 16);
+        toc[i].dataOffset = offset;
+        offset += stored[i].size();
+    }
+
+    std::vector<char> pack;
+    pack.insert(pack.end(), SL_ASSET_PACK_MAGIC, SL_ASSET_PACK_MAGIC + 6);
+    Append(pack, (uint32_t)SL_ASSET_PACK_VERSION);
+    Append(pack, (uint32_t)assets.size());
+    Append(pack, (uint16_t)0);
+    Append(pack, (uint32_t)names.size());
+    Append(pack, tocOffset);
+    Append(pack, namesOffset);
+    pack.resize(tocOffset);
+    pack.insert(pack.end(), (const char*)toc.data(), (const char*)(toc.data() + toc.size()));
+    pack.insert(pack.end(), names.begin(), names.end());
+    for (size_t i = 0; i < assets.size(); i++)
+    {
+        pack.resize(toc[i].dataOffset);
+        pack.insert(pack.end(), stored[i].begin(), stored[i].end());
+    }
+
+    std::ofstream(path, std::ios::binary).write(pack.data(), pack.size());
+    return pack.size();
+}
+
+// Drops the pack from the page cache, returns false where that is not possible
+static bool EvictFromCache(const std::string& path)
+{
+#ifdef __linux__
+    const int file = open(path.c_str(), O_RDONLY);
+    if (file < 0)
+        return false;
+    fdatasync(file);
+    const bool evicted = posix_fadvise(file, 0, 0, POSIX_FADV_DONTNEED) == 0;
+    close(file);
+    return evicted;
+#else
+    return false;
+#endif
+}
+
+static void WarmCache(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    std::vector<char> buffer(1 << 20);
+    while (file.read(buffer.data(), buffer.size()))
+    {
+    }
+}
+
+static void LoadPack(const std::string& path, bool upload, std::vector<char>& staging)
+{
+    Slayer::AssetPack pack;
+    pack.Load(path);
+    const bool decompressed = pack.DecompressAssets(Slayer::JobLane::Loading);
+    SL_ASSERT(decompressed && "Failed to decompress the pack!");
+    if (upload)
+    {
+        for (const auto& [id, record] : pack.GetAssets())
+        {
+            const Slayer::PackedSpan<char> bytes = pack.GetAssetBytes(id);
+            Slayer::Copy(bytes.Data(), staging.data(), bytes.Size());
+        }
+    }
+    Slayer::Benchmark::Consume(pack.GetAssets().size());
+}
+
+int main(int argc, char** argv)
+{
+    const size_t assetMB = argc > 1 ? (size_t)std::stoull(argv[1]) : 256;
+
+    Slayer::JobSettings settings;
+    settings.loadingThreads = argc > 2 ? (uint32_t)std::stoul(argv[2]) : 0;
+    Slayer::ThreadManager threadManager;
+    threadManager.Initialize(settings);
+    const size_t loadingThreads = threadManager.GetLane(Slayer::JobLane::Loading).GetThreadCount();
+
+    const std::vector<PackAsset> assets = GenerateAssets(assetMB << 20);
+    size_t assetBytes = 0;
+    size_t largestAsset = 0;
+    for (const PackAsset& asset : assets)
+    {
+        assetBytes += asset.data.size();
+        largestAsset = std::max(largestAsset, asset.data.size());
+    }
+
+    const std::filesystem::path directory = std::filesystem::temp_directory_path();
+    const std::string rawPath = (directory / "slayer_bench_raw.slp").string();
+    const std::string lz4Path = (directory / "slayer_bench_lz4.slp").string();
+    const uint64_t rawSize = WritePack(rawPath, assets, false);
+    const uint64_t lz4Size = WritePack(lz4Path, assets, true);
+
+    // Checks that the compressed pack holds the same bytes
+    {
+        Slayer::AssetPack raw, lz4;
+        raw.Load(rawPath);
+        lz4.Load(lz4Path);
+        lz4.DecompressAssets(Slayer::JobLane::Loading);
+        for (const auto& [id, record] : raw.GetAssets())
+        {
+            const Slayer::PackedSpan<char> a = raw.GetAssetBytes(id), b = lz4.GetAssetBytes(id);
+            SL_ASSERT(lz4.VerifyAsset(id) && a.Size() == b.Size() && memcmp(a.Data(), b.Data(), a.Size()) == 0 && "Packs differ!");
+        }
+    }
+
+    std::vector<char> staging(largestAsset);
+    const auto measure = [&](const std::string& path, bool cold, bool upload)
+        {
+            double best = 1e300;
+            for (uint32_t i = 0; i < s_repetitions; i++)
+            {
+                if (cold)
+                    EvictFromCache(path);
+                else
+                    WarmCache(path);
+                best = std::min(best, Slayer::Benchmark::Measure(1, [&]() { LoadPack(path, upload, staging); }));
+            }
+            return best;
+        };
+
+    const double rawWarm = measure(rawPath, false, true);
+    const double lz4Warm = measure(lz4Path, false, true);
+    const double lz4Decompress = measure(lz4Path, false, false);
+    const bool canEvict = EvictFromCache(rawPath);
+    const double rawCold = canEvict ? measure(rawPath, true, true) : 0.0;
+    const double lz4Cold = canEvict ? measure(lz4Path, true, true) : 0.0;
+    threadManager.Shutdown();
+
+    const double megabytes = (double)assetBytes / (1024.0 * 1024.0);
+    const auto throughput = [&](double milliseconds) { return megabytes / (milliseconds / 1000.0); };
+
+    Slayer::Benchmark::PrintHeader("Asset pack load: uncompressed (baseline) vs LZ4, " + std::to_string(assetMB) + " MB of assets, "
+        + std::to_string(loadingThreads) + " loading threads on " + std::to_string(Slayer::ThreadTopology::GetCoreCount()) + " cores");
+    Slayer::Benchmark::PrintResult("warm page cache", assets.size(), rawWarm, lz4Warm);
+    if (canEvict)
+        Slayer::Benchmark::PrintResult("cold page cache", assets.size(), rawCold, lz4Cold);
+    else
+        std::printf("cold page cache: not measured, the pack cannot be evicted here\n");
+
+    std::printf("\npack size: %.1f MB uncompressed, %.1f MB LZ4 (%.2fx)\n", (double)rawSize / (1024.0 * 1024.0), (double)lz4Size / (1024.0 * 1024.0),
+        (double)rawSize / (double)lz4Size);
+    std::printf("warm load: %.0f MB/s uncompressed, %.0f MB/s LZ4\n", throughput(rawWarm), throughput(lz4Warm));
+    if (canEvict)
+        std::printf("cold load: %.0f MB/s uncompressed, %.0f MB/s LZ4\n", throughput(rawCold), throughput(lz4Cold));
+    std::printf("LZ4 decompression alone: %.0f MB/s\n", throughput(lz4Decompress));
+
+    std::filesystem::remove(rawPath);
+    std::filesystem::remove(lz4Path);
+    return 0;
+}
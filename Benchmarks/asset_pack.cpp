@@ -0,0 +1,290 @@
+#include "Benchmark.h"
+#include "Resources/AssetPack.h"
+#include "Resources/AssetTypes.h"
+
+#include <filesystem>
+#include <fstream>
+
+// Loading a generated asset pack with the previous stream reader, which copies the pack into one buffer and every
+// packed array out of it again, and with the memory-mapped pack handing out views. Times opening the pack, and
+// opening it and uploading every texture, mesh and animation, which is modelled as one copy into a staging buffer.
+// Takes the size of the pack in MB, 512 by default.
+
+static constexpr uint32_t s_repetitions = 3;
+
+// The pack loader before it was memory-mapped
+class LegacyAssetPack
+{
+private:
+    std::vector<char> m_data;
+    Slayer::Dict<Slayer::AssetID, Slayer::AssetRecord> m_assets;
+    Slayer::BinaryDeserializer deserializer;
+
+    template<typename T>
+    static void ReadValue(std::ifstream& stream, T& value)
+    {
+        stream.read((char*)&value, sizeof(T));
+    }
+
+public:
+    void Load(const std::string& path)
+    {
+        std::ifstream inputStream(path, std::ios::binary);
+        SL_ASSERT(inputStream.is_open() && "Failed to open asset pack!");
+
+        char magic[6];
+        uint32_t version, numAssets;
+        inputStream.read(magic, 6);
+        ReadValue(inputStream, version);
+        ReadValue(inputStream, numAssets);
+
+        m_data = std::vector<char>();
+        uint64_t dataIndex = 0;
+        for (uint32_t i = 0; i < numAssets; i++)
+        {
+            Slayer::AssetRecord record;
+            uint32_t nameLength;
+            ReadValue(inputStream, record.id);
+            ReadValue(inputStream, record.type);
+            ReadValue(inputStream, nameLength);
+            record.name.resize(nameLength);
+            inputStream.read(record.name.data(), nameLength);
+            ReadValue(inputStream, record.dataLength);
+
+            record.dataOffset = dataIndex;
+            dataIndex += record.dataLength;
+            m_assets[record.id] = record;
+
+            std::vector<char> data;
+            data.resize(record.dataLength);
+            inputStream.read(data.data(), record.dataLength);
+            m_data.insert(m_data.end(), data.begin(), data.end());
+        }
+    }
+
+    const Slayer::Dict<Slayer::AssetID, Slayer::AssetRecord>& GetAssets() const { return m_assets; }
+
+    template<typename T>
+    T GetAssetData(const Slayer::AssetID& id)
+    {
+        const Slayer::AssetRecord& record = m_assets.at(id);
+        T data;
+        deserializer.Deserialize(data, m_data.data() + record.dataOffset, record.dataLength);
+        return data;
+    }
+};
+
+template<typename T>
+static void WriteValue(std::ofstream& stream, const T& value)
+{
+    stream.write((const char*)&value, sizeof(T));
+}
+
+template<typename T>
+static void WriteArray(std::ofstream& stream, uint32_t count, T value)
+{
+    WriteValue(stream, count);
+    std::vector<T> values(count, value);
+    stream.write((const char*)values.data(), count * sizeof(T));
+}
+
+// Writes a pack of 4 MB textures, 1.5 MB models and 256 KB animations in the ratio 6:3:1 by size. The names differ
+// in length, so that most packed arrays are not aligned, as in packs from the pack builder.
+static size_t WritePack(const std::string& path, size_t packBytes)
+{
+    struct AssetSpec
+    {
+        Slayer::AssetType type;
+        uint32_t dataLength;
+    };
+
+    const uint32_t textureTexels = 1024 * 1024;
+    const uint32_t vertexFloats = 256 * 1024, indexCount = 128 * 1024;
+    const uint32_t animationFloats = 64 * 1024;
+    const AssetSpec specs[] = {
+        { Slayer::SL_ASSET_TYPE_TEXTURE, 5 * sizeof(uint32_t) + textureTexels * 4 },
+        { Slayer::SL_ASSET_TYPE_TEXTURE, 5 * sizeof(uint32_t) + textureTexels * 4 },
+        { Slayer::SL_ASSET_TYPE_TEXTURE, 5 * sizeof(uint32_t) + textureTexels * 4 },
+        { Slayer::SL_ASSET_TYPE_MODEL, 3 * sizeof(uint32_t) + (vertexFloats + indexCount) * 4 },
+        { Slayer::SL_ASSET_TYPE_MODEL, 3 * sizeof(uint32_t) + (vertexFloats + indexCount) * 4 },
+        { Slayer::SL_ASSET_TYPE_ANIMATION, 5 * sizeof(uint32_t) + (animationFloats / 4 + animationFloats) * 4 },
+    };
+
+    std::vector<AssetSpec> assets;
+    size_t totalBytes = 0;
+    for (size_t i = 0; totalBytes < packBytes; i++)
+    {
+        assets.push_back(specs[i % std::size(specs)]);
+        totalBytes += assets.back().dataLength;
+    }
+
+    std::ofstream stream(path, std::ios::binary);
+    stream.write(SL_ASSET_PACK_MAGIC, 6);
+    WriteValue(stream, (uint32_t)SL_ASSET_PACK_VERSION_1);
+    WriteValue(stream, (uint32_t)assets.size());
+
+    for (size_t i = 0; i < assets.size(); i++)
+    {
+        const std::string name = "asset_" + std::to_string(i) + std::string(i % 7, '_');
+        WriteValue(stream, (Slayer::AssetID)(i + 1));
+        WriteValue(stream, assets[i].type);
+        WriteValue(stream, (uint32_t)name.size());
+        stream.write(name.data(), name.size());
+        WriteValue(stream, assets[i].dataLength);
+
+        switch (assets[i].type)
+        {
+        case Slayer::SL_ASSET_TYPE_TEXTURE:
+            WriteValue(stream, 1024u);
+            WriteValue(stream, 1024u);
+            WriteValue(stream, 4u);
+            WriteValue(stream, 0x0DE1u);
+            WriteArray(stream, textureTexels * 4, (uint8_t)i);
+            break;
+        case Slayer::SL_ASSET_TYPE_MODEL:
+            WriteValue(stream, 1u);
+            WriteArray(stream, vertexFloats, 1.0f);
+            WriteArray(stream, indexCount, (uint32_t)i);
+            break;
+        default:
+            WriteValue(stream, 2.0f);
+            WriteValue(stream, 30.0f);
+            WriteValue(stream, 8u);
+            WriteArray(stream, animationFloats / 4, 0.5f);
+            WriteArray(stream, animationFloats, 0.25f);
+            break;
+        }
+    }
+
+    return assets.size();
+}
+
+// Copies the packed arrays of every asset into the staging buffer, the way they are handed to the GPU
+template<typename Texture, typename Model, typename Animation, typename Pack, typename Upload>
+static void UploadAll(Pack& pack, Upload&& upload)
+{
+    for (const auto& [id, record] : pack.GetAssets())
+    {
+        switch (record.type)
+        {
+        case Slayer::SL_ASSET_TYPE_TEXTURE:
+        {
+            Texture texture = pack.template GetAssetData<Texture>(id);
+            upload(texture.data);
+            break;
+        }
+        case Slayer::SL_ASSET_TYPE_MODEL:
+        {
+            Model model = pack.template GetAssetData<Model>(id);
+            for (auto& mesh : model.meshes)
+            {
+                upload(mesh.vertices);
+                upload(mesh.indices);
+            }
+            break;
+        }
+        default:
+        {
+            Animation animation = pack.template GetAssetData<Animation>(id);
+            upload(animation.times);
+            upload(animation.data);
+            break;
+        }
+        }
+    }
+}
+
+static void LegacyLoad(const std::string& path, bool upload, std::vector<char>& staging)
+{
+    LegacyAssetPack pack;
+    pack.Load(path);
+    if (upload)
+    {
+        UploadAll<Slayer::TextureAsset, Slayer::ModelAsset, Slayer::AnimationAsset>(pack, [&](const auto& values)
+            {
+                Slayer::Copy(values.data(), staging.data(), values.size() * sizeof(values[0]));
+            });
+    }
+    Slayer::Benchmark::Consume(pack.GetAssets().size());
+}
+
+static void MappedLoad(const std::string& path, bool upload, std::vector<char>& staging)
+{
+    Slayer::AssetPack pack;
+    pack.Load(path);
+    if (upload)
+    {
+        UploadAll<Slayer::TextureAssetView, Slayer::ModelAssetView, Slayer::AnimationAssetView>(pack, [&](const auto& values)
+            {
+                Slayer::Copy(values.Data(), staging.data(), values.SizeInBytes());
+            });
+    }
+    Slayer::Benchmark::Consume(pack.GetAssets().size());
+}
+
+#ifdef __linux__
+// Reads a field of /proc/self/status in kB
+static double ReadStatusKB(const std::string& field)
+{
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line))
+    {
+        if (line.compare(0, field.size(), field) == 0)
+            return std::stod(line.substr(field.size() + 1));
+    }
+    return 0.0;
+}
+#endif
+
+// Increase of the peak resident set while running the function in MB, or -1 where it is not measured
+template<typename Func>
+static double MeasurePeakMB(Func&& func)
+{
+#ifdef __linux__
+    // Resets the peak to the current resident set
+    std::ofstream("/proc/self/clear_refs") << "5";
+    const double before = ReadStatusKB("VmRSS");
+    func();
+    return (ReadStatusKB("VmHWM") - before) / 1024.0;
+#else
+    return -1.0;
+#endif
+}
+
+int main(int argc, char** argv)
+{
+    const size_t packMB = argc > 1 ? (size_t)std::stoull(argv[1]) : 512;
+    const std::string path = (std::filesystem::temp_directory_path() / "slayer_bench_pack.slp").string();
+    const size_t assetCount = WritePack(path, packMB << 20);
+    std::vector<char> staging(8 << 20);
+
+    // The first read brings the pack into the file cache, so that both loaders read from memory
+    LegacyLoad(path, false, staging);
+
+    const auto legacyOpen = [&]() { LegacyLoad(path, false, staging); };
+    const auto mappedOpen = [&]() { MappedLoad(path, false, staging); };
+    const auto legacyUpload = [&]() { LegacyLoad(path, true, staging); };
+    const auto mappedUpload = [&]() { MappedLoad(path, true, staging); };
+
+    const double legacyOpenTime = Slayer::Benchmark::Measure(s_repetitions, legacyOpen);
+    const double mappedOpenTime = Slayer::Benchmark::Measure(s_repetitions, mappedOpen);
+    const double legacyUploadTime = Slayer::Benchmark::Measure(s_repetitions, legacyUpload);
+    const double mappedUploadTime = Slayer::Benchmark::Measure(s_repetitions, mappedUpload);
+
+    Slayer::Benchmark::PrintHeader("Asset pack: stream reader (baseline) vs memory-mapped, " + std::to_string(packMB) + " MB pack");
+    Slayer::Benchmark::PrintResult("open", assetCount, legacyOpenTime, mappedOpenTime);
+    Slayer::Benchmark::PrintResult("open + upload every asset", assetCount, legacyUploadTime, mappedUploadTime);
+
+    // Mapped pages are file cache the OS can drop at any time, but they count as resident once touched
+    const double legacyOpenPeak = MeasurePeakMB(legacyOpen);
+    const double mappedOpenPeak = MeasurePeakMB(mappedOpen);
+    const double legacyUploadPeak = MeasurePeakMB(legacyUpload);
+    const double mappedUploadPeak = MeasurePeakMB(mappedUpload);
+    std::printf("\n%-36s %14s %14s\n", "peak RSS increase (MB)", "baseline", "new");
+    std::printf("%-36s %14.1f %14.1f\n", "open", legacyOpenPeak, mappedOpenPeak);
+    std::printf("%-36s %14.1f %14.1f\n", "open + upload every asset", legacyUploadPeak, mappedUploadPeak);
+
+    std::filesystem::remove(path);
+    return 0;
+}
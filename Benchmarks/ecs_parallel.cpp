@@ -0,0 +1,90 @@
+#include "Benchmark.h"
+#include "Scene/ComponentStore.h"
+#include "Jobs/ThreadManager.h"
+
+#include <cmath>
+
+// Compares ParallelForEach on the worker pool against the serial ForEach and the
+// std::async based ForEachAsync. All times are relative to ForEach.
+
+struct Position
+{
+    float x = 0.0f;
+    float y = 0.0f;
+    float z = 0.0f;
+};
+
+struct Velocity
+{
+    float x = 0.0f;
+    float y = 0.0f;
+    float z = 0.0f;
+};
+
+static constexpr uint32_t s_repetitions = 5;
+// ForEachAsync creates one thread per entity, larger counts take minutes
+static constexpr size_t s_maxAsyncEntities = 10000;
+
+// A few dozen flops per entity, roughly the cost of a small gameplay update
+void Integrate(Slayer::Entity entity, Position* position, Velocity* velocity)
+{
+    for (int i = 0; i < 16; i++)
+    {
+        velocity->x = std::sin(position->y) * 0.5f + velocity->x * 0.5f;
+        velocity->y = std::cos(position->z) * 0.5f + velocity->y * 0.5f;
+        position->x += velocity->x * 0.016f;
+        position->y += velocity->y * 0.016f;
+        position->z += velocity->z * 0.016f;
+    }
+}
+
+void RunBenchmarks(size_t count)
+{
+    Slayer::ComponentStore store;
+    store.RegisterComponent<Position>();
+    store.RegisterComponent<Velocity>();
+
+    for (size_t i = 0; i < count; i++)
+    {
+        Slayer::Entity entity = store.CreateEntityWithoutID();
+        store.AddComponent(entity, Position{ (float)i, 0.0f, 0.0f });
+        store.AddComponent(entity, Velocity{ 1.0f, 2.0f, 3.0f });
+    }
+
+    double serial = Slayer::Benchmark::Measure(s_repetitions, [&]() { store.ForEach<Position, Velocity>(&Integrate); });
+    Slayer::Benchmark::PrintResult("ForEach", count, serial, serial);
+
+    if (count <= s_maxAsyncEntities)
+    {
+        double async = Slayer::Benchmark::Measure(1, [&]() { store.ForEachAsync<Position, Velocity>(&Integrate); });
+        Slayer::Benchmark::PrintResult("ForEachAsync", count, serial, async);
+    }
+
+    double balanced = Slayer::Benchmark::Measure(s_repetitions, [&]()
+        {
+            store.ParallelForEach<Position, Velocity>(&Integrate, 256, Slayer::Partitioning::Balanced);
+        });
+    Slayer::Benchmark::PrintResult("ParallelForEach (balanced)", count, serial, balanced);
+
+    double deterministic = Slayer::Benchmark::Measure(s_repetitions, [&]()
+        {
+            store.ParallelForEach<Position, Velocity>(&Integrate, 256, Slayer::Partitioning::Deterministic);
+        });
+    Slayer::Benchmark::PrintResult("ParallelForEach (deterministic)", count, serial, deterministic);
+}
+
+int main(int argc, char** argv)
+{
+    Slayer::ThreadManager threadManager;
+    threadManager.Initialize();
+
+    Slayer::Benchmark::PrintHeader("ForEach (baseline) vs ForEachAsync and ParallelForEach, " + std::to_string(threadManager.GetWorkerCount()) + " workers");
+    for (size_t count : { 1000, 10000, 100000 })
+    {
+        RunBenchmarks(count);
+    }
+
+    threadManager.Shutdown();
+
+    return 0;
+}
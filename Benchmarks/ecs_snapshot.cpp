@@ -0,0 +1,87 @@
+#include "Benchmark.h"
+#include "Scene/ComponentStore.h"
+
+// Measures snapshots and restores of 100k entities against copying every component out of the
+// store one entity at a time, which is what a snapshot without chunk access has to do.
+
+using Slayer::Vector;
+using Slayer::Entity;
+
+struct Position
+{
+    float x = 0.0f;
+    float y = 0.0f;
+    float z = 0.0f;
+};
+
+struct Velocity
+{
+    float x = 0.0f;
+    float y = 0.0f;
+    float z = 0.0f;
+};
+
+static constexpr uint32_t s_repetitions = 5;
+static constexpr uint32_t s_entityCount = 100000;
+
+template <typename... Ts>
+void RunBenchmarks(const std::string& name, Ts... components)
+{
+    Slayer::ComponentStore store;
+    const Vector<Entity> entities = store.CreateEntities<Ts...>(s_entityCount, components...);
+
+    double baselineTime = Slayer::Benchmark::Measure(s_repetitions, [&]()
+        {
+            std::tuple<Vector<Ts>...> copies;
+            (std::get<Vector<Ts>>(copies).reserve(s_entityCount), ...);
+            for (Entity entity : entities)
+                (std::get<Vector<Ts>>(copies).push_back(*store.GetComponent<const Ts>(entity)), ...);
+            Slayer::Benchmark::Consume(std::get<0>(copies).size());
+        });
+
+    Slayer::WorldSnapshot snapshot;
+    double snapshotTime = Slayer::Benchmark::Measure(s_repetitions, [&]() { snapshot = store.CreateSnapshot(); });
+    Slayer::Benchmark::PrintResult(name + ", snapshot", s_entityCount, baselineTime, snapshotTime);
+
+    // Snapshots of a replay buffer reuse the memory of the frame they replace
+    Slayer::WorldSnapshot reused = store.CreateSnapshot();
+    double reusedTime = Slayer::Benchmark::Measure(s_repetitions, [&]() { store.CreateSnapshot(reused); });
+    Slayer::Benchmark::PrintResult(name + ", snapshot into reused", s_entityCount, baselineTime, reusedTime);
+
+    // A frame where 1% of the entities moved, which were spawned together
+    using First = std::tuple_element_t<0, std::tuple<Ts...>>;
+    double deltaTime = Slayer::Benchmark::Measure(s_repetitions, [&]()
+        {
+            for (uint32_t i = 0; i < s_entityCount / 100; i++)
+                store.GetComponent<First>(entities[i]);
+            store.CreateSnapshot(reused, &snapshot);
+        });
+    Slayer::Benchmark::PrintResult(name + ", delta, 1% changed", s_entityCount, baselineTime, deltaTime);
+
+    // Rolling back that frame
+    double restoreTime = Slayer::Benchmark::Measure(s_repetitions, [&]()
+        {
+            for (uint32_t i = 0; i < s_entityCount / 100; i++)
+                store.GetComponent<First>(entities[i]);
+            store.Restore(snapshot);
+        });
+    Slayer::Benchmark::PrintResult(name + ", restore, 1% changed", s_entityCount, baselineTime, restoreTime);
+
+    double forkTime = Slayer::Benchmark::Measure(s_repetitions, [&]()
+        {
+            Slayer::ComponentStore fork;
+            fork.Restore(snapshot);
+            Slayer::Benchmark::Consume(fork.GetEntityCount());
+        });
+    Slayer::Benchmark::PrintResult(name + ", fork", s_entityCount, baselineTime, forkTime);
+}
+
+int main(int argc, char** argv)
+{
+    Slayer::Benchmark::PrintHeader("Per-entity copy (baseline) vs WorldSnapshot");
+
+    RunBenchmarks("position, velocity", Position{ 1.0f, 2.0f, 3.0f }, Velocity{ 1.0f, 0.0f, 0.0f });
+    RunBenchmarks("transform, model", Slayer::Transform(Slayer::Vec3(1.0f), Slayer::Quat(1.0f, 0.0f, 0.0f, 0.0f), Slayer::Vec3(1.0f)), Slayer::ModelRenderer(1, 2));
+
+    return 0;
+}
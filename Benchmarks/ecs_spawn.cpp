@@ -0,0 +1,72 @@
+#include "Benchmark.h"
+#include "Scene/ComponentStore.h"
+
+// Compares creating entities one component at a time, which moves every entity through an
+// archetype per component, against the bulk spawn, batch add and prefab APIs.
+
+using Slayer::Vector;
+using Slayer::Entity;
+
+static constexpr uint32_t s_repetitions = 5;
+static constexpr uint32_t s_entityCount = 100000;
+
+static Slayer::Transform MakeTransform(uint32_t i)
+{
+    return Slayer::Transform(Slayer::Vec3((float)i, 0.0f, 0.0f), Slayer::Quat(1.0f, 0.0f, 0.0f, 0.0f), Slayer::Vec3(1.0f));
+}
+
+// Creates a fresh store for every run so that each run spawns into empty archetypes
+template <typename Func>
+double MeasureSpawn(Func&& spawn)
+{
+    return Slayer::Benchmark::Measure(s_repetitions, [&]()
+        {
+            Slayer::ComponentStore store;
+            store.RegisterComponents<ENGINE_COMPONENTS>();
+            spawn(store);
+            Slayer::Benchmark::Consume(store.GetEntityCount());
+        });
+}
+
+int main(int argc, char** argv)
+{
+    Slayer::Benchmark::PrintHeader("Per-entity creation (baseline) vs bulk spawn");
+
+    const Slayer::ModelRenderer renderer(1, 2);
+
+    double baselineTime = MeasureSpawn([&](Slayer::ComponentStore& store)
+        {
+            for (uint32_t i = 0; i < s_entityCount; i++)
+            {
+                Entity entity = store.CreateEntityWithoutID();
+                store.AddComponent(entity, MakeTransform(i));
+                store.AddComponent(entity, renderer);
+            }
+        });
+
+    double addComponentsTime = MeasureSpawn([&](Slayer::ComponentStore& store)
+        {
+            for (uint32_t i = 0; i < s_entityCount; i++)
+            {
+                Entity entity = store.CreateEntityWithoutID();
+                store.AddComponents(entity, MakeTransform(i), renderer);
+            }
+        });
+    Slayer::Benchmark::PrintResult("AddComponents", s_entityCount, baselineTime, addComponentsTime);
+
+    double createEntitiesTime = MeasureSpawn([&](Slayer::ComponentStore& store)
+        {
+            store.CreateEntities<Slayer::Transform, Slayer::ModelRenderer>(s_entityCount, &MakeTransform, renderer);
+        });
+    Slayer::Benchmark::PrintResult("CreateEntities", s_entityCount, baselineTime, createEntitiesTime);
+
+    double instantiateTime = MeasureSpawn([&](Slayer::ComponentStore& store)
+        {
+            Entity prefab = store.CreateEntityWithoutID();
+            store.AddComponents(prefab, MakeTransform(0), renderer);
+            store.Instantiate(prefab, s_entityCount - 1);
+        });
+    Slayer::Benchmark::PrintResult("Instantiate", s_entityCount, baselineTime, instantiateTime);
+
+    return 0;
+}
@@ -0,0 +1,127 @@
+#include "Benchmark.h"
+#include "LegacyComponentStore.h"
+#include "Scene/ComponentStore.h"
+
+#include <random>
+
+// Compares the archetype chunked ComponentStore against the original map-based store.
+
+using Slayer::Vector;
+
+struct Position
+{
+    float x = 0.0f;
+    float y = 0.0f;
+    float z = 0.0f;
+};
+
+struct Velocity
+{
+    float x = 0.0f;
+    float y = 0.0f;
+    float z = 0.0f;
+};
+
+struct Health
+{
+    float value = 100.0f;
+};
+
+static constexpr uint32_t s_repetitions = 5;
+
+template <typename Store, typename EntityType>
+void Populate(Store& store, Vector<EntityType>& entities, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        EntityType entity;
+        if constexpr (std::is_same_v<Store, Slayer::ComponentStore>)
+            entity = store.CreateEntityWithoutID();
+        else
+            entity = store.CreateEntity();
+
+        store.AddComponent(entity, Position{ (float)i, 0.0f, 0.0f });
+        store.AddComponent(entity, Velocity{ 1.0f, 2.0f, 3.0f });
+        // Split the entities over two archetypes
+        if (i % 2 == 0)
+            store.AddComponent(entity, Health{});
+        entities.push_back(entity);
+    }
+}
+
+template <typename Store>
+void RegisterComponents(Store& store)
+{
+    store.template RegisterComponent<Position>();
+    store.template RegisterComponent<Velocity>();
+    store.template RegisterComponent<Health>();
+}
+
+void RunBenchmarks(size_t count)
+{
+    Slayer::Legacy::ComponentStore legacyStore;
+    Slayer::ComponentStore store;
+    Vector<Slayer::Legacy::Entity> legacyEntities;
+    Vector<Slayer::Entity> entities;
+
+    double legacyTime = Slayer::Benchmark::Measure(1, [&]() { RegisterComponents(legacyStore); Populate(legacyStore, legacyEntities, count); });
+    double time = Slayer::Benchmark::Measure(1, [&]() { RegisterComponents(store); Populate(store, entities, count); });
+    Slayer::Benchmark::PrintResult("create + 3x AddComponent", count, legacyTime, time);
+
+    auto integrate = [](auto entity, Position* position, Velocity* velocity)
+        {
+            position->x += velocity->x * 0.016f;
+            position->y += velocity->y * 0.016f;
+            position->z += velocity->z * 0.016f;
+        };
+
+    legacyTime = Slayer::Benchmark::Measure(s_repetitions, [&]() { legacyStore.ForEach<Position, Velocity>(integrate); });
+    time = Slayer::Benchmark::Measure(s_repetitions, [&]() { store.ForEach<Position, Velocity>(integrate); });
+    Slayer::Benchmark::PrintResult("ForEach<Position, Velocity>", count, legacyTime, time);
+
+    // Random access through GetComponent
+    std::mt19937 rng(1234);
+    std::shuffle(legacyEntities.begin(), legacyEntities.end(), rng);
+    std::shuffle(entities.begin(), entities.end(), rng);
+
+    legacyTime = Slayer::Benchmark::Measure(s_repetitions, [&]()
+        {
+            float sum = 0.0f;
+            for (Slayer::Legacy::Entity entity : legacyEntities)
+                sum += legacyStore.GetComponent<Position>(entity)->x;
+            Slayer::Benchmark::Consume(sum);
+        });
+    time = Slayer::Benchmark::Measure(s_repetitions, [&]()
+        {
+            float sum = 0.0f;
+            for (Slayer::Entity entity : entities)
+                sum += store.GetComponent<Position>(entity)->x;
+            Slayer::Benchmark::Consume(sum);
+        });
+    Slayer::Benchmark::PrintResult("GetComponent<Position> (random)", count, legacyTime, time);
+
+    // Projectile style churn, every frame a batch of short lived entities is created and destroyed
+    const size_t churnPerFrame = std::max<size_t>(count / 10, 1);
+    auto churn = [churnPerFrame](auto& churnStore, auto& churnEntities)
+        {
+            churnEntities.clear();
+            Populate(churnStore, churnEntities, churnPerFrame);
+            for (auto entity : churnEntities)
+                churnStore.DestroyEntity(entity);
+        };
+
+    legacyTime = Slayer::Benchmark::Measure(s_repetitions, [&]() { churn(legacyStore, legacyEntities); });
+    time = Slayer::Benchmark::Measure(s_repetitions, [&]() { churn(store, entities); });
+    Slayer::Benchmark::PrintResult("create + destroy churn (count / 10)", count, legacyTime, time);
+}
+
+int main(int argc, char** argv)
+{
+    Slayer::Benchmark::PrintHeader("ComponentStore: map-based (baseline) vs archetype chunks (new)");
+    for (size_t count : { 1000, 10000, 100000 })
+    {
+        RunBenchmarks(count);
+    }
+
+    return 0;
+}
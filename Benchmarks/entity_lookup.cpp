@@ -0,0 +1,78 @@
+#include "Benchmark.h"
+#include "Scene/EntityIdIndex.h"
+
+#include <random>
+
+// Compares AssetID to entity lookups in std::unordered_map, which the store used before,
+// against the flat EntityIdIndex, for ids that are present and ids that are not.
+
+using Slayer::Vector;
+using Slayer::Entity;
+using Slayer::AssetID;
+
+static constexpr uint32_t s_repetitions = 5;
+static constexpr size_t s_lookupCount = 1000000;
+
+void RunBenchmarks(size_t entityCount)
+{
+    std::mt19937_64 random(entityCount);
+    Vector<AssetID> ids(entityCount);
+    for (AssetID& id : ids)
+        id = random();
+
+    Slayer::Dict<AssetID, Entity> map;
+    Slayer::EntityIdIndex index;
+    for (size_t i = 0; i < entityCount; i++)
+    {
+        map[ids[i]] = (Entity)i;
+        index.Set(ids[i], (Entity)i);
+    }
+
+    Vector<AssetID> hits(s_lookupCount);
+    Vector<AssetID> misses(s_lookupCount);
+    for (size_t i = 0; i < s_lookupCount; i++)
+    {
+        hits[i] = ids[random() % entityCount];
+        misses[i] = random();
+    }
+
+    auto measureMap = [&](const Vector<AssetID>& lookups)
+        {
+            return Slayer::Benchmark::Measure(s_repetitions, [&]()
+                {
+                    Entity sum = 0;
+                    for (AssetID id : lookups)
+                    {
+                        auto it = map.find(id);
+                        sum += it != map.end() ? it->second : SL_INVALID_ENTITY;
+                    }
+                    Slayer::Benchmark::Consume(sum);
+                });
+        };
+
+    auto measureIndex = [&](const Vector<AssetID>& lookups)
+        {
+            return Slayer::Benchmark::Measure(s_repetitions, [&]()
+                {
+                    Entity sum = 0;
+                    for (AssetID id : lookups)
+                        sum += index.Find(id);
+                    Slayer::Benchmark::Consume(sum);
+                });
+        };
+
+    const std::string size = std::to_string(entityCount) + " ids";
+    Slayer::Benchmark::PrintResult(size + ", present", s_lookupCount, measureMap(hits), measureIndex(hits));
+    Slayer::Benchmark::PrintResult(size + ", missing", s_lookupCount, measureMap(misses), measureIndex(misses));
+}
+
+int main(int argc, char** argv)
+{
+    Slayer::Benchmark::PrintHeader("std::unordered_map (baseline) vs EntityIdIndex lookups");
+
+    RunBenchmarks(1000);
+    RunBenchmarks(100000);
+    RunBenchmarks(1000000);
+
+    return 0;
+}
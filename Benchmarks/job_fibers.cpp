@@ -0,0 +1,106 @@
+#include "Benchmark.h"
+#include "Jobs/ThreadManager.h"
+
+#include <atomic>
+#include <cmath>
+
+// Nested waits the way a frame does them: animation jobs wait for their skinning jobs, which wait for
+// their submit jobs. Without fibers a waiting job runs other jobs on top of its own stack, with fibers it
+// parks and the worker continues on another fiber. Compares the frame time and the deepest stack of
+// nested jobs on any thread.
+
+static constexpr uint32_t s_repetitions = 10;
+static constexpr uint32_t s_animationJobs = 64;
+static constexpr uint32_t s_skinningJobs = 8;
+static constexpr uint32_t s_submitJobs = 4;
+
+static thread_local uint32_t s_depth = 0;
+static std::atomic<uint32_t> s_maxDepth = 0;
+
+struct LevelData
+{
+    uint32_t level;
+    std::atomic<uint64_t>* sink;
+};
+
+// About a microsecond of work
+static void Work(std::atomic<uint64_t>& sink)
+{
+    float value = 1.0f;
+    for (int i = 0; i < 200; i++)
+        value = std::sqrt(value + (float)i);
+    sink.fetch_add((uint64_t)value, std::memory_order_relaxed);
+}
+
+static void LevelJob(Slayer::Job& job)
+{
+    const LevelData data = job.GetDataCopy<LevelData>();
+    s_depth++;
+    uint32_t maxDepth = s_maxDepth.load(std::memory_order_relaxed);
+    while (s_depth > maxDepth && !s_maxDepth.compare_exchange_weak(maxDepth, s_depth)) {}
+
+    static constexpr uint32_t childCounts[] = { s_skinningJobs, s_submitJobs, 0 };
+    const uint32_t childCount = childCounts[data.level];
+    if (childCount > 0)
+    {
+        Slayer::Worker* worker = Slayer::ThreadManager::Get()->GetCurrentWorker();
+        Slayer::JobPool& pool = worker->Pool();
+        const size_t marker = pool.GetMarker();
+        Slayer::Job* root = pool.CreateJob([](Slayer::Job&) {});
+        for (uint32_t i = 0; i < childCount; i++)
+            worker->Submit(pool.CreateJobAsChild(&LevelJob, LevelData{ data.level + 1, data.sink }, root));
+        worker->Submit(root);
+
+        // The depth counts jobs on this thread's stack, a parked fiber leaves it
+        const uint32_t parkedDepth = worker->UsesFibers() ? 1 : 0;
+        s_depth -= parkedDepth;
+        worker->Wait(root);
+        s_depth += parkedDepth;
+        pool.Rewind(marker);
+    }
+
+    Work(*data.sink);
+    s_depth--;
+}
+
+static double RunFrames(bool useFibers, uint32_t& maxDepth)
+{
+    Slayer::ThreadManager threadManager;
+    threadManager.Initialize(useFibers);
+    Slayer::Worker* worker = threadManager.GetCurrentWorker();
+    std::atomic<uint64_t> sink = 0;
+    s_maxDepth = 0;
+
+    const double time = Slayer::Benchmark::Measure(s_repetitions, [&]()
+        {
+            Slayer::JobPool& pool = worker->Pool();
+            const size_t marker = pool.GetMarker();
+            Slayer::Job* frame = pool.CreateJob([](Slayer::Job&) {});
+            for (uint32_t i = 0; i < s_animationJobs; i++)
+                worker->Submit(pool.CreateJobAsChild(&LevelJob, LevelData{ 0, &sink }, frame));
+            worker->Submit(frame);
+            worker->Wait(frame);
+            pool.Rewind(marker);
+        });
+
+    threadManager.Shutdown();
+    Slayer::Benchmark::Consume(sink.load());
+    maxDepth = s_maxDepth.load();
+    return time;
+}
+
+int main(int argc, char** argv)
+{
+    const size_t jobCount = s_animationJobs * (1 + s_skinningJobs * (1 + s_submitJobs));
+
+    uint32_t threadDepth = 0;
+    uint32_t fiberDepth = 0;
+    const double threadTime = RunFrames(false, threadDepth);
+    const double fiberTime = RunFrames(true, fiberDepth);
+
+    Slayer::Benchmark::PrintHeader("Waiting on the thread's stack (baseline) vs parking fibers, animation -> skinning -> submit");
+    Slayer::Benchmark::PrintResult("frame", jobCount, threadTime, fiberTime);
+    std::printf("deepest stack of nested jobs: %u without fibers, %u with fibers\n", threadDepth, fiberDepth);
+
+    return 0;
+}
@@ -0,0 +1,120 @@
+#include "Benchmark.h"
+#include "Jobs/MPMCQueue.h"
+#include "Jobs/JobClosure.h"
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Compares the lock-free MPMCQueue of JobClosures against the mutex guarded ring buffer of
+// std::function that JobSystem used before. Every thread pushes a job and pops one in a loop,
+// so producers and consumers contend on both ends of the queue.
+
+static constexpr uint32_t s_repetitions = 3;
+static constexpr size_t s_operationCount = 1 << 20;
+static constexpr size_t s_capacity = 1024;
+
+// The ring buffer JobSystem used before, kept here as the baseline
+template <typename T, size_t capacity>
+class MutexRingBuffer
+{
+public:
+    bool TryPush(T&& item)
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        size_t next = (m_head + 1) % capacity;
+        if (next == m_tail)
+            return false;
+        m_data[m_head] = std::move(item);
+        m_head = next;
+        return true;
+    }
+
+    bool TryPop(T& item)
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        if (m_tail == m_head)
+            return false;
+        item = std::move(m_data[m_tail]);
+        m_tail = (m_tail + 1) % capacity;
+        return true;
+    }
+
+private:
+    T m_data[capacity];
+    size_t m_head = 0;
+    size_t m_tail = 0;
+    std::mutex m_lock;
+};
+
+// Captures about as much as a JobSystem::Dispatch group, which is too large for the small buffer of std::function
+struct WorkItem
+{
+    std::atomic<uint64_t>* sum;
+    uint64_t value;
+    uint32_t groupIndex;
+    uint32_t groupSize;
+};
+
+// Runs func(threadIndex) on threadCount threads that start together, returns the time until all of them finished.
+template <typename Func>
+double RunThreads(uint32_t threadCount, Func&& func)
+{
+    return Slayer::Benchmark::Measure(s_repetitions, [&]()
+        {
+            std::atomic<bool> start = false;
+            std::vector<std::thread> threads;
+            for (uint32_t i = 0; i < threadCount; i++)
+            {
+                threads.emplace_back([&, i]()
+                    {
+                        while (!start.load())
+                            std::this_thread::yield();
+                        func(i);
+                    });
+            }
+            start.store(true);
+            for (std::thread& thread : threads)
+                thread.join();
+        });
+}
+
+template <typename Queue, typename Job>
+void PushAndPop(Queue& queue, std::atomic<uint64_t>& sum, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        WorkItem item = { &sum, i, (uint32_t)i, 64 };
+        Job job([item]() { item.sum->fetch_add(item.value + item.groupIndex, std::memory_order_relaxed); });
+        while (!queue.TryPush(std::move(job)))
+            std::this_thread::yield();
+
+        Job popped;
+        while (!queue.TryPop(popped))
+            std::this_thread::yield();
+        popped();
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Slayer::Benchmark::PrintHeader("Mutex ring buffer of std::function (baseline) vs MPMCQueue of JobClosure, " + std::to_string(std::thread::hardware_concurrency()) + " cores");
+    for (uint32_t threadCount : { 1, 2, 4, 8, 16, 32, 64 })
+    {
+        const size_t perThread = s_operationCount / threadCount;
+        std::atomic<uint64_t> sum = 0;
+
+        auto ringBuffer = std::make_unique<MutexRingBuffer<std::function<void()>, s_capacity>>();
+        double baseline = RunThreads(threadCount, [&](uint32_t) { PushAndPop<decltype(*ringBuffer), std::function<void()>>(*ringBuffer, sum, perThread); });
+
+        Slayer::MPMCQueue<Slayer::JobClosure> queue(s_capacity);
+        double lockFree = RunThreads(threadCount, [&](uint32_t) { PushAndPop<decltype(queue), Slayer::JobClosure>(queue, sum, perThread); });
+
+        Slayer::Benchmark::Consume(sum.load());
+        Slayer::Benchmark::PrintResult(std::to_string(threadCount) + " threads", perThread * threadCount, baseline, lockFree);
+    }
+
+    return 0;
+}
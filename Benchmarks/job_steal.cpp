@@ -0,0 +1,179 @@
+#include "Benchmark.h"
+#include "Jobs/JobQueue.h"
+#include "Jobs/ThreadManager.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// Work-stealing throughput. The first part compares the Chase-Lev JobQueue against the seq_cst
+// deque it replaced, with an owner that pushes and pops while thieves steal. The second part runs
+// fib-style nested job trees on the worker pool, relative to the same recursion run serially.
+
+static constexpr uint32_t s_repetitions = 5;
+static constexpr size_t s_queueJobs = 1 << 18;
+static constexpr size_t s_batchSize = 256;
+static constexpr uint32_t s_thiefCount = 3;
+// Subtrees below this size are computed inline instead of as jobs
+static constexpr int s_fibCutoff = 10;
+
+// The deque the workers used before, kept here as the baseline
+class LegacyJobQueue
+{
+public:
+    LegacyJobQueue(std::size_t maxJobs) : m_jobs(maxJobs), m_mask((int)maxJobs - 1) {}
+
+    void Push(Slayer::Job* job)
+    {
+        int bottom = m_bottom.load(std::memory_order_seq_cst);
+        m_jobs[bottom & m_mask] = job;
+        m_bottom.store(bottom + 1, std::memory_order_seq_cst);
+    }
+
+    Slayer::Job* Pop()
+    {
+        int bottom = m_bottom.load(std::memory_order_seq_cst) - 1;
+        m_bottom.store(bottom, std::memory_order_seq_cst);
+        int top = m_top.load(std::memory_order_seq_cst);
+        if (top <= bottom)
+        {
+            Slayer::Job* job = m_jobs[bottom & m_mask];
+            if (top != bottom)
+                return job;
+            if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst))
+                job = nullptr;
+            m_bottom.store(top + 1, std::memory_order_seq_cst);
+            return job;
+        }
+        m_bottom.store(top, std::memory_order_seq_cst);
+        return nullptr;
+    }
+
+    Slayer::Job* Steal()
+    {
+        int top = m_top.load(std::memory_order_seq_cst);
+        int bottom = m_bottom.load(std::memory_order_seq_cst);
+        if (top < bottom)
+        {
+            Slayer::Job* job = m_jobs[top & m_mask];
+            if (m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst))
+                return job;
+        }
+        return nullptr;
+    }
+
+private:
+    std::atomic_int m_bottom = 0;
+    std::atomic_int m_top = 0;
+    std::vector<Slayer::Job*> m_jobs;
+    int m_mask;
+};
+
+// The owner pushes batches and pops them back while the thieves steal, returns the time the owner took.
+template <typename Queue>
+double OwnerWithThieves(Queue& queue, std::vector<Slayer::Job>& jobs)
+{
+    return Slayer::Benchmark::Measure(s_repetitions, [&]()
+        {
+            std::atomic<bool> done = false;
+            std::atomic<size_t> stolen = 0;
+            std::vector<std::thread> thieves;
+            for (uint32_t i = 0; i < s_thiefCount; i++)
+            {
+                thieves.emplace_back([&]()
+                    {
+                        while (!done.load(std::memory_order_relaxed))
+                        {
+                            if (queue.Steal() != nullptr)
+                                stolen.fetch_add(1, std::memory_order_relaxed);
+                        }
+                    });
+            }
+
+            size_t popped = 0;
+            for (size_t batch = 0; batch < jobs.size(); batch += s_batchSize)
+            {
+                for (size_t i = batch; i < batch + s_batchSize; i++)
+                    queue.Push(&jobs[i]);
+                while (queue.Pop() != nullptr)
+                    popped++;
+            }
+
+            done = true;
+            for (std::thread& thief : thieves)
+                thief.join();
+            Slayer::Benchmark::Consume(popped + stolen.load());
+        });
+}
+
+struct FibData
+{
+    int n;
+    std::atomic<uint64_t>* result;
+    std::atomic<uint64_t>* jobCount;
+};
+
+static uint64_t Fib(int n)
+{
+    return n < 2 ? n : Fib(n - 1) + Fib(n - 2);
+}
+
+static void FibJob(Slayer::Job& job)
+{
+    const FibData data = job.GetDataCopy<FibData>();
+    data.jobCount->fetch_add(1, std::memory_order_relaxed);
+    if (data.n < s_fibCutoff)
+    {
+        data.result->fetch_add(Fib(data.n), std::memory_order_relaxed);
+        return;
+    }
+
+    Slayer::Worker* worker = Slayer::ThreadManager::Get()->GetCurrentWorker();
+    Slayer::JobPool& pool = worker->Pool();
+    const size_t marker = pool.GetMarker();
+    Slayer::Job* root = pool.CreateJob([](Slayer::Job&) {});
+    worker->Submit(pool.CreateJobAsChild(&FibJob, FibData{ data.n - 1, data.result, data.jobCount }, root));
+    worker->Submit(pool.CreateJobAsChild(&FibJob, FibData{ data.n - 2, data.result, data.jobCount }, root));
+    worker->Submit(root);
+    worker->Wait(root);
+    pool.Rewind(marker);
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<Slayer::Job> jobs(s_queueJobs);
+
+    Slayer::Benchmark::PrintHeader("seq_cst deque (baseline) vs Chase-Lev JobQueue, owner with " + std::to_string(s_thiefCount) + " thieves");
+    LegacyJobQueue legacyQueue(s_batchSize);
+    const double legacyTime = OwnerWithThieves(legacyQueue, jobs);
+    Slayer::JobQueue queue(s_batchSize);
+    const double queueTime = OwnerWithThieves(queue, jobs);
+    Slayer::Benchmark::PrintResult("push, pop and steal", jobs.size(), legacyTime, queueTime);
+
+    Slayer::ThreadManager threadManager;
+    threadManager.Initialize();
+
+    Slayer::Benchmark::PrintHeader("Serial recursion (baseline) vs nested fib job trees, " + std::to_string(threadManager.GetWorkerCount()) + " workers, " + std::to_string(std::thread::hardware_concurrency()) + " cores");
+    for (int n : { 20, 25, 30 })
+    {
+        const double serialTime = Slayer::Benchmark::Measure(s_repetitions, [&]() { Slayer::Benchmark::Consume(Fib(n)); });
+
+        std::atomic<uint64_t> result = 0;
+        std::atomic<uint64_t> jobCount = 0;
+        const double jobTime = Slayer::Benchmark::Measure(s_repetitions, [&]()
+            {
+                jobCount = 0;
+                Slayer::Job job(&FibJob, nullptr);
+                job.SetData(FibData{ n, &result, &jobCount });
+                Slayer::Worker* worker = threadManager.GetCurrentWorker();
+                worker->Submit(&job);
+                worker->Wait(&job);
+            });
+        Slayer::Benchmark::Consume(result.load());
+        Slayer::Benchmark::PrintResult("fib(" + std::to_string(n) + ") jobs", jobCount.load(), serialTime, jobTime);
+    }
+
+    threadManager.Shutdown();
+
+    return 0;
+}
@@ -0,0 +1,75 @@
+#include "Benchmark.h"
+#include "Jobs/ThreadManager.h"
+#include "Jobs/JobTrace.h"
+
+#include <atomic>
+#include <sstream>
+
+// Cost of the scheduler's trace on fib-style nested job trees, the same trees run with the trace disabled
+// and with every thread recording into its ring. Also times writing one frame out as Chrome trace JSON.
+
+static constexpr uint32_t s_repetitions = 10;
+static constexpr int s_fibN = 20;
+
+struct FibData
+{
+    int n;
+    std::atomic<uint64_t>* jobCount;
+};
+
+static void FibJob(Slayer::Job& job)
+{
+    const FibData data = job.GetDataCopy<FibData>();
+    data.jobCount->fetch_add(1, std::memory_order_relaxed);
+    if (data.n < 2)
+        return;
+
+    Slayer::Worker* worker = Slayer::ThreadManager::Get()->GetCurrentWorker();
+    Slayer::JobPool& pool = worker->Pool();
+    const size_t marker = pool.GetMarker();
+    Slayer::Job* root = pool.CreateJob([](Slayer::Job&) {});
+    worker->Submit(pool.CreateJobAsChild(&FibJob, FibData{ data.n - 1, data.jobCount }, root));
+    worker->Submit(pool.CreateJobAsChild(&FibJob, FibData{ data.n - 2, data.jobCount }, root));
+    worker->Submit(root);
+    worker->Wait(root);
+    pool.Rewind(marker);
+}
+
+static double RunFrames(Slayer::ThreadManager& threadManager, std::atomic<uint64_t>& jobCount)
+{
+    Slayer::Worker* worker = threadManager.GetCurrentWorker();
+    return Slayer::Benchmark::Measure(s_repetitions, [&]()
+        {
+            threadManager.BeginFrame();
+            jobCount = 0;
+            Slayer::Job job(&FibJob, nullptr);
+            job.SetData(FibData{ s_fibN, &jobCount });
+            worker->Submit(&job);
+            worker->Wait(&job);
+        });
+}
+
+int main(int argc, char** argv)
+{
+    Slayer::ThreadManager threadManager;
+    threadManager.Initialize();
+    const size_t workerCount = threadManager.GetWorkerCount();
+    std::atomic<uint64_t> jobCount = 0;
+
+    const double disabledTime = RunFrames(threadManager, jobCount);
+    Slayer::JobTrace::Enable(1 << 20);
+    const double enabledTime = RunFrames(threadManager, jobCount);
+    threadManager.BeginFrame();
+    Slayer::JobTrace::Disable();
+
+    const uint64_t lastFrame = threadManager.GetFrameIndex() - 2;
+    std::ostringstream trace;
+    const double writeTime = Slayer::Benchmark::Measure(1, [&]() { Slayer::JobTrace::WriteChromeTrace(trace, lastFrame, lastFrame); });
+    threadManager.Shutdown();
+
+    Slayer::Benchmark::PrintHeader("Job trace disabled (baseline) vs recording, fib(" + std::to_string(s_fibN) + ") job trees, " + std::to_string(workerCount) + " workers");
+    Slayer::Benchmark::PrintResult("frame", jobCount.load(), disabledTime, enabledTime);
+    std::printf("writing one frame as Chrome trace JSON: %.3f ms, %zu bytes\n", writeTime, trace.str().size());
+
+    return 0;
+}
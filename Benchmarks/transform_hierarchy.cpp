@@ -0,0 +1,123 @@
+#include "Benchmark.h"
+#include "Scene/ComponentStore.h"
+#include "Scene/TransformHierarchy.h"
+#include "Jobs/ThreadManager.h"
+
+// Compares TransformHierarchy against resolving every parent through the EntityID map each frame,
+// on wide, deep and balanced hierarchies.
+
+using Slayer::Vector;
+using Slayer::Entity;
+
+static constexpr uint32_t s_repetitions = 5;
+static constexpr size_t s_nodeCount = 50000;
+
+// The approach TransformSystem used before the hierarchy, extended to apply the parent matrix:
+// parents are looked up by AssetID for every entity and resolved with a per-frame memo.
+class MapLookupPropagation
+{
+private:
+    Vector<uint32_t> m_frames;
+    Vector<Slayer::Mat4> m_world;
+    Vector<Entity> m_chain;
+    uint32_t m_frame = 0;
+
+public:
+    void Update(Slayer::ComponentStore& store)
+    {
+        m_frame++;
+        store.ForEach<Slayer::Transform>([&](Entity entity, Slayer::Transform* transform)
+            {
+                // Walk up until a root or an entity that was already computed this frame
+                m_chain.clear();
+                Entity current = entity;
+                while (current != SL_INVALID_ENTITY)
+                {
+                    const uint32_t index = Slayer::GetEntityIndex(current);
+                    if (index >= m_frames.size())
+                    {
+                        m_frames.resize(index + 1, 0);
+                        m_world.resize(index + 1);
+                    }
+                    if (m_frames[index] == m_frame)
+                        break;
+                    m_chain.push_back(current);
+                    current = store.GetEntity(store.GetComponent<const Slayer::Transform>(current)->parentId);
+                }
+
+                for (size_t i = m_chain.size(); i-- > 0;)
+                {
+                    const Entity node = m_chain[i];
+                    const Slayer::Transform* nodeTransform = store.GetComponent<const Slayer::Transform>(node);
+                    const Entity parent = store.GetEntity(nodeTransform->parentId);
+                    const uint32_t index = Slayer::GetEntityIndex(node);
+                    m_world[index] = parent != SL_INVALID_ENTITY ? m_world[Slayer::GetEntityIndex(parent)] * nodeTransform->GetMatrix() : nodeTransform->GetMatrix();
+                    m_frames[index] = m_frame;
+                }
+
+                transform->worldTransform = m_world[Slayer::GetEntityIndex(entity)];
+            });
+    }
+};
+
+// parentOf(i) returns the index of the parent of node i, or -1 for roots. Parents always have a smaller index.
+template <typename ParentFunc>
+void BuildHierarchy(Slayer::ComponentStore& store, ParentFunc&& parentOf)
+{
+    Vector<Slayer::AssetID> ids;
+    for (size_t i = 0; i < s_nodeCount; i++)
+    {
+        Entity entity = store.CreateEntity();
+        ids.push_back(store.GetComponent<const Slayer::EntityID>(entity)->id);
+
+        Slayer::Transform transform(Slayer::Vec3(1.0f, 0.0f, 0.0f), Slayer::Quat(1.0f, 0.0f, 0.0f, 0.0f), Slayer::Vec3(1.0f));
+        const int64_t parent = parentOf(i);
+        transform.parentId = parent >= 0 ? ids[parent] : 0;
+        store.AddComponent(entity, transform);
+    }
+}
+
+template <typename ParentFunc>
+void RunBenchmarks(const std::string& name, ParentFunc&& parentOf)
+{
+    Slayer::ComponentStore store;
+    store.RegisterComponents<ENGINE_COMPONENTS>();
+    BuildHierarchy(store, parentOf);
+
+    MapLookupPropagation baseline;
+    Slayer::TransformHierarchy hierarchy;
+    hierarchy.Update(store);
+
+    double baselineTime = Slayer::Benchmark::Measure(s_repetitions, [&]() { baseline.Update(store); });
+
+    double fullTime = Slayer::Benchmark::Measure(s_repetitions, [&]()
+        {
+            store.ForEach<Slayer::Transform>([](Entity entity, Slayer::Transform* transform) { transform->position.y += 1.0f; });
+            hierarchy.Update(store);
+        });
+    Slayer::Benchmark::PrintResult(name + ", all moved", s_nodeCount, baselineTime, fullTime);
+
+    double staticTime = Slayer::Benchmark::Measure(s_repetitions, [&]() { hierarchy.Update(store); });
+    Slayer::Benchmark::PrintResult(name + ", none moved", s_nodeCount, baselineTime, staticTime);
+
+    Slayer::Benchmark::Consume(store.GetComponent<const Slayer::Transform>(store.GetAllEntities().back())->worldTransform[3].x);
+}
+
+int main(int argc, char** argv)
+{
+    Slayer::ThreadManager threadManager;
+    threadManager.Initialize();
+
+    Slayer::Benchmark::PrintHeader("Map lookup per entity (baseline) vs TransformHierarchy, " + std::to_string(threadManager.GetWorkerCount()) + " workers");
+
+    // One root with every other node as its child
+    RunBenchmarks("wide", [](size_t i) { return i == 0 ? -1 : 0; });
+    // 10 chains of 5000 nodes
+    RunBenchmarks("deep", [](size_t i) { return i < 10 ? -1 : (int64_t)i - 10; });
+    // Every node has four children
+    RunBenchmarks("4-ary tree", [](size_t i) { return i == 0 ? -1 : ((int64_t)i - 1) / 4; });
+
+    threadManager.Shutdown();
+
+    return 0;
+}
@@ -0,0 +1,64 @@
+#include "Benchmark.h"
+#include "Scene/Components.h"
+#include "Core/TransformKernel.h"
+
+#include <random>
+
+// Compares Transform::GetMatrix() one transform at a time against the batched ComposeTRS paths.
+
+using Slayer::Vector;
+
+static constexpr uint32_t s_repetitions = 20;
+
+void RunBenchmarks(size_t count)
+{
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+    Vector<Slayer::Transform> transforms;
+    Slayer::TRSBuffer buffer;
+    for (size_t i = 0; i < count; i++)
+    {
+        Slayer::Transform transform(Slayer::Vec3(unit(rng), unit(rng), unit(rng)) * 100.0f,
+            glm::normalize(Slayer::Quat(unit(rng), unit(rng), unit(rng), unit(rng))), Slayer::Vec3(unit(rng) + 2.0f));
+        transforms.push_back(transform);
+        buffer.Push(transform.position, transform.rotation, transform.scale);
+    }
+
+    Vector<Slayer::Mat4> matrices(count);
+    const Slayer::TRSArrays arrays = buffer.GetArrays();
+
+    double baseline = Slayer::Benchmark::Measure(s_repetitions, [&]()
+        {
+            for (size_t i = 0; i < count; i++)
+                matrices[i] = transforms[i].GetMatrix();
+        });
+    Slayer::Benchmark::PrintResult("GetMatrix", count, baseline, baseline);
+
+    const std::pair<const char*, Slayer::SimdLevel> levels[] = {
+        { "ComposeTRS (scalar)", Slayer::SimdLevel::Scalar },
+        { "ComposeTRS (SSE2)", Slayer::SimdLevel::SSE2 },
+        { "ComposeTRS (AVX2)", Slayer::SimdLevel::AVX2 }
+    };
+    for (const auto& [name, level] : levels)
+    {
+        if (level > Slayer::GetSimdLevel())
+            continue;
+
+        double result = Slayer::Benchmark::Measure(s_repetitions, [&]() { Slayer::ComposeTRS(arrays, matrices.data(), level); });
+        Slayer::Benchmark::PrintResult(name, count, baseline, result);
+    }
+
+    Slayer::Benchmark::Consume(matrices[count / 2][3].x);
+}
+
+int main(int argc, char** argv)
+{
+    Slayer::Benchmark::PrintHeader("Transform::GetMatrix (baseline) vs batched ComposeTRS");
+    for (size_t count : { 1000, 10000, 100000 })
+    {
+        RunBenchmarks(count);
+    }
+
+    return 0;
+}
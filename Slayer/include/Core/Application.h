@@ -5,6 +5,7 @@
 #include "Core/Window.h"
 #include "Core/Log.h"
 #include "Core/Layer.h"
+#include "Jobs/JobSettings.h"
 #include "GameTypesDecl.h"
 
 #include <chrono>
@@ -26,6 +27,8 @@ namespace Slayer
         Timespan m_deltaTime = 0.0f;
 
         Window m_window;      
+        // Read by the engine after OnPreInitialize to start the scheduler
+        JobSettings m_jobSettings;
     public:
     
         static Application* Get() { return s_instance; }
@@ -67,5 +70,6 @@ namespace Slayer
         void CalculateDeltaTime();
 
         Window& GetWindow() { return m_window; }
+        const JobSettings& GetJobSettings() const { return m_jobSettings; }
     };
 }
\ No newline at end of file
@@ -132,4 +132,48 @@ namespace Slayer
         }
 
     };
+
+    // Non-owning view of elements packed back to back, such as an array inside a memory-mapped file. The
+    // elements need not be aligned for T, so they are read by copy, and Data can be handed as is to anything
+    // that takes bytes, such as a buffer upload.
+    template<typename T>
+    class PackedSpan
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "Packed elements are read by copying their bytes.");
+
+        const char* m_data = nullptr;
+        size_t m_size = 0;
+    public:
+        PackedSpan() = default;
+        PackedSpan(const void* data, size_t size) : m_data((const char*)data), m_size(size) {}
+
+        T operator[](size_t index) const
+        {
+            SL_ASSERT(index < m_size && "Index out of bounds!");
+            T value;
+            Copy(m_data + index * sizeof(T), &value, sizeof(T));
+            return value;
+        }
+
+        size_t Size() const { return m_size; }
+        size_t SizeInBytes() const { return m_size * sizeof(T); }
+        bool Empty() const { return m_size == 0; }
+        const void* Data() const { return m_data; }
+
+        bool IsAligned() const { return (uintptr_t)m_data % alignof(T) == 0; }
+
+        // The elements as an array, only when they are aligned.
+        const T* AlignedData() const
+        {
+            SL_ASSERT(IsAligned() && "Packed elements are not aligned!");
+            return reinterpret_cast<const T*>(m_data);
+        }
+
+        Vector<T> ToVector() const
+        {
+            Vector<T> values(m_size);
+            Copy(m_data, values.data(), SizeInBytes());
+            return values;
+        }
+    };
 }
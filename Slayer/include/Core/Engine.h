@@ -8,16 +8,23 @@ namespace Slayer
     class Engine
     {
     private:
+        // Set from SL_JOB_TRACE=<file> and SL_JOB_TRACE_FRAMES=<first>-<last>, written out once the last frame
+        // has passed or at shutdown
+        std::string m_jobTracePath;
+        uint64_t m_jobTraceFirstFrame = 0;
+        uint64_t m_jobTraceLastFrame = UINT64_MAX;
+
         bool Initialize();
         void Update();
         void Render();
         void Shutdown();
+        void WriteJobTrace();
 
         template<typename Manager_t, typename ...VArgs>
         bool InitializeManager(VArgs... args)
         {
             Manager_t* m = new Manager_t();
-            if(!m || !m->Initialize())
+            if(!m || !m->Initialize(args...))
             {
                 Log::Critical("Failed to initialize", typeid(Manager_t).name());
                 delete m;
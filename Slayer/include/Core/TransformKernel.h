@@ -0,0 +1,81 @@
+#pragma once
+
+#include "Core/Core.h"
+#include "Core/Containers.h"
+#include "Core/Math.h"
+
+namespace Slayer
+{
+    enum class SimdLevel
+    {
+        Scalar,
+        SSE2,
+        AVX2
+    };
+
+    // Translation, rotation and scale values as a structure of arrays, every array holds count elements.
+    struct TRSArrays
+    {
+        const float* positionX = nullptr;
+        const float* positionY = nullptr;
+        const float* positionZ = nullptr;
+        const float* rotationX = nullptr;
+        const float* rotationY = nullptr;
+        const float* rotationZ = nullptr;
+        const float* rotationW = nullptr;
+        const float* scaleX = nullptr;
+        const float* scaleY = nullptr;
+        const float* scaleZ = nullptr;
+        size_t count = 0;
+    };
+
+    // Owns the arrays of a TRSArrays, filled one transform at a time.
+    class TRSBuffer
+    {
+    private:
+        Array<Vector<float>, 10> m_values;
+
+    public:
+        void Push(const Vec3& position, const Quat& rotation, const Vec3& scale)
+        {
+            const float values[10] = { position.x, position.y, position.z, rotation.x, rotation.y, rotation.z, rotation.w, scale.x, scale.y, scale.z };
+            for (size_t i = 0; i < 10; i++)
+                m_values[i].push_back(values[i]);
+        }
+
+        void Clear()
+        {
+            for (Vector<float>& values : m_values)
+                values.clear();
+        }
+
+        size_t Size() const { return m_values[0].size(); }
+
+        TRSArrays GetArrays() const
+        {
+            TRSArrays arrays;
+            arrays.positionX = m_values[0].data();
+            arrays.positionY = m_values[1].data();
+            arrays.positionZ = m_values[2].data();
+            arrays.rotationX = m_values[3].data();
+            arrays.rotationY = m_values[4].data();
+            arrays.rotationZ = m_values[5].data();
+            arrays.rotationW = m_values[6].data();
+            arrays.scaleX = m_values[7].data();
+            arrays.scaleY = m_values[8].data();
+            arrays.scaleZ = m_values[9].data();
+            arrays.count = Size();
+            return arrays;
+        }
+    };
+
+    // Returns the best instruction set supported by the running CPU.
+    SimdLevel GetSimdLevel();
+
+    // Writes translate(position) * mat4_cast(rotation) * scale(scale) for every element, the same
+    // matrix as Transform::GetMatrix(). Uses the best code path the CPU supports.
+    void ComposeTRS(const TRSArrays& input, Mat4* output);
+
+    // Same as above with a specific code path, levels the CPU does not support fall back to the best supported one.
+    void ComposeTRS(const TRSArrays& input, Mat4* output, SimdLevel level);
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "Core/Core.h"
+
+#include <cstddef>
+
+// x86-64 Linux switches with a few instructions, other POSIX systems fall back to ucontext
+#if !defined(_WIN32) && defined(__x86_64__) && defined(__linux__)
+#define SL_FIBER_ASM 1
+#elif !defined(_WIN32)
+#include <ucontext.h>
+#endif
+
+namespace Slayer
+{
+    // An execution context with its own stack. A thread first creates a Fiber for its own context, which
+    // other fibers switch back to, and then switches into fibers created with an entry function. The entry
+    // function must never return. Fibers are not moved between threads.
+    class Fiber
+    {
+    public:
+        using Entry = void (*)(void* arg);
+
+    private:
+#if defined(_WIN32)
+        void* m_handle = nullptr;
+#elif defined(SL_FIBER_ASM)
+        void* m_stackPointer = nullptr;
+#else
+        ucontext_t m_context;
+#endif
+        // Null for the context of a thread
+        void* m_stack = nullptr;
+        size_t m_stackSize = 0;
+        Entry m_entry = nullptr;
+        void* m_arg = nullptr;
+
+        // Stack above the guard page, the sanitizers learn the stack of a thread when switching away from it
+        const void* m_stackBottom = nullptr;
+        size_t m_usableStackSize = 0;
+        // Unused unless ThreadSanitizer is enabled
+        void* m_sanitizerFiber = nullptr;
+
+        static void Start(Fiber* fiber);
+#if defined(_WIN32)
+        bool m_convertedThread = false;
+        static void __stdcall StartWindows(void* fiber);
+#elif !defined(SL_FIBER_ASM)
+        static void StartContext(unsigned int high, unsigned int low);
+#endif
+        void BeginSwitch(Fiber& to, void** fakeStack);
+        static void EndSwitch(void* fakeStack);
+
+    public:
+        // The context of the calling thread.
+        Fiber();
+        Fiber(size_t stackSize, Entry entry, void* arg);
+        ~Fiber();
+
+        Fiber(const Fiber&) = delete;
+        Fiber& operator=(const Fiber&) = delete;
+
+        // Saves the running context in this fiber and continues the other one. Returns when
+        // something switches back to this fiber.
+        void SwitchTo(Fiber& to);
+    };
+}
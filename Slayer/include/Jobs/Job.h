@@ -2,52 +2,86 @@
 
 #include <atomic>
 #include <array>
+#include <cstring>
 
 namespace Slayer
 {
     using JobFunction = void (*)(class Job &);
 
+    // A job finishes once its function and every child job have finished, so a job with an empty function
+    // doubles as a counter for a group of children. Continuations are submitted when the job finishes.
     class Job
     {
+    public:
+        static constexpr std::size_t MAX_CONTINUATIONS = 4;
+
     private:
+        friend class JobPool;
+
         JobFunction function;
         Job *parent;
         std::atomic_int unfinishedJobs;
-        static constexpr std::size_t JOB_PAYLOAD_SIZE = sizeof(function) + sizeof(parent) + sizeof(unfinishedJobs);
-        static constexpr std::size_t JOB_MAX_PADDING_SIZE = 64;
+        std::atomic_int continuationCount;
+        std::array<Job*, MAX_CONTINUATIONS> continuations;
+        static constexpr std::size_t JOB_PAYLOAD_SIZE = sizeof(function) + sizeof(parent) + sizeof(unfinishedJobs) + sizeof(continuationCount) + sizeof(continuations);
+        static constexpr std::size_t JOB_MAX_PADDING_SIZE = 128;
         static constexpr std::size_t JOB_PADDING_SIZE = JOB_MAX_PADDING_SIZE - JOB_PAYLOAD_SIZE;
 
         std::array<unsigned char, JOB_PADDING_SIZE> padding;
 
+        template<typename T>
+        const void* DataAddress() const
+        {
+            if constexpr (StoresDataInline<T>())
+            {
+                return padding.data();
+            }
+            else
+            {
+                const void* data;
+                memcpy(&data, padding.data(), sizeof(data));
+                return data;
+            }
+        }
+
+        void SetDataPointer(const void* data) { memcpy(padding.data(), &data, sizeof(data)); }
+
     public:
         Job(JobFunction function, Job *parent);
         Job(const Job &) = delete;
         Job() = default;
         ~Job() = default;
 
+        // Data that does not fit in the job is stored in the frame arena of the pool that creates the job,
+        // the job then only holds a pointer to it. Such jobs have to be created through a JobPool.
+        template<typename T>
+        static constexpr bool StoresDataInline() { return sizeof(T) <= JOB_PADDING_SIZE; }
+
         template<typename T>
         void SetData(const T &data)
         {
-            static_assert(sizeof(T) <= JOB_PADDING_SIZE, "Job data is too large");
+            static_assert(StoresDataInline<T>(), "Job data is too large, create the job from a JobPool to store it in the frame arena");
             memcpy(padding.data(), &data, sizeof(T));
         }
 
         template<typename T>
         T GetDataCopy() const
         {
-            static_assert(sizeof(T) <= JOB_PADDING_SIZE, "Job data is too large");
             T data;
-            memcpy(&data, padding.data(), sizeof(T));
+            memcpy(&data, DataAddress<T>(), sizeof(T));
             return data;
         }
 
         template<typename T>
-        T* GetData() const
+        T* GetData()
         {
-            static_assert(sizeof(T) <= JOB_PADDING_SIZE, "Job data is too large");
-            return reinterpret_cast<T*>(padding.data());
+            return reinterpret_cast<T*>(const_cast<void*>(DataAddress<T>()));
         }
 
+        // Submits the continuation to the worker that finishes this job. Continuations have to be added
+        // before the job is submitted, and to wait for one, create it as a child of the job that is waited on.
+        void AddContinuation(Job* continuation);
+
         void Run();
         bool Finished() const;
         void Finish();
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace Slayer
+{
+    // A move-only void() callable stored inline, so that queuing a job never allocates. Callables that do not
+    // fit in the buffer are rejected at compile time, they should capture a pointer to their state instead.
+    class JobClosure
+    {
+    public:
+        static constexpr size_t Capacity = 48;
+
+    private:
+        alignas(std::max_align_t) unsigned char m_storage[Capacity];
+        void (*m_invoke)(void* storage) = nullptr;
+        // Moves the callable from src to dst and destroys src, or only destroys src when dst is null.
+        // Null for trivially copyable callables, which are moved with memcpy and need no destruction.
+        void (*m_manage)(void* dst, void* src) = nullptr;
+
+        void Reset()
+        {
+            if (m_manage != nullptr)
+                m_manage(nullptr, m_storage);
+            m_invoke = nullptr;
+            m_manage = nullptr;
+        }
+
+        void MoveFrom(JobClosure& other)
+        {
+            if (other.m_manage != nullptr)
+                other.m_manage(m_storage, other.m_storage);
+            else if (other.m_invoke != nullptr)
+                std::memcpy(m_storage, other.m_storage, Capacity);
+
+            m_invoke = other.m_invoke;
+            m_manage = other.m_manage;
+            other.m_invoke = nullptr;
+            other.m_manage = nullptr;
+        }
+
+    public:
+        JobClosure() = default;
+
+        template <typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, JobClosure>>>
+        JobClosure(F&& func)
+        {
+            using Callable = std::decay_t<F>;
+            static_assert(sizeof(Callable) <= Capacity, "Job captures too much state, capture a pointer to it instead.");
+            static_assert(alignof(Callable) <= alignof(std::max_align_t), "Job captures over-aligned state.");
+
+            new (m_storage) Callable(std::forward<F>(func));
+            m_invoke = [](void* storage) { (*static_cast<Callable*>(storage))(); };
+            if constexpr (!std::is_trivially_copyable_v<Callable>)
+            {
+                m_manage = [](void* dst, void* src)
+                    {
+                        Callable* callable = static_cast<Callable*>(src);
+                        if (dst != nullptr)
+                            new (dst) Callable(std::move(*callable));
+                        callable->~Callable();
+                    };
+            }
+        }
+
+        ~JobClosure() { Reset(); }
+
+        JobClosure(JobClosure&& other) noexcept { MoveFrom(other); }
+
+        JobClosure& operator=(JobClosure&& other) noexcept
+        {
+            if (this != &other)
+            {
+                Reset();
+                MoveFrom(other);
+            }
+            return *this;
+        }
+
+        JobClosure(const JobClosure&) = delete;
+        JobClosure& operator=(const JobClosure&) = delete;
+
+        void operator()() { m_invoke(m_storage); }
+        explicit operator bool() const { return m_invoke != nullptr; }
+    };
+}
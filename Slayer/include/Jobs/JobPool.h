@@ -1,29 +1,103 @@
 #pragma once
 
 #include "Jobs/Job.h"
+#include <atomic>
 #include <vector>
 
 namespace Slayer
 {
+    // Linear allocator for job data that does not fit in a job. Every worker owns one that its pools share,
+    // allocations live until the arena is reset at the next frame boundary.
+    class FrameArena
+    {
+    public:
+        FrameArena(std::size_t size);
+
+        // Returns nullptr when the arena is full.
+        void *Allocate(std::size_t size, std::size_t alignment);
+        void Reset();
+
+        std::size_t GetCapacity() const { return storage.size(); }
+        // Most bytes in use at once since the arena was created
+        std::size_t GetHighWaterMark() const { return highWaterMark.load(std::memory_order_relaxed); }
+        std::size_t GetFailedAllocations() const { return failedAllocations.load(std::memory_order_relaxed); }
+
+    private:
+        std::size_t offset;
+        std::vector<unsigned char> storage;
+        // Written by the owning worker only, atomic so that other threads can read the telemetry
+        std::atomic<std::size_t> highWaterMark;
+        std::atomic<std::size_t> failedAllocations;
+    };
+
     class JobPool
     {
     public:
-        JobPool(std::size_t maxJobs);
+        JobPool(std::size_t maxJobs, FrameArena *arena = nullptr);
 
         Job *Allocate();
         bool Full() const;
         void Clear();
 
+        // Jobs are allocated linearly, a marker taken before allocating a group of jobs
+        // can be rewound to once every job in the group has finished.
+        std::size_t GetMarker() const { return allocatedJobs; }
+        void Rewind(std::size_t marker);
+
+        std::size_t GetCapacity() const { return storage.size(); }
+        // Most jobs allocated at once since the pool was created
+        std::size_t GetHighWaterMark() const { return highWaterMark.load(std::memory_order_relaxed); }
+        std::size_t GetFailedAllocations() const { return failedAllocations.load(std::memory_order_relaxed); }
+
         Job *CreateJob(JobFunction jobFunction);
-        Job *CreateJobAsChild(JobFunction& jobFunction, Job *parent);
+        Job *CreateJobAsChild(JobFunction jobFunction, Job *parent);
 
         template <typename Data>
-        Job *CreateJob(JobFunction jobFunction, const Data &data);
+        Job *CreateJob(JobFunction jobFunction, const Data &data)
+        {
+            return CreateJobAsChild(jobFunction, data, nullptr);
+        }
+
+        // Data too large for the job is copied to the frame arena, returns nullptr if either is full.
         template <typename Data>
-        Job *CreateJobAsChild(JobFunction jobFunction, const Data &data, Job *parent);
+        Job *CreateJobAsChild(JobFunction jobFunction, const Data &data, Job *parent)
+        {
+            if constexpr (Job::StoresDataInline<Data>())
+            {
+                Job *job = CreateJobAsChild(jobFunction, parent);
+
+                if (job != nullptr)
+                {
+                    job->SetData(data);
+                }
+
+                return job;
+            }
+            else
+            {
+                void *dataCopy = arena != nullptr ? arena->Allocate(sizeof(Data), alignof(Data)) : nullptr;
+                if (dataCopy == nullptr)
+                {
+                    return nullptr;
+                }
+
+                Job *job = CreateJobAsChild(jobFunction, parent);
+
+                if (job != nullptr)
+                {
+                    memcpy(dataCopy, &data, sizeof(Data));
+                    job->SetDataPointer(dataCopy);
+                }
+
+                return job;
+            }
+        }
 
     private:
         std::size_t allocatedJobs;
         std::vector<Job> storage;
+        FrameArena *arena;
+        std::atomic<std::size_t> highWaterMark;
+        std::atomic<std::size_t> failedAllocations;
     };
-}
\ No newline at end of file
+}
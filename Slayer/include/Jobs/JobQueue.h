@@ -1,28 +1,58 @@
 #pragma once
 
 #include "Core/Core.h"
+#include "Core/Containers.h"
 #include "Jobs/Job.h"
 #include <atomic>
+#include <cstdint>
 
 namespace Slayer
 {
+    // Chase-Lev work-stealing deque. The owning worker pushes and pops at the bottom, other workers steal
+    // from the top. Only the last job is contended, which is settled with a CAS on the top index.
+    // The circular array grows when it is full; replaced arrays are kept until the queue is destroyed,
+    // because a thief may still be reading from one.
     class JobQueue
     {
     private:
+        struct Buffer
+        {
+            int64_t mask;
+            Unique<std::atomic<Job*>[]> slots;
+
+            Buffer(int64_t capacity)
+                : mask(capacity - 1), slots(new std::atomic<Job*>[capacity]) {}
+
+            Job* Get(int64_t index) const { return slots[index & mask].load(std::memory_order_relaxed); }
+            void Put(int64_t index, Job* job) { slots[index & mask].store(job, std::memory_order_relaxed); }
+        };
+
+        Buffer* Grow(Buffer* buffer, int64_t bottom, int64_t top);
+
     public:
-        JobQueue(std::size_t maxJobs);
+        JobQueue(std::size_t capacity);
         JobQueue();
         ~JobQueue() = default;
 
+        // Only called by the owning worker.
         void Push(Job* job);
         Job* Pop();
+        // Can be called from any thread.
         Job* Steal();
+
+        // Only called while no other thread uses the queue.
         void Clear() { m_bottom = m_top = 0; }
-        size_t Size() const { return m_bottom - m_top; }
+        size_t Size() const
+        {
+            const int64_t size = m_bottom.load() - m_top.load();
+            return size > 0 ? (size_t)size : 0;
+        }
 
     private:
-        std::atomic_int m_bottom;
-        std::atomic_int m_top;
-        Vector<Job*> m_jobs;
+        // Kept on separate cache lines, the owner writes the bottom and thieves the top
+        alignas(64) std::atomic<int64_t> m_top;
+        alignas(64) std::atomic<int64_t> m_bottom;
+        std::atomic<Buffer*> m_buffer;
+        Vector<Unique<Buffer>> m_buffers;
     };
-}
\ No newline at end of file
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "Jobs/ThreadTopology.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Slayer
+{
+    // Where a closure pushed through JobSystem runs. Frame jobs run on the workers between the jobs of the frame,
+    // IO, background and loading jobs on threads of their own, so that slow loads never hold up a frame. The
+    // loading lane has a thread per core by default, for CPU heavy loading work such as decompressing assets.
+    enum class JobLane
+    {
+        Frame,
+        IO,
+        Background,
+        Loading
+    };
+
+    // Thread topology of the scheduler and the sizes of the job allocators of every worker. The pools and frame
+    // arenas are reset at every frame boundary, so they only have to hold the jobs of the worst frame, see
+    // ThreadManager::GetJobStats.
+    struct JobSettings
+    {
+        // Workers including the one on the main thread, 0 for one per core
+        uint32_t workerCount = 0;
+        uint32_t ioThreads = 1;
+        uint32_t backgroundThreads = 1;
+        // 0 for one per core, the threads run at low priority so that they only take the time the workers leave
+        uint32_t loadingThreads = 0;
+        // Pins worker i, the main thread being worker 0, to core i. IO, background and loading threads are then
+        // kept on the cores left over, if there are any.
+        bool pinWorkers = false;
+        ThreadPriority workerPriority = ThreadPriority::Normal;
+        ThreadPriority ioPriority = ThreadPriority::Low;
+        ThreadPriority backgroundPriority = ThreadPriority::Low;
+        ThreadPriority loadingPriority = ThreadPriority::Low;
+
+        std::size_t jobsPerWorker = 4096;
+        // Fiber mode: jobs each fiber can allocate
+        std::size_t jobsPerFiber = 512;
+        // Bytes for the data of jobs that does not fit in the job itself
+        std::size_t frameArenaSize = 64 * 1024;
+        // With fibers, jobs that wait park their fiber instead of running other jobs on top of their stack.
+        bool useFibers = false;
+    };
+
+    // Allocator telemetry, the high-water marks are the most in use at once since the pools were created.
+    struct JobStats
+    {
+        std::size_t jobHighWaterMark = 0;
+        std::size_t fiberJobHighWaterMark = 0;
+        std::size_t frameArenaHighWaterMark = 0;
+        // Jobs and job data that did not fit, creating them returned nullptr
+        std::size_t failedAllocations = 0;
+    };
+}
@@ -1,5 +1,9 @@
 #pragma once
-#include <functional>
+#include "Jobs/JobClosure.h"
+#include "Jobs/JobSettings.h"
+
+#include <algorithm>
+#include <cstdint>
 
 namespace Slayer
 {
@@ -10,13 +14,56 @@ namespace Slayer
         uint32_t groupIndex;
     };
 
+    // Closures on the lanes of the engine's ThreadManager. Without a ThreadManager, jobs run on the calling thread.
     namespace JobSystem
     {
-        void Initialize();
-        void Execute(const std::function<void()>& job);
-        void Dispatch(uint32_t jobCount, uint32_t groupSize, const std::function<void(JobDispatchArgs)>& job);
-        bool IsBusy();
-        void Wait();
+        // Queues a job without allocating. Runs queued jobs on the calling thread while the queue is full.
+        void Push(JobClosure&& job, JobLane lane = JobLane::Frame);
+        bool IsBusy(JobLane lane = JobLane::Frame);
+        // Runs queued jobs of the lane on the calling thread, then sleeps until every job of the lane has finished.
+        void Wait(JobLane lane = JobLane::Frame);
+
+        // The job is stored inline in the queue, so it can capture at most JobClosure::Capacity bytes.
+        template <typename F>
+        void Execute(F&& job, JobLane lane = JobLane::Frame)
+        {
+            Push(JobClosure(std::forward<F>(job)), lane);
+        }
+
+        // Calls job(JobDispatchArgs) for every index below jobCount, in groups of groupSize indices per job.
+        // Every group holds a copy of the job, so it can capture a few bytes less than a job passed to Execute.
+        template <typename F>
+        void Dispatch(uint32_t jobCount, uint32_t groupSize, const F& job, JobLane lane = JobLane::Frame)
+        {
+            if (jobCount == 0 || groupSize == 0)
+            {
+                return;
+            }
+
+            // Calculate the amount of job groups to dispatch (overestimate, or "ceil"):
+            const uint32_t groupCount = (jobCount + groupSize - 1) / groupSize;
+
+            for (uint32_t groupIndex = 0; groupIndex < groupCount; ++groupIndex)
+            {
+                // For each group, generate one real job:
+                Push(JobClosure([jobCount, groupSize, job, groupIndex]() {
+
+                    // Calculate the current group's offset into the jobs:
+                    const uint32_t groupJobOffset = groupIndex * groupSize;
+                    const uint32_t groupJobEnd = std::min(groupJobOffset + groupSize, jobCount);
+
+                    JobDispatchArgs args;
+                    args.groupIndex = groupIndex;
+
+                    // Inside the group, loop through all job indices and execute job for each index:
+                    for (uint32_t i = groupJobOffset; i < groupJobEnd; ++i)
+                    {
+                        args.jobIndex = i;
+                        job(args);
+                    }
+                }), lane);
+            }
+        }
     }
 
 } // namespace Slayer
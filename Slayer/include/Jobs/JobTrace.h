@@ -0,0 +1,69 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+// Compiles the recording out of the scheduler when 0. When 1, a disabled trace costs one relaxed load per event.
+#ifndef SL_JOB_TRACE_ENABLED
+#define SL_JOB_TRACE_ENABLED 1
+#endif
+
+// SL_JOB_TRACE(type[, data[, extra]]) records an event of the given EventType
+#if SL_JOB_TRACE_ENABLED
+#define SL_JOB_TRACE(...) do { if (Slayer::JobTrace::IsEnabled()) Slayer::JobTrace::Record(Slayer::JobTrace::EventType::__VA_ARGS__); } while (0)
+#else
+#define SL_JOB_TRACE(...) do {} while (0)
+#endif
+
+namespace Slayer
+{
+    // Timeline of the scheduler, for profiling where Optick cannot run. Every thread records into a ring buffer
+    // of its own without locks, the oldest events are overwritten once it is full. The rings can be written out
+    // as Chrome trace_event JSON, which chrome://tracing and the Perfetto UI open.
+    namespace JobTrace
+    {
+        enum class EventType : uint32_t
+        {
+            // Spans, the begin and end of one span share their data
+            JobBegin,
+            JobEnd,
+            LaneJobBegin,
+            LaneJobEnd,
+            IdleBegin,
+            // Extra is the number of failed steal attempts while idle
+            IdleEnd,
+            SleepBegin,
+            SleepEnd,
+            // Data is the fiber, a parked fiber's span overlaps the jobs the worker runs meanwhile
+            ParkBegin,
+            ParkEnd,
+            // Data is the index of the victim
+            Steal,
+            // Data is the depth, extra is the name of a lane or null for the worker's own queue
+            QueueDepth,
+            // Data is the frame index
+            Frame
+        };
+
+        extern std::atomic<bool> enabled;
+
+        inline bool IsEnabled() { return enabled.load(std::memory_order_relaxed); }
+        // Threads that record their first event get a ring of the given number of events, a power of two.
+        void Enable(size_t eventsPerThread = 1 << 16);
+        // Does not wait for threads that are recording an event at the time, they may still add it.
+        void Disable();
+
+        void Record(EventType type, uint64_t data = 0, uint64_t extra = 0);
+        // Name of the calling thread in the trace.
+        void NameThread(const char* name);
+        void MarkFrame(uint64_t frameIndex);
+
+        // Writes the events from the start of firstFrame until the start of the frame after lastFrame. The
+        // threads should be idle, events overwritten while writing are left out.
+        void WriteChromeTrace(std::ostream& stream, uint64_t firstFrame = 0, uint64_t lastFrame = UINT64_MAX);
+        bool WriteChromeTrace(const std::string& path, uint64_t firstFrame = 0, uint64_t lastFrame = UINT64_MAX);
+    }
+}
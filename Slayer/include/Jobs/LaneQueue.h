@@ -0,0 +1,57 @@
+#pragma once
+
+#include "Core/Core.h"
+#include "Core/Containers.h"
+#include "Jobs/JobClosure.h"
+#include "Jobs/MPMCQueue.h"
+#include "Jobs/ThreadTopology.h"
+
+#include <atomic>
+#include <thread>
+
+namespace Slayer
+{
+    // Closures pushed from any thread and run by the threads of the lane, or by the workers for the frame lane,
+    // which has no threads of its own. Counts the closures that have not finished, so that a lane can be waited on.
+    class LaneQueue
+    {
+    private:
+        MPMCQueue<JobClosure> m_queue;
+        const char* m_name;
+        Vector<std::thread> m_threads;
+        std::atomic<bool> m_running = false;
+        // Bumped to wake sleeping threads, who wait on its address
+        std::atomic<uint32_t> m_wakeEpoch = 0;
+        std::atomic<uint32_t> m_sleepingThreads = 0;
+        // Pushed closures that have not finished, threads in Wait sleep on it
+        std::atomic<uint32_t> m_pendingClosures = 0;
+        std::atomic<uint32_t> m_waitingThreads = 0;
+
+        void Run(uint32_t index, ThreadPriority priority, uint64_t coreMask);
+        void Sleep();
+
+    public:
+        // The name has to outlive the lane, it names the threads and the queue in traces.
+        LaneQueue(size_t capacity, const char* name);
+        ~LaneQueue() { Stop(); }
+
+        LaneQueue(const LaneQueue&) = delete;
+        LaneQueue& operator=(const LaneQueue&) = delete;
+
+        // Starts threads named "<name> <index>" that run the closures with the given priority on the given cores.
+        void Start(uint32_t threadCount, ThreadPriority priority, uint64_t coreMask);
+        // Joins the threads once they have run every queued closure.
+        void Stop();
+
+        // Runs queued closures on the calling thread while the queue is full, and wakes a thread of the lane.
+        void Push(JobClosure&& closure);
+        // Runs one queued closure on the calling thread, returns false if there was none.
+        bool RunPending();
+        // Runs queued closures on the calling thread, then sleeps until every pushed closure has finished.
+        void Wait();
+
+        bool IsBusy() const { return m_pendingClosures.load() > 0; }
+        bool HasQueued() const { return m_queue.Size() > 0; }
+        uint32_t GetThreadCount() const { return (uint32_t)m_threads.size(); }
+    };
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "Core/Core.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace Slayer
+{
+    // Bounded multi-producer multi-consumer queue without locks. Every cell has a sequence number that tells
+    // producers and consumers whose turn it is, so each side only contends on its own position counter.
+    // The capacity must be a power of two.
+    template <typename T>
+    class MPMCQueue
+    {
+    private:
+        struct Cell
+        {
+            std::atomic<size_t> sequence;
+            T value;
+        };
+
+        Unique<Cell[]> m_cells;
+        size_t m_mask = 0;
+
+        // Kept on separate cache lines, producers only write the first and consumers the second
+        alignas(64) std::atomic<size_t> m_enqueuePosition = 0;
+        alignas(64) std::atomic<size_t> m_dequeuePosition = 0;
+
+    public:
+        explicit MPMCQueue(size_t capacity)
+            : m_cells(std::make_unique<Cell[]>(capacity)), m_mask(capacity - 1)
+        {
+            SL_ASSERT(capacity >= 2 && (capacity & (capacity - 1)) == 0 && "Capacity must be a power of two.");
+            for (size_t i = 0; i < capacity; i++)
+                m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+
+        MPMCQueue(const MPMCQueue&) = delete;
+        MPMCQueue& operator=(const MPMCQueue&) = delete;
+
+        // Returns false if the queue is full, the value is left untouched then.
+        bool TryPush(T&& value)
+        {
+            size_t position = m_enqueuePosition.load(std::memory_order_relaxed);
+            Cell* cell;
+            while (true)
+            {
+                cell = &m_cells[position & m_mask];
+                const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+                const intptr_t difference = (intptr_t)sequence - (intptr_t)position;
+                if (difference == 0)
+                {
+                    if (m_enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                        break;
+                }
+                else if (difference < 0)
+                {
+                    return false;
+                }
+                else
+                {
+                    position = m_enqueuePosition.load(std::memory_order_relaxed);
+                }
+            }
+
+            cell->value = std::move(value);
+            cell->sequence.store(position + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Returns false if the queue is empty.
+        bool TryPop(T& value)
+        {
+            size_t position = m_dequeuePosition.load(std::memory_order_relaxed);
+            Cell* cell;
+            while (true)
+            {
+                cell = &m_cells[position & m_mask];
+                const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+                const intptr_t difference = (intptr_t)sequence - (intptr_t)(position + 1);
+                if (difference == 0)
+                {
+                    if (m_dequeuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                        break;
+                }
+                else if (difference < 0)
+                {
+                    return false;
+                }
+                else
+                {
+                    position = m_dequeuePosition.load(std::memory_order_relaxed);
+                }
+            }
+
+            value = std::move(cell->value);
+            cell->sequence.store(position + m_mask + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Pushed values that are not popped yet, or being pushed. Only exact when no other thread uses the queue.
+        size_t Size() const
+        {
+            const size_t enqueued = m_enqueuePosition.load();
+            const size_t dequeued = m_dequeuePosition.load();
+            return enqueued > dequeued ? enqueued - dequeued : 0;
+        }
+
+        size_t Capacity() const { return m_mask + 1; }
+    };
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "Core/Core.h"
+#include "Jobs/ThreadManager.h"
+
+#include <algorithm>
+#include <type_traits>
+
+namespace Slayer
+{
+    // Calls func(rangeBegin, rangeEnd) for consecutive ranges of at most grainSize indices that together cover
+    // [begin, end), on the worker pool, and returns when every range is done. The calling thread works on the
+    // ranges while it waits. Outside the worker pool, or for a single range, everything runs on the calling thread.
+    template <typename Func>
+    void ParallelFor(uint32_t begin, uint32_t end, uint32_t grainSize, Func&& func)
+    {
+        using FuncType = std::remove_reference_t<Func>;
+        struct RangeJobData
+        {
+            FuncType* func;
+            uint32_t begin;
+            uint32_t end;
+        };
+
+        SL_ASSERT(grainSize > 0 && "Grain size must be larger than zero.");
+        if (begin >= end)
+            return;
+
+        ThreadManager* threadManager = ThreadManager::Get();
+        Worker* worker = threadManager != nullptr ? threadManager->GetCurrentWorker() : nullptr;
+        if (worker == nullptr || end - begin <= grainSize)
+        {
+            func(begin, end);
+            return;
+        }
+
+        JobPool& pool = worker->Pool();
+        const size_t marker = pool.GetMarker();
+        Job* root = pool.CreateJob([](Job&) {});
+        SL_ASSERT(root != nullptr && "Job pool exhausted.");
+
+        for (uint32_t rangeBegin = begin; rangeBegin < end; )
+        {
+            const RangeJobData data = { &func, rangeBegin, rangeBegin + std::min(grainSize, end - rangeBegin) };
+            rangeBegin = data.end;
+            Job* job = pool.CreateJobAsChild([](Job& job)
+                {
+                    const RangeJobData data = job.GetDataCopy<RangeJobData>();
+                    (*data.func)(data.begin, data.end);
+                }, data, root);
+
+            if (job != nullptr)
+                worker->Submit(job);
+            else
+                func(data.begin, data.end);
+        }
+
+        worker->Submit(root);
+        worker->Wait(root);
+
+        // Every job allocated above has finished, their slots can be reused
+        pool.Rewind(marker);
+    }
+}
@@ -2,26 +2,74 @@
 
 #include "Slayer.h"
 #include "Jobs/Worker.h"
+#include "Jobs/LaneQueue.h"
+
+#define SL_MAX_WORKERS 64
+// Closures each lane can queue before pushing runs them on the pushing thread
+#define SL_LANE_CAPACITY 4096
 
 namespace Slayer
 {
+    // The engine's scheduler. Work-stealing workers run the jobs of the frame, the calling thread of Initialize
+    // being the first of them, and closures pushed to the frame lane. IO, background and loading lanes have
+    // threads of their own, which can be kept off the cores of the workers.
     class ThreadManager
     {
     private:
         static ThreadManager* instance;
         std::vector<std::unique_ptr<Worker>> workers;
+        LaneQueue frameLane{ SL_LANE_CAPACITY, "Frame lane" };
+        LaneQueue ioLane{ SL_LANE_CAPACITY, "IO lane" };
+        LaneQueue backgroundLane{ SL_LANE_CAPACITY, "Background lane" };
+        LaneQueue loadingLane{ SL_LANE_CAPACITY, "Loading lane" };
+        // Bumped to wake sleeping workers, who wait on its address
+        std::atomic<uint32_t> wakeEpoch = 0;
+        std::atomic<uint32_t> sleepingWorkers = 0;
+        // Failed allocations already warned about
+        std::size_t reportedFailures = 0;
+        uint64_t frameIndex = 0;
     public:
         ThreadManager() = default;
-        ~ThreadManager() = default;
+        ~ThreadManager() { Shutdown(); }
 
-        bool Initialize();
+        bool Initialize(const JobSettings& settings);
+        bool Initialize(bool useFibers = false);
         void Shutdown();
         void Run();
 
         Job* CreateJob(JobFunction function);
 
-        Worker* GetRandomWorker();
+        // Queues a closure on a lane. A lane without threads hands its closures to the frame lane.
+        void Push(JobClosure&& closure, JobLane lane = JobLane::Frame);
+        // Runs queued closures of the lane on the calling thread, then sleeps until the lane is idle.
+        void Wait(JobLane lane = JobLane::Frame);
+        bool IsBusy(JobLane lane = JobLane::Frame);
+        // Runs one closure of the frame lane, workers call it when their queues are empty.
+        bool RunFrameLaneJob() { return frameLane.RunPending(); }
+        bool HasFrameLaneJobs() const { return frameLane.HasQueued(); }
+        LaneQueue& GetLane(JobLane lane);
+
+        Worker* GetWorker(size_t index) { return workers[index].get(); }
         Worker* FindThreadWorker(const std::thread::id threadId);
+        // Returns the worker bound to the calling thread, or nullptr if the thread is not part of the pool
+        Worker* GetCurrentWorker() { return FindThreadWorker(std::this_thread::get_id()); }
+        // Returns the index of the worker bound to the calling thread, or -1 if the thread is not part of the pool
+        int32_t GetCurrentWorkerIndex() const;
+        size_t GetWorkerCount() const { return workers.size(); }
+
+        // Puts the calling worker to sleep until a job is submitted or the worker is stopped.
+        void WaitForJobs(const Worker& worker);
+        // Wakes a sleeping worker after a job was pushed, or every worker.
+        void NotifyJobs(bool all = false);
+        bool HasQueuedJobs() const;
+
+        // Called by the engine loop at the start of every frame, when no jobs are in flight. Resets the job pools
+        // and frame arenas of every worker and warns if allocations failed during the previous frame.
+        void BeginFrame();
+        // Telemetry of every worker's allocators, only consistent while no jobs are in flight.
+        JobStats GetJobStats() const;
+        // Frames begun so far
+        uint64_t GetFrameIndex() const { return frameIndex; }
 
         static ThreadManager* Get() { return instance; }
     };
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+
+namespace Slayer
+{
+    enum class ThreadPriority
+    {
+        Low,
+        Normal,
+        High
+    };
+
+    // Configures the calling thread. Every function returns false where the platform does not support it or
+    // denies it, raising the priority usually needs elevated rights, and the thread is left as it was.
+    namespace ThreadTopology
+    {
+        uint32_t GetCoreCount();
+        // Names longer than 15 characters are cut on Linux.
+        bool SetName(const char* name);
+        // Bit i of the mask allows core i, an empty mask leaves the affinity as it is.
+        bool SetAffinity(uint64_t coreMask);
+        bool SetPriority(ThreadPriority priority);
+    }
+}
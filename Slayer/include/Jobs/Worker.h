@@ -1,14 +1,25 @@
 #pragma once
 
 #include "Core/Core.h"
+#include "Core/Containers.h"
 #include "Jobs/Job.h"
 #include "Jobs/JobQueue.h"
 #include "Jobs/JobPool.h"
+#include "Jobs/Fiber.h"
+#include "Jobs/JobSettings.h"
 #include <thread>
 #include <atomic>
 
+// Fiber mode: fibers each worker can create and the stack size of each
+#define SL_FIBERS_PER_WORKER 32
+#define SL_FIBER_STACK_SIZE (256 * 1024)
+
 namespace Slayer
 {
+    // Runs jobs from its own queue and steals from the other workers when it runs out. In fiber mode every
+    // job runs on a fiber from the worker's pool, and a job that waits parks its fiber so that the worker
+    // can run other jobs on other fibers. The fiber is resumed on the same worker once the job it waits for
+    // has finished. Without fibers, a waiting job runs other jobs on its own stack.
     class Worker
     {
     public:
@@ -26,28 +37,86 @@ namespace Slayer
         };
 
     private:
+        struct JobFiber
+        {
+            Worker* worker;
+            Unique<Fiber> fiber;
+            // Jobs created by the jobs running on the fiber, rewinding them stays in order within a fiber
+            JobPool pool;
+            // Job to run when switched to
+            Job* job = nullptr;
+            // Job the fiber waits for while it is parked
+            Job* waitJob = nullptr;
+
+            JobFiber(Worker* worker);
+        };
+
         Unique<JobQueue> workQueue;
+        FrameArena frameArena;
         JobPool jobPool;
         std::thread::id threadId;
         std::thread* thread;
         std::atomic<State> state;
         std::atomic<Mode> mode;
+        uint32_t index;
+        // Cores the thread may run on, zero for any, and the priority of a background worker's thread
+        uint64_t coreMask;
+        ThreadPriority priority;
+        // Xorshift state for picking the first victim to steal from
+        uint32_t randomState;
+        // Whether the worker is in an idle span of the trace, and the steals that failed since it began
+        bool idle = false;
+        uint32_t failedSteals = 0;
+
+        bool useFibers;
+        std::size_t jobsPerFiber;
+        // Context of the worker's thread, which runs the scheduling loop and which fibers switch back to
+        Unique<Fiber> threadFiber;
+        Vector<Unique<JobFiber>> fibers;
+        Vector<JobFiber*> freeFibers;
+        Vector<JobFiber*> waitingFibers;
+        JobFiber* currentFiber = nullptr;
+
+        static void RunFiber(void* arg);
+        // Runs jobs on fibers until the job has finished, or until the worker stops if it is null
+        void Schedule(Job* until);
+        void SwitchToFiber(JobFiber* fiber);
+        bool ResumeWaitingFiber();
+        JobFiber* AcquireFiber();
 
         Job* GetJob();
+        // Runs a job from the queues or a closure of the frame lane, returns false if there was neither.
+        bool RunJob();
+        bool RunFrameLaneJob();
+        Job* StealJob();
+        // Backs off after the given number of rounds without finding a job: spins, then yields,
+        // then sleeps until a job is submitted if sleeping is allowed.
+        void Idle(uint32_t idleRounds, bool allowSleep);
+        void EndIdle();
 
     public:
-        Worker(std::size_t maxJobs, Mode mode = Mode::BACKGROUND);
+        Worker(const JobSettings& settings, uint32_t index, Mode mode = Mode::BACKGROUND, uint64_t coreMask = 0);
         ~Worker();
 
         void Run();
         void StartBackgroundWorker();
         void Start();
         void Stop();
+        void RequestStop() { state = State::STOPPING; }
         void Submit(Job* job);
+        // Returns once the job has finished, running other jobs meanwhile.
         void Wait(Job* job);
+        // Clears the pools and the frame arena, every job created from them has to have finished.
+        void ResetFrame();
+        // Adds the telemetry of this worker's pools, the high-water marks are combined with max.
+        void CollectStats(JobStats& stats) const;
 
         bool IsRunning() const { return state == State::RUNNING; }
-        const std::thread::id& Worker::GetThreadId() const { return threadId; }
-        JobPool& Pool() { return jobPool; }
+        bool HasQueuedJobs() const { return workQueue->Size() > 0; }
+        uint32_t GetIndex() const { return index; }
+        const std::thread::id& GetThreadId() const { return threadId; }
+        bool UsesFibers() const { return useFibers; }
+        // Pool to create jobs from, on a fiber it belongs to the fiber.
+        JobPool& Pool() { return currentFiber != nullptr ? currentFiber->pool : jobPool; }
     };
 }
\ No newline at end of file
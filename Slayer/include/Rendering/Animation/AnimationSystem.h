@@ -1,5 +1,6 @@
 #include "Scene/System.h"
 #include "Scene/ComponentStore.h"
+#include "Scene/Query.h"
 #include "Scene/Components.h"
 #include "Resources/ResourceManager.h"
 
@@ -9,8 +10,15 @@ namespace Slayer {
 
 	class AnimationSystem : public System<SystemGroup::SL_GROUP_ANIMATION>
 	{
+	private:
+		Query<const Transform, SkeletalRenderer, AnimationPlayer> m_animatedQuery;
+
 	public:
-		AnimationSystem() = default;
+		AnimationSystem()
+		{
+			Reads<Transform>();
+			Writes<SkeletalRenderer, AnimationPlayer>();
+		}
 		virtual ~AnimationSystem() = default;
 
 		void Initialize()
@@ -25,7 +33,7 @@ namespace Slayer {
 
 		void Update(float dt, ComponentStore& store)
 		{
-			store.ForEach<Transform, SkeletalRenderer, AnimationPlayer>([&](Entity entity, Transform* transform, SkeletalRenderer* renderer, AnimationPlayer* player)
+			m_animatedQuery.ForEach(store, [&](Entity entity, const Transform* transform, SkeletalRenderer* renderer, AnimationPlayer* player)
 				{
 					Shared<SkeletalModel> model = ResourceManager::Get()->GetAsset<SkeletalModel>(renderer->modelID);
 					AnimationState* state = &renderer->state;
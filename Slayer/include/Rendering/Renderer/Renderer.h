@@ -149,23 +149,35 @@ namespace Slayer {
 		RenderPass() = default;
 		RenderPass(Shared<Framebuffer> framebuffer, SortingFunction sortingFunction);
 
-		void Submit(const RenderJob& job)
+		Batch* GetBatch(const RenderJob& job)
 		{
-			Batch* batch = nullptr;
 			size_t hash = Batch::GetHash(job);
 			// Create a new batch if it doesn't exist
 			if (batchIndices.find(hash) == batchIndices.end())
 			{
 				batchIndices[hash] = batches.size();
-				Batch newBatch(job.vaoID, job.indexCount, job.material, job.shader, job.animationState->inverseBindPose);
+				Batch newBatch(job.vaoID, job.indexCount, job.material, job.shader, job.animationState != nullptr ? job.animationState->inverseBindPose : nullptr);
 				batches.push_back(newBatch);
-				batch = &batches.back();
+				return &batches.back();
 			}
-			else
+
+			return &batches[batchIndices[hash]];
+		}
+
+		// Adds instances of a job without animation state that only differ in their transforms,
+		// the batch is looked up once for all of them.
+		void Submit(const RenderJob& job, const Mat4* transforms, size_t count)
+		{
+			Batch* batch = GetBatch(job);
+			for (size_t i = 0; i < count; i++)
 			{
-				batch = &batches[batchIndices[hash]];
+				batch->transforms.PushBack(transforms[i]);
 			}
+		}
 
+		void Submit(const RenderJob& job)
+		{
+			Batch* batch = GetBatch(job);
 			if (job.animationState != nullptr)
 			{
 				animationStates.push_back(*job.animationState);
@@ -308,6 +320,7 @@ namespace Slayer {
 		void Submit(Shared<SkeletalModel> model, const Mat4& transform, AnimationState* animationState);
 		void Submit(Shared<SkeletalModel> model, AnimationState* animationState, Shared<Material> material, const Mat4& transform);
 		void Submit(Shared<Model> model, Shared<Material> material, const Mat4& transform);
+		void Submit(Shared<Model> model, Shared<Material> material, const Mat4* transforms, size_t count);
 		void Submit(Shared<SkeletalModel> model, Shared<Material> material, const Mat4& transform);
 		void Submit(Shared<Mesh> mesh, const Mat4& transform);
 		void SubmitQuad(Shared<Material> material, const Mat4& transform);
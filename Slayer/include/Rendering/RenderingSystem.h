@@ -2,6 +2,7 @@
 
 #include "Scene/System.h"
 #include "Scene/ComponentStore.h"
+#include "Scene/Query.h"
 #include "Scene/Components.h"
 #include "Resources/ResourceManager.h"
 
@@ -12,7 +13,25 @@ namespace Slayer {
     class RenderingSystem : public System<SystemGroup::SL_GROUP_RENDER>
     {
     public:
-        RenderingSystem() = default;
+        // Orders the renderers by model and material so that Render gets whole instance runs
+        static void SetSortKeys(ComponentStore& store)
+        {
+            store.SetSortKey<ModelRenderer>([](const ModelRenderer& renderer) { return std::make_pair(renderer.modelID, renderer.materialID); });
+            store.SetSortKey<SkeletalRenderer>([](const SkeletalRenderer& renderer) { return std::make_pair(renderer.modelID, renderer.materialID); });
+        }
+
+
+    private:
+        Query<const Transform, SkeletalRenderer> m_skeletalQuery;
+        Query<const Transform, const ModelRenderer> m_modelQuery;
+        Vector<Mat4> m_instanceTransforms;
+
+    public:
+        RenderingSystem()
+        {
+            Reads<Transform, ModelRenderer>();
+            Writes<SkeletalRenderer>();
+        }
         virtual ~RenderingSystem() = default;
 
         void Initialize()
@@ -35,20 +54,29 @@ namespace Slayer {
 
             ResourceManager* rm = ResourceManager::Get();
 
-            store.ForEach<Transform, SkeletalRenderer>([&](Entity entity, Transform* transform, SkeletalRenderer* modelRenderer)
+            // Renderers are sorted by model and material, so the assets are looked up once per run
+            m_skeletalQuery.ForEachRun(store, [&](const Entity* entities, uint32_t count, const Transform* transforms, SkeletalRenderer* modelRenderers)
                 {
-                    Shared<SkeletalModel> model = rm->GetAsset<SkeletalModel>(modelRenderer->modelID);
-                    Shared<Material> material = rm->GetAsset<Material>(modelRenderer->materialID);
-                    modelRenderer->state.inverseBindPose = model->GetInverseBindPoseMatrices();
-                    modelRenderer->state.parents = model->GetParents();
-                    renderer.Submit(model, &modelRenderer->state, material, transform->worldTransform);
+                    Shared<SkeletalModel> model = rm->GetAsset<SkeletalModel>(modelRenderers->modelID);
+                    Shared<Material> material = rm->GetAsset<Material>(modelRenderers->materialID);
+                    for (uint32_t i = 0; i < count; i++)
+                    {
+                        modelRenderers[i].state.inverseBindPose = model->GetInverseBindPoseMatrices();
+                        modelRenderers[i].state.parents = model->GetParents();
+                        renderer.Submit(model, &modelRenderers[i].state, material, transforms[i].worldTransform);
+                    }
                 });
 
-            store.ForEach<Transform, ModelRenderer>([&](Entity entity, Transform* transform, ModelRenderer* modelRenderer)
+            m_modelQuery.ForEachRun(store, [&](const Entity* entities, uint32_t count, const Transform* transforms, const ModelRenderer* modelRenderers)
                 {
-                    Shared<Model> model = rm->GetAsset<Model>(modelRenderer->modelID);
-                    Shared<Material> material = rm->GetAsset<Material>(modelRenderer->materialID);
-                    renderer.Submit(model, material, transform->worldTransform);
+                    Shared<Model> model = rm->GetAsset<Model>(modelRenderers->modelID);
+                    Shared<Material> material = rm->GetAsset<Material>(modelRenderers->materialID);
+                    m_instanceTransforms.clear();
+                    for (uint32_t i = 0; i < count; i++)
+                    {
+                        m_instanceTransforms.push_back(transforms[i].worldTransform);
+                    }
+                    renderer.Submit(model, material, m_instanceTransforms.data(), count);
                 });
         }
     };
@@ -4,29 +4,107 @@
 #include "Core/Containers.h"
 #include "Core/Math.h"
 #include "Resources/Asset.h"
+#include "Resources/MappedFile.h"
 #include "Serialization/BinarySerializer.h"
+#include "Jobs/JobSettings.h"
 
-#include <fstream>
-
-#define SL_ASSET_PACK_VERSION 1
+// Version written by the pack builder, version 1 packs are still read
+#define SL_ASSET_PACK_VERSION 2
+#define SL_ASSET_PACK_VERSION_1 1
 #define SL_ASSET_PACK_MAGIC "SLPCK"
+// Uncompressed bytes per block of a compressed asset, the pack builder writes the same
+#define SL_ASSET_PACK_BLOCK_SIZE (256 * 1024)
 
 namespace Slayer
 {
+    // Reads the fields of a pack from the mapped bytes, fails instead of reading past the end.
+    class AssetPackReader
+    {
+    private:
+        const char* m_current;
+        const char* m_end;
+    public:
+        AssetPackReader(const char* data, size_t size) : m_current(data), m_end(data + size) {}
+
+        bool Read(void* dst, size_t size)
+        {
+            if ((size_t)(m_end - m_current) < size)
+                return false;
+            Copy(m_current, dst, size);
+            m_current += size;
+            return true;
+        }
+
+        bool Skip(size_t size)
+        {
+            if ((size_t)(m_end - m_current) < size)
+                return false;
+            m_current += size;
+            return true;
+        }
+
+        const char* GetCurrent() const { return m_current; }
+    };
+
+    // Starts every pack. Version 1 packs follow it with the header and data of each asset in turn. Version 2 packs
+    // add the fields below, the table of contents and the names sit in front of the data, which is aligned.
     struct AssetPackHeader
     {
         char magic[6];
         uint32_t version;
         uint32_t numAssets;
+        // Version 2
+        uint16_t flags = 0;
+        uint32_t namesSize = 0;
+        uint64_t tocOffset = 0;
+        uint64_t namesOffset = 0;
 
-        void Read(std::ifstream& stream)
+        bool Read(AssetPackReader& reader)
         {
-            stream.read(magic, 6);
-            stream.read((char*)&version, sizeof(uint32_t));
-            stream.read((char*)&numAssets, sizeof(uint32_t));
+            if (!reader.Read(magic, 6) || !reader.Read(&version, sizeof(uint32_t)) || !reader.Read(&numAssets, sizeof(uint32_t)))
+                return false;
+            if (version == SL_ASSET_PACK_VERSION_1)
+                return true;
+            return reader.Read(&flags, sizeof(uint16_t)) && reader.Read(&namesSize, sizeof(uint32_t))
+                && reader.Read(&tocOffset, sizeof(uint64_t)) && reader.Read(&namesOffset, sizeof(uint64_t));
         }
     };
 
+    // Compressed assets are split into blocks that decompress independently, so that one large asset is
+    // decompressed by several threads. The data starts with the uncompressed size of a block, the number of blocks
+    // and the compressed size of each block as uint32, followed by the blocks. Only the last block is shorter.
+    enum class AssetCompression : uint8_t
+    {
+        None = 0,
+        LZ4 = 1,
+    };
+
+    // Entry of the version 2 table of contents, which is sorted by id
+    struct AssetTocEntry
+    {
+        AssetID id;
+        // Offset of the data from the start of the pack, a multiple of the alignment
+        uint64_t dataOffset;
+        uint32_t dataLength;
+        // Length of the data once decompressed, the same as dataLength when it is stored as is
+        uint32_t uncompressedLength;
+        // FNV-1a of the name
+        uint32_t nameHash;
+        // Offset of the name in the names of the pack
+        uint32_t nameOffset;
+        // CRC-32 of the data as stored
+        uint32_t checksum;
+        AssetType type;
+        uint16_t alignment;
+        uint16_t nameLength;
+        uint8_t compression;
+        uint8_t reserved0;
+        uint32_t reserved1;
+    };
+
+    static_assert(sizeof(AssetTocEntry) == 48, "The table of contents is read as is.");
+
+    // Version 1 header in front of the data of each asset
     struct AssetHeader
     {
         AssetID id;
@@ -34,15 +112,17 @@ namespace Slayer
         uint32_t dataLength;
         std::string name;
 
-        void Read(std::ifstream& stream)
+        bool Read(AssetPackReader& reader)
         {
-            stream.read((char*)&id, sizeof(AssetID));
-            stream.read((char*)&type, sizeof(AssetType));
             uint32_t nameLength;
-            stream.read((char*)&nameLength, sizeof(uint32_t));
-            name.resize(nameLength);
-            stream.read(name.data(), nameLength);
-            stream.read((char*)&dataLength, sizeof(uint32_t));
+            if (!reader.Read(&id, sizeof(AssetID)) || !reader.Read(&type, sizeof(AssetType)) || !reader.Read(&nameLength, sizeof(uint32_t)))
+                return false;
+
+            const char* nameData = reader.GetCurrent();
+            if (!reader.Skip(nameLength))
+                return false;
+            name.assign(nameData, nameLength);
+            return reader.Read(&dataLength, sizeof(uint32_t));
         }
 
         uint32_t GetSize() const
@@ -56,47 +136,145 @@ namespace Slayer
         AssetID id;
         AssetType type;
         std::string name;
+        // Length of the data as stored
         uint32_t dataLength;
-        uint32_t dataIndex;
-
-        void Read(std::ifstream& stream)
-        {
-            stream.read((char*)&id, sizeof(AssetID));
-            stream.read((char*)&type, sizeof(AssetType));
-            stream.read((char*)&dataLength, sizeof(uint32_t));
-            stream.read((char*)&dataIndex, sizeof(uint32_t));
-        }
+        // Offset of the data from the start of the pack
+        uint64_t dataOffset;
+        // Zero for version 1 packs, which have no checksums
+        uint32_t checksum = 0;
+        uint32_t uncompressedLength = 0;
+        AssetCompression compression = AssetCompression::None;
     };
 
+    // A pack mapped into memory, loading only reads the table of contents, or the asset headers of a version 1 pack.
+    // Asset data is read in by the OS when it is first touched, the View asset types and GetAssetBytes point into
+    // the mapping and must not outlive the pack.
     class AssetPack
     {
     private:
-        bool m_isLoaded;
-        std::vector<char> m_data;
+        bool m_isLoaded = false;
+        uint32_t m_version = 0;
+        MappedFile m_file;
         Dict<std::string, AssetID> m_assetNames;
         Dict<AssetID, AssetRecord> m_assets;
+        // Data of the compressed assets that have been decompressed
+        Dict<AssetID, Vector<char>> m_decompressed;
         BinaryDeserializer deserializer;
+
+        struct CompressedBlock
+        {
+            const char* src;
+            uint32_t srcLength;
+            char* dst;
+            uint32_t dstLength;
+            // Index of the asset among the ones being decompressed
+            uint32_t asset = 0;
+        };
+
+        // Allocates the buffer of a compressed asset and appends its blocks. Returns false if the block table is corrupt,
+        // leaving blocks and the decompressed buffers as they were.
+        bool PrepareBlocks(const AssetRecord& record, Vector<CompressedBlock>& blocks);
+
+        bool LoadVersion1(AssetPackReader& reader, const AssetPackHeader& header);
+        bool LoadVersion2(const AssetPackHeader& header);
+        void AddRecord(AssetRecord&& record);
     public:
         AssetPack() = default;
         ~AssetPack() = default;
 
+        AssetPack(const AssetPack&) = delete;
+        AssetPack& operator=(const AssetPack&) = delete;
+
+        // A pack that is corrupt or of an unsupported version is logged and left unloaded, see IsLoaded.
         void Load(const std::string& path);
         void Save(const std::string& path);
 
         bool IsLoaded() const { return m_isLoaded; }
+        uint32_t GetVersion() const { return m_version; }
         const Dict<AssetID, AssetRecord>& GetAssets() const { return m_assets; }
 
+        // Returns null if the pack has no such asset.
+        const AssetRecord* FindAsset(const AssetID& id) const
+        {
+            auto it = m_assets.find(id);
+            return it != m_assets.end() ? &it->second : nullptr;
+        }
+
+        const AssetRecord* FindAsset(const std::string& name) const
+        {
+            auto it = m_assetNames.find(name);
+            return it != m_assetNames.end() ? FindAsset(it->second) : nullptr;
+        }
+
+        bool IsDecompressed(const AssetID& id) const
+        {
+            const AssetRecord* record = FindAsset(id);
+            SL_ASSERT(record && "Asset not found!");
+            return record->compression == AssetCompression::None || m_decompressed.find(id) != m_decompressed.end();
+        }
+
+        // Decompresses one asset on the calling thread.
+        bool DecompressAsset(const AssetID& id);
+        // Decompresses every compressed asset with a job per block on the given lane, the calling thread helps and
+        // waits. Returns false if an asset is corrupt, the other assets are decompressed regardless.
+        bool DecompressAssets(JobLane lane = JobLane::Loading);
+
+        // The data of the asset, which has to be decompressed first if it is compressed. Empty if it is not.
+        PackedSpan<char> GetAssetBytes(const AssetID& id) const
+        {
+            const AssetRecord* record = FindAsset(id);
+            SL_ASSERT(record && "Asset not found!");
+            if (record == nullptr)
+                return PackedSpan<char>();
+            if (record->compression == AssetCompression::None)
+                return PackedSpan<char>(m_file.Data() + record->dataOffset, record->dataLength);
+
+            auto it = m_decompressed.find(id);
+            SL_ASSERT(it != m_decompressed.end() && "Asset has not been decompressed!");
+            if (it == m_decompressed.end())
+                return PackedSpan<char>();
+            return PackedSpan<char>(it->second.data(), it->second.size());
+        }
+
+        // Compares the data of the asset as stored with its checksum, which reads all of it. Always true for version 1 packs.
+        bool VerifyAsset(const AssetID& id) const;
+
+        // FNV-1a of an asset name, as in the table of contents.
+        static uint32_t HashName(const char* name, size_t length);
+        // CRC-32 as in zlib, which the pack builder uses.
+        static uint32_t Checksum(const char* data, size_t length);
+
+        // Decompresses the asset first if needed. Returns false and leaves data as is if the asset is missing or
+        // cannot be decompressed.
         template<typename T>
-        T GetAssetData(const AssetID& id)
+        bool GetAssetData(const AssetID& id, T& data)
         {
-            SL_ASSERT(m_assets.find(id) != m_assets.end() && "Asset not found!");
+            const AssetRecord* record = FindAsset(id);
+            if (record == nullptr)
+            {
+                Log::Error("Asset not found:", id);
+                return false;
+            }
 
-            const AssetRecord& record = m_assets.at(id);
-            const char* dataPtr = m_data.data() + record.dataIndex;
+            if (!IsDecompressed(id) && !DecompressAsset(id))
+            {
+                Log::Error("Failed to decompress asset:", record->name);
+                return false;
+            }
+
+            const PackedSpan<char> bytes = GetAssetBytes(id);
+            deserializer.Deserialize(data, (const char*)bytes.Data(), bytes.Size());
+            return true;
+        }
+
+        // As above, a default constructed asset is returned on failure.
+        template<typename T>
+        T GetAssetData(const AssetID& id)
+        {
             T data;
-            deserializer.Deserialize(data, dataPtr, record.dataLength);
+            GetAssetData(id, data);
             return data;
         }
     };
 
-}
\ No newline at end of file
+}
@@ -9,16 +9,19 @@
 
 namespace Slayer
 {
-    struct TextureAsset
+    // Assets with packed arrays are templates over the array type. The Vector instantiations own a copy of
+    // the arrays, the PackedSpan ones, named ...View, point into the asset pack and must not outlive it.
+    template<template<typename> class PackedArray>
+    struct BasicTextureAsset
     {
         uint32_t width = 0;
         uint32_t height = 0;
         uint32_t channels = 0;
         uint32_t target = 0;
-        Vector<uint8_t> data = {};
+        PackedArray<uint8_t> data = {};
 
-        TextureAsset() = default;
-        ~TextureAsset() = default;
+        BasicTextureAsset() = default;
+        ~BasicTextureAsset() = default;
 
         template<typename Serializer>
         void Transfer(Serializer& serializer)
@@ -31,6 +34,9 @@ namespace Slayer
         }
     };
 
+    using TextureAsset = BasicTextureAsset<Vector>;
+    using TextureAssetView = BasicTextureAsset<PackedSpan>;
+
     struct ShaderAsset
     {
         std::string vsSource = "";
@@ -86,13 +92,14 @@ namespace Slayer
         ~MaterialAsset() = default;
     };
 
-    struct ModelAsset
+    template<template<typename> class PackedArray>
+    struct BasicModelAsset
     {
         // Next is a map of texture names to texture ids.
         struct MeshAsset
         {
-            Vector<float> vertices = {};
-            Vector<uint32_t> indices = {};
+            PackedArray<float> vertices = {};
+            PackedArray<uint32_t> indices = {};
 
             MeshAsset() = default;
             ~MeshAsset() = default;
@@ -107,8 +114,8 @@ namespace Slayer
 
         Vector<MeshAsset> meshes = {};
 
-        ModelAsset() = default;
-        ~ModelAsset() = default;
+        BasicModelAsset() = default;
+        ~BasicModelAsset() = default;
 
         template<typename Serializer>
         void Transfer(Serializer& serializer)
@@ -117,6 +124,9 @@ namespace Slayer
         }
     };
 
+    using ModelAsset = BasicModelAsset<Vector>;
+    using ModelAssetView = BasicModelAsset<PackedSpan>;
+
     struct Bone
     {
         std::string name = "";
@@ -148,13 +158,14 @@ namespace Slayer
     };
 #pragma pack(pop)
 
-    struct SkeletalModelAsset
+    template<template<typename> class PackedArray>
+    struct BasicSkeletalModelAsset
     {
         struct SkeletalMesh
         {
 
-            Vector<SkeletalMeshVertex> vertices = {};
-            Vector<uint32_t> indices = {};
+            PackedArray<SkeletalMeshVertex> vertices = {};
+            PackedArray<uint32_t> indices = {};
             Vector<Bone> bones = {};
             Mat4 globalInverseTransform = Mat4(1.0f);
 
@@ -178,17 +189,21 @@ namespace Slayer
             SL_TRANSFER_VEC(sockets);
         }
 
-        SkeletalModelAsset() = default;
-        ~SkeletalModelAsset() = default;
+        BasicSkeletalModelAsset() = default;
+        ~BasicSkeletalModelAsset() = default;
     };
 
-    struct AnimationAsset
+    using SkeletalModelAsset = BasicSkeletalModelAsset<Vector>;
+    using SkeletalModelAssetView = BasicSkeletalModelAsset<PackedSpan>;
+
+    template<template<typename> class PackedArray>
+    struct BasicAnimationAsset
     {
         float duration = 0.0f;
         float ticksPerSecond = 0.0f;
         uint32_t numChannels = 0;
-        Vector<float> times = {};
-        Vector<float> data = {};
+        PackedArray<float> times = {};
+        PackedArray<float> data = {};
 
         template<typename Serializer>
         void Transfer(Serializer& serializer)
@@ -201,4 +216,6 @@ namespace Slayer
         }
     };
 
+    using AnimationAsset = BasicAnimationAsset<Vector>;
+    using AnimationAssetView = BasicAnimationAsset<PackedSpan>;
 }
\ No newline at end of file
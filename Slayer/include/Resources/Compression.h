@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Slayer
+{
+    // LZ4 block format, as written by the lz4 package the pack builder uses. Fast to decode, which matters more for
+    // packs than the ratio. Frames and dictionaries are not supported.
+    namespace Compression
+    {
+        // Largest size compressing the given number of bytes can produce.
+        size_t GetLz4Bound(size_t size);
+        // Greedy compressor for tools and tests, returns the compressed size or 0 if it did not fit.
+        size_t CompressLz4(const char* src, size_t srcSize, char* dst, size_t dstCapacity);
+        // Returns false if the block is malformed or does not decompress to exactly dstSize bytes.
+        bool DecompressLz4(const char* src, size_t srcSize, char* dst, size_t dstSize);
+    }
+}
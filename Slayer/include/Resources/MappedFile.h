@@ -0,0 +1,38 @@
+#pragma once
+
+#include "Core/Core.h"
+
+#include <string>
+
+namespace Slayer
+{
+    // Read-only view of a whole file mapped into memory. Pages are read in by the OS on first touch and
+    // are shared with the file cache, so mapping a large file costs neither a copy nor memory up front.
+    class MappedFile
+    {
+    private:
+        const char* m_data = nullptr;
+        size_t m_size = 0;
+#ifdef _WIN32
+        void* m_file = nullptr;
+        void* m_mapping = nullptr;
+#endif
+
+    public:
+        MappedFile() = default;
+        ~MappedFile() { Close(); }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+
+        // Maps the file, returns false if it cannot be opened or mapped.
+        bool Open(const std::string& path);
+        void Close();
+
+        bool IsOpen() const { return m_data != nullptr; }
+        const char* Data() const { return m_data; }
+        size_t Size() const { return m_size; }
+    };
+}
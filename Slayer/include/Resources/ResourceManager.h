@@ -22,12 +22,14 @@ namespace Slayer
     // A struct that holds all the GPU resources that need to be loaded on the GPU
     struct GPULoadData
     {
-        Vector<Tuple<TextureAsset, AssetRecord>> textures = {};
+        // The views point into the pack, which stays mapped until the data has been uploaded
+        Shared<AssetPack> assetPack = nullptr;
+        Vector<Tuple<TextureAssetView, AssetRecord>> textures = {};
         Vector<Tuple<ShaderAsset, AssetRecord>> shaders = {};
         Vector<Tuple<ComputeShaderAsset, AssetRecord>> computeShaders = {};
-        Vector<Tuple<ModelAsset, AssetRecord>> models = {};
-        Vector<Tuple<SkeletalModelAsset, AssetRecord>> skeletalModels = {};
-        Vector<Tuple<AnimationAsset, AssetRecord>> animations = {};
+        Vector<Tuple<ModelAssetView, AssetRecord>> models = {};
+        Vector<Tuple<SkeletalModelAssetView, AssetRecord>> skeletalModels = {};
+        Vector<Tuple<AnimationAssetView, AssetRecord>> animations = {};
 
         GPULoadData() = default;
         ~GPULoadData() = default;
@@ -0,0 +1,845 @@
+#pragma once
+
+#include "Core/Core.h"
+#include "Core/Containers.h"
+
+#include <new>
+#include <bit>
+#include <algorithm>
+#include <numeric>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define SL_ARCHETYPE_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SL_ARCHETYPE_SSE2 1
+#endif
+
+// Size in bytes of a single chunk of archetype storage, archetypes whose rows
+// do not fit in one chunk get a larger chunk that fits exactly one row.
+#define SL_CHUNK_SIZE (16 * 1024)
+#define SL_CHUNK_ALIGNMENT 64
+#define SL_MAX_COMPONENTS 256
+
+// Typed as an Entity so comparisons against handles do not mix signed and unsigned values.
+#define SL_INVALID_ENTITY (static_cast<Slayer::Entity>(-1))
+
+namespace Slayer
+{
+    // An entity handle holds the index of its slot in the low 32 bits and the generation of the
+    // slot in the high 32 bits. Destroying an entity bumps the generation, so old handles to a
+    // reused slot are rejected.
+    using Entity = uint64_t;
+    using ComponentType = uint32_t;
+
+    inline Entity MakeEntity(uint32_t index, uint32_t generation)
+    {
+        return (Entity(generation) << 32) | Entity(index);
+    }
+
+    inline uint32_t GetEntityIndex(Entity entity)
+    {
+        return (uint32_t)(entity & 0xFFFFFFFF);
+    }
+
+    inline uint32_t GetEntityGeneration(Entity entity)
+    {
+        return (uint32_t)(entity >> 32);
+    }
+
+    // The set of component types of an entity, one bit per component index. The words are
+    // aligned so that subset tests compare 128 or 256 bits at a time.
+    struct alignas(32) Archetype
+    {
+        static_assert(SL_MAX_COMPONENTS % 256 == 0, "SL_MAX_COMPONENTS must be a multiple of 256.");
+        static constexpr uint32_t WordCount = SL_MAX_COMPONENTS / 64;
+
+        uint64_t words[WordCount] = {};
+
+        static Archetype FromBit(uint32_t bit)
+        {
+            Archetype archetype;
+            archetype.Set(bit);
+            return archetype;
+        }
+
+        void Set(uint32_t bit)
+        {
+            SL_ASSERT(bit < SL_MAX_COMPONENTS && "Component index out of range.");
+            words[bit >> 6] |= uint64_t(1) << (bit & 63);
+        }
+
+        void Reset(uint32_t bit)
+        {
+            SL_ASSERT(bit < SL_MAX_COMPONENTS && "Component index out of range.");
+            words[bit >> 6] &= ~(uint64_t(1) << (bit & 63));
+        }
+
+        bool Test(uint32_t bit) const
+        {
+            return (words[bit >> 6] & (uint64_t(1) << (bit & 63))) != 0;
+        }
+
+        // True if every bit set in other is also set in this archetype.
+        bool Contains(const Archetype& other) const
+        {
+#if SL_ARCHETYPE_AVX2
+            for (uint32_t i = 0; i < WordCount; i += 4)
+            {
+                const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(words + i));
+                const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(other.words + i));
+                if (!_mm256_testc_si256(a, b))
+                    return false;
+            }
+            return true;
+#elif SL_ARCHETYPE_SSE2
+            __m128i missing = _mm_setzero_si128();
+            for (uint32_t i = 0; i < WordCount; i += 2)
+            {
+                const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(words + i));
+                const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(other.words + i));
+                missing = _mm_or_si128(missing, _mm_andnot_si128(a, b));
+            }
+            return _mm_movemask_epi8(_mm_cmpeq_epi8(missing, _mm_setzero_si128())) == 0xFFFF;
+#else
+            uint64_t missing = 0;
+            for (uint32_t i = 0; i < WordCount; i++)
+                missing |= other.words[i] & ~words[i];
+            return missing == 0;
+#endif
+        }
+
+        // True if any bit is set in both archetypes.
+        bool Intersects(const Archetype& other) const
+        {
+#if SL_ARCHETYPE_AVX2
+            for (uint32_t i = 0; i < WordCount; i += 4)
+            {
+                const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(words + i));
+                const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(other.words + i));
+                if (!_mm256_testz_si256(a, b))
+                    return true;
+            }
+            return false;
+#elif SL_ARCHETYPE_SSE2
+            __m128i shared = _mm_setzero_si128();
+            for (uint32_t i = 0; i < WordCount; i += 2)
+            {
+                const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(words + i));
+                const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(other.words + i));
+                shared = _mm_or_si128(shared, _mm_and_si128(a, b));
+            }
+            return _mm_movemask_epi8(_mm_cmpeq_epi8(shared, _mm_setzero_si128())) != 0xFFFF;
+#else
+            uint64_t shared = 0;
+            for (uint32_t i = 0; i < WordCount; i++)
+                shared |= other.words[i] & words[i];
+            return shared != 0;
+#endif
+        }
+
+        bool IsEmpty() const
+        {
+            return !Intersects(*this);
+        }
+
+        uint32_t Count() const
+        {
+            uint32_t count = 0;
+            for (uint32_t i = 0; i < WordCount; i++)
+                count += (uint32_t)std::popcount(words[i]);
+            return count;
+        }
+
+        // Calls func(bitIndex) for every set bit, in increasing order.
+        template <typename Func>
+        void ForEachBit(Func&& func) const
+        {
+            for (uint32_t i = 0; i < WordCount; i++)
+            {
+                uint64_t word = words[i];
+                while (word != 0)
+                {
+                    func(i * 64 + (uint32_t)std::countr_zero(word));
+                    word &= word - 1;
+                }
+            }
+        }
+
+        Archetype& operator|=(const Archetype& other)
+        {
+            for (uint32_t i = 0; i < WordCount; i++)
+                words[i] |= other.words[i];
+            return *this;
+        }
+
+        Archetype operator|(const Archetype& other) const
+        {
+            Archetype result = *this;
+            result |= other;
+            return result;
+        }
+
+        bool operator==(const Archetype& other) const
+        {
+            return Contains(other) && other.Contains(*this);
+        }
+
+        bool operator!=(const Archetype& other) const
+        {
+            return !(*this == other);
+        }
+    };
+
+    struct ArchetypeHash
+    {
+        size_t operator()(const Archetype& archetype) const noexcept
+        {
+            uint64_t hash = 14695981039346656037ull;
+            for (uint32_t i = 0; i < Archetype::WordCount; i++)
+                hash = (hash ^ archetype.words[i]) * 1099511628211ull;
+            return static_cast<size_t>(hash);
+        }
+    };
+
+    // Type-erased description of a component type, allows the chunk storage
+    // to move and destroy components without knowing their static type.
+    struct ComponentInfo
+    {
+        ComponentType type = 0;
+        uint32_t bitIndex = 0;
+        size_t size = 0;
+        size_t alignment = 0;
+        void (*moveConstruct)(void* dst, void* src) = nullptr;
+        // Null for types that cannot be copied
+        void (*copyConstruct)(void* dst, const void* src) = nullptr;
+        void (*destroy)(void* ptr) = nullptr;
+        // Trivially copyable columns are copied with memcpy by snapshots
+        bool triviallyCopyable = false;
+        // Orders two components by their sort key, null for types without one, see ComponentStore::SetSortKey
+        bool (*sortLess)(const void* a, const void* b) = nullptr;
+
+        template <typename T>
+        static ComponentInfo Create(ComponentType type, uint32_t bitIndex)
+        {
+            static_assert(alignof(T) <= SL_CHUNK_ALIGNMENT, "Component alignment is larger than the chunk alignment.");
+
+            ComponentInfo info;
+            info.type = type;
+            info.bitIndex = bitIndex;
+            info.size = sizeof(T);
+            info.alignment = alignof(T);
+            info.moveConstruct = [](void* dst, void* src) { new (dst) T(std::move(*static_cast<T*>(src))); };
+            if constexpr (std::is_copy_constructible_v<T>)
+                info.copyConstruct = [](void* dst, const void* src) { new (dst) T(*static_cast<const T*>(src)); };
+            info.destroy = [](void* ptr) { static_cast<T*>(ptr)->~T(); };
+            info.triviallyCopyable = std::is_trivially_copyable_v<T>;
+            return info;
+        }
+    };
+
+    // A fixed size block of memory holding the components of up to capacity entities,
+    // laid out as one contiguous column per component type.
+    class Chunk
+    {
+    private:
+        uint8_t* m_data = nullptr;
+        uint32_t m_size = 0;
+        // Highest change version of any row, per column
+        Vector<uint32_t> m_columnVersions;
+        // Changes whenever rows are added, removed or moved, see ArchetypeStorage::GetChunkStamp
+        uint64_t m_stamp = 0;
+
+    public:
+        Chunk(size_t bytes, size_t columns)
+            : m_columnVersions(columns, 0)
+        {
+            m_data = static_cast<uint8_t*>(::operator new(bytes, std::align_val_t(SL_CHUNK_ALIGNMENT)));
+        }
+
+        ~Chunk()
+        {
+            ::operator delete(m_data, std::align_val_t(SL_CHUNK_ALIGNMENT));
+        }
+
+        Chunk(const Chunk&) = delete;
+        Chunk& operator=(const Chunk&) = delete;
+
+        uint8_t* GetData() const { return m_data; }
+        uint32_t Size() const { return m_size; }
+        uint32_t& GetColumnVersion(uint32_t column) { return m_columnVersions[column]; }
+        uint64_t GetStamp() const { return m_stamp; }
+        void SetStamp(uint64_t stamp) { m_stamp = stamp; }
+        void SetSize(uint32_t size) { m_size = size; }
+
+        uint32_t Push() { return m_size++; }
+        uint32_t Push(uint32_t count) { const uint32_t first = m_size; m_size += count; return first; }
+        void Pop() { SL_ASSERT(m_size > 0 && "Chunk is empty."); m_size--; }
+    };
+
+    // Where an entity's components currently live.
+    struct EntityLocation
+    {
+        uint32_t chunk = 0;
+        uint32_t row = 0;
+    };
+
+    // Stores every entity that has exactly the component set described by an archetype.
+    // Entities are kept densely packed: all chunks are full except the last one, and removing
+    // an entity moves the last row into the hole.
+    // Every component keeps the change version it was last written at, next to its column.
+    class ArchetypeStorage
+    {
+    private:
+        Archetype m_archetype;
+        // Columns ordered by bit index
+        Vector<const ComponentInfo*> m_components;
+        Vector<uint32_t> m_columnOffsets;
+        Vector<uint32_t> m_versionOffsets;
+        // Maps a component bit index to its column, -1 if the component is not part of the archetype
+        Array<int16_t, SL_MAX_COMPONENTS> m_columnIndices;
+
+        uint32_t m_chunkCapacity = 0;
+        size_t m_chunkBytes = 0;
+        Vector<Unique<Chunk>> m_chunks;
+        size_t m_size = 0;
+
+        // Source of chunk stamps, unique within the storage
+        uint64_t m_lastStamp = 0;
+
+        // Rows were added or moved since the last Sort
+        bool m_orderDirty = false;
+        // Change version the rows were last sorted at, later writes to the sort column need a new sort
+        uint32_t m_sortedVersion = 0;
+
+        static size_t AlignUp(size_t value, size_t alignment)
+        {
+            return (value + alignment - 1) & ~(alignment - 1);
+        }
+
+        // Computes the column offsets for the given capacity and returns the total number of bytes needed.
+        size_t ComputeLayout(uint32_t capacity, Vector<uint32_t>& offsets, Vector<uint32_t>& versionOffsets) const
+        {
+            offsets.resize(m_components.size());
+            versionOffsets.resize(m_components.size());
+            size_t offset = sizeof(Entity) * capacity;
+            for (size_t i = 0; i < m_components.size(); i++)
+            {
+                offset = AlignUp(offset, m_components[i]->alignment);
+                offsets[i] = (uint32_t)offset;
+                offset += m_components[i]->size * capacity;
+
+                offset = AlignUp(offset, alignof(uint32_t));
+                versionOffsets[i] = (uint32_t)offset;
+                offset += sizeof(uint32_t) * capacity;
+            }
+            return offset;
+        }
+
+        void* GetRowData(const Chunk& chunk, uint32_t row, uint32_t column) const
+        {
+            return chunk.GetData() + m_columnOffsets[column] + m_components[column]->size * row;
+        }
+
+        uint32_t* GetVersionData(const Chunk& chunk, uint32_t column) const
+        {
+            return reinterpret_cast<uint32_t*>(chunk.GetData() + m_versionOffsets[column]);
+        }
+
+        // Moves a row with its entity and change versions into an unused row, leaving the source row unused.
+        void MoveRow(Chunk& dst, uint32_t dstRow, Chunk& src, uint32_t srcRow)
+        {
+            reinterpret_cast<Entity*>(dst.GetData())[dstRow] = reinterpret_cast<Entity*>(src.GetData())[srcRow];
+            for (uint32_t column = 0; column < m_components.size(); column++)
+            {
+                void* source = GetRowData(src, srcRow, column);
+                m_components[column]->moveConstruct(GetRowData(dst, dstRow, column), source);
+                m_components[column]->destroy(source);
+
+                const uint32_t version = GetVersionData(src, column)[srcRow];
+                GetVersionData(dst, column)[dstRow] = version;
+                dst.GetColumnVersion(column) = std::max(dst.GetColumnVersion(column), version);
+            }
+        }
+
+        void Touch(Chunk& chunk) { chunk.SetStamp(++m_lastStamp); }
+
+        void AddChunk()
+        {
+            m_chunks.emplace_back(MakeUnique<Chunk>(m_chunkBytes, m_components.size()));
+            Touch(*m_chunks.back());
+        }
+
+        void DestroyRows(Chunk& chunk)
+        {
+            for (uint32_t column = 0; column < m_components.size(); column++)
+            {
+                if (m_components[column]->triviallyCopyable)
+                    continue;
+                for (uint32_t row = 0; row < chunk.Size(); row++)
+                    m_components[column]->destroy(GetRowData(chunk, row, column));
+            }
+        }
+
+        // Rows are addressed by their index across all chunks, every chunk but the last is full
+        Chunk& GetRowChunk(uint32_t index) const { return *m_chunks[index / m_chunkCapacity]; }
+        uint32_t GetRowInChunk(uint32_t index) const { return index % m_chunkCapacity; }
+
+        // Moves the rows so that row i holds what was row order[i].
+        void Permute(const Vector<uint32_t>& order)
+        {
+            Chunk temp(m_chunkBytes, m_components.size());
+            Vector<bool> placed(m_size, false);
+            for (uint32_t start = 0; start < m_size; start++)
+            {
+                if (placed[start] || order[start] == start)
+                    continue;
+
+                // Follow the cycle through start, the row at start is parked in temp until the cycle closes
+                MoveRow(temp, 0, GetRowChunk(start), GetRowInChunk(start));
+                uint32_t current = start;
+                while (order[current] != start)
+                {
+                    MoveRow(GetRowChunk(current), GetRowInChunk(current), GetRowChunk(order[current]), GetRowInChunk(order[current]));
+                    placed[current] = true;
+                    current = order[current];
+                }
+                MoveRow(GetRowChunk(current), GetRowInChunk(current), temp, 0);
+                placed[current] = true;
+            }
+        }
+
+    public:
+        ArchetypeStorage(const Archetype& archetype, const Vector<const ComponentInfo*>& components)
+            : m_archetype(archetype), m_components(components)
+        {
+            std::sort(m_components.begin(), m_components.end(), [](const ComponentInfo* a, const ComponentInfo* b) { return a->bitIndex < b->bitIndex; });
+
+            m_columnIndices.fill(-1);
+            size_t rowSize = sizeof(Entity);
+            for (size_t i = 0; i < m_components.size(); i++)
+            {
+                m_columnIndices[m_components[i]->bitIndex] = (int16_t)i;
+                rowSize += m_components[i]->size + sizeof(uint32_t);
+            }
+
+            m_chunkCapacity = std::max<uint32_t>(1, (uint32_t)(SL_CHUNK_SIZE / rowSize));
+            while (m_chunkCapacity > 1 && ComputeLayout(m_chunkCapacity, m_columnOffsets, m_versionOffsets) > SL_CHUNK_SIZE)
+            {
+                m_chunkCapacity--;
+            }
+            m_chunkBytes = std::max<size_t>(SL_CHUNK_SIZE, ComputeLayout(m_chunkCapacity, m_columnOffsets, m_versionOffsets));
+        }
+
+        ~ArchetypeStorage()
+        {
+            for (uint32_t chunk = 0; chunk < m_chunks.size(); chunk++)
+            {
+                for (uint32_t row = 0; row < m_chunks[chunk]->Size(); row++)
+                {
+                    for (uint32_t column = 0; column < m_components.size(); column++)
+                    {
+                        m_components[column]->destroy(GetComponentData(chunk, row, column));
+                    }
+                }
+            }
+        }
+
+        ArchetypeStorage(const ArchetypeStorage&) = delete;
+        ArchetypeStorage& operator=(const ArchetypeStorage&) = delete;
+
+        const Archetype& GetArchetype() const { return m_archetype; }
+        size_t Size() const { return m_size; }
+        uint32_t GetChunkCount() const { return (uint32_t)m_chunks.size(); }
+        uint32_t GetChunkSize(uint32_t chunk) const { return m_chunks[chunk]->Size(); }
+        uint32_t GetChunkCapacity() const { return m_chunkCapacity; }
+        const Vector<const ComponentInfo*>& GetComponents() const { return m_components; }
+
+        bool Contains(const Archetype& archetype) const { return m_archetype.Contains(archetype); }
+        int32_t GetColumnIndex(uint32_t bitIndex) const { return m_columnIndices[bitIndex]; }
+
+        Entity* GetEntities(uint32_t chunk) const
+        {
+            return reinterpret_cast<Entity*>(m_chunks[chunk]->GetData());
+        }
+
+        void* GetComponentData(uint32_t chunk, uint32_t row, uint32_t column) const
+        {
+            return GetRowData(*m_chunks[chunk], row, column);
+        }
+
+        template <typename T>
+        T* GetColumn(uint32_t chunk, uint32_t bitIndex) const
+        {
+            const int32_t column = m_columnIndices[bitIndex];
+            SL_ASSERT(column >= 0 && "Component is not part of archetype.");
+            return reinterpret_cast<T*>(m_chunks[chunk]->GetData() + m_columnOffsets[column]);
+        }
+
+        uint32_t* GetRowVersions(uint32_t chunk, uint32_t column) const
+        {
+            return GetVersionData(*m_chunks[chunk], column);
+        }
+
+        // The highest change version of the column in the chunk, no row of the chunk changed after it.
+        uint32_t GetChunkVersion(uint32_t chunk, uint32_t column) const
+        {
+            return m_chunks[chunk]->GetColumnVersion(column);
+        }
+
+        void RaiseChunkVersion(uint32_t chunk, uint32_t column, uint32_t version)
+        {
+            uint32_t& chunkVersion = m_chunks[chunk]->GetColumnVersion(column);
+            chunkVersion = std::max(chunkVersion, version);
+        }
+
+        void SetRowVersion(uint32_t chunk, uint32_t row, uint32_t column, uint32_t version)
+        {
+            GetRowVersions(chunk, column)[row] = version;
+            RaiseChunkVersion(chunk, column, version);
+        }
+
+        // Marks the rows [begin, end) of a column as changed at the given version.
+        void MarkChanged(uint32_t chunk, uint32_t column, uint32_t begin, uint32_t end, uint32_t version)
+        {
+            std::fill(GetRowVersions(chunk, column) + begin, GetRowVersions(chunk, column) + end, version);
+            RaiseChunkVersion(chunk, column, version);
+        }
+
+        // Appends a row for the entity, the components and change versions of the row are left
+        // uninitialized and must be set by the caller.
+        EntityLocation Allocate(Entity entity)
+        {
+            if (m_chunks.empty() || m_chunks.back()->Size() == m_chunkCapacity)
+            {
+                AddChunk();
+            }
+            Touch(*m_chunks.back());
+
+            EntityLocation location;
+            location.chunk = (uint32_t)m_chunks.size() - 1;
+            location.row = m_chunks.back()->Push();
+            GetEntities(location.chunk)[location.row] = entity;
+            m_size++;
+            m_orderDirty = true;
+            return location;
+        }
+
+        // Appends up to count rows in one go, to the last chunk or to a new chunk if the last one is full.
+        // Returns the location of the first row and sets count to the number of rows appended, which are
+        // contiguous. The entities, components and change versions of the rows must be set by the caller.
+        EntityLocation AllocateRows(uint32_t& count)
+        {
+            if (m_chunks.empty() || m_chunks.back()->Size() == m_chunkCapacity)
+            {
+                AddChunk();
+            }
+            Touch(*m_chunks.back());
+
+            count = std::min(count, m_chunkCapacity - m_chunks.back()->Size());
+            EntityLocation location;
+            location.chunk = (uint32_t)m_chunks.size() - 1;
+            location.row = m_chunks.back()->Push(count);
+            m_size += count;
+            m_orderDirty = true;
+            return location;
+        }
+
+        // Destroys the components in a row and fills the hole with the last row.
+        // Returns the entity that was moved into the hole, or SL_INVALID_ENTITY if no entity was moved.
+        Entity Remove(const EntityLocation& location)
+        {
+            for (uint32_t column = 0; column < m_components.size(); column++)
+            {
+                m_components[column]->destroy(GetComponentData(location.chunk, location.row, column));
+            }
+
+            Entity moved = SL_INVALID_ENTITY;
+            const uint32_t lastChunk = (uint32_t)m_chunks.size() - 1;
+            const uint32_t lastRow = m_chunks.back()->Size() - 1;
+            if (location.chunk != lastChunk || location.row != lastRow)
+            {
+                for (uint32_t column = 0; column < m_components.size(); column++)
+                {
+                    void* last = GetComponentData(lastChunk, lastRow, column);
+                    m_components[column]->moveConstruct(GetComponentData(location.chunk, location.row, column), last);
+                    m_components[column]->destroy(last);
+                    SetRowVersion(location.chunk, location.row, column, GetRowVersions(lastChunk, column)[lastRow]);
+                }
+
+                moved = GetEntities(lastChunk)[lastRow];
+                GetEntities(location.chunk)[location.row] = moved;
+                m_orderDirty = true;
+            }
+
+            Touch(*m_chunks[location.chunk]);
+            Touch(*m_chunks.back());
+
+            m_chunks.back()->Pop();
+            if (m_chunks.back()->Size() == 0)
+            {
+                m_chunks.pop_back();
+            }
+            m_size--;
+
+            return moved;
+        }
+
+        // The column the rows are ordered by: the first component with a sort key, or -1 if there is none.
+        int32_t GetSortColumn() const
+        {
+            for (uint32_t column = 0; column < m_components.size(); column++)
+            {
+                if (m_components[column]->sortLess != nullptr)
+                    return (int32_t)column;
+            }
+            return -1;
+        }
+
+        // Returns true if the rows are in different runs of the sort column, or if there is no sort column.
+        bool IsRunBoundary(uint32_t chunk, int32_t sortColumn, uint32_t row) const
+        {
+            return sortColumn < 0 || m_components[sortColumn]->sortLess(GetComponentData(chunk, row - 1, sortColumn), GetComponentData(chunk, row, sortColumn));
+        }
+
+        void InvalidateOrder() { m_orderDirty = true; }
+
+        // Orders the rows by the sort column if rows were added or moved, or the column was written
+        // after the version of the last sort. Rows with equal keys keep their relative order.
+        // Returns true if any row moved, the caller has to update the locations of the entities.
+        bool Sort(uint32_t version, Vector<uint32_t>& order)
+        {
+            const int32_t column = GetSortColumn();
+            if (column < 0)
+                return false;
+
+            bool keysChanged = false;
+            for (uint32_t chunk = 0; chunk < m_chunks.size(); chunk++)
+                keysChanged |= GetChunkVersion(chunk, column) > m_sortedVersion;
+
+            if (!m_orderDirty && !keysChanged)
+                return false;
+
+            m_orderDirty = false;
+            m_sortedVersion = version;
+
+            auto less = m_components[column]->sortLess;
+            auto key = [&](uint32_t index) { return GetRowData(GetRowChunk(index), GetRowInChunk(index), column); };
+
+            // Usually only a few rows changed, so most calls end at the check
+            bool sorted = true;
+            for (uint32_t index = 1; index < m_size && sorted; index++)
+                sorted = !less(key(index), key(index - 1));
+            if (sorted)
+                return false;
+
+            order.resize(m_size);
+            std::iota(order.begin(), order.end(), 0);
+            std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return less(key(a), key(b)); });
+            Permute(order);
+            for (Unique<Chunk>& chunk : m_chunks)
+                Touch(*chunk);
+            return true;
+        }
+
+        size_t GetChunkBytes() const { return m_chunkBytes; }
+        size_t GetColumnOffset(uint32_t column) const { return m_columnOffsets[column]; }
+
+        // Changes whenever rows of the chunk are added, removed or moved. Together with the chunk versions it
+        // tells whether the chunk is unchanged: its stamp is the same and no column version is newer.
+        uint64_t GetChunkStamp(uint32_t chunk) const { return m_chunks[chunk]->GetStamp(); }
+
+        // Copies the whole chunk to dst, which must hold GetChunkBytes() bytes aligned like a chunk.
+        // Trivially copyable columns are copied with the raw bytes, the others are copy constructed.
+        void CopyChunk(uint32_t chunk, uint8_t* dst) const
+        {
+            const Chunk& source = *m_chunks[chunk];
+            std::memcpy(dst, source.GetData(), m_chunkBytes);
+            for (uint32_t column = 0; column < m_components.size(); column++)
+            {
+                const ComponentInfo* info = m_components[column];
+                if (info->triviallyCopyable)
+                    continue;
+
+                SL_ASSERT(info->copyConstruct != nullptr && "Component cannot be copied.");
+                for (uint32_t row = 0; row < source.Size(); row++)
+                    info->copyConstruct(dst + m_columnOffsets[column] + info->size * row, GetRowData(source, row, column));
+            }
+        }
+
+        // Sets the number of chunks, removed chunks are destroyed with their rows and added ones are empty.
+        void ResizeChunks(uint32_t count)
+        {
+            while (m_chunks.size() > count)
+            {
+                DestroyRows(*m_chunks.back());
+                m_size -= m_chunks.back()->Size();
+                m_chunks.pop_back();
+            }
+            while (m_chunks.size() < count)
+                AddChunk();
+            m_orderDirty = true;
+        }
+
+        // Replaces the rows of the chunk with size rows copied by CopyChunk, and marks them as changed at the version.
+        // The chunks must stay densely packed, only the last one can have fewer rows than the capacity.
+        void RestoreChunk(uint32_t chunk, const uint8_t* data, uint32_t size, uint32_t version)
+        {
+            Chunk& target = *m_chunks[chunk];
+            DestroyRows(target);
+            m_size -= target.Size();
+
+            std::memcpy(target.GetData(), data, m_chunkBytes);
+            for (uint32_t column = 0; column < m_components.size(); column++)
+            {
+                const ComponentInfo* info = m_components[column];
+                if (!info->triviallyCopyable)
+                {
+                    for (uint32_t row = 0; row < size; row++)
+                        info->copyConstruct(GetRowData(target, row, column), data + m_columnOffsets[column] + info->size * row);
+                }
+            }
+
+            target.SetSize(size);
+            m_size += size;
+            for (uint32_t column = 0; column < m_components.size(); column++)
+            {
+                std::fill_n(GetVersionData(target, column), size, version);
+                target.GetColumnVersion(column) = version;
+            }
+            Touch(target);
+            m_orderDirty = true;
+        }
+    };
+
+    // The archetypes matching a query. New archetypes are only ever appended to the store's
+    // archetype list, so the cache stays valid by checking the archetypes added since the last update.
+    struct ArchetypeQueryCache
+    {
+        Archetype include;
+        Archetype exclude;
+        Vector<ArchetypeStorage*> archetypes;
+        size_t checkedArchetypes = 0;
+
+        void Reset(const Archetype& includeArchetype, const Archetype& excludeArchetype)
+        {
+            include = includeArchetype;
+            exclude = excludeArchetype;
+            archetypes.clear();
+            checkedArchetypes = 0;
+        }
+
+        void Update(const Vector<ArchetypeStorage*>& allArchetypes)
+        {
+            for (; checkedArchetypes < allArchetypes.size(); checkedArchetypes++)
+            {
+                ArchetypeStorage* storage = allArchetypes[checkedArchetypes];
+                if (storage->Contains(include) && !storage->GetArchetype().Intersects(exclude))
+                {
+                    archetypes.push_back(storage);
+                }
+            }
+        }
+    };
+
+    // Calls func(entity, Ts*...) for every row of the given archetypes, chunk by chunk.
+    // Components accessed through a non-const type are marked as changed at the given version.
+    template <typename... Ts, size_t... Is>
+    void ForEachRow(const Vector<ArchetypeStorage*>& archetypes, const Array<uint32_t, sizeof...(Ts)>& bitIndices, auto& func, std::index_sequence<Is...>, uint32_t version)
+    {
+        for (ArchetypeStorage* storage : archetypes)
+        {
+            for (uint32_t chunk = 0; chunk < storage->GetChunkCount(); chunk++)
+            {
+                const uint32_t size = storage->GetChunkSize(chunk);
+                const Entity* entities = storage->GetEntities(chunk);
+                const std::tuple<Ts*...> columns = { storage->template GetColumn<Ts>(chunk, bitIndices[Is])... };
+                ((std::is_const_v<Ts> ? void() : storage->MarkChanged(chunk, storage->GetColumnIndex(bitIndices[Is]), 0, size, version)), ...);
+
+                for (uint32_t row = 0; row < size; row++)
+                {
+                    func(entities[row], (std::get<Is>(columns) + row)...);
+                }
+            }
+        }
+    }
+
+    // Like ForEachRow, but only visits rows where at least one of the changedBits components
+    // was changed after lastVersion. Chunks without such changes are skipped as a whole.
+    template <typename... Ts, size_t... Is, size_t ChangedCount>
+    void ForEachChangedRow(const Vector<ArchetypeStorage*>& archetypes, const Array<uint32_t, sizeof...(Ts)>& bitIndices, const Array<uint32_t, ChangedCount>& changedBits,
+        uint32_t lastVersion, auto& func, std::index_sequence<Is...>, uint32_t version)
+    {
+        for (ArchetypeStorage* storage : archetypes)
+        {
+            Array<uint32_t, ChangedCount> changedColumns;
+            for (size_t i = 0; i < ChangedCount; i++)
+                changedColumns[i] = storage->GetColumnIndex(changedBits[i]);
+
+            for (uint32_t chunk = 0; chunk < storage->GetChunkCount(); chunk++)
+            {
+                bool chunkChanged = false;
+                for (uint32_t column : changedColumns)
+                    chunkChanged |= storage->GetChunkVersion(chunk, column) > lastVersion;
+                if (!chunkChanged)
+                    continue;
+
+                Array<const uint32_t*, ChangedCount> rowVersions;
+                for (size_t i = 0; i < ChangedCount; i++)
+                    rowVersions[i] = storage->GetRowVersions(chunk, changedColumns[i]);
+
+                const uint32_t size = storage->GetChunkSize(chunk);
+                const Entity* entities = storage->GetEntities(chunk);
+                const std::tuple<Ts*...> columns = { storage->template GetColumn<Ts>(chunk, bitIndices[Is])... };
+                const Array<uint32_t*, sizeof...(Ts)> versions = { storage->GetRowVersions(chunk, storage->GetColumnIndex(bitIndices[Is]))... };
+
+                bool visited = false;
+                for (uint32_t row = 0; row < size; row++)
+                {
+                    bool rowChanged = false;
+                    for (const uint32_t* rows : rowVersions)
+                        rowChanged |= rows[row] > lastVersion;
+                    if (!rowChanged)
+                        continue;
+
+                    ((std::is_const_v<Ts> ? void() : void(versions[Is][row] = version)), ...);
+                    func(entities[row], (std::get<Is>(columns) + row)...);
+                    visited = true;
+                }
+
+                if (visited)
+                    ((std::is_const_v<Ts> ? void() : storage->RaiseChunkVersion(chunk, storage->GetColumnIndex(bitIndices[Is]), version)), ...);
+            }
+        }
+    }
+
+    // Calls func(entities, count, Ts*...) for every run of rows with equal sort keys, with pointers to the
+    // first row of the run. Runs never span chunks, and every row is its own run in archetypes without a sort column.
+    template <typename... Ts, size_t... Is>
+    void ForEachRun(const Vector<ArchetypeStorage*>& archetypes, const Array<uint32_t, sizeof...(Ts)>& bitIndices, auto& func, std::index_sequence<Is...>, uint32_t version)
+    {
+        for (ArchetypeStorage* storage : archetypes)
+        {
+            const int32_t sortColumn = storage->GetSortColumn();
+            for (uint32_t chunk = 0; chunk < storage->GetChunkCount(); chunk++)
+            {
+                const uint32_t size = storage->GetChunkSize(chunk);
+                const Entity* entities = storage->GetEntities(chunk);
+                const std::tuple<Ts*...> columns = { storage->template GetColumn<Ts>(chunk, bitIndices[Is])... };
+                ((std::is_const_v<Ts> ? void() : storage->MarkChanged(chunk, storage->GetColumnIndex(bitIndices[Is]), 0, size, version)), ...);
+
+                uint32_t begin = 0;
+                for (uint32_t row = 1; row <= size; row++)
+                {
+                    if (row < size && !storage->IsRunBoundary(chunk, sortColumn, row))
+                        continue;
+
+                    func(entities + begin, row - begin, (std::get<Is>(columns) + begin)...);
+                    begin = row;
+                }
+            }
+        }
+    }
+}
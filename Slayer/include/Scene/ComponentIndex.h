@@ -0,0 +1,76 @@
+#pragma once
+
+#include "Scene/Components.h"
+#include "Scene/Archetype.h"
+#include "Utils.h"
+
+#include <atomic>
+
+namespace Slayer
+{
+    template <typename T, typename... Components>
+    constexpr uint32_t IndexInComponentList()
+    {
+        constexpr bool matches[] = { std::is_same_v<T, Components>... };
+        for (uint32_t i = 0; i < sizeof...(Components); i++)
+        {
+            if (matches[i])
+                return i;
+        }
+        return sizeof...(Components);
+    }
+
+    template <typename... Components>
+    constexpr uint32_t CountComponentList()
+    {
+        return sizeof...(Components);
+    }
+
+    // Engine and game components have a fixed index given by their position in the component lists.
+    constexpr uint32_t StaticComponentCount = CountComponentList<ENGINE_COMPONENTS, GAME_COMPONENTS>();
+    static_assert(StaticComponentCount <= SL_MAX_COMPONENTS, "Too many component types.");
+
+    template <typename T>
+    constexpr uint32_t StaticComponentIndex()
+    {
+        return IndexInComponentList<T, ENGINE_COMPONENTS, GAME_COMPONENTS>();
+    }
+
+    inline std::atomic<uint32_t> s_nextComponentIndex = StaticComponentCount;
+
+    // Returns the bit index of a component type in an Archetype. The index of engine and game
+    // components is a compile-time constant, other types get the next free index on first use.
+    // Indices are shared by every ComponentStore.
+    template <typename T>
+    uint32_t GetComponentIndex()
+    {
+        if constexpr (!std::is_same_v<T, std::remove_cv_t<T>>)
+        {
+            // Const access shares the index of the component type
+            return GetComponentIndex<std::remove_cv_t<T>>();
+        }
+        else if constexpr (StaticComponentIndex<T>() < StaticComponentCount)
+        {
+            constexpr uint32_t staticIndex = StaticComponentIndex<T>();
+            return staticIndex;
+        }
+        else
+        {
+            static const uint32_t index = []()
+                {
+                    const uint32_t next = s_nextComponentIndex.fetch_add(1);
+                    SL_ASSERT(next < SL_MAX_COMPONENTS && "Too many component types.");
+                    return next;
+                }();
+            return index;
+        }
+    }
+
+    // Type information of a component, shared by every ComponentStore.
+    template <typename T>
+    const ComponentInfo& GetStaticComponentInfo()
+    {
+        static const ComponentInfo info = ComponentInfo::Create<T>(HashType<T>(), GetComponentIndex<T>());
+        return info;
+    }
+}
@@ -5,18 +5,22 @@
 #include "Serialization/Serialization.h"
 #include "Resources/Asset.h"
 #include "Scene/Components.h"
+#include "Scene/Archetype.h"
+#include "Scene/ComponentIndex.h"
+#include "Scene/EntityCommandBuffer.h"
+#include "Scene/EntityIdIndex.h"
+#include "Scene/WorldSnapshot.h"
+#include "Scene/SingletonRegistry.h"
+#include "Jobs/ThreadManager.h"
+#include "Jobs/ParallelFor.h"
 
 #include <future>
-
-#define SL_MAX_ENTITIES 10000
-#define SL_INVALID_ENTITY -1
+#include <bit>
+#include <atomic>
+#include <shared_mutex>
 
 namespace Slayer
 {
-    using Entity = uint32_t;
-    using ComponentType = uint32_t;
-    using Archetype = uint64_t;
-
     struct EntityHash
     {
         size_t operator()(const Entity& e) const noexcept
@@ -37,115 +41,417 @@ namespace Slayer
         return typeName;
     }
 
-    class ComponentArrayBase
+    // How ParallelForEach splits the matching entities into batches
+    enum class Partitioning
     {
-    public:
-        virtual void RemoveEntity(Entity entity) = 0;
+        // Batches are sized from the number of workers to keep every worker busy
+        Balanced,
+        // Batches are exactly grainSize entities in iteration order, independent of the
+        // number of workers, so per-batch results can be combined reproducibly
+        Deterministic
+    };
 
-        ComponentArrayBase() = default;
-        virtual ~ComponentArrayBase() = default;
+    class Singleton
+    {
+    public:
+        Singleton() = default;
+        virtual ~Singleton() = default;
+        Singleton(const Singleton&) = delete;
+        Singleton& operator=(const Singleton&) = delete;
     };
 
-    template <typename T>
-    class ComponentArray : public ComponentArrayBase
+    template <typename... Terms>
+    class Query;
+
+    class ComponentStore
     {
+    public:
+        // Where an entity lives, archetype is null for destroyed entities
+        struct EntityRecord
+        {
+            ArchetypeStorage* archetype = nullptr;
+            EntityLocation location;
+            uint32_t generation = 0;
+        };
+
+        // Type information indexed by component index, unregistered entries have no functions
+        using ComponentArray = Array<ComponentInfo, SL_MAX_COMPONENTS>;
     private:
-        std::vector<T> m_componentArray;
-        std::unordered_map<Entity, size_t, EntityHash> m_entityToIndexMap;
-        // Vacant entities are stored in a set
-        std::set<size_t> m_emptyIndcies;
-        size_t m_size = 0;
+        // Stores the type information for each component type, declared before the
+        // archetypes so that it outlives them
+        ComponentArray m_components;
+        Archetype m_registeredComponents;
+        SingletonRegistry m_singletons;
+
+        // One command buffer per worker thread, slot 0 is used by threads outside the worker pool
+        Vector<Unique<EntityCommandBuffer>> m_commandBuffers;
+
+        size_t m_entityCount = 0;
+        // Indexed by entity index, slots of destroyed entities are reused through m_freeIndices
+        Vector<EntityRecord> m_entityRecords;
+        Vector<uint32_t> m_freeIndices;
+        EntityIdIndex m_entityIds;
+
+        // Every archetype that has been seen, m_archetypeList is kept for fast iteration
+        DictHash<Archetype, Unique<ArchetypeStorage>, ArchetypeHash> m_archetypes;
+        Vector<ArchetypeStorage*> m_archetypeList;
+
+        // Matching archetypes for the ForEach style calls, keyed by the required components
+        mutable DictHash<Archetype, ArchetypeQueryCache, ArchetypeHash> m_queryCaches;
+        // Systems scheduled in parallel look up the caches at the same time
+        mutable std::shared_mutex m_queryCacheLock;
+        // Scratch space for sorting archetypes
+        Vector<uint32_t> m_sortOrder;
+
+        // Version that writes through mutable component access are marked with, queries filtering
+        // on Changed<> advance it so that they can tell apart changes made before and after they ran.
+        // Atomic because systems scheduled in parallel query the same store.
+        std::atomic<uint32_t> m_changeVersion = 1;
+
+        // Lets queries detect that they are used with a different store than the one they cached
+        static inline std::atomic<uint64_t> s_nextStoreId = 0;
+        uint64_t m_storeId = ++s_nextStoreId;
+
+        template <typename... Terms>
+        friend class Query;
+
+        // Archetypes are only created by structural changes, which never run alongside other accesses, so a
+        // cache that is up to date stays valid while the lock is released.
+        const Vector<ArchetypeStorage*>& GetMatchingArchetypes(const Archetype& include) const
+        {
+            {
+                std::shared_lock lock(m_queryCacheLock);
+                auto it = m_queryCaches.find(include);
+                if (it != m_queryCaches.end() && it->second.checkedArchetypes == m_archetypeList.size())
+                    return it->second.archetypes;
+            }
 
-    public:
+            std::unique_lock lock(m_queryCacheLock);
+            auto it = m_queryCaches.find(include);
+            if (it == m_queryCaches.end())
+            {
+                it = m_queryCaches.emplace(include, ArchetypeQueryCache()).first;
+                it->second.Reset(include, Archetype());
+            }
 
-        virtual void RemoveEntity(Entity entity)
+            it->second.Update(m_archetypeList);
+            return it->second.archetypes;
+        }
+
+        ArchetypeStorage* GetOrCreateArchetype(const Archetype& archetype)
+        {
+            auto it = m_archetypes.find(archetype);
+            if (it != m_archetypes.end())
+                return it->second.get();
+
+            Vector<const ComponentInfo*> components;
+            archetype.ForEachBit([&](uint32_t bitIndex)
+                {
+                    SL_ASSERT(m_registeredComponents.Test(bitIndex) && "Component not registered before use.");
+                    components.push_back(&m_components[bitIndex]);
+                });
+
+            ArchetypeStorage* storage = m_archetypes.emplace(archetype, MakeUnique<ArchetypeStorage>(archetype, components)).first->second.get();
+            m_archetypeList.push_back(storage);
+            return storage;
+        }
+
+        // Moves the entity to a new archetype, components shared by both archetypes are moved,
+        // the ones missing in the new archetype are destroyed and new ones are left unconstructed.
+        // Moved components keep their change version, new ones are marked as changed.
+        EntityLocation MoveEntity(Entity entity, ArchetypeStorage* newStorage)
         {
-            if (m_entityToIndexMap.find(entity) != m_entityToIndexMap.end())
+            EntityRecord& record = m_entityRecords[GetEntityIndex(entity)];
+            ArchetypeStorage* oldStorage = record.archetype;
+            const EntityLocation newLocation = newStorage->Allocate(entity);
+
+            for (uint32_t column = 0; column < newStorage->GetComponents().size(); column++)
             {
-                m_emptyIndcies.insert(entity);
-                m_entityToIndexMap.erase(entity);
+                newStorage->SetRowVersion(newLocation.chunk, newLocation.row, column, m_changeVersion);
             }
+
+            if (oldStorage != nullptr)
+            {
+                const auto& components = oldStorage->GetComponents();
+                for (uint32_t column = 0; column < components.size(); column++)
+                {
+                    const int32_t newColumn = newStorage->GetColumnIndex(components[column]->bitIndex);
+                    if (newColumn < 0)
+                        continue;
+
+                    components[column]->moveConstruct(
+                        newStorage->GetComponentData(newLocation.chunk, newLocation.row, newColumn),
+                        oldStorage->GetComponentData(record.location.chunk, record.location.row, column));
+                    newStorage->GetRowVersions(newLocation.chunk, newColumn)[newLocation.row] = oldStorage->GetRowVersions(record.location.chunk, column)[record.location.row];
+                }
+
+                Entity moved = oldStorage->Remove(record.location);
+                if (moved != SL_INVALID_ENTITY)
+                    m_entityRecords[GetEntityIndex(moved)].location = record.location;
+            }
+
+            record.archetype = newStorage;
+            record.location = newLocation;
+            return newLocation;
         }
 
-        void InsertData(Entity entity, T component)
+        // The accumulated effect of a command buffer on one entity
+        struct PendingChange
         {
-            SL_ASSERT(m_entityToIndexMap.find(entity) == m_entityToIndexMap.end() && "Component added to same entity more than once.");
-            SL_ASSERT(m_size < SL_MAX_ENTITIES && "Too many entities, consider increasing SL_MAX_ENTITIES.");
+            Entity entity = SL_INVALID_ENTITY;
+            Archetype archetype;
+            ArchetypeStorage* destination = nullptr;
+            uint32_t group = 0;
+            bool destroy = false;
+            // Indices of the AddComponent commands that are applied to the entity
+            Vector<uint32_t> adds;
+        };
 
-            if (m_emptyIndcies.empty())
+        // Takes a slot from the free list or appends a new one, the record is left without an archetype.
+        uint32_t AllocateEntityIndex()
+        {
+            uint32_t index;
+            if (!m_freeIndices.empty())
             {
-                m_componentArray.push_back(component);
-                m_entityToIndexMap[entity] = m_size;
-                m_size++;
+                index = m_freeIndices.back();
+                m_freeIndices.pop_back();
             }
             else
             {
-                size_t newIndex = *m_emptyIndcies.begin();
-                m_emptyIndcies.erase(newIndex);
+                SL_ASSERT(m_entityRecords.size() < UINT32_MAX && "Too many entities.");
+                index = (uint32_t)m_entityRecords.size();
+                m_entityRecords.emplace_back();
             }
+            return index;
         }
 
-        T* GetComponent(Entity entity)
+        // Appends count rows to the storage for new entities and calls func(location, rows, firstEntity)
+        // for every contiguous range of rows, the components of the rows must be constructed by func.
+        Vector<Entity> SpawnRows(ArchetypeStorage* storage, uint32_t count, auto&& func)
         {
-            SL_ASSERT(m_entityToIndexMap.find(entity) != m_entityToIndexMap.end() && "Component not found for entity.");
+            Vector<Entity> entities(count);
+            uint32_t spawned = 0;
+            while (spawned < count)
+            {
+                uint32_t rows = count - spawned;
+                const EntityLocation location = storage->AllocateRows(rows);
+                Entity* chunkEntities = storage->GetEntities(location.chunk);
+                for (uint32_t row = 0; row < rows; row++)
+                {
+                    const uint32_t index = AllocateEntityIndex();
+                    EntityRecord& record = m_entityRecords[index];
+                    record.archetype = storage;
+                    record.location = { location.chunk, location.row + row };
+
+                    const Entity entity = MakeEntity(index, record.generation);
+                    chunkEntities[location.row + row] = entity;
+                    entities[spawned + row] = entity;
+                }
+
+                func(location, rows, spawned);
+                for (uint32_t column = 0; column < storage->GetComponents().size(); column++)
+                {
+                    storage->MarkChanged(location.chunk, column, location.row, location.row + rows, m_changeVersion);
+                }
+                spawned += rows;
+            }
 
-            return &m_componentArray[m_entityToIndexMap[entity]];
+            m_entityCount += count;
+            return entities;
         }
-    };
 
-    class Singleton
-    {
-    public:
-        Singleton() = default;
-        virtual ~Singleton() = default;
-        Singleton(const Singleton&) = delete;
-        Singleton& operator=(const Singleton&) = delete;
-    };
+        // Constructs the component of rows [row, row + count) from an initializer, which is either a
+        // value to copy or a function taking the index of the entity among the spawned ones.
+        template <typename T, typename Init>
+        static void ConstructColumn(T* column, uint32_t row, uint32_t count, uint32_t firstIndex, Init& init)
+        {
+            for (uint32_t i = 0; i < count; i++)
+            {
+                if constexpr (std::is_invocable_v<Init&, uint32_t>)
+                    new (column + row + i) T(init(firstIndex + i));
+                else
+                    new (column + row + i) T(init);
+            }
+        }
 
-    class ComponentStore
-    {
-    public:
-        struct ComponentRecord
+        // Brings the archetypes into the order of their sort keys and updates the locations of the moved entities.
+        void SortArchetypes(const Vector<ArchetypeStorage*>& archetypes)
         {
-            ComponentType type = 0;
-            size_t size = 0;
-            uint32_t bitIndex = 0;
-            Shared<ComponentArrayBase> componentArray;
-        };
+            // Writes after the sort get a newer version, so that the next sort sees them
+            const uint32_t version = m_changeVersion++;
+            for (ArchetypeStorage* storage : archetypes)
+            {
+                if (!storage->Sort(version, m_sortOrder))
+                    continue;
 
-        using ComponentDict = DictHash<ComponentType, ComponentRecord, std::hash<ComponentType>>;
-        using SingletonDict = DictHash<ComponentType, Shared<Singleton>, std::hash<ComponentType>>;
-    private:
-        Entity entityIndex = 0;
+                for (uint32_t chunk = 0; chunk < storage->GetChunkCount(); chunk++)
+                {
+                    const Entity* entities = storage->GetEntities(chunk);
+                    for (uint32_t row = 0; row < storage->GetChunkSize(chunk); row++)
+                        m_entityRecords[GetEntityIndex(entities[row])].location = { chunk, row };
+                }
+            }
+        }
+
+        // True if the chunk still holds what was copied, which was at the given version
+        static bool IsChunkUnchanged(const ArchetypeStorage& storage, uint32_t chunk, const WorldSnapshot::ChunkCopy& copy, uint32_t version)
+        {
+            if (storage.GetChunkStamp(chunk) != copy.stamp || storage.GetChunkSize(chunk) != copy.size)
+                return false;
+
+            for (uint32_t column = 0; column < storage.GetComponents().size(); column++)
+            {
+                if (storage.GetChunkVersion(chunk, column) > version)
+                    return false;
+            }
+            return true;
+        }
 
-        // Stores the what component types are associated with each entity
-        DictHash<Entity, Archetype, EntityHash> m_entityComponentIndexMap;
-        Dict<AssetID, Entity> m_entityIdMap;
+        void RegisterComponentInfo(const ComponentInfo& info)
+        {
+            if (m_registeredComponents.Test(info.bitIndex))
+                return;
 
-        Dict<Archetype, std::set<Entity>> m_archetypeEntityMap;
-        // Stores the component array for each component type
-        ComponentDict m_components;
-        SingletonDict m_singletons;
+            m_components[info.bitIndex] = info;
+            m_registeredComponents.Set(info.bitIndex);
+        }
 
-        inline void UpdateArachtype(Entity entity, Archetype oldArchetype, Archetype newArchetype)
+        template <typename T>
+        const ComponentInfo& GetComponentInfo()
         {
-            if (m_archetypeEntityMap.find(oldArchetype) != m_archetypeEntityMap.end())
+            const uint32_t bitIndex = GetComponentIndex<T>();
+            if (!m_registeredComponents.Test(bitIndex))
             {
-                m_archetypeEntityMap[oldArchetype].erase(entity);
+                RegisterComponent<T>();
             }
 
-            m_archetypeEntityMap[newArchetype].insert(entity);
-            m_entityComponentIndexMap[entity] = newArchetype;
+            return m_components[bitIndex];
+        }
+
+        template <size_t N>
+        static Archetype ToArchetype(const std::array<uint32_t, N>& bitIndices)
+        {
+            Archetype archetype;
+            for (uint32_t bitIndex : bitIndices)
+                archetype.Set(bitIndex);
+            return archetype;
         }
 
+        static void AppendEntities(const ArchetypeStorage& storage, std::vector<Entity>& entities)
+        {
+            entities.reserve(entities.size() + storage.Size());
+            for (uint32_t chunk = 0; chunk < storage.GetChunkCount(); chunk++)
+            {
+                const Entity* chunkEntities = storage.GetEntities(chunk);
+                entities.insert(entities.end(), chunkEntities, chunkEntities + storage.GetChunkSize(chunk));
+            }
+        }
+
+        // A range of rows inside one chunk, executed as a single job by ParallelForEach
+        struct BatchRange
+        {
+            ArchetypeStorage* storage = nullptr;
+            uint32_t chunk = 0;
+            uint32_t begin = 0;
+            uint32_t end = 0;
+        };
+
+        template <typename Func, typename... Ts>
+        struct ParallelForEachContext
+        {
+            const Vector<BatchRange>* batches;
+            Func* func;
+            std::array<uint32_t, sizeof...(Ts)> bitIndices;
+            uint32_t version;
+        };
+
+        template <typename Func, typename... Ts, size_t... Is>
+        static void RunBatch(const ParallelForEachContext<Func, Ts...>& context, uint32_t batch, std::index_sequence<Is...>)
+        {
+            const BatchRange& range = (*context.batches)[batch];
+            const Entity* entities = range.storage->GetEntities(range.chunk);
+            const std::tuple<Ts*...> columns = { range.storage->template GetColumn<Ts>(range.chunk, context.bitIndices[Is])... };
+
+            // The chunk versions are raised before the batches are dispatched, only the rows are written here
+            ((std::is_const_v<Ts> ? void() : void(std::fill_n(range.storage->GetRowVersions(range.chunk, range.storage->GetColumnIndex(context.bitIndices[Is])) + range.begin, range.end - range.begin, context.version))), ...);
+
+            for (uint32_t row = range.begin; row < range.end; row++)
+            {
+                if constexpr (std::is_invocable_v<Func&, uint32_t, Entity, Ts*...>)
+                    (*context.func)(batch, entities[row], (std::get<Is>(columns) + row)...);
+                else
+                    (*context.func)(entities[row], (std::get<Is>(columns) + row)...);
+            }
+        }
+
+        template <typename... Ts, typename Func>
+        void ParallelForEachImpl(const Vector<ArchetypeStorage*>& archetypes, const std::array<uint32_t, sizeof...(Ts)>& bitIndices, Func& func, uint32_t grainSize, Partitioning partitioning)
+        {
+            using FuncType = std::remove_reference_t<Func>;
+
+            ThreadManager* threadManager = ThreadManager::Get();
+            Worker* worker = threadManager != nullptr ? threadManager->GetCurrentWorker() : nullptr;
+            SL_ASSERT(grainSize > 0 && "Grain size must be larger than zero.");
+
+            ParallelForEachContext<FuncType, Ts...> context;
+            context.func = &func;
+            context.bitIndices = bitIndices;
+            context.version = m_changeVersion;
+            constexpr std::array<bool, sizeof...(Ts)> isConst = { std::is_const_v<Ts>... };
+
+            size_t matchingEntities = 0;
+            for (ArchetypeStorage* storage : archetypes)
+            {
+                matchingEntities += storage->Size();
+            }
+
+            uint32_t batchSize = grainSize;
+            if (partitioning == Partitioning::Balanced && worker != nullptr)
+            {
+                // Aim for a few batches per worker so that stealing can even out the load
+                const size_t targetBatches = threadManager->GetWorkerCount() * 4;
+                batchSize = std::max<uint32_t>(grainSize, (uint32_t)((matchingEntities + targetBatches - 1) / targetBatches));
+            }
+
+            Vector<BatchRange> batches;
+            for (ArchetypeStorage* storage : archetypes)
+            {
+                for (uint32_t chunk = 0; chunk < storage->GetChunkCount(); chunk++)
+                {
+                    for (size_t i = 0; i < sizeof...(Ts); i++)
+                    {
+                        if (!isConst[i])
+                            storage->RaiseChunkVersion(chunk, storage->GetColumnIndex(bitIndices[i]), m_changeVersion);
+                    }
+
+                    const uint32_t size = storage->GetChunkSize(chunk);
+                    for (uint32_t begin = 0; begin < size; begin += batchSize)
+                    {
+                        batches.push_back({ storage, chunk, begin, std::min(begin + batchSize, size) });
+                    }
+                }
+            }
+            context.batches = &batches;
+
+            // One job per batch, the batches are already sized for the workers
+            ParallelFor(0, (uint32_t)batches.size(), 1, [&context](uint32_t first, uint32_t last)
+                {
+                    for (uint32_t batch = first; batch < last; batch++)
+                        RunBatch<FuncType, Ts...>(context, batch, std::index_sequence_for<Ts...>{});
+                });
+        }
 
     public:
+        ComponentStore()
+        {
+            m_commandBuffers.resize(SL_MAX_WORKERS + 1);
+        }
+
+        ~ComponentStore() = default;
 
         Entity CreateEntity()
         {
-            SL_ASSERT(m_entityComponentIndexMap.size() < SL_MAX_ENTITIES && "Too many entities.");
-
-            Entity entity = entityIndex++;
+            Entity entity = CreateEntityWithoutID();
 
             EntityID component;
             component.id = GenerateAssetID();
@@ -156,9 +462,7 @@ namespace Slayer
 
         Entity CreateEntity(AssetID id)
         {
-            SL_ASSERT(m_entityComponentIndexMap.size() < SL_MAX_ENTITIES && "Too many entities.");
-
-            Entity entity = entityIndex++;
+            Entity entity = CreateEntityWithoutID();
 
             EntityID component;
             component.id = id;
@@ -169,46 +473,506 @@ namespace Slayer
 
         Entity CreateEntityWithoutID()
         {
-            SL_ASSERT(m_entityComponentIndexMap.size() < SL_MAX_ENTITIES && "Too many entities.");
-
-            Entity entity = entityIndex++;
+            const uint32_t index = AllocateEntityIndex();
+            Entity entity = MakeEntity(index, m_entityRecords[index].generation);
+            MoveEntity(entity, GetOrCreateArchetype(Archetype()));
+            m_entityCount++;
 
             return entity;
         }
 
+        // Creates count entities with the components Ts, placed straight into their archetype a chunk at a time.
+        // Takes one initializer per component, either a value copied to every entity or a function
+        // (uint32_t i) returning the component of the i-th entity, or none to default construct them.
+        // No EntityID is generated, include EntityID in Ts to give the entities one.
+        //
+        //     store.CreateEntities<Transform, ModelRenderer>(1000, [&](uint32_t i) { return Transform(positions[i], rotation, scale); }, renderer);
+        template <typename... Ts, typename... Inits>
+        Vector<Entity> CreateEntities(uint32_t count, Inits&&... initializers)
+        {
+            static_assert(sizeof...(Inits) == 0 || sizeof...(Inits) == sizeof...(Ts), "Give one initializer per component or none.");
+
+            const std::array<uint32_t, sizeof...(Ts)> bitIndices = { GetComponentInfo<Ts>().bitIndex... };
+            ArchetypeStorage* storage = GetOrCreateArchetype(ToArchetype(bitIndices));
+
+            Vector<Entity> entities = SpawnRows(storage, count, [&](const EntityLocation& location, uint32_t rows, uint32_t firstIndex)
+                {
+                    if constexpr (sizeof...(Inits) == 0)
+                        ((std::uninitialized_value_construct_n(storage->GetColumn<Ts>(location.chunk, GetComponentIndex<Ts>()) + location.row, rows)), ...);
+                    else
+                        (ConstructColumn<Ts>(storage->GetColumn<Ts>(location.chunk, GetComponentIndex<Ts>()), location.row, rows, firstIndex, initializers), ...);
+                });
+
+            if constexpr ((std::is_same_v<Ts, EntityID> || ...))
+            {
+                for (Entity entity : entities)
+                    m_entityIds.Set(GetComponent<const EntityID>(entity)->id, entity);
+            }
+
+            return entities;
+        }
+
+        // Creates count copies of the prefab entity by copying its whole row. Copies of a prefab
+        // with an EntityID get a newly generated id.
+        Vector<Entity> Instantiate(Entity prefab, uint32_t count)
+        {
+            SL_ASSERT(IsValid(prefab) && "Invalid entity.");
+
+            const EntityRecord source = m_entityRecords[GetEntityIndex(prefab)];
+            ArchetypeStorage* storage = source.archetype;
+            const auto& components = storage->GetComponents();
+
+            Vector<Entity> entities = SpawnRows(storage, count, [&](const EntityLocation& location, uint32_t rows, uint32_t /*firstIndex*/)
+                {
+                    for (uint32_t column = 0; column < components.size(); column++)
+                    {
+                        SL_ASSERT(components[column]->copyConstruct != nullptr && "Prefab has a component that cannot be copied.");
+                        const void* prefabData = storage->GetComponentData(source.location.chunk, source.location.row, column);
+                        for (uint32_t row = location.row; row < location.row + rows; row++)
+                        {
+                            components[column]->copyConstruct(storage->GetComponentData(location.chunk, row, column), prefabData);
+                        }
+                    }
+                });
+
+            if (storage->GetColumnIndex(GetComponentIndex<EntityID>()) >= 0)
+            {
+                for (Entity entity : entities)
+                {
+                    EntityID* id = GetComponent<EntityID>(entity);
+                    id->id = GenerateAssetID();
+                    m_entityIds.Set(id->id, entity);
+                }
+            }
+
+            return entities;
+        }
+
         void DestroyEntity(Entity entity)
         {
-            for (auto& [componentType, componentRecord] : m_components)
+            if (!IsValid(entity))
+                return;
+
+            if (HasComponent<EntityID>(entity))
+                m_entityIds.Erase(GetComponent<const EntityID>(entity)->id, entity);
+
+            if (HasComponent<Relationship>(entity))
             {
-                componentRecord.componentArray->RemoveEntity(entity);
+                // Children are left as roots
+                SetParent(entity, SL_INVALID_ENTITY);
+                Entity child = GetComponent<const Relationship>(entity)->firstChild;
+                while (child != SL_INVALID_ENTITY)
+                {
+                    Relationship* relationship = GetComponent<Relationship>(child);
+                    child = relationship->nextSibling;
+                    *relationship = Relationship();
+                }
             }
 
-            m_entityComponentIndexMap.erase(entity);
+            const uint32_t index = GetEntityIndex(entity);
+            EntityRecord& record = m_entityRecords[index];
+            Entity moved = record.archetype->Remove(record.location);
+            if (moved != SL_INVALID_ENTITY)
+                m_entityRecords[GetEntityIndex(moved)].location = record.location;
+
+            record.archetype = nullptr;
+            record.generation++;
+            if (record.generation == SL_DEFERRED_GENERATION)
+                record.generation = 0;
+            m_freeIndices.push_back(index);
+            m_entityCount--;
         }
 
-        bool IsValid(Entity entity)
+        // Returns the command buffer of the calling thread. Commands recorded while systems iterate
+        // the store are applied by PlaybackCommands.
+        EntityCommandBuffer& GetCommandBuffer()
         {
-            return entity != SL_INVALID_ENTITY && m_entityComponentIndexMap.find(entity) != m_entityComponentIndexMap.end();
+            ThreadManager* threadManager = ThreadManager::Get();
+            const int32_t workerIndex = threadManager != nullptr ? threadManager->GetCurrentWorkerIndex() : -1;
+
+            Unique<EntityCommandBuffer>& buffer = m_commandBuffers[workerIndex + 1];
+            if (buffer == nullptr)
+                buffer = MakeUnique<EntityCommandBuffer>();
+
+            return *buffer;
         }
 
-        Entity GetEntity(AssetID id)
+        // Applies and clears the command buffers of every thread, in worker order.
+        // Must be called while no other thread uses the store.
+        void PlaybackCommands()
         {
-            if (m_entityIdMap.find(id) != m_entityIdMap.end())
+            for (Unique<EntityCommandBuffer>& buffer : m_commandBuffers)
             {
-                return m_entityIdMap[id];
+                if (buffer != nullptr && !buffer->IsEmpty())
+                    PlaybackCommands(*buffer);
             }
+        }
 
-            return SL_INVALID_ENTITY;
+        // Applies the commands of the buffer in one batch and clears it. Every entity is moved at most
+        // once, straight to the archetype it ends up in, and the moves are grouped by that archetype.
+        void PlaybackCommands(EntityCommandBuffer& buffer)
+        {
+            using CommandType = EntityCommandBuffer::CommandType;
+            const auto& commands = buffer.GetCommands();
+
+            Vector<Entity> created(buffer.GetCreatedCount(), SL_INVALID_ENTITY);
+            Vector<PendingChange> changes;
+            Dict<Entity, uint32_t> changeIndices;
+
+            for (uint32_t i = 0; i < commands.size(); i++)
+            {
+                const EntityCommandBuffer::Command& command = commands[i];
+
+                Entity entity = command.entity;
+                if (EntityCommandBuffer::IsDeferred(entity))
+                {
+                    const uint32_t createdIndex = GetEntityIndex(entity);
+                    SL_ASSERT(createdIndex < created.size() && "Entity was created by another command buffer.");
+                    if (command.type == CommandType::CreateEntity)
+                        created[createdIndex] = CreateEntityWithoutID();
+                    entity = created[createdIndex];
+                }
+
+                if (!IsValid(entity))
+                    continue;
+
+                auto [it, inserted] = changeIndices.try_emplace(entity, (uint32_t)changes.size());
+                if (inserted)
+                {
+                    PendingChange& change = changes.emplace_back();
+                    change.entity = entity;
+                    change.archetype = m_entityRecords[GetEntityIndex(entity)].archetype->GetArchetype();
+                }
+
+                PendingChange& change = changes[it->second];
+                if (change.destroy)
+                    continue;
+
+                const uint32_t bitIndex = command.info != nullptr ? command.info->bitIndex : 0;
+                auto isSameComponent = [&](uint32_t add) { return commands[add].info->bitIndex == bitIndex; };
+
+                switch (command.type)
+                {
+                case CommandType::CreateEntity:
+                    break;
+                case CommandType::DestroyEntity:
+                    change.destroy = true;
+                    change.adds.clear();
+                    break;
+                case CommandType::AddComponent:
+                    RegisterComponentInfo(*command.info);
+                    change.archetype.Set(bitIndex);
+                    std::erase_if(change.adds, isSameComponent);
+                    change.adds.push_back(i);
+                    break;
+                case CommandType::RemoveComponent:
+                    change.archetype.Reset(bitIndex);
+                    std::erase_if(change.adds, isSameComponent);
+                    break;
+                }
+            }
+
+            // Destroy first so that the freed rows are reused by the moves
+            Vector<PendingChange*> moves;
+            Dict<ArchetypeStorage*, uint32_t> groups;
+            for (PendingChange& change : changes)
+            {
+                if (change.destroy)
+                {
+                    DestroyEntity(change.entity);
+                    continue;
+                }
+
+                change.destination = GetOrCreateArchetype(change.archetype);
+                change.group = groups.try_emplace(change.destination, (uint32_t)groups.size()).first->second;
+                moves.push_back(&change);
+            }
+
+            std::stable_sort(moves.begin(), moves.end(), [](const PendingChange* a, const PendingChange* b) { return a->group < b->group; });
+
+            const uint32_t entityIdIndex = GetComponentIndex<EntityID>();
+            for (PendingChange* change : moves)
+            {
+                EntityRecord& record = m_entityRecords[GetEntityIndex(change->entity)];
+                const Archetype previous = record.archetype->GetArchetype();
+
+                // The id may be removed or replaced, it is mapped again below if the entity still has one
+                if (previous.Test(entityIdIndex))
+                    m_entityIds.Erase(GetComponent<const EntityID>(change->entity)->id, change->entity);
+                const EntityLocation location = record.archetype == change->destination ? record.location : MoveEntity(change->entity, change->destination);
+
+                for (uint32_t add : change->adds)
+                {
+                    const EntityCommandBuffer::Command& command = commands[add];
+                    const ComponentInfo& info = *command.info;
+                    void* component = change->destination->GetComponentData(location.chunk, location.row, change->destination->GetColumnIndex(info.bitIndex));
+
+                    if (command.generateId)
+                        static_cast<EntityID*>(command.data)->id = GenerateAssetID();
+
+                    const uint32_t column = change->destination->GetColumnIndex(info.bitIndex);
+                    if (previous.Test(info.bitIndex))
+                    {
+                        info.destroy(component);
+                        change->destination->SetRowVersion(location.chunk, location.row, column, m_changeVersion);
+                    }
+                    info.moveConstruct(component, command.data);
+                }
+
+                if (change->destination->GetArchetype().Test(entityIdIndex))
+                    m_entityIds.Set(GetComponent<const EntityID>(change->entity)->id, change->entity);
+            }
+
+            buffer.Clear();
+        }
+
+        // Copies every entity and component of the store. Trivially copyable components are copied with
+        // their chunks' raw bytes, other components must be copy constructible. Given a base snapshot of
+        // this store, chunks that did not change since the base are shared with it instead of copied.
+        // Singletons and recorded commands are not part of the snapshot.
+        WorldSnapshot CreateSnapshot(const WorldSnapshot* base = nullptr)
+        {
+            WorldSnapshot snapshot;
+            CreateSnapshot(snapshot, base);
+            return snapshot;
+        }
+
+        // Same as above into an existing snapshot, reusing the memory of its chunk copies that are not
+        // shared with other snapshots. Avoids allocating for every frame of a replay buffer.
+        void CreateSnapshot(WorldSnapshot& snapshot, const WorldSnapshot* base = nullptr)
+        {
+            SL_ASSERT(&snapshot != base && "A snapshot cannot be its own base.");
+
+            Vector<Shared<WorldSnapshot::ChunkCopy>> reusable;
+            for (WorldSnapshot::ArchetypeCopy& archetype : snapshot.m_archetypes)
+            {
+                for (Shared<WorldSnapshot::ChunkCopy>& copy : archetype.chunks)
+                {
+                    if (copy.use_count() == 1)
+                        reusable.push_back(std::move(copy));
+                }
+            }
+
+            snapshot.m_storeId = m_storeId;
+            snapshot.m_version = m_changeVersion++;
+            snapshot.m_copiedChunks = 0;
+            if (base != nullptr && base->m_storeId != m_storeId)
+                base = nullptr;
+
+            snapshot.m_components.clear();
+            m_registeredComponents.ForEachBit([&](uint32_t bitIndex) { snapshot.m_components.push_back(m_components[bitIndex]); });
+
+            snapshot.m_archetypes.clear();
+            snapshot.m_archetypes.resize(m_archetypeList.size());
+            for (uint32_t i = 0; i < m_archetypeList.size(); i++)
+            {
+                const ArchetypeStorage* storage = m_archetypeList[i];
+                WorldSnapshot::ArchetypeCopy& archetype = snapshot.m_archetypes[i];
+                archetype.archetype = storage->GetArchetype();
+
+                auto columns = MakeShared<Vector<WorldSnapshot::ColumnCopy>>();
+                const auto& components = storage->GetComponents();
+                for (uint32_t column = 0; column < components.size(); column++)
+                {
+                    if (!components[column]->triviallyCopyable)
+                        columns->push_back({ storage->GetColumnOffset(column), components[column]->size, components[column]->destroy });
+                }
+
+                const WorldSnapshot::ArchetypeCopy* baseArchetype = base != nullptr && i < base->m_archetypes.size() ? &base->m_archetypes[i] : nullptr;
+                for (uint32_t chunk = 0; chunk < storage->GetChunkCount(); chunk++)
+                {
+                    if (baseArchetype != nullptr && chunk < baseArchetype->chunks.size() && IsChunkUnchanged(*storage, chunk, *baseArchetype->chunks[chunk], base->m_version))
+                    {
+                        archetype.chunks.push_back(baseArchetype->chunks[chunk]);
+                        continue;
+                    }
+
+                    Shared<WorldSnapshot::ChunkCopy> copy;
+                    auto it = std::find_if(reusable.rbegin(), reusable.rend(), [&](const auto& chunkCopy) { return chunkCopy->bytes == storage->GetChunkBytes(); });
+                    if (it != reusable.rend())
+                    {
+                        copy = std::move(*it);
+                        reusable.erase(std::next(it).base());
+                        copy->DestroyRows();
+                    }
+                    else
+                    {
+                        copy = MakeShared<WorldSnapshot::ChunkCopy>(storage->GetChunkBytes());
+                    }
+
+                    storage->CopyChunk(chunk, copy->data);
+                    copy->size = storage->GetChunkSize(chunk);
+                    copy->stamp = storage->GetChunkStamp(chunk);
+                    copy->columns = columns;
+                    archetype.chunks.push_back(std::move(copy));
+                    snapshot.m_copiedChunks++;
+                }
+            }
+
+            snapshot.m_generations.resize(m_entityRecords.size());
+            for (size_t i = 0; i < m_entityRecords.size(); i++)
+                snapshot.m_generations[i] = m_entityRecords[i].generation;
+            snapshot.m_freeIndices = m_freeIndices;
+            snapshot.m_entityCount = m_entityCount;
+            snapshot.m_entityIds = m_entityIds;
+        }
+
+        // Returns the store to the state of the snapshot, entity handles from that time become valid again.
+        // A snapshot of another store replaces the contents of this one, which forks that world.
+        // Restored components are marked as changed. Restoring a snapshot of this store only copies the
+        // chunks that changed since it was taken.
+        void Restore(const WorldSnapshot& snapshot)
+        {
+            for (const ComponentInfo& info : snapshot.m_components)
+                RegisterComponentInfo(info);
+
+            const bool sameStore = snapshot.m_storeId == m_storeId;
+            const uint32_t version = m_changeVersion;
+            Vector<ArchetypeStorage*> restored;
+            for (const WorldSnapshot::ArchetypeCopy& archetype : snapshot.m_archetypes)
+            {
+                ArchetypeStorage* storage = GetOrCreateArchetype(archetype.archetype);
+                storage->ResizeChunks((uint32_t)archetype.chunks.size());
+                for (uint32_t chunk = 0; chunk < archetype.chunks.size(); chunk++)
+                {
+                    const WorldSnapshot::ChunkCopy& copy = *archetype.chunks[chunk];
+                    if (!sameStore || !IsChunkUnchanged(*storage, chunk, copy, snapshot.m_version))
+                        storage->RestoreChunk(chunk, copy.data, copy.size, version);
+                }
+                restored.push_back(storage);
+            }
+
+            // Archetypes created after the snapshot
+            for (ArchetypeStorage* storage : m_archetypeList)
+            {
+                if (std::find(restored.begin(), restored.end(), storage) == restored.end())
+                    storage->ResizeChunks(0);
+            }
+
+            m_entityRecords.assign(snapshot.m_generations.size(), EntityRecord());
+            for (size_t i = 0; i < m_entityRecords.size(); i++)
+                m_entityRecords[i].generation = snapshot.m_generations[i];
+
+            for (ArchetypeStorage* storage : restored)
+            {
+                for (uint32_t chunk = 0; chunk < storage->GetChunkCount(); chunk++)
+                {
+                    const Entity* entities = storage->GetEntities(chunk);
+                    for (uint32_t row = 0; row < storage->GetChunkSize(chunk); row++)
+                    {
+                        EntityRecord& record = m_entityRecords[GetEntityIndex(entities[row])];
+                        record.archetype = storage;
+                        record.location = { chunk, row };
+                    }
+                }
+            }
+
+            m_freeIndices = snapshot.m_freeIndices;
+            m_entityCount = snapshot.m_entityCount;
+            m_entityIds = snapshot.m_entityIds;
+        }
+
+        bool IsValid(Entity entity) const
+        {
+            const uint32_t index = GetEntityIndex(entity);
+            return entity != SL_INVALID_ENTITY && index < m_entityRecords.size()
+                && m_entityRecords[index].archetype != nullptr
+                && m_entityRecords[index].generation == GetEntityGeneration(entity);
+        }
+
+        Entity GetEntity(AssetID id) const
+        {
+            return m_entityIds.Find(id);
+        }
+
+        // Makes parent the parent of child, or detaches the child when parent is SL_INVALID_ENTITY. Both entities
+        // get a Relationship. The parentId of the child's Transform is set to the parent's EntityID, or 0 if it
+        // has none, so that the link is saved with the scene.
+        void SetParent(Entity child, Entity parent)
+        {
+            SL_ASSERT(IsValid(child) && (parent == SL_INVALID_ENTITY || IsValid(parent)) && "Invalid entity.");
+
+            if (!HasComponent<Relationship>(child))
+                AddComponent(child, Relationship());
+            if (parent != SL_INVALID_ENTITY && !HasComponent<Relationship>(parent))
+                AddComponent(parent, Relationship());
+
+            for (Entity ancestor = parent; ancestor != SL_INVALID_ENTITY; ancestor = GetComponent<const Relationship>(ancestor)->parent)
+                SL_ASSERT(ancestor != child && "Entity cannot be parented to itself or its descendants.");
+
+            Relationship* relationship = GetComponent<Relationship>(child);
+            if (relationship->parent != SL_INVALID_ENTITY)
+            {
+                Relationship* oldParent = GetComponent<Relationship>(relationship->parent);
+                if (oldParent->firstChild == child)
+                    oldParent->firstChild = relationship->nextSibling;
+                if (relationship->previousSibling != SL_INVALID_ENTITY)
+                    GetComponent<Relationship>(relationship->previousSibling)->nextSibling = relationship->nextSibling;
+                if (relationship->nextSibling != SL_INVALID_ENTITY)
+                    GetComponent<Relationship>(relationship->nextSibling)->previousSibling = relationship->previousSibling;
+            }
+
+            relationship->parent = parent;
+            relationship->previousSibling = SL_INVALID_ENTITY;
+            relationship->nextSibling = SL_INVALID_ENTITY;
+            if (parent != SL_INVALID_ENTITY)
+            {
+                Relationship* newParent = GetComponent<Relationship>(parent);
+                relationship->nextSibling = newParent->firstChild;
+                if (newParent->firstChild != SL_INVALID_ENTITY)
+                    GetComponent<Relationship>(newParent->firstChild)->previousSibling = child;
+                newParent->firstChild = child;
+            }
+
+            if (HasComponent<Transform>(child))
+            {
+                const AssetID parentId = parent != SL_INVALID_ENTITY && HasComponent<EntityID>(parent) ? GetComponent<const EntityID>(parent)->id : 0;
+                if (GetComponent<const Transform>(child)->parentId != parentId)
+                    GetComponent<Transform>(child)->parentId = parentId;
+            }
+        }
+
+        // Returns the parent set with SetParent, or SL_INVALID_ENTITY.
+        Entity GetParent(Entity entity)
+        {
+            return HasComponent<Relationship>(entity) ? GetComponent<const Relationship>(entity)->parent : SL_INVALID_ENTITY;
+        }
+
+        // Calls func(child) for every child set with SetParent, the most recently added first.
+        void ForEachChild(Entity entity, auto&& func)
+        {
+            if (!HasComponent<Relationship>(entity))
+                return;
+
+            for (Entity child = GetComponent<const Relationship>(entity)->firstChild; child != SL_INVALID_ENTITY; child = GetComponent<const Relationship>(child)->nextSibling)
+                func(child);
+        }
+
+        // Links every entity whose Transform has a parentId to the entity with that id, for example after
+        // loading a scene. Entities whose parent is not in the store are left as they are.
+        void ResolveParents()
+        {
+            Vector<std::pair<Entity, Entity>> links;
+            ForEach<const Transform>([&](Entity entity, const Transform* transform)
+                {
+                    const Entity parent = transform->parentId != 0 ? GetEntity(transform->parentId) : SL_INVALID_ENTITY;
+                    if (parent != SL_INVALID_ENTITY && parent != GetParent(entity))
+                        links.emplace_back(entity, parent);
+                });
+
+            for (const auto& [child, parent] : links)
+                SetParent(child, parent);
         }
 
         template <typename... Ts>
         Entity FindFirst()
         {
-            Archetype archetype = GetArchetype<Ts...>();
-
-            if (m_archetypeEntityMap.find(archetype) != m_archetypeEntityMap.end())
+            for (ArchetypeStorage* storage : GetMatchingArchetypes(GetArchetype<Ts...>()))
             {
-                return *m_archetypeEntityMap[archetype].begin();
+                if (storage->Size() > 0)
+                {
+                    return storage->GetEntities(0)[0];
+                }
             }
 
             return SL_INVALID_ENTITY;
@@ -223,110 +987,143 @@ namespace Slayer
         template <typename T>
         void RegisterComponent()
         {
-            const ComponentType typeHash = HashType<T>();
+            const uint32_t bitIndex = GetComponentIndex<T>();
 
-            SL_ASSERT(m_components.find(typeHash) == m_components.end() && "Registering component type more than once.");
+            SL_ASSERT(!m_registeredComponents.Test(bitIndex) && "Registering component type more than once.");
 
-            m_components[typeHash] = { typeHash, sizeof(T), (uint32_t)m_components.size(), std::make_unique<ComponentArray<T>>() };
+            RegisterComponentInfo(GetStaticComponentInfo<T>());
         }
 
-        template <typename T>
-        ComponentArray<T>* GetComponentArray()
+        template <typename C>
+        void AddComponent(Entity entity, C component)
         {
-            uint32_t typeHash = HashType<T>();
+            SL_ASSERT(IsValid(entity) && "Invalid entity.");
+            SL_ASSERT(!HasComponent<C>(entity) && "Component added to same entity more than once.");
 
-            if (m_components.find(typeHash) == m_components.end())
-                RegisterComponent<T>();
+            if constexpr (std::is_same_v<C, EntityID>)
+            {
+                // We overwrite the entity id if it already exists
+                m_entityIds.Set(component.id, entity);
+            }
 
-            return static_cast<ComponentArray<T> *>(m_components[typeHash].componentArray.get());
-        }
+            const ComponentInfo& info = GetComponentInfo<C>();
+            EntityRecord& record = m_entityRecords[GetEntityIndex(entity)];
+            ArchetypeStorage* newStorage = GetOrCreateArchetype(record.archetype->GetArchetype() | Archetype::FromBit(info.bitIndex));
+            EntityLocation location = MoveEntity(entity, newStorage);
 
-        template <typename C>
-        void AddComponent(Entity entity, C component)
-        {
-            GetComponentArray<C>()->InsertData(entity, component);
-            Archetype oldArch = m_entityComponentIndexMap[entity];
-            Archetype newArch = oldArch | (uint64_t(1) << uint64_t(m_components[HashType<C>()].bitIndex));
-            UpdateArachtype(entity, oldArch, newArch);
+            new (newStorage->GetColumn<C>(location.chunk, info.bitIndex) + location.row) C(std::move(component));
         }
 
-        template <>
-        void AddComponent(Entity entity, EntityID component)
+        // Adds several components with a single move to the final archetype.
+        template <typename... Ts>
+        void AddComponents(Entity entity, Ts... components)
         {
-            // We overwrite the entity id if it already exists
-            m_entityIdMap[component.id] = entity;
-            GetComponentArray<EntityID>()->InsertData(entity, component);
-            Archetype oldArch = m_entityComponentIndexMap[entity];
-            Archetype newArch = oldArch | (uint64_t(1) << uint64_t(m_components[HashType<EntityID>()].bitIndex));
-            UpdateArachtype(entity, oldArch, newArch);
+            SL_ASSERT(IsValid(entity) && "Invalid entity.");
+            SL_ASSERT((!HasComponent<Ts>(entity) && ...) && "Component added to same entity more than once.");
+
+            const std::array<uint32_t, sizeof...(Ts)> bitIndices = { GetComponentInfo<Ts>().bitIndex... };
+            EntityRecord& record = m_entityRecords[GetEntityIndex(entity)];
+            ArchetypeStorage* newStorage = GetOrCreateArchetype(record.archetype->GetArchetype() | ToArchetype(bitIndices));
+            EntityLocation location = MoveEntity(entity, newStorage);
+
+            (new (newStorage->GetColumn<Ts>(location.chunk, GetComponentIndex<Ts>()) + location.row) Ts(std::move(components)), ...);
+
+            if constexpr ((std::is_same_v<Ts, EntityID> || ...))
+                m_entityIds.Set(GetComponent<const EntityID>(entity)->id, entity);
         }
 
         template <typename C>
         void RemoveComponent(Entity entity)
         {
-            GetComponentArray<C>()->RemoveEntity(entity);
-            Archetype oldArch = m_entityComponentIndexMap[entity];
-            Archetype newArch = oldArch & ~(1 << m_components[HashType<C>()].bitIndex);
-            UpdateArachtype(entity, oldArch, newArch);
+            if (!HasComponent<C>(entity))
+                return;
+
+            if constexpr (std::is_same_v<C, EntityID>)
+                m_entityIds.Erase(GetComponent<const EntityID>(entity)->id, entity);
+            else if constexpr (std::is_same_v<C, Relationship>)
+                SL_ASSERT(GetParent(entity) == SL_INVALID_ENTITY && GetComponent<const Relationship>(entity)->firstChild == SL_INVALID_ENTITY && "Detach the entity before removing its Relationship.");
+
+            EntityRecord& record = m_entityRecords[GetEntityIndex(entity)];
+            Archetype archetype = record.archetype->GetArchetype();
+            archetype.Reset(GetComponentIndex<C>());
+            ArchetypeStorage* newStorage = GetOrCreateArchetype(archetype);
+
+            // The removed component is destroyed together with the old row
+            MoveEntity(entity, newStorage);
         }
 
+        // Returns the component of the entity. Asking for a non-const T marks the component as changed,
+        // use GetComponent<const T> for read-only access.
         template <typename T>
         T* GetComponent(Entity entity)
         {
-            return GetComponentArray<T>()->GetComponent(entity);
+            SL_ASSERT(IsValid(entity) && HasComponent<T>(entity) && "Component not found for entity.");
+
+            const EntityRecord& record = m_entityRecords[GetEntityIndex(entity)];
+            const uint32_t bitIndex = GetComponentIndex<T>();
+            if constexpr (!std::is_const_v<T>)
+                record.archetype->SetRowVersion(record.location.chunk, record.location.row, record.archetype->GetColumnIndex(bitIndex), m_changeVersion);
+
+            return record.archetype->GetColumn<T>(record.location.chunk, bitIndex) + record.location.row;
         }
 
         template <typename T>
         bool HasComponent(Entity entity)
         {
-            return (m_entityComponentIndexMap[entity] & (uint64_t(1) << uint64_t(m_components[HashType<T>()].bitIndex))) != 0;
+            return IsValid(entity) && m_entityRecords[GetEntityIndex(entity)].archetype->GetArchetype().Test(GetComponentIndex<T>());
         }
 
+        // Calls func(entity, Ts*...) for every entity that has all of the components,
+        // iterating the matching archetypes chunk by chunk. Components of non-const types are marked as changed.
         template <typename... Ts>
         void ForEach(auto&& func)
         {
-            const std::vector<uint32_t> hashes = { HashType<Ts>()... };
+            const std::array<uint32_t, sizeof...(Ts)> bitIndices = { GetComponentIndex<Ts>()... };
+            ForEachRow<Ts...>(GetMatchingArchetypes(ToArchetype(bitIndices)), bitIndices, func, std::index_sequence_for<Ts...>{}, m_changeVersion);
+        }
 
-            // Build a bit mask of all the component types
-            Archetype searchArchetype = GetArchetype<Ts...>();
+        // Keeps the rows of every archetype with T ordered by key(component), compared with operator<, so that
+        // ForEachRun visits entities with equal keys together. The key function must be captureless:
+        //
+        //     store.SetSortKey<ModelRenderer>([](const ModelRenderer& renderer) { return std::make_pair(renderer.modelID, renderer.materialID); });
+        //
+        // An archetype with several sorted components is ordered by the one with the lowest component index.
+        template <typename T, typename KeyFunc>
+        void SetSortKey(KeyFunc)
+        {
+            static_assert(std::is_empty_v<KeyFunc> && std::is_default_constructible_v<KeyFunc>, "Sort key functions must be captureless.");
 
-            for (auto& [archetype, entitySet] : m_archetypeEntityMap)
+            ComponentInfo& info = m_components[GetComponentInfo<T>().bitIndex];
+            info.sortLess = [](const void* a, const void* b) { return KeyFunc{}(*static_cast<const T*>(a)) < KeyFunc{}(*static_cast<const T*>(b)); };
+            for (ArchetypeStorage* storage : m_archetypeList)
             {
-                if ((archetype & searchArchetype) == searchArchetype)
-                {
-                    for (auto& entity : entitySet)
-                    {
-                        func(entity, GetComponent<Ts>(entity)...);
-                    }
-                }
+                if (storage->GetArchetype().Test(info.bitIndex))
+                    storage->InvalidateOrder();
             }
         }
 
+        // Calls func(entities, count, Ts*...) for every run of entities with equal sort keys, see SetSortKey.
+        // The pointers are to the first entity of the run, which continues for count entities. Runs never
+        // span chunks or archetypes, so entities with one key can come in several runs. Archetypes that were
+        // changed since the last call are sorted first, which moves entities like a structural change does.
         template <typename... Ts>
-        void ForEachAsync(auto&& func)
+        void ForEachRun(auto&& func)
         {
-            const std::vector<uint32_t> hashes = { HashType<Ts>()... };
-
-            // Build a bit mask of all the component types
-            Archetype searchArchetype = 0;
-            for (auto& hash : hashes)
-            {
-                SL_ASSERT(m_components.find(hash) != m_components.end() && "Component not registered before use.");
-                searchArchetype |= (1 << m_components[hash].bitIndex);
-            }
+            const std::array<uint32_t, sizeof...(Ts)> bitIndices = { GetComponentIndex<Ts>()... };
+            const Vector<ArchetypeStorage*>& archetypes = GetMatchingArchetypes(ToArchetype(bitIndices));
+            SortArchetypes(archetypes);
+            Slayer::ForEachRun<Ts...>(archetypes, bitIndices, func, std::index_sequence_for<Ts...>{}, m_changeVersion);
+        }
 
+        template <typename... Ts>
+        void ForEachAsync(auto&& func)
+        {
             std::vector<std::future<void>> futures;
 
-            for (auto& [archetype, entitySet] : m_archetypeEntityMap)
-            {
-                if ((archetype & searchArchetype) == searchArchetype)
+            ForEach<Ts...>([&](Entity entity, Ts*... components)
                 {
-                    for (auto& entity : entitySet)
-                    {
-                        futures.push_back(std::async(std::launch::async, func, entity, GetComponent<Ts>(entity)...));
-                    }
-                }
-            }
+                    futures.push_back(std::async(std::launch::async, func, entity, components...));
+                });
 
             for (auto& future : futures)
             {
@@ -334,45 +1131,40 @@ namespace Slayer
             }
         }
 
+        // Runs func over the matching entities on the ThreadManager workers, the calling thread executes
+        // batches too until all of them have finished. func receives (entity, Ts*...), or
+        // (batchIndex, entity, Ts*...) if it accepts a leading batch index. Batches never span chunks.
+        // Falls back to ForEach if the calling thread is not part of the worker pool.
+        // Structural changes to the store are not allowed while the batches run, record them in
+        // GetCommandBuffer() and apply them with PlaybackCommands() afterwards.
+        template <typename... Ts, typename Func>
+        void ParallelForEach(Func&& func, uint32_t grainSize = 256, Partitioning partitioning = Partitioning::Balanced)
+        {
+            const std::array<uint32_t, sizeof...(Ts)> bitIndices = { GetComponentIndex<Ts>()... };
+            ParallelForEachImpl<Ts...>(GetMatchingArchetypes(ToArchetype(bitIndices)), bitIndices, func, grainSize, partitioning);
+        }
+
         template <typename... Ts>
         std::vector<Entity> GetEntities(bool excludeArchetypesWithMoreComponents = false) const
         {
-            const std::vector<uint32_t> hashes = { HashType<Ts>()... };
-
-            // Build a bit mask of all the component types
-            Archetype searchArchetype = 0;
-            for (auto& hash : hashes)
-            {
-                SL_ASSERT(m_components.find(hash) != m_components.end() && "Component not registered before use.");
-                searchArchetype |= (1 << m_components[hash].bitIndex);
-            }
+            SL_ASSERT((m_registeredComponents.Test(GetComponentIndex<Ts>()) && ...) && "Component not registered before use.");
+            const Archetype searchArchetype = ToArchetype(std::array<uint32_t, sizeof...(Ts)>{ GetComponentIndex<Ts>()... });
 
             std::vector<Entity> entities;
 
-            if (!excludeArchetypesWithMoreComponents)
+            if (excludeArchetypesWithMoreComponents)
             {
-                for (auto& [archetype, entitySet] : m_archetypeEntityMap)
-                {
-                    if ((archetype & searchArchetype) == searchArchetype)
-                    {
-                        entities.reserve(entities.size() + entitySet.size());
-                        for (auto& entity : entitySet)
-                        {
-                            entities.emplace_back(entity);
-                        }
-                    }
-                }
+                auto it = m_archetypes.find(searchArchetype);
+                if (it == m_archetypes.end())
+                    return entities;
+
+                AppendEntities(*it->second, entities);
+                return entities;
             }
-            else
+
+            for (ArchetypeStorage* storage : GetMatchingArchetypes(searchArchetype))
             {
-                if (m_archetypeEntityMap.find(searchArchetype) != m_archetypeEntityMap.end())
-                {
-                    entities.reserve(m_archetypeEntityMap[searchArchetype].size());
-                    for (auto& entity : m_archetypeEntityMap[searchArchetype])
-                    {
-                        entities.emplace_back(entity);
-                    }
-                }
+                AppendEntities(*storage, entities);
             }
 
             return entities;
@@ -381,10 +1173,10 @@ namespace Slayer
         std::vector<Entity> GetAllEntities() const
         {
             std::vector<Entity> entities;
-            entities.reserve(m_entityComponentIndexMap.size());
-            for (auto& [entity, archetype] : m_entityComponentIndexMap)
+            entities.reserve(m_entityCount);
+            for (ArchetypeStorage* storage : m_archetypeList)
             {
-                entities.emplace_back(entity);
+                AppendEntities(*storage, entities);
             }
 
             return entities;
@@ -392,68 +1184,67 @@ namespace Slayer
 
         size_t GetEntityCount() const
         {
-            return m_entityComponentIndexMap.size();
+            return m_entityCount;
         }
 
         template <typename... Ts>
-        Archetype GetArchetype()
+        Archetype GetArchetype() const
         {
-            const std::vector<uint32_t> hashes = { HashType<Ts>()... };
-
-            // Build a bit mask of all the component types
-            Archetype searchArchetype = 0;
-            for (auto& hash : hashes)
-            {
-                SL_ASSERT(m_components.find(hash) != m_components.end() && "Component not registered before use.");
-                searchArchetype |= (1 << m_components[hash].bitIndex);
-            }
-
-            return searchArchetype;
+            return ToArchetype(std::array<uint32_t, sizeof...(Ts)>{ GetComponentIndex<Ts>()... });
         }
 
         size_t GetComponentCount(Entity entity)
         {
-            Archetype archetype = m_entityComponentIndexMap[entity];
-            // Count the number of bits set in the archetype
-            size_t count = 0;
-            while (archetype)
-            {
-                count += archetype & 1;
-                archetype >>= 1;
-            }
-
-            return count;
+            SL_ASSERT(IsValid(entity) && "Invalid entity.");
+            return m_entityRecords[GetEntityIndex(entity)].archetype->GetArchetype().Count();
         }
 
-        const ComponentDict& GetComponents()
+        const ComponentArray& GetComponents()
         {
             return m_components;
         }
 
         template<typename T, typename... Args>
-        void AddSingleton(Args... args)
+        T* AddSingleton(Args&&... args)
         {
-            uint32_t typeHash = HashType<T>();
-            SL_ASSERT(m_singletons.find(typeHash) == m_singletons.end() && "Singleton already exists.");
-            m_singletons.insert(std::make_pair(typeHash, MakeShared<T>(args)));
+            return m_singletons.Add<T>(std::forward<Args>(args)...);
         }
 
         template<typename T>
         T* GetSingleton()
         {
-            uint32_t typeHash = HashType<T>();
-            SL_ASSERT(m_singletons.find(typeHash) != m_singletons.end() && "Singleton does not exist.");
-            return static_cast<T*>(m_singletons[typeHash].get());
+            return m_singletons.Get<T>();
+        }
+
+        template<typename T>
+        bool HasSingleton()
+        {
+            return m_singletons.Has<T>();
         }
 
         template<typename T>
         void RemoveSingleton()
         {
-            uint32_t typeHash = HashType<T>();
-            if (m_singletons.find(typeHash) != m_singletons.end())
-            {
-                m_singletons.erase(typeHash);
-            }
+            m_singletons.Remove<T>();
+        }
+
+        // Singletons with one instance per worker, for systems that accumulate results in parallel
+        template<typename T, typename... Args>
+        void AddThreadLocalSingleton(Args&&... args)
+        {
+            m_singletons.AddThreadLocal<T>(std::forward<Args>(args)...);
+        }
+
+        template<typename T>
+        T* GetThreadLocalSingleton()
+        {
+            return m_singletons.GetThreadLocal<T>();
+        }
+
+        template<typename T>
+        void ForEachThreadLocalSingleton(auto&& func)
+        {
+            m_singletons.ForEachThreadLocal<T>(func);
         }
 
         template<typename Serializer>
@@ -464,7 +1255,7 @@ namespace Slayer
 
             if (serializer.GetFlags() == SerializationFlags::Read)
             {
-                for (auto& [entity, archetype] : m_entityComponentIndexMap)
+                for (Entity entity : GetAllEntities())
                 {
                     serializer.PushObject();
                     ForEachComponentType([this, &serializer, entity]<typename T>()
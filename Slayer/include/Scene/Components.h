@@ -3,6 +3,7 @@
 #include "Core/Core.h"
 #include "GameTypesDecl.h"
 #include "Resources/Asset.h"
+#include "Scene/Archetype.h"
 #include "Rendering/Renderer/SkeletalModel.h"
 #include "Rendering/Animation/AnimationState.h"
 
@@ -33,7 +34,8 @@ namespace Slayer {
 
     struct Transform
     {
-        AssetID parentId;
+        // EntityID of the parent, 0 for none
+        AssetID parentId = 0;
         Mat4 worldTransform = Mat4(1.0f);
         Vec3 position = Vec3(0.0f);
         Quat rotation = Quat(0.0f, 0.0f, 0.0f, 1.0f);
@@ -148,6 +150,17 @@ namespace Slayer {
         }
     };
 
+    // Resolved links to the parent and children of an entity, kept by ComponentStore::SetParent. The links
+    // are entity handles, so walking them needs no AssetID lookups. Children form a doubly linked list
+    // through their siblings. Not serialized, the saved form of a parent link is Transform::parentId.
+    struct Relationship
+    {
+        Entity parent = SL_INVALID_ENTITY;
+        Entity firstChild = SL_INVALID_ENTITY;
+        Entity previousSibling = SL_INVALID_ENTITY;
+        Entity nextSibling = SL_INVALID_ENTITY;
+    };
+
     // Attaches a entity to a socket on a skeletal model
     struct SocketAttacher
     {
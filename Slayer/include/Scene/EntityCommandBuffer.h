@@ -0,0 +1,177 @@
+#pragma once
+
+#include "Core/Core.h"
+#include "Core/Containers.h"
+#include "Scene/Archetype.h"
+#include "Scene/ComponentIndex.h"
+#include "Scene/Components.h"
+
+// Size of the blocks the recorded components are allocated from
+#define SL_COMMAND_BLOCK_SIZE (64 * 1024)
+
+// Generation used by entities created through a command buffer before they are played back,
+// the store never hands out this generation for real entities.
+#define SL_DEFERRED_GENERATION 0xFFFFFFFF
+
+namespace Slayer
+{
+    // Records structural changes (create, destroy, add and remove component) so that they can be
+    // applied to a ComponentStore later, at a point where no system is iterating it.
+    // A buffer must only be used by one thread at a time.
+    class EntityCommandBuffer
+    {
+    public:
+        enum class CommandType : uint8_t
+        {
+            CreateEntity,
+            DestroyEntity,
+            AddComponent,
+            RemoveComponent
+        };
+
+        struct Command
+        {
+            CommandType type = CommandType::CreateEntity;
+            // Set on the EntityID of CreateEntity, the id is generated during playback
+            bool generateId = false;
+            Entity entity = SL_INVALID_ENTITY;
+            const ComponentInfo* info = nullptr;
+            // The recorded component of AddComponent, constructed in the buffer's arena
+            void* data = nullptr;
+        };
+
+    private:
+        struct Block
+        {
+            uint8_t* data = nullptr;
+            size_t size = 0;
+            size_t used = 0;
+        };
+
+        Vector<Command> m_commands;
+        Vector<Block> m_blocks;
+        size_t m_currentBlock = 0;
+        uint32_t m_createdCount = 0;
+
+        void* Allocate(size_t size, size_t alignment)
+        {
+            while (m_currentBlock < m_blocks.size())
+            {
+                Block& block = m_blocks[m_currentBlock];
+                const size_t offset = (block.used + alignment - 1) & ~(alignment - 1);
+                if (offset + size <= block.size)
+                {
+                    block.used = offset + size;
+                    return block.data + offset;
+                }
+                m_currentBlock++;
+            }
+
+            Block block;
+            block.size = std::max<size_t>(SL_COMMAND_BLOCK_SIZE, size);
+            block.data = static_cast<uint8_t*>(::operator new(block.size, std::align_val_t(SL_CHUNK_ALIGNMENT)));
+            block.used = size;
+            m_blocks.push_back(block);
+            m_currentBlock = m_blocks.size() - 1;
+            return block.data;
+        }
+
+        template <typename C>
+        Command& RecordAdd(Entity entity, C&& component)
+        {
+            using Component = std::decay_t<C>;
+            static_assert(alignof(Component) <= SL_CHUNK_ALIGNMENT, "Component alignment is larger than the block alignment.");
+
+            Command command;
+            command.type = CommandType::AddComponent;
+            command.entity = entity;
+            command.info = &GetStaticComponentInfo<Component>();
+            command.data = new (Allocate(sizeof(Component), alignof(Component))) Component(std::forward<C>(component));
+            return m_commands.emplace_back(command);
+        }
+
+    public:
+        EntityCommandBuffer() = default;
+        ~EntityCommandBuffer()
+        {
+            Clear();
+            for (Block& block : m_blocks)
+            {
+                ::operator delete(block.data, std::align_val_t(SL_CHUNK_ALIGNMENT));
+            }
+        }
+
+        EntityCommandBuffer(const EntityCommandBuffer&) = delete;
+        EntityCommandBuffer& operator=(const EntityCommandBuffer&) = delete;
+
+        static bool IsDeferred(Entity entity)
+        {
+            return entity != SL_INVALID_ENTITY && GetEntityGeneration(entity) == SL_DEFERRED_GENERATION;
+        }
+
+        // Returns a placeholder for the new entity, it can be used in later commands of this buffer
+        // and is replaced by the real entity during playback.
+        Entity CreateEntity()
+        {
+            Entity entity = CreateEntityWithoutID();
+            RecordAdd(entity, EntityID()).generateId = true;
+            return entity;
+        }
+
+        Entity CreateEntityWithoutID()
+        {
+            Command command;
+            command.type = CommandType::CreateEntity;
+            command.entity = MakeEntity(m_createdCount++, SL_DEFERRED_GENERATION);
+            m_commands.push_back(command);
+            return command.entity;
+        }
+
+        void DestroyEntity(Entity entity)
+        {
+            Command command;
+            command.type = CommandType::DestroyEntity;
+            command.entity = entity;
+            m_commands.push_back(command);
+        }
+
+        // Adds the component on playback, a component the entity already has is replaced.
+        template <typename C>
+        void AddComponent(Entity entity, C component)
+        {
+            RecordAdd(entity, std::move(component));
+        }
+
+        template <typename C>
+        void RemoveComponent(Entity entity)
+        {
+            Command command;
+            command.type = CommandType::RemoveComponent;
+            command.entity = entity;
+            command.info = &GetStaticComponentInfo<C>();
+            m_commands.push_back(command);
+        }
+
+        const Vector<Command>& GetCommands() const { return m_commands; }
+        uint32_t GetCreatedCount() const { return m_createdCount; }
+        bool IsEmpty() const { return m_commands.empty(); }
+
+        // Destroys the recorded components and forgets all commands, the arena memory is kept for reuse.
+        void Clear()
+        {
+            for (const Command& command : m_commands)
+            {
+                if (command.data != nullptr)
+                    command.info->destroy(command.data);
+            }
+
+            m_commands.clear();
+            for (Block& block : m_blocks)
+            {
+                block.used = 0;
+            }
+            m_currentBlock = 0;
+            m_createdCount = 0;
+        }
+    };
+}
@@ -0,0 +1,147 @@
+#pragma once
+
+#include "Core/Core.h"
+#include "Core/Containers.h"
+#include "Resources/Asset.h"
+#include "Scene/Archetype.h"
+
+namespace Slayer
+{
+    // Maps AssetIDs to entities with open addressing in one flat array. Collisions are resolved by linear
+    // probing, and erasing shifts the following entries back instead of leaving tombstones, so a lookup
+    // only ever scans the entries that share its cluster.
+    class EntityIdIndex
+    {
+    private:
+        // Empty slots have an invalid entity, so that every AssetID can be a key
+        struct Slot
+        {
+            AssetID id = 0;
+            Entity entity = SL_INVALID_ENTITY;
+        };
+
+        static constexpr size_t MinCapacity = 16;
+
+        Vector<Slot> m_slots;
+        size_t m_size = 0;
+        size_t m_mask = 0;
+
+        // Generated AssetIDs are random, but ids given by hand are often sequential, so the bits are mixed
+        static size_t Hash(AssetID id)
+        {
+            id ^= id >> 33;
+            id *= 0xff51afd7ed558ccdULL;
+            id ^= id >> 33;
+            return (size_t)id;
+        }
+
+        size_t FindSlot(AssetID id) const
+        {
+            size_t slot = Hash(id) & m_mask;
+            while (m_slots[slot].entity != SL_INVALID_ENTITY && m_slots[slot].id != id)
+                slot = (slot + 1) & m_mask;
+            return slot;
+        }
+
+        void Rehash(size_t capacity)
+        {
+            Vector<Slot> slots(capacity);
+            std::swap(slots, m_slots);
+            m_mask = capacity - 1;
+            for (const Slot& slot : slots)
+            {
+                if (slot.entity != SL_INVALID_ENTITY)
+                    m_slots[FindSlot(slot.id)] = slot;
+            }
+        }
+
+        void EraseSlot(size_t slot)
+        {
+            // Move back every later entry of the cluster whose home slot is not between the hole and itself
+            size_t next = slot;
+            while (true)
+            {
+                next = (next + 1) & m_mask;
+                if (m_slots[next].entity == SL_INVALID_ENTITY)
+                    break;
+
+                const size_t home = Hash(m_slots[next].id) & m_mask;
+                if (((next - home) & m_mask) >= ((next - slot) & m_mask))
+                {
+                    m_slots[slot] = m_slots[next];
+                    slot = next;
+                }
+            }
+
+            m_slots[slot] = Slot();
+            m_size--;
+        }
+
+    public:
+        EntityIdIndex() = default;
+        ~EntityIdIndex() = default;
+
+        // Maps the id to the entity, replacing any entity it was mapped to.
+        void Set(AssetID id, Entity entity)
+        {
+            SL_ASSERT(entity != SL_INVALID_ENTITY && "Cannot map an id to an invalid entity.");
+
+            // Kept at most half full, so that lookups of missing ids stop early
+            if ((m_size + 1) * 2 > m_slots.size())
+                Rehash(std::max(MinCapacity, m_slots.size() * 2));
+
+            Slot& slot = m_slots[FindSlot(id)];
+            if (slot.entity == SL_INVALID_ENTITY)
+                m_size++;
+            slot.id = id;
+            slot.entity = entity;
+        }
+
+        // Returns the entity mapped to the id, or SL_INVALID_ENTITY.
+        Entity Find(AssetID id) const
+        {
+            return m_size > 0 ? m_slots[FindSlot(id)].entity : SL_INVALID_ENTITY;
+        }
+
+        bool Contains(AssetID id) const { return Find(id) != SL_INVALID_ENTITY; }
+
+        void Erase(AssetID id)
+        {
+            if (m_size == 0)
+                return;
+
+            const size_t slot = FindSlot(id);
+            if (m_slots[slot].entity != SL_INVALID_ENTITY)
+                EraseSlot(slot);
+        }
+
+        // Erases the id only if it is still mapped to the entity, the id may have been given to another entity since.
+        void Erase(AssetID id, Entity entity)
+        {
+            if (m_size == 0)
+                return;
+
+            const size_t slot = FindSlot(id);
+            if (m_slots[slot].entity == entity)
+                EraseSlot(slot);
+        }
+
+        void Reserve(size_t count)
+        {
+            size_t capacity = MinCapacity;
+            while (count * 2 > capacity)
+                capacity *= 2;
+            if (capacity > m_slots.size())
+                Rehash(capacity);
+        }
+
+        void Clear()
+        {
+            m_slots.clear();
+            m_size = 0;
+            m_mask = 0;
+        }
+
+        size_t Size() const { return m_size; }
+    };
+}
@@ -0,0 +1,197 @@
+#pragma once
+
+#include "Scene/ComponentStore.h"
+
+namespace Slayer
+{
+    // Excludes entities that have any of the components from a query.
+    template <typename... Ts>
+    struct Without {};
+
+    // Only visits entities where any of the components changed since the query last ran.
+    // The components are required but not passed to the query function.
+    template <typename... Ts>
+    struct Changed {};
+
+    namespace QueryTerms
+    {
+        template <typename... Ts>
+        struct TypeList {};
+
+        template <typename... Lists>
+        struct Concat { using Type = TypeList<>; };
+
+        template <typename... Ts>
+        struct Concat<TypeList<Ts...>> { using Type = TypeList<Ts...>; };
+
+        template <typename... As, typename... Bs, typename... Rest>
+        struct Concat<TypeList<As...>, TypeList<Bs...>, Rest...>
+        {
+            using Type = typename Concat<TypeList<As..., Bs...>, Rest...>::Type;
+        };
+
+        template <typename T>
+        struct Included { using Type = TypeList<T>; };
+
+        template <typename... Ts>
+        struct Included<Without<Ts...>> { using Type = TypeList<>; };
+
+        template <typename... Ts>
+        struct Included<Changed<Ts...>> { using Type = TypeList<>; };
+
+        template <typename T>
+        struct Excluded { using Type = TypeList<>; };
+
+        template <typename... Ts>
+        struct Excluded<Without<Ts...>> { using Type = TypeList<Ts...>; };
+
+        template <typename T>
+        struct ChangeFiltered { using Type = TypeList<>; };
+
+        template <typename... Ts>
+        struct ChangeFiltered<Changed<Ts...>> { using Type = TypeList<Ts...>; };
+
+        template <typename List>
+        struct Size;
+
+        template <typename... Ts>
+        struct Size<TypeList<Ts...>> { static constexpr size_t value = sizeof...(Ts); };
+    }
+
+    // A persistent query that caches the archetypes matching its terms. Only archetypes created since
+    // the query was last used are tested, so iterating it costs nothing beyond visiting the matches.
+    // Terms are the required components, optionally with Without<...> exclusions and Changed<...> filters:
+    //
+    //     Query<Transform, ModelRenderer, Without<SkeletalRenderer>> query;
+    //     query.ForEach(store, [](Entity entity, Transform* transform, ModelRenderer* renderer) { ... });
+    //
+    // Components requested as const are read-only, all others are marked as changed for the entities visited.
+    template <typename... Terms>
+    class Query
+    {
+    private:
+        using IncludedTypes = typename QueryTerms::Concat<typename QueryTerms::Included<Terms>::Type...>::Type;
+        using ExcludedTypes = typename QueryTerms::Concat<typename QueryTerms::Excluded<Terms>::Type...>::Type;
+        using ChangedTypes = typename QueryTerms::Concat<typename QueryTerms::ChangeFiltered<Terms>::Type...>::Type;
+        static constexpr size_t IncludedCount = QueryTerms::Size<IncludedTypes>::value;
+        static constexpr size_t ChangedCount = QueryTerms::Size<ChangedTypes>::value;
+
+        uint64_t m_storeId = 0;
+        std::array<uint32_t, IncludedCount> m_bitIndices = {};
+        std::array<uint32_t, ChangedCount> m_changedBits = {};
+        // Change version of the store when the query last ran, changes after it are visited
+        uint32_t m_lastVersion = 0;
+        ArchetypeQueryCache m_cache;
+
+        template <typename... Ts, typename... Es, typename... Cs>
+        void Bind(ComponentStore& store, QueryTerms::TypeList<Ts...>, QueryTerms::TypeList<Es...>, QueryTerms::TypeList<Cs...>)
+        {
+            if (m_storeId != store.m_storeId)
+            {
+                m_storeId = store.m_storeId;
+                m_bitIndices = { GetComponentIndex<Ts>()... };
+                m_changedBits = { GetComponentIndex<Cs>()... };
+                m_lastVersion = 0;
+                m_cache.Reset(ComponentStore::ToArchetype(m_bitIndices) | ComponentStore::ToArchetype(m_changedBits), store.GetArchetype<Es...>());
+            }
+
+            m_cache.Update(store.m_archetypeList);
+        }
+
+        void Bind(ComponentStore& store)
+        {
+            Bind(store, IncludedTypes{}, ExcludedTypes{}, ChangedTypes{});
+        }
+
+        template <typename... Ts>
+        void ForEachImpl(ComponentStore& store, auto& func, QueryTerms::TypeList<Ts...>)
+        {
+            if constexpr (ChangedCount == 0)
+            {
+                ForEachRow<Ts...>(m_cache.archetypes, m_bitIndices, func, std::index_sequence_for<Ts...>{}, store.m_changeVersion);
+            }
+            else
+            {
+                // Writes made by func get this run's version, which the next run does not see as changes.
+                // The store version is advanced again afterwards so that any later write is newer.
+                const uint32_t version = ++store.m_changeVersion;
+                ForEachChangedRow<Ts...>(m_cache.archetypes, m_bitIndices, m_changedBits, m_lastVersion, func, std::index_sequence_for<Ts...>{}, version);
+                m_lastVersion = version;
+                ++store.m_changeVersion;
+            }
+        }
+
+        template <typename... Ts>
+        void ForEachRunImpl(ComponentStore& store, auto& func, QueryTerms::TypeList<Ts...>)
+        {
+            static_assert(ChangedCount == 0, "Changed<> filters are not supported by ForEachRun.");
+            store.SortArchetypes(m_cache.archetypes);
+            Slayer::ForEachRun<Ts...>(m_cache.archetypes, m_bitIndices, func, std::index_sequence_for<Ts...>{}, store.m_changeVersion);
+        }
+
+        template <typename... Ts>
+        void ParallelForEachImpl(ComponentStore& store, auto& func, uint32_t grainSize, Partitioning partitioning, QueryTerms::TypeList<Ts...>)
+        {
+            static_assert(ChangedCount == 0, "Changed<> filters are not supported by ParallelForEach.");
+            store.ParallelForEachImpl<Ts...>(m_cache.archetypes, m_bitIndices, func, grainSize, partitioning);
+        }
+
+    public:
+        // Returns the archetypes matching the query, updated with any archetypes created since the last call.
+        // Changed<> filters are not applied.
+        const Vector<ArchetypeStorage*>& GetArchetypes(ComponentStore& store)
+        {
+            Bind(store);
+            return m_cache.archetypes;
+        }
+
+        // Calls func(entity, components...) for every matching entity, with one pointer per required component.
+        void ForEach(ComponentStore& store, auto&& func)
+        {
+            Bind(store);
+            ForEachImpl(store, func, IncludedTypes{});
+        }
+
+        // Same as ComponentStore::ForEachRun but over the cached archetypes.
+        void ForEachRun(ComponentStore& store, auto&& func)
+        {
+            Bind(store);
+            ForEachRunImpl(store, func, IncludedTypes{});
+        }
+
+        // Same as ComponentStore::ParallelForEach but over the cached archetypes.
+        void ParallelForEach(ComponentStore& store, auto&& func, uint32_t grainSize = 256, Partitioning partitioning = Partitioning::Balanced)
+        {
+            Bind(store);
+            ParallelForEachImpl(store, func, grainSize, partitioning, IncludedTypes{});
+        }
+
+        // Treats every change made so far as seen by the Changed<> filters, for example after the
+        // caller wrote derived data back to the components it watches.
+        void SkipChanges(ComponentStore& store)
+        {
+            Bind(store);
+            m_lastVersion = store.m_changeVersion++;
+        }
+
+        size_t Count(ComponentStore& store)
+        {
+            size_t count = 0;
+            for (ArchetypeStorage* storage : GetArchetypes(store))
+            {
+                count += storage->Size();
+            }
+            return count;
+        }
+
+        std::vector<Entity> GetEntities(ComponentStore& store)
+        {
+            std::vector<Entity> entities;
+            for (ArchetypeStorage* storage : GetArchetypes(store))
+            {
+                ComponentStore::AppendEntities(*storage, entities);
+            }
+            return entities;
+        }
+    };
+}
@@ -0,0 +1,155 @@
+#pragma once
+
+#include "Core/Core.h"
+#include "Core/Containers.h"
+#include "Jobs/ThreadManager.h"
+
+#include <atomic>
+#include <new>
+
+// Thread-local singletons have one instance per worker plus one for threads outside the pool
+#define SL_THREAD_LOCAL_INSTANCES (SL_MAX_WORKERS + 1)
+
+namespace Slayer
+{
+    inline std::atomic<uint32_t> s_nextSingletonIndex = 0;
+
+    // Returns the slot of a singleton type in a SingletonRegistry. The index is fixed on first use
+    // and shared by every registry, so a lookup is an array access.
+    template <typename T>
+    uint32_t GetSingletonIndex()
+    {
+        static const uint32_t index = s_nextSingletonIndex.fetch_add(1);
+        return index;
+    }
+
+    // Owns one instance of each singleton type. Instances are constructed in place and keep their
+    // address until they are removed.
+    class SingletonRegistry
+    {
+    private:
+        struct Slot
+        {
+            // Instance, or the first of SL_THREAD_LOCAL_INSTANCES instances stride bytes apart
+            uint8_t* data = nullptr;
+            size_t stride = 0;
+            size_t alignment = 0;
+            uint32_t instanceCount = 0;
+            void (*destroy)(void*) = nullptr;
+        };
+
+        Vector<Slot> m_slots;
+
+        template <typename T>
+        Slot* FindSlot()
+        {
+            const uint32_t index = GetSingletonIndex<T>();
+            return index < m_slots.size() && m_slots[index].data != nullptr ? &m_slots[index] : nullptr;
+        }
+
+        template <typename T, typename... Args>
+        T* Create(uint32_t instanceCount, Args&&... args)
+        {
+            const uint32_t index = GetSingletonIndex<T>();
+            if (index >= m_slots.size())
+                m_slots.resize(index + 1);
+
+            Slot& slot = m_slots[index];
+            SL_ASSERT(slot.data == nullptr && "Singleton already exists.");
+
+            // Thread-local instances get their own cache lines so that workers do not share them
+            slot.alignment = std::max<size_t>(alignof(T), instanceCount > 1 ? 64 : alignof(T));
+            slot.stride = (sizeof(T) + slot.alignment - 1) & ~(slot.alignment - 1);
+            slot.instanceCount = instanceCount;
+            slot.destroy = [](void* data) { static_cast<T*>(data)->~T(); };
+            slot.data = static_cast<uint8_t*>(::operator new(slot.stride * instanceCount, std::align_val_t(slot.alignment)));
+
+            for (uint32_t i = 0; i < instanceCount; i++)
+                new (slot.data + slot.stride * i) T(args...);
+
+            return reinterpret_cast<T*>(slot.data);
+        }
+
+        static void Destroy(Slot& slot)
+        {
+            for (uint32_t i = 0; i < slot.instanceCount; i++)
+                slot.destroy(slot.data + slot.stride * i);
+
+            ::operator delete(slot.data, std::align_val_t(slot.alignment));
+            slot = Slot();
+        }
+
+    public:
+        SingletonRegistry() = default;
+        ~SingletonRegistry() { Clear(); }
+
+        SingletonRegistry(const SingletonRegistry&) = delete;
+        SingletonRegistry& operator=(const SingletonRegistry&) = delete;
+
+        template <typename T, typename... Args>
+        T* Add(Args&&... args)
+        {
+            return Create<T>(1, std::forward<Args>(args)...);
+        }
+
+        // Adds one instance per worker, each constructed from the same arguments.
+        template <typename T, typename... Args>
+        void AddThreadLocal(Args&&... args)
+        {
+            Create<T>(SL_THREAD_LOCAL_INSTANCES, std::forward<Args>(args)...);
+        }
+
+        template <typename T>
+        T* Get()
+        {
+            const uint32_t index = GetSingletonIndex<T>();
+            SL_ASSERT(index < m_slots.size() && m_slots[index].instanceCount == 1 && "Singleton does not exist.");
+            return reinterpret_cast<T*>(m_slots[index].data);
+        }
+
+        // Returns the instance of the calling worker, threads outside the pool share one instance.
+        template <typename T>
+        T* GetThreadLocal()
+        {
+            const uint32_t index = GetSingletonIndex<T>();
+            SL_ASSERT(index < m_slots.size() && m_slots[index].instanceCount == SL_THREAD_LOCAL_INSTANCES && "Thread-local singleton does not exist.");
+
+            ThreadManager* threadManager = ThreadManager::Get();
+            const int32_t workerIndex = threadManager != nullptr ? threadManager->GetCurrentWorkerIndex() : -1;
+            const Slot& slot = m_slots[index];
+            return reinterpret_cast<T*>(slot.data + slot.stride * (workerIndex + 1));
+        }
+
+        // Calls func(T*) for every instance of a thread-local singleton, for example to merge them after a parallel system.
+        template <typename T>
+        void ForEachThreadLocal(auto&& func)
+        {
+            Slot* slot = FindSlot<T>();
+            SL_ASSERT(slot != nullptr && slot->instanceCount == SL_THREAD_LOCAL_INSTANCES && "Thread-local singleton does not exist.");
+            for (uint32_t i = 0; i < slot->instanceCount; i++)
+                func(reinterpret_cast<T*>(slot->data + slot->stride * i));
+        }
+
+        template <typename T>
+        bool Has()
+        {
+            return FindSlot<T>() != nullptr;
+        }
+
+        template <typename T>
+        void Remove()
+        {
+            if (Slot* slot = FindSlot<T>())
+                Destroy(*slot);
+        }
+
+        void Clear()
+        {
+            for (Slot& slot : m_slots)
+            {
+                if (slot.data != nullptr)
+                    Destroy(slot);
+            }
+        }
+    };
+}
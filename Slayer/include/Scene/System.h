@@ -1,6 +1,8 @@
 #pragma once
 
 #include "Core/Core.h"
+#include "Scene/Archetype.h"
+#include "Scene/ComponentIndex.h"
 
 namespace Slayer {
 
@@ -16,22 +18,66 @@ namespace Slayer {
         SL_GROUP_ANIMATION = 1 << 6,
     };
 
-    template <SystemGroup ...Groups>
-    class System
+    // Common base of all systems, used by the SystemManager to schedule them.
+    // Systems declare the components they access in their constructor with Reads<...>() and Writes<...>(),
+    // two systems may run at the same time when neither writes a component the other one accesses.
+    // A system that declares nothing is exclusive and never runs alongside another system.
+    class SystemBase
     {
     private:
-        uint32_t m_groupFlags = (Groups | ...);
+        uint32_t m_groupFlags = SL_GROUP_NONE;
+        Archetype m_reads;
+        Archetype m_writes;
+        bool m_exclusive = true;
+
+    protected:
+        template <typename... Ts>
+        void Reads()
+        {
+            (m_reads.Set(GetComponentIndex<Ts>()), ...);
+            m_exclusive = false;
+        }
+
+        template <typename... Ts>
+        void Writes()
+        {
+            (m_writes.Set(GetComponentIndex<Ts>()), ...);
+            m_exclusive = false;
+        }
+
+        // For systems that make structural changes to the store directly instead of through command buffers
+        void Exclusive() { m_exclusive = true; }
+
     public:
-        System() = default;
-        virtual ~System() = default;
+        explicit SystemBase(uint32_t groupFlags) : m_groupFlags(groupFlags) {}
+        virtual ~SystemBase() = default;
 
-        constexpr uint32_t GetGroupFlags() const { return m_groupFlags; }
+        uint32_t GetGroupFlags() const { return m_groupFlags; }
         bool IsInGroup(SystemGroup group) const { return m_groupFlags & group; }
 
+        const Archetype& GetReads() const { return m_reads; }
+        const Archetype& GetWrites() const { return m_writes; }
+        bool IsExclusive() const { return m_exclusive; }
+
+        bool ConflictsWith(const SystemBase& other) const
+        {
+            return m_exclusive || other.m_exclusive
+                || m_writes.Intersects(other.m_writes | other.m_reads)
+                || other.m_writes.Intersects(m_reads);
+        }
+
         virtual void Initialize() = 0;
         virtual void Shutdown() = 0;
-        virtual void Update(Timespan dt, class ComponentStore& store) { SL_ASSERT(false && "Render function not implemented"); }
+        virtual void Update(Timespan dt, class ComponentStore& store) { SL_ASSERT(false && "Update function not implemented"); }
         virtual void Render(class Renderer& renderer, class ComponentStore& store) { SL_ASSERT(false && "Render function not implemented"); }
     };
 
-}
\ No newline at end of file
+    template <SystemGroup ...Groups>
+    class System : public SystemBase
+    {
+    public:
+        System() : SystemBase((Groups | ...)) {}
+        virtual ~System() = default;
+    };
+
+}
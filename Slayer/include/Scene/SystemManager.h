@@ -4,20 +4,80 @@
 #include "Core/Containers.h"
 #include "Scene/System.h"
 
+#include <atomic>
+
 namespace Slayer {
 
+    class ComponentStore;
+    class Job;
+
+    struct SystemTiming
+    {
+        std::string name;
+        // Wall time of the last Update in milliseconds
+        double updateTime = 0.0;
+    };
+
+    // Runs the Update of the registered systems on the worker pool. Systems of groups earlier in the group
+    // order run before systems of later groups, and systems of the same group run in the order they were added,
+    // but only where their declared component accesses conflict. Everything else runs concurrently.
+    // Systems that run concurrently must not change the structure of the store, they record changes in
+    // ComponentStore::GetCommandBuffer() instead.
     class SystemManager
     {
     private:
-        Dict<SystemGroup, Vector<class System*>> m_systems;
+        struct SystemNode
+        {
+            SystemBase* system = nullptr;
+            uint32_t order = 0;
+            Vector<uint32_t> successors;
+            uint32_t dependencyCount = 0;
+        };
+
+        struct SystemJobData
+        {
+            SystemManager* manager;
+            uint32_t node;
+        };
+
+        Vector<SystemNode> m_systems;
+        // Node indices sorted by group order and then by the order the systems were added
+        Vector<uint32_t> m_executionOrder;
+        Vector<SystemGroup> m_groupOrder;
+        Vector<SystemTiming> m_timings;
+        bool m_graphDirty = false;
+
+        // State of the Update in progress
+        Timespan m_frameDelta = 0.0f;
+        ComponentStore* m_frameStore = nullptr;
+        Vector<Job*> m_frameJobs;
+        Unique<std::atomic<uint32_t>[]> m_remainingDependencies;
+
+        uint32_t GetGroupOrder(const SystemBase& system) const;
+        void BuildGraph();
+        void RunSystem(uint32_t node);
+        static void RunSystemJob(Job& job);
+
     public:
         SystemManager();
         ~SystemManager();
 
+        // The system must outlive the manager. The name is used for timings.
+        void AddSystem(SystemBase* system, const std::string& name);
+        void RemoveSystem(SystemBase* system);
+
+        // Groups not in the list run after every listed group.
+        void SetGroupOrder(const Vector<SystemGroup>& order);
+
         void Initialize();
         void Shutdown();
 
-        void Update(float dt);
+        void Update(Timespan dt, ComponentStore& store);
+
+        // Returns true if a always finishes before b starts, directly or through other systems.
+        bool RunsBefore(const SystemBase* a, const SystemBase* b);
+
+        const Vector<SystemTiming>& GetTimings() const { return m_timings; }
     };
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,360 @@
+#pragma once
+
+#include "Core/Core.h"
+#include "Core/Containers.h"
+#include "Core/TransformKernel.h"
+#include "Scene/ComponentStore.h"
+#include "Scene/Query.h"
+#include "Jobs/ParallelFor.h"
+
+// Levels with fewer nodes than this are propagated on the calling thread
+#define SL_HIERARCHY_PARALLEL_THRESHOLD 4096
+// Number of nodes propagated by one job
+#define SL_HIERARCHY_BATCH_SIZE 1024
+
+namespace Slayer
+{
+    // Resolves the parent of every Transform into cached parent and child links and computes the world matrices.
+    // Entities with a Relationship use its parent, all others resolve their Transform's parentId.
+    // Nodes are kept in breadth-first order, so every depth level is contiguous and parents always come before
+    // their children. Only changed transforms and their descendants are recomputed, level by level.
+    class TransformHierarchy
+    {
+    public:
+        static constexpr uint32_t InvalidNode = 0xFFFFFFFF;
+
+        struct Node
+        {
+            Entity entity = SL_INVALID_ENTITY;
+            Entity parent = SL_INVALID_ENTITY;
+            // The parentId the parent was resolved from, unused for entities with a Relationship
+            AssetID parentId = 0;
+            uint32_t parentNode = InvalidNode;
+            // Children are stored contiguously in the next level
+            uint32_t firstChild = 0;
+            uint32_t childCount = 0;
+        };
+
+    private:
+        Vector<Node> m_nodes;
+        Vector<Mat4> m_localMatrices;
+        Vector<Mat4> m_worldMatrices;
+        Vector<uint8_t> m_dirty;
+        // Nodes of depth d are in [m_levelOffsets[d], m_levelOffsets[d + 1])
+        Vector<uint32_t> m_levelOffsets;
+        // Node of each entity, indexed by entity index
+        Vector<uint32_t> m_entityNodes;
+        bool m_topologyChanged = false;
+
+        // Changed transforms of the current update, their local matrices are composed in one batch
+        TRSBuffer m_changedTRS;
+        Vector<uint32_t> m_changedNodes;
+        Vector<Mat4> m_composed;
+
+        Query<const Transform, Changed<Transform>> m_changedQuery;
+        Query<const Relationship, Changed<Relationship>> m_relationshipQuery;
+        Query<const Transform, const SocketAttacher> m_socketQuery;
+
+        uint32_t AddNode(Entity entity)
+        {
+            const uint32_t node = (uint32_t)m_nodes.size();
+            m_nodes.push_back({ entity });
+            m_localMatrices.push_back(Mat4(1.0f));
+            m_worldMatrices.push_back(Mat4(1.0f));
+            m_dirty.push_back(1);
+
+            const uint32_t index = GetEntityIndex(entity);
+            if (index >= m_entityNodes.size())
+                m_entityNodes.resize(index + 1, InvalidNode);
+            m_entityNodes[index] = node;
+            return node;
+        }
+
+        // Drops removed entities, resolves parents and sorts the nodes breadth-first.
+        void Rebuild(ComponentStore& store)
+        {
+            const uint32_t oldCount = (uint32_t)m_nodes.size();
+            Vector<uint32_t> live;
+            live.reserve(oldCount);
+            for (uint32_t i = 0; i < oldCount; i++)
+            {
+                if (store.HasComponent<Transform>(m_nodes[i].entity))
+                    live.push_back(i);
+                else
+                    m_entityNodes[GetEntityIndex(m_nodes[i].entity)] = InvalidNode;
+            }
+
+            // Resolve parents to positions in the live list, parents without a Transform are ignored
+            const uint32_t count = (uint32_t)live.size();
+            Vector<uint32_t> parents(count, InvalidNode);
+            Vector<uint32_t> childStart(count + 1, 0);
+            for (uint32_t i = 0; i < count; i++)
+            {
+                Node& node = m_nodes[live[i]];
+                if (store.HasComponent<Relationship>(node.entity))
+                    node.parent = store.GetComponent<const Relationship>(node.entity)->parent;
+                else if (!store.IsValid(node.parent))
+                    node.parent = node.parentId != 0 ? store.GetEntity(node.parentId) : SL_INVALID_ENTITY;
+
+                const uint32_t parentNode = FindNode(node.parent);
+                if (parentNode == InvalidNode || parentNode == live[i])
+                    continue;
+
+                // Live nodes keep their relative order, so the position is found by binary search
+                parents[i] = (uint32_t)(std::lower_bound(live.begin(), live.end(), parentNode) - live.begin());
+                childStart[parents[i] + 1]++;
+            }
+
+            for (uint32_t i = 0; i < count; i++)
+                childStart[i + 1] += childStart[i];
+
+            Vector<uint32_t> children(childStart[count]);
+            Vector<uint32_t> childFill(childStart.begin(), childStart.end() - 1);
+            for (uint32_t i = 0; i < count; i++)
+            {
+                if (parents[i] != InvalidNode)
+                    children[childFill[parents[i]]++] = i;
+            }
+
+            // Breadth-first from the roots. Nodes that are never reached are part of a parent cycle,
+            // their links are broken and they are added as roots.
+            Vector<uint32_t> order;
+            Vector<uint32_t> firstChild(count, 0);
+            Vector<uint8_t> reached(count, 0);
+            order.reserve(count);
+            for (uint32_t i = 0; i < count; i++)
+            {
+                if (parents[i] == InvalidNode)
+                {
+                    order.push_back(i);
+                    reached[i] = 1;
+                }
+            }
+
+            m_levelOffsets.clear();
+            uint32_t levelBegin = 0;
+            while (true)
+            {
+                if (levelBegin == order.size() && order.size() < count)
+                {
+                    for (uint32_t i = 0; i < count; i++)
+                    {
+                        if (!reached[i])
+                        {
+                            parents[i] = InvalidNode;
+                            order.push_back(i);
+                            reached[i] = 1;
+                            break;
+                        }
+                    }
+                }
+
+                if (levelBegin == order.size())
+                    break;
+
+                m_levelOffsets.push_back(levelBegin);
+                const uint32_t levelEnd = (uint32_t)order.size();
+                for (uint32_t i = levelBegin; i < levelEnd; i++)
+                {
+                    const uint32_t node = order[i];
+                    firstChild[node] = (uint32_t)order.size();
+                    for (uint32_t c = childStart[node]; c < childStart[node + 1]; c++)
+                    {
+                        if (!reached[children[c]])
+                        {
+                            order.push_back(children[c]);
+                            reached[children[c]] = 1;
+                        }
+                    }
+                }
+                levelBegin = levelEnd;
+            }
+            m_levelOffsets.push_back(count);
+
+            Vector<uint32_t> newIndex(count);
+            for (uint32_t i = 0; i < count; i++)
+                newIndex[order[i]] = i;
+
+            Vector<Node> nodes(count);
+            Vector<Mat4> localMatrices(count);
+            for (uint32_t i = 0; i < count; i++)
+            {
+                const uint32_t source = order[i];
+                Node& node = nodes[i];
+                node = m_nodes[live[source]];
+                node.parentNode = parents[source] != InvalidNode ? newIndex[parents[source]] : InvalidNode;
+                node.firstChild = firstChild[source];
+                node.childCount = 0;
+                localMatrices[i] = m_localMatrices[live[source]];
+                m_entityNodes[GetEntityIndex(node.entity)] = i;
+            }
+
+            for (uint32_t i = 0; i < count; i++)
+            {
+                if (nodes[i].parentNode != InvalidNode)
+                    nodes[nodes[i].parentNode].childCount++;
+                else
+                    nodes[i].parent = SL_INVALID_ENTITY;
+            }
+
+            m_nodes = std::move(nodes);
+            m_localMatrices = std::move(localMatrices);
+            m_worldMatrices.assign(count, Mat4(1.0f));
+            m_dirty.assign(count, 1);
+            m_topologyChanged = false;
+        }
+
+        void PropagateRange(uint32_t begin, uint32_t end)
+        {
+            for (uint32_t i = begin; i < end; i++)
+            {
+                const uint32_t parent = m_nodes[i].parentNode;
+                if (parent == InvalidNode)
+                {
+                    if (m_dirty[i])
+                        m_worldMatrices[i] = m_localMatrices[i];
+                }
+                else
+                {
+                    m_dirty[i] |= m_dirty[parent];
+                    if (m_dirty[i])
+                        m_worldMatrices[i] = m_worldMatrices[parent] * m_localMatrices[i];
+                }
+            }
+        }
+
+        // Computes the world matrices level by level, the nodes of a large level are split across the workers.
+        void Propagate()
+        {
+            for (size_t level = 0; level + 1 < m_levelOffsets.size(); level++)
+            {
+                const uint32_t begin = m_levelOffsets[level];
+                const uint32_t end = m_levelOffsets[level + 1];
+                if (end - begin < SL_HIERARCHY_PARALLEL_THRESHOLD)
+                    PropagateRange(begin, end);
+                else
+                    ParallelFor(begin, end, SL_HIERARCHY_BATCH_SIZE, [this](uint32_t first, uint32_t last) { PropagateRange(first, last); });
+            }
+        }
+
+    public:
+        TransformHierarchy() = default;
+        ~TransformHierarchy() = default;
+
+        // Brings the hierarchy up to date with the store and writes the world matrix of every transform that moved.
+        void Update(ComponentStore& store)
+        {
+            for (const Node& node : m_nodes)
+            {
+                if (!store.HasComponent<Transform>(node.entity) || (node.parent != SL_INVALID_ENTITY && !store.IsValid(node.parent)))
+                {
+                    m_topologyChanged = true;
+                    break;
+                }
+            }
+
+            m_changedQuery.ForEach(store, [&](Entity entity, const Transform* transform)
+                {
+                    uint32_t node = FindNode(entity);
+                    if (node == InvalidNode)
+                    {
+                        node = AddNode(entity);
+                        m_topologyChanged = true;
+                    }
+
+                    if (m_nodes[node].parentId != transform->parentId)
+                    {
+                        m_nodes[node].parentId = transform->parentId;
+                        m_nodes[node].parent = SL_INVALID_ENTITY;
+                        m_topologyChanged = true;
+                    }
+
+                    m_changedTRS.Push(transform->position, transform->rotation, transform->scale);
+                    m_changedNodes.push_back(node);
+                    m_dirty[node] = 1;
+                });
+
+            m_relationshipQuery.ForEach(store, [&](Entity entity, const Relationship* relationship)
+                {
+                    const uint32_t node = FindNode(entity);
+                    if (node != InvalidNode && m_nodes[node].parent != relationship->parent)
+                        m_topologyChanged = true;
+                });
+
+            m_composed.resize(m_changedNodes.size());
+            ComposeTRS(m_changedTRS.GetArrays(), m_composed.data());
+            for (size_t i = 0; i < m_changedNodes.size(); i++)
+                m_localMatrices[m_changedNodes[i]] = m_composed[i];
+            m_changedTRS.Clear();
+            m_changedNodes.clear();
+
+            if (m_topologyChanged)
+                Rebuild(store);
+
+            // Socket attachments follow the animated skeleton of their parent, so they are updated every frame
+            m_socketQuery.ForEach(store, [&](Entity entity, const Transform* transform, const SocketAttacher* attacher)
+                {
+                    const uint32_t node = FindNode(entity);
+                    const Entity parent = m_nodes[node].parent;
+                    if (store.HasComponent<SkeletalSockets>(parent))
+                        m_localMatrices[node] = store.GetComponent<const SkeletalSockets>(parent)->GetWorldTransform(attacher->name) * transform->GetMatrix();
+                    else
+                        m_localMatrices[node] = transform->GetMatrix();
+                    m_dirty[node] = 1;
+                });
+
+            Propagate();
+
+            for (uint32_t i = 0; i < m_nodes.size(); i++)
+            {
+                if (m_dirty[i])
+                {
+                    store.GetComponent<Transform>(m_nodes[i].entity)->worldTransform = m_worldMatrices[i];
+                    m_dirty[i] = 0;
+                }
+            }
+
+            // The world matrices written above are not changes to react to
+            m_changedQuery.SkipChanges(store);
+        }
+
+        uint32_t FindNode(Entity entity) const
+        {
+            const uint32_t index = GetEntityIndex(entity);
+            if (entity == SL_INVALID_ENTITY || index >= m_entityNodes.size())
+                return InvalidNode;
+
+            const uint32_t node = m_entityNodes[index];
+            return node < m_nodes.size() && m_nodes[node].entity == entity ? node : InvalidNode;
+        }
+
+        // Returns the parent of the entity, or SL_INVALID_ENTITY for roots and entities not in the hierarchy.
+        Entity GetParent(Entity entity) const
+        {
+            const uint32_t node = FindNode(entity);
+            return node != InvalidNode ? m_nodes[node].parent : SL_INVALID_ENTITY;
+        }
+
+        // Calls func(child) for every direct child of the entity.
+        void ForEachChild(Entity entity, auto&& func) const
+        {
+            const uint32_t node = FindNode(entity);
+            if (node == InvalidNode)
+                return;
+
+            for (uint32_t i = 0; i < m_nodes[node].childCount; i++)
+                func(m_nodes[m_nodes[node].firstChild + i].entity);
+        }
+
+        const Mat4& GetWorldMatrix(Entity entity) const
+        {
+            const uint32_t node = FindNode(entity);
+            SL_ASSERT(node != InvalidNode && "Entity is not part of the hierarchy.");
+            return m_worldMatrices[node];
+        }
+
+        const Vector<Node>& GetNodes() const { return m_nodes; }
+        size_t GetNodeCount() const { return m_nodes.size(); }
+        size_t GetLevelCount() const { return m_levelOffsets.empty() ? 0 : m_levelOffsets.size() - 1; }
+    };
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "Core/Core.h"
+#include "Core/Containers.h"
+#include "Scene/Archetype.h"
+#include "Scene/EntityIdIndex.h"
+
+namespace Slayer
+{
+    // A copy of the entities and components of a ComponentStore, taken by ComponentStore::CreateSnapshot and
+    // applied by ComponentStore::Restore. Chunks are copied whole, and a snapshot taken against a base
+    // snapshot shares the chunks that did not change since the base instead of copying them.
+    class WorldSnapshot
+    {
+    private:
+        friend class ComponentStore;
+
+        // A column that is copied through its ComponentInfo and has to be destroyed with the copy
+        struct ColumnCopy
+        {
+            size_t offset = 0;
+            size_t size = 0;
+            void (*destroy)(void* ptr) = nullptr;
+        };
+
+        struct ChunkCopy
+        {
+            uint8_t* data = nullptr;
+            size_t bytes = 0;
+            uint32_t size = 0;
+            uint64_t stamp = 0;
+            Shared<const Vector<ColumnCopy>> columns;
+
+            ChunkCopy(size_t bytes)
+                : bytes(bytes)
+            {
+                data = static_cast<uint8_t*>(::operator new(bytes, std::align_val_t(SL_CHUNK_ALIGNMENT)));
+            }
+
+            ~ChunkCopy()
+            {
+                DestroyRows();
+                ::operator delete(data, std::align_val_t(SL_CHUNK_ALIGNMENT));
+            }
+
+            void DestroyRows()
+            {
+                if (columns == nullptr)
+                    return;
+
+                for (const ColumnCopy& column : *columns)
+                {
+                    for (uint32_t row = 0; row < size; row++)
+                        column.destroy(data + column.offset + column.size * row);
+                }
+                columns = nullptr;
+                size = 0;
+            }
+
+            ChunkCopy(const ChunkCopy&) = delete;
+            ChunkCopy& operator=(const ChunkCopy&) = delete;
+        };
+
+        struct ArchetypeCopy
+        {
+            Archetype archetype;
+            Vector<Shared<ChunkCopy>> chunks;
+        };
+
+        // The registered component types, so that the snapshot can be restored into another store
+        Vector<ComponentInfo> m_components;
+        // Every archetype of the store, in the order of the store's archetype list
+        Vector<ArchetypeCopy> m_archetypes;
+        // Generation of every entity slot, the live entities are found in the chunks
+        Vector<uint32_t> m_generations;
+        Vector<uint32_t> m_freeIndices;
+        size_t m_entityCount = 0;
+        EntityIdIndex m_entityIds;
+
+        uint64_t m_storeId = 0;
+        // Change version of the store when the snapshot was taken, later writes have a newer version
+        uint32_t m_version = 0;
+        size_t m_copiedChunks = 0;
+
+    public:
+        WorldSnapshot() = default;
+        ~WorldSnapshot() = default;
+
+        WorldSnapshot(WorldSnapshot&&) = default;
+        WorldSnapshot& operator=(WorldSnapshot&&) = default;
+
+        size_t GetEntityCount() const { return m_entityCount; }
+
+        size_t GetChunkCount() const
+        {
+            size_t count = 0;
+            for (const ArchetypeCopy& archetype : m_archetypes)
+                count += archetype.chunks.size();
+            return count;
+        }
+
+        // Chunks copied when the snapshot was taken, the others are shared with its base
+        size_t GetCopiedChunkCount() const { return m_copiedChunks; }
+    };
+}
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "Core/Core.h"
+#include "Core/Containers.h"
+#include "Core/Log.h"
 #include "Serialization/Serialization.h"
 
 #include <fstream>
@@ -323,6 +325,20 @@ namespace Slayer {
             CopyData(values.data(), size * sizeof(T));
         }
 
+        // Points the span at the packed elements instead of copying them, the data has to outlive the span.
+        template<typename T>
+        void TransferVectorPacked(PackedSpan<T>& values, const std::string& name)
+        {
+            uint32_t size = 0;
+            Copy(m_current, &size, sizeof(uint32_t));
+            m_current += sizeof(uint32_t);
+
+            SL_ASSERT((m_current + size * sizeof(T) <= m_data + m_size) && "Out of bounds.");
+
+            values = PackedSpan<T>(m_current, size);
+            m_current += size * sizeof(T);
+        }
+
         template<typename T, typename U>
         void TransferDict(Dict<T, U>& values, const std::string& name)
         {
@@ -3,13 +3,35 @@
 #include "Slayer.h"
 #include "Core/Log.h"
 #include "Rendering/RenderingManager.h"
+#include "Jobs/ThreadManager.h"
+#include "Jobs/JobTrace.h"
 
+#include <cstdio>
+#include <cstdlib>
 #include <string>
 
 namespace Slayer
 {
     bool Engine::Initialize()
     {
+        // Tracing the scheduler works without a profiler GUI, for example on headless machines
+        if (const char* tracePath = std::getenv("SL_JOB_TRACE"))
+        {
+            m_jobTracePath = tracePath;
+            if (const char* frames = std::getenv("SL_JOB_TRACE_FRAMES"))
+            {
+                unsigned long long first = 0, last = 0;
+                if (sscanf(frames, "%llu-%llu", &first, &last) == 2)
+                {
+                    m_jobTraceFirstFrame = first;
+                    m_jobTraceLastFrame = last;
+                }
+            }
+            JobTrace::Enable();
+        }
+
+        // The thread calling Initialize becomes the scheduler's foreground worker
+        if (!InitializeManager<ThreadManager>(Application::Get()->GetJobSettings())) return false;
         if (!InitializeManager<RenderingManager>()) return false;
 
         Log::Info("Engine initialized");
@@ -28,6 +50,21 @@ namespace Slayer
     void Engine::Shutdown()
     {
         ShutdownManager<RenderingManager>();
+        ShutdownManager<ThreadManager>();
+        WriteJobTrace();
+    }
+
+    void Engine::WriteJobTrace()
+    {
+        if (m_jobTracePath.empty())
+            return;
+
+        JobTrace::Disable();
+        if (JobTrace::WriteChromeTrace(m_jobTracePath, m_jobTraceFirstFrame, m_jobTraceLastFrame))
+            Log::Info("Job trace written to", m_jobTracePath);
+        else
+            Log::Error("Failed to write job trace to", m_jobTracePath);
+        m_jobTracePath.clear();
     }
 
     void Engine::RunMainLoop(Application* app)
@@ -41,6 +78,16 @@ namespace Slayer
         while (app->IsRunning())
         {
             SL_FRAME("MainThread");
+            // Jobs from the last frame have finished, their pools start over
+            if (ThreadManager* threadManager = ThreadManager::Get())
+            {
+                threadManager->BeginFrame();
+
+                // The frame after the traced range has started, write the trace before the rings wrap
+                if (m_jobTraceLastFrame != UINT64_MAX && threadManager->GetFrameIndex() > m_jobTraceLastFrame + 1)
+                    WriteJobTrace();
+            }
+
             app->Update();
             Update();
             app->Render();
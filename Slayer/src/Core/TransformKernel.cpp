@@ -0,0 +1,254 @@
+#include "Core/TransformKernel.h"
+
+#if defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define SL_TRS_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+// MSVC compiles AVX2 intrinsics without any flags
+#define SL_TARGET_AVX2
+#else
+#define SL_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace Slayer
+{
+    // The operations follow glm's mat3_cast, translate and scale in the same order, so that every
+    // path gives the same result as Transform::GetMatrix() when the compiler does not contract them.
+    static void ComposeScalar(const TRSArrays& input, Mat4* output, size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; i++)
+        {
+            const float qx = input.rotationX[i];
+            const float qy = input.rotationY[i];
+            const float qz = input.rotationZ[i];
+            const float qw = input.rotationW[i];
+            const float qxx = qx * qx;
+            const float qyy = qy * qy;
+            const float qzz = qz * qz;
+            const float qxz = qx * qz;
+            const float qxy = qx * qy;
+            const float qyz = qy * qz;
+            const float qwx = qw * qx;
+            const float qwy = qw * qy;
+            const float qwz = qw * qz;
+
+            const float sx = input.scaleX[i];
+            const float sy = input.scaleY[i];
+            const float sz = input.scaleZ[i];
+
+            Mat4& matrix = output[i];
+            matrix[0] = Vec4((1.0f - 2.0f * (qyy + qzz)) * sx, (2.0f * (qxy + qwz)) * sx, (2.0f * (qxz - qwy)) * sx, 0.0f);
+            matrix[1] = Vec4((2.0f * (qxy - qwz)) * sy, (1.0f - 2.0f * (qxx + qzz)) * sy, (2.0f * (qyz + qwx)) * sy, 0.0f);
+            matrix[2] = Vec4((2.0f * (qxz + qwy)) * sz, (2.0f * (qyz - qwx)) * sz, (1.0f - 2.0f * (qxx + qyy)) * sz, 0.0f);
+            matrix[3] = Vec4(input.positionX[i], input.positionY[i], input.positionZ[i], 1.0f);
+        }
+    }
+
+#if SL_TRS_X86
+    static void ComposeSSE2(const TRSArrays& input, Mat4* output, size_t count)
+    {
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 two = _mm_set1_ps(2.0f);
+        const __m128 zero = _mm_setzero_ps();
+
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            const __m128 qx = _mm_loadu_ps(input.rotationX + i);
+            const __m128 qy = _mm_loadu_ps(input.rotationY + i);
+            const __m128 qz = _mm_loadu_ps(input.rotationZ + i);
+            const __m128 qw = _mm_loadu_ps(input.rotationW + i);
+            const __m128 qxx = _mm_mul_ps(qx, qx);
+            const __m128 qyy = _mm_mul_ps(qy, qy);
+            const __m128 qzz = _mm_mul_ps(qz, qz);
+            const __m128 qxz = _mm_mul_ps(qx, qz);
+            const __m128 qxy = _mm_mul_ps(qx, qy);
+            const __m128 qyz = _mm_mul_ps(qy, qz);
+            const __m128 qwx = _mm_mul_ps(qw, qx);
+            const __m128 qwy = _mm_mul_ps(qw, qy);
+            const __m128 qwz = _mm_mul_ps(qw, qz);
+
+            const __m128 sx = _mm_loadu_ps(input.scaleX + i);
+            const __m128 sy = _mm_loadu_ps(input.scaleY + i);
+            const __m128 sz = _mm_loadu_ps(input.scaleZ + i);
+
+            // One vector per matrix element holding it for four transforms, transposed into one column per transform
+            __m128 columns[4][4] = {
+                {
+                    _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(qyy, qzz))), sx),
+                    _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(qxy, qwz)), sx),
+                    _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(qxz, qwy)), sx),
+                    zero
+                },
+                {
+                    _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(qxy, qwz)), sy),
+                    _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(qxx, qzz))), sy),
+                    _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(qyz, qwx)), sy),
+                    zero
+                },
+                {
+                    _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(qxz, qwy)), sz),
+                    _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(qyz, qwx)), sz),
+                    _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(qxx, qyy))), sz),
+                    zero
+                },
+                {
+                    _mm_loadu_ps(input.positionX + i),
+                    _mm_loadu_ps(input.positionY + i),
+                    _mm_loadu_ps(input.positionZ + i),
+                    one
+                }
+            };
+
+            for (int column = 0; column < 4; column++)
+            {
+                __m128* c = columns[column];
+                _MM_TRANSPOSE4_PS(c[0], c[1], c[2], c[3]);
+                for (int k = 0; k < 4; k++)
+                    _mm_storeu_ps(&output[i + k][column][0], c[k]);
+            }
+        }
+
+        ComposeScalar(input, output, i, count);
+    }
+
+    SL_TARGET_AVX2 static void ComposeAVX2(const TRSArrays& input, Mat4* output, size_t count)
+    {
+        const __m256 one = _mm256_set1_ps(1.0f);
+        const __m256 two = _mm256_set1_ps(2.0f);
+        const __m256 zero = _mm256_setzero_ps();
+
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            const __m256 qx = _mm256_loadu_ps(input.rotationX + i);
+            const __m256 qy = _mm256_loadu_ps(input.rotationY + i);
+            const __m256 qz = _mm256_loadu_ps(input.rotationZ + i);
+            const __m256 qw = _mm256_loadu_ps(input.rotationW + i);
+            const __m256 qxx = _mm256_mul_ps(qx, qx);
+            const __m256 qyy = _mm256_mul_ps(qy, qy);
+            const __m256 qzz = _mm256_mul_ps(qz, qz);
+            const __m256 qxz = _mm256_mul_ps(qx, qz);
+            const __m256 qxy = _mm256_mul_ps(qx, qy);
+            const __m256 qyz = _mm256_mul_ps(qy, qz);
+            const __m256 qwx = _mm256_mul_ps(qw, qx);
+            const __m256 qwy = _mm256_mul_ps(qw, qy);
+            const __m256 qwz = _mm256_mul_ps(qw, qz);
+
+            const __m256 sx = _mm256_loadu_ps(input.scaleX + i);
+            const __m256 sy = _mm256_loadu_ps(input.scaleY + i);
+            const __m256 sz = _mm256_loadu_ps(input.scaleZ + i);
+
+            const __m256 columns[4][4] = {
+                {
+                    _mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(qyy, qzz))), sx),
+                    _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(qxy, qwz)), sx),
+                    _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(qxz, qwy)), sx),
+                    zero
+                },
+                {
+                    _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(qxy, qwz)), sy),
+                    _mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(qxx, qzz))), sy),
+                    _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(qyz, qwx)), sy),
+                    zero
+                },
+                {
+                    _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(qxz, qwy)), sz),
+                    _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(qyz, qwx)), sz),
+                    _mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(qxx, qyy))), sz),
+                    zero
+                },
+                {
+                    _mm256_loadu_ps(input.positionX + i),
+                    _mm256_loadu_ps(input.positionY + i),
+                    _mm256_loadu_ps(input.positionZ + i),
+                    one
+                }
+            };
+
+            for (int column = 0; column < 4; column++)
+            {
+                // 4x4 transposes within each 128-bit lane, the low lane holds transforms i..i+3 and the high lane i+4..i+7
+                const __m256* c = columns[column];
+                const __m256 t0 = _mm256_unpacklo_ps(c[0], c[1]);
+                const __m256 t1 = _mm256_unpackhi_ps(c[0], c[1]);
+                const __m256 t2 = _mm256_unpacklo_ps(c[2], c[3]);
+                const __m256 t3 = _mm256_unpackhi_ps(c[2], c[3]);
+                const __m256 rows[4] = {
+                    _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0)),
+                    _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2)),
+                    _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0)),
+                    _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2))
+                };
+
+                for (int k = 0; k < 4; k++)
+                {
+                    _mm_storeu_ps(&output[i + k][column][0], _mm256_castps256_ps128(rows[k]));
+                    _mm_storeu_ps(&output[i + k + 4][column][0], _mm256_extractf128_ps(rows[k], 1));
+                }
+            }
+        }
+
+        ComposeScalar(input, output, i, count);
+    }
+
+    static bool SupportsAVX2()
+    {
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7)
+            return false;
+
+        // The OS has to save the AVX registers on context switches
+        __cpuid(info, 1);
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        const bool avx = (info[2] & (1 << 28)) != 0;
+        if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6)
+            return false;
+
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#else
+        return __builtin_cpu_supports("avx2");
+#endif
+    }
+#endif
+
+    SimdLevel GetSimdLevel()
+    {
+#if SL_TRS_X86
+        static const SimdLevel level = SupportsAVX2() ? SimdLevel::AVX2 : SimdLevel::SSE2;
+        return level;
+#else
+        return SimdLevel::Scalar;
+#endif
+    }
+
+    void ComposeTRS(const TRSArrays& input, Mat4* output)
+    {
+        ComposeTRS(input, output, GetSimdLevel());
+    }
+
+    void ComposeTRS(const TRSArrays& input, Mat4* output, SimdLevel level)
+    {
+        level = std::min(level, GetSimdLevel());
+
+        switch (level)
+        {
+#if SL_TRS_X86
+        case SimdLevel::AVX2:
+            ComposeAVX2(input, output, input.count);
+            break;
+        case SimdLevel::SSE2:
+            ComposeSSE2(input, output, input.count);
+            break;
+#endif
+        default:
+            ComposeScalar(input, output, 0, input.count);
+            break;
+        }
+    }
+}
@@ -0,0 +1,232 @@
+#include "Jobs/Fiber.h"
+
+#include <cstdint>
+#include <cstdlib>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// Sanitizers lose track of the stack when it is switched unless they are told about it
+#if defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define SL_FIBER_ASAN 1
+#endif
+#if __has_feature(thread_sanitizer)
+#define SL_FIBER_TSAN 1
+#endif
+#endif
+#if defined(__SANITIZE_ADDRESS__)
+#define SL_FIBER_ASAN 1
+#endif
+#if defined(__SANITIZE_THREAD__)
+#define SL_FIBER_TSAN 1
+#endif
+
+#ifdef SL_FIBER_ASAN
+#include <sanitizer/common_interface_defs.h>
+#endif
+#ifdef SL_FIBER_TSAN
+#include <sanitizer/tsan_interface.h>
+#endif
+
+#ifdef SL_FIBER_ASM
+// Saves the callee-saved registers and the floating point control words on the current stack, stores the
+// stack pointer in *from and continues on the stack saved in to. A new fiber's stack is prepared so that
+// the switch returns into SlayerFiberStart, which calls r13 with r12 as its argument.
+extern "C" void SlayerFiberSwitch(void** from, void* to);
+extern "C" void SlayerFiberStart();
+
+asm(R"(
+    .text
+    .globl SlayerFiberSwitch
+    .hidden SlayerFiberSwitch
+    .type SlayerFiberSwitch, @function
+SlayerFiberSwitch:
+    pushq %rbp
+    pushq %rbx
+    pushq %r12
+    pushq %r13
+    pushq %r14
+    pushq %r15
+    subq $8, %rsp
+    stmxcsr (%rsp)
+    fnstcw 4(%rsp)
+    movq %rsp, (%rdi)
+    movq %rsi, %rsp
+    ldmxcsr (%rsp)
+    fldcw 4(%rsp)
+    addq $8, %rsp
+    popq %r15
+    popq %r14
+    popq %r13
+    popq %r12
+    popq %rbx
+    popq %rbp
+    ret
+    .size SlayerFiberSwitch, .-SlayerFiberSwitch
+
+    .globl SlayerFiberStart
+    .hidden SlayerFiberStart
+    .type SlayerFiberStart, @function
+SlayerFiberStart:
+    movq %r12, %rdi
+    callq *%r13
+    ud2
+    .size SlayerFiberStart, .-SlayerFiberStart
+)");
+#endif
+
+namespace Slayer
+{
+#ifdef SL_FIBER_ASAN
+    // The fiber being switched away from, so that the one switched to can record its stack
+    static thread_local Fiber* s_switchingFrom = nullptr;
+#endif
+
+    Fiber::Fiber()
+    {
+#if defined(_WIN32)
+        if (IsThreadAFiber())
+        {
+            m_handle = GetCurrentFiber();
+        }
+        else
+        {
+            m_handle = ConvertThreadToFiber(nullptr);
+            m_convertedThread = true;
+        }
+        SL_ASSERT(m_handle != nullptr && "Failed to convert the thread to a fiber.");
+#endif
+#ifdef SL_FIBER_TSAN
+        m_sanitizerFiber = __tsan_get_current_fiber();
+#endif
+    }
+
+    Fiber::Fiber(size_t stackSize, Entry entry, void* arg)
+        : m_entry(entry), m_arg(arg)
+    {
+#if defined(_WIN32)
+        m_stackSize = stackSize;
+        m_handle = CreateFiber(stackSize, &Fiber::StartWindows, this);
+        SL_ASSERT(m_handle != nullptr && "Failed to create fiber.");
+#else
+        // The lowest page is left inaccessible, so that overflowing the stack faults instead of corrupting memory
+        const size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+        m_stackSize = (stackSize + pageSize - 1) / pageSize * pageSize + pageSize;
+        m_stack = mmap(nullptr, m_stackSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        SL_ASSERT(m_stack != MAP_FAILED && "Failed to allocate fiber stack.");
+        mprotect(m_stack, pageSize, PROT_NONE);
+        m_stackBottom = static_cast<uint8_t*>(m_stack) + pageSize;
+        m_usableStackSize = m_stackSize - pageSize;
+
+#if defined(SL_FIBER_ASM)
+        uintptr_t top = (uintptr_t)m_stack + m_stackSize;
+        top &= ~(uintptr_t)15;
+        uint64_t* frame = reinterpret_cast<uint64_t*>(top) - 8;
+        frame[0] = 0x1F80 | ((uint64_t)0x037F << 32); // Default MXCSR and x87 control word
+        frame[1] = 0; // r15
+        frame[2] = 0; // r14
+        frame[3] = (uint64_t)(uintptr_t)&Fiber::Start; // r13
+        frame[4] = (uint64_t)(uintptr_t)this; // r12
+        frame[5] = 0; // rbx
+        frame[6] = 0; // rbp
+        frame[7] = (uint64_t)(uintptr_t)&SlayerFiberStart;
+        m_stackPointer = frame;
+#else
+        getcontext(&m_context);
+        m_context.uc_stack.ss_sp = const_cast<void*>(m_stackBottom);
+        m_context.uc_stack.ss_size = m_usableStackSize;
+        m_context.uc_link = nullptr;
+        const uintptr_t self = (uintptr_t)this;
+        makecontext(&m_context, (void (*)())&Fiber::StartContext, 2, (unsigned int)((uint64_t)self >> 32), (unsigned int)(self & 0xFFFFFFFF));
+#endif
+#endif
+#ifdef SL_FIBER_TSAN
+        m_sanitizerFiber = __tsan_create_fiber(0);
+#endif
+    }
+
+    Fiber::~Fiber()
+    {
+#ifdef SL_FIBER_TSAN
+        if (m_entry != nullptr)
+        {
+            __tsan_destroy_fiber(m_sanitizerFiber);
+        }
+#endif
+#if defined(_WIN32)
+        if (m_entry != nullptr)
+        {
+            DeleteFiber(m_handle);
+        }
+        else if (m_convertedThread)
+        {
+            ConvertFiberToThread();
+        }
+#else
+        if (m_stack != nullptr)
+        {
+            munmap(m_stack, m_stackSize);
+        }
+#endif
+    }
+
+    void Fiber::Start(Fiber* fiber)
+    {
+        EndSwitch(nullptr);
+        fiber->m_entry(fiber->m_arg);
+        SL_ASSERT(false && "Fiber entry returned.");
+        std::abort();
+    }
+
+#if defined(_WIN32)
+    void __stdcall Fiber::StartWindows(void* fiber)
+    {
+        Start(static_cast<Fiber*>(fiber));
+    }
+#elif !defined(SL_FIBER_ASM)
+    void Fiber::StartContext(unsigned int high, unsigned int low)
+    {
+        Start(reinterpret_cast<Fiber*>(((uintptr_t)high << 32) | (uintptr_t)low));
+    }
+#endif
+
+    void Fiber::BeginSwitch([[maybe_unused]] Fiber& to, [[maybe_unused]] void** fakeStack)
+    {
+#ifdef SL_FIBER_ASAN
+        s_switchingFrom = this;
+        __sanitizer_start_switch_fiber(fakeStack, to.m_stackBottom, to.m_usableStackSize);
+#endif
+#ifdef SL_FIBER_TSAN
+        __tsan_switch_to_fiber(to.m_sanitizerFiber, 0);
+#endif
+    }
+
+    void Fiber::EndSwitch([[maybe_unused]] void* fakeStack)
+    {
+#ifdef SL_FIBER_ASAN
+        // Records the stack of the context that was left, the stack of a thread is only known this way
+        Fiber* from = s_switchingFrom;
+        __sanitizer_finish_switch_fiber(fakeStack, &from->m_stackBottom, &from->m_usableStackSize);
+#endif
+    }
+
+    void Fiber::SwitchTo(Fiber& to)
+    {
+        void* fakeStack = nullptr;
+        BeginSwitch(to, &fakeStack);
+#if defined(_WIN32)
+        SwitchToFiber(to.m_handle);
+#elif defined(SL_FIBER_ASM)
+        SlayerFiberSwitch(&m_stackPointer, to.m_stackPointer);
+#else
+        swapcontext(&m_context, &to.m_context);
+#endif
+        EndSwitch(fakeStack);
+    }
+}
@@ -1,9 +1,11 @@
 #include "Jobs/Job.h"
+#include "Jobs/ThreadManager.h"
+#include "Jobs/JobTrace.h"
 
 namespace Slayer
 {
     Job::Job(JobFunction function, Job *parent)
-        : function{function}, parent{parent}, unfinishedJobs{1}
+        : function{function}, parent{parent}, unfinishedJobs{1}, continuationCount{0}
     {
         if (parent != nullptr)
         {
@@ -11,9 +13,19 @@ namespace Slayer
         }
     }
 
+    void Job::AddContinuation(Job* continuation)
+    {
+        const int index = continuationCount++;
+        SL_ASSERT(index < (int)MAX_CONTINUATIONS && "Too many continuations.");
+        continuations[index] = continuation;
+    }
+
     void Job::Run()
     {
+        SL_JOB_TRACE(JobBegin, (uint64_t)(uintptr_t)this, (uint64_t)(uintptr_t)function);
         function(*this);
+        // Recorded before finishing, the job may be reused right after
+        SL_JOB_TRACE(JobEnd, (uint64_t)(uintptr_t)this);
         Finish();
     }
 
@@ -24,13 +36,29 @@ namespace Slayer
 
     void Job::Finish()
     {
-        unfinishedJobs--;
+        // The job may be reused as soon as the counter reaches zero, so the parent and continuations are read first
+        Job* parentJob = parent;
+        const int continuationsToRun = continuationCount.load();
+        std::array<Job*, MAX_CONTINUATIONS> continuationJobs;
+        for (int i = 0; i < continuationsToRun; i++)
+        {
+            continuationJobs[i] = continuations[i];
+        }
 
-        if (Finished())
+        if (--unfinishedJobs == 0)
         {
-            if (parent != nullptr)
+            if (continuationsToRun > 0)
+            {
+                Worker* worker = ThreadManager::Get()->GetCurrentWorker();
+                for (int i = 0; i < continuationsToRun; i++)
+                {
+                    worker->Submit(continuationJobs[i]);
+                }
+            }
+
+            if (parentJob != nullptr)
             {
-                parent->Finish();
+                parentJob->Finish();
             }
         }
     }
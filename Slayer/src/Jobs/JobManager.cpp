@@ -1,15 +0,0 @@
-#include "Jobs/JobManager.h"
-
-namespace Slayer
-{
-    JobManager *JobManager::instance = nullptr;
-
-    bool JobManager::Initialize()
-    {
-        return true;
-    }
-
-    void JobManager::Shutdown()
-    {
-    }
-}
\ No newline at end of file
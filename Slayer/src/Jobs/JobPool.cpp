@@ -1,10 +1,42 @@
 #include "Jobs/JobPool.h"
 #include <assert.h>
+#include <cstdint>
 
 namespace Slayer
 {
-    JobPool::JobPool(std::size_t maxJobs)
-        : allocatedJobs{0}, storage{maxJobs}
+    FrameArena::FrameArena(std::size_t size)
+        : offset{0}, storage(size), highWaterMark{0}, failedAllocations{0}
+    {
+    }
+
+    void *FrameArena::Allocate(std::size_t size, std::size_t alignment)
+    {
+        // Aligns the address rather than the offset, the storage itself is only aligned for fundamental types
+        const std::uintptr_t base = reinterpret_cast<std::uintptr_t>(storage.data());
+        const std::uintptr_t address = (base + offset + alignment - 1) & ~(std::uintptr_t)(alignment - 1);
+        const std::size_t end = (std::size_t)(address - base) + size;
+        if (end > storage.size())
+        {
+            failedAllocations.store(failedAllocations.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        offset = end;
+        if (offset > highWaterMark.load(std::memory_order_relaxed))
+        {
+            highWaterMark.store(offset, std::memory_order_relaxed);
+        }
+
+        return reinterpret_cast<void *>(address);
+    }
+
+    void FrameArena::Reset()
+    {
+        offset = 0;
+    }
+
+    JobPool::JobPool(std::size_t maxJobs, FrameArena *arena)
+        : allocatedJobs{0}, storage{maxJobs}, arena{arena}, highWaterMark{0}, failedAllocations{0}
     {
         assert(storage.size() == maxJobs);
     }
@@ -13,10 +45,17 @@ namespace Slayer
     {
         if (!Full())
         {
-            return &storage[allocatedJobs++];
+            Job *job = &storage[allocatedJobs++];
+            if (allocatedJobs > highWaterMark.load(std::memory_order_relaxed))
+            {
+                highWaterMark.store(allocatedJobs, std::memory_order_relaxed);
+            }
+
+            return job;
         }
         else
         {
+            failedAllocations.store(failedAllocations.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
             return nullptr;
         }
     }
@@ -26,6 +65,12 @@ namespace Slayer
         allocatedJobs = 0;
     }
 
+    void JobPool::Rewind(std::size_t marker)
+    {
+        assert(marker <= allocatedJobs);
+        allocatedJobs = marker;
+    }
+
     bool JobPool::Full() const
     {
         return allocatedJobs == storage.size();
@@ -46,4 +91,19 @@ namespace Slayer
         }
     }
 
-}
\ No newline at end of file
+    Job *JobPool::CreateJobAsChild(JobFunction jobFunction, Job *parent)
+    {
+        Job *job = Allocate();
+
+        if (job != nullptr)
+        {
+            new (job) Job{jobFunction, parent};
+            return job;
+        }
+        else
+        {
+            return nullptr;
+        }
+    }
+
+}
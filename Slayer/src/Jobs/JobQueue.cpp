@@ -1,77 +1,105 @@
 #include "Jobs/JobQueue.h"
 
+// Memory orderings follow "Correct and Efficient Work-Stealing for Weak Memory Models" (Le et al., 2013),
+// except that the bottom index is published with a release store instead of a release fence.
+
 namespace Slayer
 {
     JobQueue::JobQueue()
+        : JobQueue(64)
     {
-        m_jobs = {};
-        m_bottom = 0;
-        m_top = 0;
     }
 
-    JobQueue::JobQueue(std::size_t maxJobs)
+    JobQueue::JobQueue(std::size_t capacity)
     {
-        m_jobs.resize(maxJobs);
+        SL_ASSERT(capacity > 0 && (capacity & (capacity - 1)) == 0 && "Job queue size must be a power of two.");
+        m_buffers.push_back(MakeUnique<Buffer>((int64_t)capacity));
+        m_buffer = m_buffers.back().get();
         m_bottom = 0;
         m_top = 0;
     }
 
+    JobQueue::Buffer* JobQueue::Grow(Buffer* buffer, int64_t bottom, int64_t top)
+    {
+        Unique<Buffer> grown = MakeUnique<Buffer>((buffer->mask + 1) * 2);
+        for (int64_t i = top; i < bottom; i++)
+        {
+            grown->Put(i, buffer->Get(i));
+        }
+
+        Buffer* result = grown.get();
+        m_buffers.push_back(std::move(grown));
+        m_buffer.store(result, std::memory_order_release);
+        return result;
+    }
+
     void JobQueue::Push(Job *job)
     {
-        int bottom = m_bottom.load(std::memory_order_seq_cst);
-        m_jobs[bottom] = job;
-        m_bottom.store(bottom + 1, std::memory_order_seq_cst);
+        const int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+        const int64_t top = m_top.load(std::memory_order_acquire);
+        Buffer* buffer = m_buffer.load(std::memory_order_relaxed);
+        if (bottom - top > buffer->mask)
+        {
+            buffer = Grow(buffer, bottom, top);
+        }
+
+        buffer->Put(bottom, job);
+        m_bottom.store(bottom + 1, std::memory_order_release);
     }
 
     Job *JobQueue::Pop()
     {
-        int bottom = m_bottom.load(std::memory_order_seq_cst);
-        bottom = std::max(0, bottom - 1);
-        m_bottom.store(bottom, std::memory_order_seq_cst);
-        int top = m_top.load(std::memory_order_seq_cst);
+        const int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+        Buffer* buffer = m_buffer.load(std::memory_order_relaxed);
+        m_bottom.store(bottom, std::memory_order_relaxed);
+
+        // The bottom has to be visible to thieves before the top is read, or both could take the last job
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t top = m_top.load(std::memory_order_relaxed);
 
-        if (top <= bottom)
+        if (top > bottom)
         {
-            Job *job = m_jobs[bottom];
-
-            if (top != bottom)
-            {
-                return job;
-            }
-
-            int stolenTop = top + 1;
-            if (m_top.compare_exchange_strong(stolenTop, top + 1, std::memory_order_seq_cst))
-            {
-                m_bottom.store(stolenTop, std::memory_order_release);
-                return nullptr;
-            }
+            // The queue was already empty
+            m_bottom.store(bottom + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        Job *job = buffer->Get(bottom);
+        if (top != bottom)
+        {
+            // More than one job left in the queue
             return job;
         }
-        else
+
+        // This is the last job, race against stealing threads for it
+        if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
         {
-            m_bottom.store(top, std::memory_order_seq_cst);
-            return nullptr;
+            job = nullptr;
         }
+
+        m_bottom.store(bottom + 1, std::memory_order_relaxed);
+        return job;
     }
 
     Job *JobQueue::Steal()
     {
-        int top = m_top.load(std::memory_order_seq_cst);
-        int bottom = m_bottom.load(std::memory_order_seq_cst);
+        int64_t top = m_top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const int64_t bottom = m_bottom.load(std::memory_order_acquire);
 
-        if (m_top < m_bottom)
+        if (top >= bottom)
         {
-            Job *job = m_jobs[top];
-
-            if (m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst))
-            {
-                return job;
-            }
-
             return nullptr;
         }
-        else
+
+        Job *job = m_buffer.load(std::memory_order_acquire)->Get(top);
+        if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        {
+            // Lost the race to the owner or another thief
             return nullptr;
+        }
+
+        return job;
     }
 
 }
@@ -0,0 +1,353 @@
+#include "Jobs/JobTrace.h"
+#include "Core/Core.h"
+#include "Core/Containers.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+// Reading the time stamp counter is about twice as fast as the steady clock, it is converted to nanoseconds
+// when the trace is written. Assumes an invariant TSC, which every x86-64 CPU of the last decade has.
+#if defined(_M_X64) || defined(__x86_64__)
+#define SL_JOB_TRACE_TSC 1
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+namespace Slayer
+{
+    namespace JobTrace
+    {
+        std::atomic<bool> enabled = false;
+
+        struct Event
+        {
+            // Atomic so that writing out a ring while its thread records is not a data race, a torn event is
+            // detected by the write count instead
+            std::atomic<uint64_t> timestamp;
+            std::atomic<uint64_t> data;
+            std::atomic<uint64_t> extra;
+            std::atomic<uint32_t> type;
+        };
+
+        struct ThreadRing
+        {
+            std::string name;
+            Unique<Event[]> events;
+            uint64_t mask;
+            // Events recorded so far, the ring holds the last mask + 1 of them
+            std::atomic<uint64_t> written = 0;
+        };
+
+        // Rings outlive their threads, so that the trace of a stopped scheduler can still be written out.
+        // Never destroyed, threads may record until the process exits.
+        std::mutex& ringLock = *new std::mutex();
+        Vector<Unique<ThreadRing>>& rings = *new Vector<Unique<ThreadRing>>();
+        std::atomic<size_t> eventsPerRing = 1 << 16;
+
+        thread_local ThreadRing* threadRing = nullptr;
+        thread_local char threadName[32] = {};
+
+        uint64_t SteadyNanoseconds()
+        {
+            return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        // Timestamp of an event, in ticks of the time stamp counter or in nanoseconds
+        uint64_t Now()
+        {
+#ifdef SL_JOB_TRACE_TSC
+            return __rdtsc();
+#else
+            return SteadyNanoseconds();
+#endif
+        }
+
+        // Ticks and nanoseconds at the same moment, taken when tracing is enabled, for converting ticks
+        std::atomic<uint64_t> referenceTicks = 0;
+        std::atomic<uint64_t> referenceNanoseconds = 0;
+
+        ThreadRing* RegisterThread()
+        {
+            std::lock_guard<std::mutex> guard(ringLock);
+            const size_t capacity = eventsPerRing.load();
+            Unique<ThreadRing> ring = MakeUnique<ThreadRing>();
+            ring->name = threadName[0] != '\0' ? std::string(threadName) : "Thread " + std::to_string(rings.size());
+            ring->events = std::make_unique<Event[]>(capacity);
+            ring->mask = capacity - 1;
+            threadRing = ring.get();
+            rings.push_back(std::move(ring));
+            return threadRing;
+        }
+
+        void Enable(size_t eventsPerThread)
+        {
+            SL_ASSERT(eventsPerThread >= 2 && (eventsPerThread & (eventsPerThread - 1)) == 0 && "Ring size must be a power of two.");
+            eventsPerRing = eventsPerThread;
+            referenceNanoseconds = SteadyNanoseconds();
+            referenceTicks = Now();
+            enabled = true;
+        }
+
+        void Disable()
+        {
+            enabled = false;
+        }
+
+        void Record(EventType type, uint64_t data, uint64_t extra)
+        {
+            ThreadRing* ring = threadRing != nullptr ? threadRing : RegisterThread();
+            const uint64_t index = ring->written.load(std::memory_order_relaxed);
+            Event& event = ring->events[index & ring->mask];
+            event.timestamp.store(Now(), std::memory_order_relaxed);
+            event.data.store(data, std::memory_order_relaxed);
+            event.extra.store(extra, std::memory_order_relaxed);
+            event.type.store((uint32_t)type, std::memory_order_relaxed);
+            ring->written.store(index + 1, std::memory_order_release);
+        }
+
+        void NameThread(const char* name)
+        {
+            strncpy(threadName, name, sizeof(threadName) - 1);
+            if (threadRing != nullptr)
+            {
+                std::lock_guard<std::mutex> guard(ringLock);
+                threadRing->name = threadName;
+            }
+        }
+
+        void MarkFrame(uint64_t frameIndex)
+        {
+            SL_JOB_TRACE(Frame, frameIndex);
+        }
+
+        struct EventCopy
+        {
+            uint64_t timestamp;
+            uint64_t data;
+            uint64_t extra;
+            EventType type;
+        };
+
+        // Copies the events of a ring that were not overwritten while copying, oldest first
+        Vector<EventCopy> CopyRing(const ThreadRing& ring)
+        {
+            const uint64_t capacity = ring.mask + 1;
+            const uint64_t end = ring.written.load(std::memory_order_acquire);
+            uint64_t begin = end > capacity ? end - capacity : 0;
+
+            Vector<EventCopy> events;
+            events.reserve((size_t)(end - begin));
+            for (uint64_t i = begin; i < end; i++)
+            {
+                const Event& event = ring.events[i & ring.mask];
+                events.push_back({ event.timestamp.load(std::memory_order_relaxed), event.data.load(std::memory_order_relaxed),
+                    event.extra.load(std::memory_order_relaxed), (EventType)event.type.load(std::memory_order_relaxed) });
+            }
+
+            // The event being recorded now may already overwrite the slot of the oldest one
+            std::atomic_thread_fence(std::memory_order_acquire);
+            const uint64_t written = ring.written.load(std::memory_order_relaxed);
+            const uint64_t firstValid = written + 1 > capacity ? written + 1 - capacity : 0;
+            if (firstValid > begin)
+            {
+                events.erase(events.begin(), events.begin() + (size_t)std::min(firstValid - begin, (uint64_t)events.size()));
+            }
+
+            return events;
+        }
+
+        const char* SpanName(EventType begin)
+        {
+            switch (begin)
+            {
+            case EventType::LaneJobBegin: return "Lane job";
+            case EventType::IdleBegin: return "Idle";
+            case EventType::SleepBegin: return "Sleep";
+            case EventType::ParkBegin: return "Parked";
+            default: return "Job";
+            }
+        }
+
+        void WriteChromeTrace(std::ostream& stream, uint64_t firstFrame, uint64_t lastFrame)
+        {
+            struct ThreadEvents
+            {
+                std::string name;
+                Vector<EventCopy> events;
+            };
+
+            Vector<ThreadEvents> threads;
+            {
+                std::lock_guard<std::mutex> guard(ringLock);
+                for (const Unique<ThreadRing>& ring : rings)
+                {
+                    threads.push_back({ ring->name, CopyRing(*ring) });
+                }
+            }
+
+            // Converts the ticks to nanoseconds with the rate measured since tracing was enabled
+#ifdef SL_JOB_TRACE_TSC
+            uint64_t elapsedNanoseconds = SteadyNanoseconds() - referenceNanoseconds;
+            while (elapsedNanoseconds < 10000000)
+            {
+                std::this_thread::yield();
+                elapsedNanoseconds = SteadyNanoseconds() - referenceNanoseconds;
+            }
+            const double nanosecondsPerTick = (double)elapsedNanoseconds / (double)(Now() - referenceTicks);
+            for (ThreadEvents& thread : threads)
+            {
+                for (EventCopy& event : thread.events)
+                {
+                    event.timestamp = referenceNanoseconds + (uint64_t)((double)(int64_t)(event.timestamp - referenceTicks) * nanosecondsPerTick);
+                }
+            }
+#endif
+
+            // The window starts at the first recorded frame from firstFrame on, and ends where the frame after lastFrame starts
+            std::map<uint64_t, uint64_t> frameStarts;
+            for (const ThreadEvents& thread : threads)
+            {
+                for (const EventCopy& event : thread.events)
+                {
+                    if (event.type == EventType::Frame)
+                    {
+                        frameStarts[event.data] = event.timestamp;
+                    }
+                }
+            }
+
+            uint64_t windowBegin = 0;
+            uint64_t windowEnd = UINT64_MAX;
+            auto first = frameStarts.lower_bound(firstFrame);
+            if (first != frameStarts.end())
+            {
+                windowBegin = first->second;
+            }
+            if (lastFrame != UINT64_MAX)
+            {
+                auto next = frameStarts.lower_bound(lastFrame + 1);
+                if (next != frameStarts.end())
+                {
+                    windowEnd = next->second;
+                }
+            }
+
+            const auto inWindow = [&](uint64_t timestamp) { return timestamp >= windowBegin && timestamp < windowEnd; };
+            const auto micros = [&](uint64_t timestamp)
+                {
+                    char text[32];
+                    snprintf(text, sizeof(text), "%.3f", (double)(timestamp - windowBegin) / 1000.0);
+                    return std::string(text);
+                };
+
+            stream << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+            bool firstEvent = true;
+            const auto beginEvent = [&]() -> std::ostream&
+                {
+                    stream << (firstEvent ? "" : ",\n");
+                    firstEvent = false;
+                    return stream;
+                };
+
+            for (size_t tid = 0; tid < threads.size(); tid++)
+            {
+                const ThreadEvents& thread = threads[tid];
+                beginEvent() << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid << ",\"args\":{\"name\":\"" << thread.name << "\"}}";
+
+                // Spans are matched by their data, parked fibers and the jobs run meanwhile do not nest
+                std::unordered_map<uint64_t, EventCopy> openSpans;
+                for (const EventCopy& event : thread.events)
+                {
+                    const uint32_t type = (uint32_t)event.type;
+                    if (type <= (uint32_t)EventType::ParkEnd)
+                    {
+                        const uint64_t key = event.data * 16 + (type & ~1u);
+                        if ((type & 1u) == 0)
+                        {
+                            openSpans[key] = event;
+                            continue;
+                        }
+
+                        auto open = openSpans.find(key);
+                        if (open == openSpans.end())
+                        {
+                            continue;
+                        }
+
+                        const EventCopy begin = open->second;
+                        openSpans.erase(open);
+                        if (!inWindow(begin.timestamp))
+                        {
+                            continue;
+                        }
+
+                        std::string name = SpanName(begin.type);
+                        if (begin.type == EventType::JobBegin)
+                        {
+                            char function[32];
+                            snprintf(function, sizeof(function), " %llx", (unsigned long long)begin.extra);
+                            name += function;
+                        }
+
+                        beginEvent() << "{\"name\":\"" << name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << tid << ",\"ts\":" << micros(begin.timestamp)
+                            << ",\"dur\":" << micros(windowBegin + event.timestamp - begin.timestamp);
+                        if (event.type == EventType::IdleEnd)
+                        {
+                            stream << ",\"args\":{\"failed steals\":" << event.extra << "}";
+                        }
+                        stream << "}";
+                        continue;
+                    }
+
+                    if (!inWindow(event.timestamp))
+                    {
+                        continue;
+                    }
+
+                    switch (event.type)
+                    {
+                    case EventType::Steal:
+                        beginEvent() << "{\"name\":\"Steal\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":" << tid << ",\"ts\":" << micros(event.timestamp)
+                            << ",\"args\":{\"victim\":" << event.data << "}}";
+                        break;
+                    case EventType::QueueDepth:
+                    {
+                        const std::string queue = event.extra != 0 ? std::string(reinterpret_cast<const char*>(event.extra)) : "Queue " + thread.name;
+                        beginEvent() << "{\"name\":\"" << queue << "\",\"ph\":\"C\",\"pid\":1,\"tid\":" << tid << ",\"ts\":" << micros(event.timestamp)
+                            << ",\"args\":{\"depth\":" << event.data << "}}";
+                        break;
+                    }
+                    case EventType::Frame:
+                        beginEvent() << "{\"name\":\"Frame " << event.data << "\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":" << tid << ",\"ts\":" << micros(event.timestamp) << "}";
+                        break;
+                    default:
+                        break;
+                    }
+                }
+            }
+
+            stream << "\n]}\n";
+        }
+
+        bool WriteChromeTrace(const std::string& path, uint64_t firstFrame, uint64_t lastFrame)
+        {
+            std::ofstream file(path);
+            if (!file)
+            {
+                return false;
+            }
+
+            WriteChromeTrace(file, firstFrame, lastFrame);
+            return file.good();
+        }
+    }
+}
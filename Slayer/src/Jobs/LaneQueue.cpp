@@ -0,0 +1,141 @@
+#include "Jobs/LaneQueue.h"
+#include "Jobs/JobTrace.h"
+
+#include <string>
+
+namespace Slayer
+{
+    LaneQueue::LaneQueue(size_t capacity, const char* name)
+        : m_queue(capacity), m_name(name)
+    {
+    }
+
+    void LaneQueue::Start(uint32_t threadCount, ThreadPriority priority, uint64_t coreMask)
+    {
+        SL_ASSERT(m_threads.empty() && "Lane is already running.");
+        m_running = true;
+        for (uint32_t i = 0; i < threadCount; i++)
+        {
+            m_threads.emplace_back(&LaneQueue::Run, this, i, priority, coreMask);
+        }
+    }
+
+    void LaneQueue::Stop()
+    {
+        m_running = false;
+
+        // Sleeping threads see the stop request once they wake up
+        m_wakeEpoch.fetch_add(1);
+        m_wakeEpoch.notify_all();
+
+        for (std::thread& thread : m_threads)
+        {
+            thread.join();
+        }
+
+        m_threads.clear();
+    }
+
+    void LaneQueue::Run(uint32_t index, ThreadPriority priority, uint64_t coreMask)
+    {
+        const std::string name = std::string(m_name) + " " + std::to_string(index);
+        ThreadTopology::SetName(name.c_str());
+        JobTrace::NameThread(name.c_str());
+        ThreadTopology::SetAffinity(coreMask);
+        ThreadTopology::SetPriority(priority);
+
+        // Queued closures still run after a stop request, so that stopping never drops a load
+        while (true)
+        {
+            if (RunPending())
+            {
+                continue;
+            }
+
+            if (!m_running)
+            {
+                break;
+            }
+
+            Sleep();
+        }
+    }
+
+    // The thread announces itself before checking the queue a last time, and pushing checks for
+    // sleepers after the closure is visible, so no wake up is lost.
+    void LaneQueue::Sleep()
+    {
+        m_sleepingThreads.fetch_add(1);
+        const uint32_t epoch = m_wakeEpoch.load();
+        if (m_running && !HasQueued())
+        {
+            SL_JOB_TRACE(SleepBegin);
+            m_wakeEpoch.wait(epoch);
+            SL_JOB_TRACE(SleepEnd);
+        }
+        m_sleepingThreads.fetch_sub(1);
+    }
+
+    void LaneQueue::Push(JobClosure&& closure)
+    {
+        m_pendingClosures.fetch_add(1);
+
+        // The queue is full, so help the threads of the lane until there is space
+        while (!m_queue.TryPush(std::move(closure)))
+        {
+            if (!RunPending())
+            {
+                std::this_thread::yield();
+            }
+        }
+
+        SL_JOB_TRACE(QueueDepth, m_queue.Size(), (uint64_t)(uintptr_t)m_name);
+
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_sleepingThreads.load() > 0)
+        {
+            m_wakeEpoch.fetch_add(1);
+            m_wakeEpoch.notify_one();
+        }
+    }
+
+    bool LaneQueue::RunPending()
+    {
+        JobClosure closure;
+        if (!m_queue.TryPop(closure))
+        {
+            return false;
+        }
+
+        // Nested lane jobs run in their own stack frame, so the closure's address tells them apart
+        SL_JOB_TRACE(LaneJobBegin, (uint64_t)(uintptr_t)&closure);
+        closure();
+        SL_JOB_TRACE(LaneJobEnd, (uint64_t)(uintptr_t)&closure);
+        m_pendingClosures.fetch_sub(1);
+        if (m_waitingThreads.load() > 0)
+        {
+            m_pendingClosures.notify_all();
+        }
+        return true;
+    }
+
+    void LaneQueue::Wait()
+    {
+        while (IsBusy())
+        {
+            if (RunPending())
+            {
+                continue;
+            }
+
+            // Only closures that are already running are left, sleep until one of them finishes
+            m_waitingThreads.fetch_add(1);
+            const uint32_t pending = m_pendingClosures.load();
+            if (pending > 0)
+            {
+                m_pendingClosures.wait(pending);
+            }
+            m_waitingThreads.fetch_sub(1);
+        }
+    }
+}
@@ -1,50 +1,208 @@
-#include "jobs/ThreadManager.h"
-#include <random>
+#include "Jobs/ThreadManager.h"
+#include "Jobs/JobTrace.h"
+#include <algorithm>
+#include <atomic>
 
 namespace Slayer
 {
     ThreadManager* ThreadManager::instance = nullptr;
 
-    bool ThreadManager::Initialize()
+    bool ThreadManager::Initialize(bool useFibers)
     {
-        static const int jobsPerThread = 4;
-        static const int workerThreads = 8;
-        std::size_t jobsPerQueue = jobsPerThread;
-        workers.emplace_back(MakeUnique<Worker>(jobsPerThread, Worker::Mode::FOREGROUND));
+        JobSettings settings;
+        settings.useFibers = useFibers;
+        return Initialize(settings);
+    }
+
+    bool ThreadManager::Initialize(const JobSettings& settings)
+    {
+        SL_ASSERT(settings.jobsPerWorker > 0 && (!settings.useFibers || settings.jobsPerFiber > 0) && "Job pools must hold at least one job.");
+        const uint32_t coreCount = ThreadTopology::GetCoreCount();
+        const uint32_t workerCount = std::min<uint32_t>(settings.workerCount > 0 ? settings.workerCount : coreCount, SL_MAX_WORKERS);
 
-        for (std::size_t i = 1; i < workerThreads; ++i)
+        // Worker i gets core i, the lanes share the cores no worker is pinned to
+        uint64_t laneCores = 0;
+        for (uint32_t i = 0; i < workerCount; ++i)
         {
-            workers.emplace_back(MakeUnique<Worker>(jobsPerThread, Worker::Mode::BACKGROUND));
+            const uint64_t workerCore = settings.pinWorkers ? 1ull << (i % std::min(coreCount, 64u)) : 0;
+            workers.emplace_back(MakeUnique<Worker>(settings, i, i == 0 ? Worker::Mode::FOREGROUND : Worker::Mode::BACKGROUND, workerCore));
+        }
+        for (uint32_t core = workerCount; settings.pinWorkers && core < std::min(coreCount, 64u); ++core)
+        {
+            laneCores |= 1ull << core;
         }
 
-        for (auto& worker : workers)
+        reportedFailures = 0;
+        instance = this;
+
+        // The foreground worker belongs to the initializing thread, the rest get their own threads
+        workers[0]->Start();
+        for (std::size_t i = 1; i < workers.size(); ++i)
         {
-            worker->Run();
+            workers[i]->StartBackgroundWorker();
         }
 
+        ioLane.Start(settings.ioThreads, settings.ioPriority, laneCores);
+        backgroundLane.Start(settings.backgroundThreads, settings.backgroundPriority, laneCores);
+        loadingLane.Start(settings.loadingThreads > 0 ? settings.loadingThreads : coreCount, settings.loadingPriority, laneCores);
+
         return true;
     }
 
     void ThreadManager::Shutdown()
     {
+        // The lanes finish what they have queued, which may still push frame closures
+        ioLane.Stop();
+        backgroundLane.Stop();
+        loadingLane.Stop();
+
+        // Signal every worker before joining, so that no running worker steals from a stopped one
         for (auto& worker : workers)
         {
-            worker.release();
+            worker->RequestStop();
+        }
+
+        // Sleeping workers see the stop request once they wake up
+        wakeEpoch.fetch_add(1);
+        wakeEpoch.notify_all();
+
+        for (auto& worker : workers)
+        {
+            worker->Stop();
         }
 
         workers.clear();
+
+        // Nothing runs the frame lane anymore
+        while (frameLane.RunPending())
+        {
+        }
+
+        if (instance == this)
+        {
+            instance = nullptr;
+        }
     }
 
     Job* ThreadManager::CreateJob(JobFunction function)
     {
-        return GetRandomWorker()->Pool().CreateJob(function);
+        Worker* worker = GetCurrentWorker();
+        return worker != nullptr ? worker->Pool().CreateJob(function) : nullptr;
+    }
+
+    LaneQueue& ThreadManager::GetLane(JobLane lane)
+    {
+        switch (lane)
+        {
+        case JobLane::IO:
+            return ioLane.GetThreadCount() > 0 ? ioLane : frameLane;
+        case JobLane::Background:
+            return backgroundLane.GetThreadCount() > 0 ? backgroundLane : frameLane;
+        case JobLane::Loading:
+            return loadingLane.GetThreadCount() > 0 ? loadingLane : frameLane;
+        default:
+            return frameLane;
+        }
+    }
+
+    void ThreadManager::Push(JobClosure&& closure, JobLane lane)
+    {
+        LaneQueue& queue = GetLane(lane);
+        queue.Push(std::move(closure));
+        if (&queue == &frameLane)
+        {
+            NotifyJobs();
+        }
+    }
+
+    void ThreadManager::Wait(JobLane lane)
+    {
+        GetLane(lane).Wait();
+    }
+
+    bool ThreadManager::IsBusy(JobLane lane)
+    {
+        return GetLane(lane).IsBusy();
+    }
+
+    void ThreadManager::WaitForJobs(const Worker& worker)
+    {
+        // The worker announces itself before checking the queues a last time, and NotifyJobs checks for
+        // sleepers after the job is pushed, so either the job is seen here or the worker is woken.
+        sleepingWorkers.fetch_add(1);
+        const uint32_t epoch = wakeEpoch.load();
+        if (worker.IsRunning() && !HasQueuedJobs())
+        {
+            SL_JOB_TRACE(SleepBegin);
+            wakeEpoch.wait(epoch);
+            SL_JOB_TRACE(SleepEnd);
+        }
+        sleepingWorkers.fetch_sub(1);
+    }
+
+    void ThreadManager::NotifyJobs(bool all)
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleepingWorkers.load() > 0)
+        {
+            wakeEpoch.fetch_add(1);
+            if (all)
+            {
+                wakeEpoch.notify_all();
+            }
+            else
+            {
+                wakeEpoch.notify_one();
+            }
+        }
+    }
+
+    bool ThreadManager::HasQueuedJobs() const
+    {
+        if (frameLane.HasQueued())
+        {
+            return true;
+        }
+
+        for (auto& worker : workers)
+        {
+            if (worker->HasQueuedJobs())
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void ThreadManager::BeginFrame()
+    {
+        SL_ASSERT(!HasQueuedJobs() && "Jobs are still queued at the frame boundary.");
+        const JobStats stats = GetJobStats();
+        if (stats.failedAllocations > reportedFailures)
+        {
+            Log::Warn("Job allocations failed last frame:", stats.failedAllocations - reportedFailures,
+                "high-water marks: jobs", stats.jobHighWaterMark, "fiber jobs", stats.fiberJobHighWaterMark, "frame arena bytes", stats.frameArenaHighWaterMark);
+            reportedFailures = stats.failedAllocations;
+        }
+
+        for (auto& worker : workers)
+        {
+            worker->ResetFrame();
+        }
+
+        JobTrace::MarkFrame(frameIndex++);
     }
 
-    Worker* ThreadManager::GetRandomWorker()
+    JobStats ThreadManager::GetJobStats() const
     {
-        static std::random_device rd;
-        static std::uniform_int_distribution<size_t> dist(0, workers.size() - 1);
-        return workers[dist(rd)].get();
+        JobStats stats;
+        for (auto& worker : workers)
+        {
+            worker->CollectStats(stats);
+        }
+
+        return stats;
     }
 
     Worker* ThreadManager::FindThreadWorker(const std::thread::id threadId)
@@ -60,4 +218,18 @@ namespace Slayer
         return nullptr;
     }
 
-}
\ No newline at end of file
+    int32_t ThreadManager::GetCurrentWorkerIndex() const
+    {
+        const std::thread::id threadId = std::this_thread::get_id();
+        for (size_t i = 0; i < workers.size(); i++)
+        {
+            if (workers[i]->GetThreadId() == threadId)
+            {
+                return (int32_t)i;
+            }
+        }
+
+        return -1;
+    }
+
+}
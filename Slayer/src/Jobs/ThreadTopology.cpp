@@ -0,0 +1,87 @@
+#include "Jobs/ThreadTopology.h"
+
+#include <algorithm>
+#include <string>
+#include <thread>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#ifdef __linux__
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace Slayer
+{
+    namespace ThreadTopology
+    {
+        uint32_t GetCoreCount()
+        {
+            return std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        bool SetName(const char* name)
+        {
+#if defined(_WIN32)
+            const std::string narrow(name);
+            const std::wstring wide(narrow.begin(), narrow.end());
+            return SUCCEEDED(SetThreadDescription(GetCurrentThread(), wide.c_str()));
+#elif defined(__linux__)
+            // The kernel keeps 15 characters and the terminator
+            const std::string shortName = std::string(name).substr(0, 15);
+            return pthread_setname_np(pthread_self(), shortName.c_str()) == 0;
+#elif defined(__APPLE__)
+            return pthread_setname_np(name) == 0;
+#else
+            return false;
+#endif
+        }
+
+        bool SetAffinity(uint64_t coreMask)
+        {
+            if (coreMask == 0)
+            {
+                return false;
+            }
+
+#if defined(_WIN32)
+            return SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)coreMask) != 0;
+#elif defined(__linux__)
+            cpu_set_t cores;
+            CPU_ZERO(&cores);
+            for (uint32_t core = 0; core < 64; core++)
+            {
+                if (coreMask & (1ull << core))
+                {
+                    CPU_SET(core, &cores);
+                }
+            }
+            return pthread_setaffinity_np(pthread_self(), sizeof(cores), &cores) == 0;
+#else
+            // macOS only takes affinity hints between threads, not cores
+            return false;
+#endif
+        }
+
+        bool SetPriority(ThreadPriority priority)
+        {
+#if defined(_WIN32)
+            static constexpr int priorities[] = { THREAD_PRIORITY_BELOW_NORMAL, THREAD_PRIORITY_NORMAL, THREAD_PRIORITY_ABOVE_NORMAL };
+            return SetThreadPriority(GetCurrentThread(), priorities[(int)priority]) != 0;
+#elif defined(__linux__)
+            // Linux threads have a nice value of their own, which is what the default scheduler uses
+            static constexpr int niceValues[] = { 10, 0, -5 };
+            return setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), niceValues[(int)priority]) == 0;
+#else
+            return false;
+#endif
+        }
+    }
+}
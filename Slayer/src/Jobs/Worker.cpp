@@ -1,13 +1,34 @@
 #include "Jobs/Job.h"
 #include "Jobs/Worker.h"
 #include "Jobs/ThreadManager.h"
+#include "Jobs/JobTrace.h"
+#include <algorithm>
+#include <string>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SL_CPU_RELAX() _mm_pause()
+#else
+#define SL_CPU_RELAX() std::this_thread::yield()
+#endif
 
 namespace Slayer
 {
-    Worker::Worker(std::size_t maxJobs, Mode mode)
-        : thread{nullptr}, mode{mode}, state{State::RUNNING}, jobPool{maxJobs}
+    // Idle rounds spent spinning with exponentially more pauses, and then yielding, before a worker sleeps
+    static constexpr uint32_t s_spinRounds = 7;
+    static constexpr uint32_t s_yieldRounds = 8;
+
+    Worker::JobFiber::JobFiber(Worker* worker)
+        : worker{worker}, pool{worker->jobsPerFiber, &worker->frameArena}
+    {
+        fiber = MakeUnique<Fiber>(SL_FIBER_STACK_SIZE, &Worker::RunFiber, this);
+    }
+
+    Worker::Worker(const JobSettings& settings, uint32_t index, Mode mode, uint64_t coreMask)
+        : frameArena{settings.frameArenaSize}, jobPool{settings.jobsPerWorker, &frameArena}, thread{nullptr}, state{State::RUNNING}, mode{mode},
+          index{index}, coreMask{coreMask}, priority{settings.workerPriority}, randomState{index * 2654435761u + 1}, useFibers{settings.useFibers}, jobsPerFiber{settings.jobsPerFiber}
     {
-        workQueue = MakeUnique<JobQueue>(maxJobs);
+        workQueue = MakeUnique<JobQueue>(settings.jobsPerWorker);
     }
 
     Worker::~Worker()
@@ -29,70 +50,357 @@ namespace Slayer
         threadId = thread->get_id();
     }
 
+    // Foreground workers do not own a thread, they are bound to the thread that starts them
+    // and only execute jobs while that thread waits.
+    void Worker::Start()
+    {
+        state = State::RUNNING;
+        threadId = std::this_thread::get_id();
+        ThreadTopology::SetAffinity(coreMask);
+        JobTrace::NameThread("Main");
+    }
+
+    void Worker::Stop()
+    {
+        state = State::STOPPING;
+        if (thread != nullptr)
+        {
+            ThreadManager::Get()->NotifyJobs(true);
+            thread->join();
+            delete thread;
+            thread = nullptr;
+        }
+
+        // The foreground thread goes back to being a plain thread, the fibers are parked at the start of their loop
+        threadFiber.reset();
+        fibers.clear();
+        freeFibers.clear();
+    }
+
     void Worker::Run()
     {
-        while (IsRunning())
+        const std::string name = "Worker " + std::to_string(index);
+        ThreadTopology::SetName(name.c_str());
+        JobTrace::NameThread(name.c_str());
+        ThreadTopology::SetAffinity(coreMask);
+        ThreadTopology::SetPriority(priority);
+
+        if (useFibers)
         {
-            Job *job = GetJob();
+            threadFiber = MakeUnique<Fiber>();
+            Schedule(nullptr);
+            threadFiber.reset();
+            return;
+        }
 
-            if (job != nullptr)
+        uint32_t idleRounds = 0;
+        while (IsRunning())
+        {
+            if (RunJob())
             {
-                job->Run();
+                idleRounds = 0;
+            }
+            else
+            {
+                Idle(idleRounds++, true);
             }
         }
+
+        EndIdle();
     }
 
     void Worker::Submit(Job *job)
     {
         workQueue->Push(job);
+        SL_JOB_TRACE(QueueDepth, workQueue->Size());
+        ThreadManager::Get()->NotifyJobs();
     }
 
     void Worker::Wait(Job *waitJob)
     {
+        if (waitJob->Finished())
+        {
+            return;
+        }
+
+        if (currentFiber != nullptr)
+        {
+            // Park the fiber, the scheduling loop resumes it once the job has finished
+            JobFiber* fiber = currentFiber;
+            fiber->waitJob = waitJob;
+            SL_JOB_TRACE(ParkBegin, (uint64_t)(uintptr_t)fiber);
+            fiber->fiber->SwitchTo(*threadFiber);
+            SL_JOB_TRACE(ParkEnd, (uint64_t)(uintptr_t)fiber);
+            SL_ASSERT(waitJob->Finished() && "Fiber resumed before the job it waits for finished.");
+            return;
+        }
+
+        if (useFibers)
+        {
+            if (threadFiber == nullptr)
+            {
+                threadFiber = MakeUnique<Fiber>();
+            }
+
+            Schedule(waitJob);
+            return;
+        }
+
+        // Finishing a job does not wake anyone, so a waiting worker never sleeps
+        uint32_t idleRounds = 0;
         while (!waitJob->Finished())
         {
+            if (RunJob())
+            {
+                idleRounds = 0;
+            }
+            else
+            {
+                Idle(idleRounds++, false);
+            }
+        }
+
+        EndIdle();
+    }
+
+    void Worker::ResetFrame()
+    {
+        SL_ASSERT(waitingFibers.empty() && "Jobs are still waiting at the frame boundary.");
+        jobPool.Clear();
+        for (auto& fiber : fibers)
+        {
+            fiber->pool.Clear();
+        }
+
+        frameArena.Reset();
+    }
+
+    void Worker::CollectStats(JobStats& stats) const
+    {
+        stats.jobHighWaterMark = std::max(stats.jobHighWaterMark, jobPool.GetHighWaterMark());
+        stats.frameArenaHighWaterMark = std::max(stats.frameArenaHighWaterMark, frameArena.GetHighWaterMark());
+        stats.failedAllocations += jobPool.GetFailedAllocations() + frameArena.GetFailedAllocations();
+        for (auto& fiber : fibers)
+        {
+            stats.fiberJobHighWaterMark = std::max(stats.fiberJobHighWaterMark, fiber->pool.GetHighWaterMark());
+            stats.failedAllocations += fiber->pool.GetFailedAllocations();
+        }
+    }
+
+    void Worker::Idle(uint32_t idleRounds, bool allowSleep)
+    {
+        if (!idle)
+        {
+            idle = true;
+            failedSteals = 0;
+            SL_JOB_TRACE(IdleBegin);
+        }
+
+        if (idleRounds < s_spinRounds)
+        {
+            for (uint32_t i = 0; i < (1u << idleRounds); i++)
+            {
+                SL_CPU_RELAX();
+            }
+        }
+        else if (idleRounds < s_spinRounds + s_yieldRounds || !allowSleep)
+        {
+            std::this_thread::yield();
+        }
+        else
+        {
+            ThreadManager::Get()->WaitForJobs(*this);
+        }
+    }
+
+    void Worker::EndIdle()
+    {
+        if (idle)
+        {
+            idle = false;
+            SL_JOB_TRACE(IdleEnd, 0, failedSteals);
+        }
+    }
+
+    void Worker::RunFiber(void* arg)
+    {
+        JobFiber* fiber = static_cast<JobFiber*>(arg);
+        while (true)
+        {
+            Job* job = fiber->job;
+            fiber->job = nullptr;
+            job->Run();
+
+            // Back to the scheduling loop, which returns the fiber to the pool
+            fiber->fiber->SwitchTo(*fiber->worker->threadFiber);
+        }
+    }
+
+    void Worker::Schedule(Job* until)
+    {
+        uint32_t idleRounds = 0;
+        while (until != nullptr ? !until->Finished() : IsRunning())
+        {
+            if (ResumeWaitingFiber())
+            {
+                idleRounds = 0;
+                continue;
+            }
+
             Job *job = GetJob();
+            if (job == nullptr && RunFrameLaneJob())
+            {
+                // Closures of the frame lane run on the thread's stack
+                idleRounds = 0;
+                continue;
+            }
 
-            if (job != nullptr)
+            if (job == nullptr)
+            {
+                // Parked fibers are not woken when their job finishes, so the worker only sleeps without any
+                Idle(idleRounds++, until == nullptr && waitingFibers.empty());
+                continue;
+            }
+
+            idleRounds = 0;
+            JobFiber* fiber = AcquireFiber();
+            if (fiber != nullptr)
+            {
+                fiber->job = job;
+                SwitchToFiber(fiber);
+            }
+            else
             {
+                // Every fiber is parked, run the job on the thread's stack instead
                 job->Run();
             }
         }
+
+        EndIdle();
     }
 
-    Job *Worker::GetJob()
+    void Worker::SwitchToFiber(JobFiber* fiber)
     {
-        Job *job = workQueue->Pop();
+        currentFiber = fiber;
+        threadFiber->SwitchTo(*fiber->fiber);
+        currentFiber = nullptr;
 
-        if (job != nullptr)
+        // The fiber switched back because its job either finished or waits for another job
+        if (fiber->waitJob != nullptr)
         {
-            job->Run();
+            waitingFibers.push_back(fiber);
         }
         else
         {
-            Worker *worker = ThreadManager::Get()->GetRandomWorker();
+            freeFibers.push_back(fiber);
+        }
+    }
 
-            if (worker != this)
+    bool Worker::ResumeWaitingFiber()
+    {
+        for (size_t i = 0; i < waitingFibers.size(); i++)
+        {
+            JobFiber* fiber = waitingFibers[i];
+            if (fiber->waitJob->Finished())
             {
-                Job *job = worker->workQueue->Steal();
-
-                if (job != nullptr)
-                {
-                    return job;
-                }
-                else
-                {
-                    std::this_thread::yield();
-                    return nullptr;
-                }
+                waitingFibers[i] = waitingFibers.back();
+                waitingFibers.pop_back();
+                fiber->waitJob = nullptr;
+                EndIdle();
+                SwitchToFiber(fiber);
+                return true;
             }
-            else
+        }
+
+        return false;
+    }
+
+    Worker::JobFiber* Worker::AcquireFiber()
+    {
+        if (freeFibers.empty())
+        {
+            if (fibers.size() >= SL_FIBERS_PER_WORKER)
             {
-                std::this_thread::yield();
                 return nullptr;
             }
+
+            fibers.push_back(MakeUnique<JobFiber>(this));
+            return fibers.back().get();
+        }
+
+        JobFiber* fiber = freeFibers.back();
+        freeFibers.pop_back();
+        return fiber;
+    }
+
+    Job *Worker::GetJob()
+    {
+        Job *job = workQueue->Pop();
+        if (job == nullptr)
+        {
+            job = StealJob();
+        }
+
+        if (job != nullptr)
+        {
+            EndIdle();
         }
 
         return job;
     }
-}
\ No newline at end of file
+
+    bool Worker::RunFrameLaneJob()
+    {
+        // The idle span ends before the closure runs, but only if there is one
+        if (!ThreadManager::Get()->HasFrameLaneJobs())
+        {
+            return false;
+        }
+
+        EndIdle();
+        return ThreadManager::Get()->RunFrameLaneJob();
+    }
+
+    bool Worker::RunJob()
+    {
+        Job *job = GetJob();
+        if (job != nullptr)
+        {
+            job->Run();
+            return true;
+        }
+
+        return RunFrameLaneJob();
+    }
+
+    Job *Worker::StealJob()
+    {
+        ThreadManager* threadManager = ThreadManager::Get();
+        const uint32_t workerCount = (uint32_t)threadManager->GetWorkerCount();
+
+        // Start at a random victim so that thieves spread out, then try every other worker once
+        randomState ^= randomState << 13;
+        randomState ^= randomState >> 17;
+        randomState ^= randomState << 5;
+        const uint32_t first = randomState % workerCount;
+
+        for (uint32_t i = 0; i < workerCount; i++)
+        {
+            Worker* victim = threadManager->GetWorker((first + i) % workerCount);
+            if (victim == this)
+            {
+                continue;
+            }
+
+            Job *job = victim->workQueue->Steal();
+            if (job != nullptr)
+            {
+                SL_JOB_TRACE(Steal, victim->index);
+                return job;
+            }
+        }
+
+        failedSteals++;
+        return nullptr;
+    }
+}
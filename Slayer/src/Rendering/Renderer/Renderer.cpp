@@ -223,6 +223,20 @@ namespace Slayer
 		}
 	}
 
+	void Renderer::Submit(Shared<Model> model, Shared<Material> material, const Mat4* transforms, size_t count)
+	{
+		for (auto& mesh : model->GetMeshes())
+		{
+			RenderJob job = { mesh->GetVaoID(),
+								mesh->GetIndexCount(),
+								material,
+								m_shaderStatic,
+								Mat4(1.0f) };
+			m_mainPass.Submit(job, transforms, count);
+			m_shadowPass.Submit(job, transforms, count);
+		}
+	}
+
 	void Renderer::Submit(Shared<SkeletalModel> model, Shared<Material> material, const Mat4& transform)
 	{
 		for (auto& mesh : model->GetMeshes())
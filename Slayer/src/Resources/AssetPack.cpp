@@ -1,12 +1,47 @@
-
 #include "Slayer.h"
 #include "Resources/AssetPack.h"
-#include <iostream>
-#include <fstream>
+#include "Resources/Compression.h"
+#include "Jobs/JobSystem.h"
+#include <atomic>
 #include <filesystem>
 
 namespace Slayer
 {
+    uint32_t AssetPack::HashName(const char* name, size_t length)
+    {
+        uint32_t hash = 2166136261u;
+        for (size_t i = 0; i < length; i++)
+        {
+            hash = (hash ^ (uint8_t)name[i]) * 16777619u;
+        }
+        return hash;
+    }
+
+    uint32_t AssetPack::Checksum(const char* data, size_t length)
+    {
+        static const Array<uint32_t, 256> table = []()
+            {
+                Array<uint32_t, 256> values;
+                for (uint32_t i = 0; i < 256; i++)
+                {
+                    uint32_t value = i;
+                    for (int bit = 0; bit < 8; bit++)
+                    {
+                        value = (value & 1) ? 0xEDB88320u ^ (value >> 1) : value >> 1;
+                    }
+                    values[i] = value;
+                }
+                return values;
+            }();
+
+        uint32_t crc = 0xFFFFFFFFu;
+        for (size_t i = 0; i < length; i++)
+        {
+            crc = table[(crc ^ (uint8_t)data[i]) & 0xFF] ^ (crc >> 8);
+        }
+        return crc ^ 0xFFFFFFFFu;
+    }
+
     void AssetPack::Save(const std::string& path)
     {
     }
@@ -14,56 +49,251 @@ namespace Slayer
     void AssetPack::Load(const std::string& path)
     {
         Log::Info("Loading asset pack: " + std::filesystem::absolute(path).string());
-        // Attach an input stream to the wanted file
-        std::ifstream inputStream(path, std::ios::binary);
-        // Check stream status
-        if (!inputStream.is_open())
-            std::cerr << path << std::endl;
-        SL_ASSERT(inputStream.is_open() && "Failed to open asset pack!");
+        m_isLoaded = false;
+        m_version = 0;
+        m_assets.clear();
+        m_assetNames.clear();
+        m_decompressed.clear();
+
+        // Map the whole pack, the data is only read from disk once an asset is deserialized
+        if (!m_file.Open(path))
+        {
+            Log::Error("Failed to open asset pack:", path);
+            SL_ASSERT(false && "Failed to open asset pack!");
+            return;
+        }
+
+        AssetPackReader reader(m_file.Data(), m_file.Size());
 
         // Read the header
         AssetPackHeader header;
-        header.Read(inputStream);
+        if (!header.Read(reader) || header.magic[5] != '\0' || std::string(header.magic) != SL_ASSET_PACK_MAGIC)
+        {
+            Log::Error("Not an asset pack:", path);
+            return;
+        }
 
-        std::cout << "Loaded asset pack: " << path << std::endl;
-        std::cout << "Asset pack magic: " << header.magic << std::endl;
-        std::cout << "Asset pack version: " << header.version << std::endl;
-        std::cout << "Number of assets: " << header.numAssets << std::endl;
+        // Check the version
+        if (header.version != SL_ASSET_PACK_VERSION_1 && header.version != SL_ASSET_PACK_VERSION)
+        {
+            Log::Error("Unsupported asset pack version:", header.version, path);
+            return;
+        }
+        m_version = header.version;
 
-        // Check the header
-        SL_ASSERT(std::string(header.magic) == SL_ASSET_PACK_MAGIC);
+        m_assets.reserve(header.numAssets);
+        m_assetNames.reserve(header.numAssets);
 
-        // Check the version
-        SL_ASSERT(header.version == SL_ASSET_PACK_VERSION);
+        const bool loaded = m_version == SL_ASSET_PACK_VERSION_1 ? LoadVersion1(reader, header) : LoadVersion2(header);
+        if (!loaded)
+        {
+            Log::Error("Asset pack is corrupt:", path);
+            m_assets.clear();
+            m_assetNames.clear();
+            return;
+        }
+
+        Log::Info("Loaded asset pack with", header.numAssets, "assets, version", header.version);
+        m_isLoaded = true;
+    }
 
-        m_data = std::vector<char>();
-        uint32_t dataIndex = 0;
-        // Read assets
+    // Builds the record table by skipping over the data of every asset
+    bool AssetPack::LoadVersion1(AssetPackReader& reader, const AssetPackHeader& header)
+    {
         for (uint32_t i = 0; i < header.numAssets; i++)
         {
             AssetHeader assetHeader;
-            assetHeader.Read(inputStream);
+            if (!assetHeader.Read(reader))
+                return false;
+
             AssetRecord record;
             record.id = assetHeader.id;
             record.type = assetHeader.type;
-            record.name = assetHeader.name;
+            record.name = std::move(assetHeader.name);
+            record.dataLength = assetHeader.dataLength;
+            record.dataOffset = (uint64_t)(reader.GetCurrent() - m_file.Data());
+            record.uncompressedLength = record.dataLength;
 
-            std::cout << "Asset name: " << record.name << std::endl;
-            std::cout << "\tData Length: " << assetHeader.dataLength << std::endl;
+            if (!reader.Skip(record.dataLength))
+                return false;
+            AddRecord(std::move(record));
+        }
 
-            record.dataIndex = dataIndex;
-            dataIndex += assetHeader.dataLength;
-            record.dataLength = assetHeader.dataLength;
+        return true;
+    }
 
-            m_assets[record.id] = record;
-            m_assetNames[record.name] = record.id;
+    // Builds the record table from the table of contents, without touching the data
+    bool AssetPack::LoadVersion2(const AssetPackHeader& header)
+    {
+        const uint64_t fileSize = m_file.Size();
+        const uint64_t tocSize = (uint64_t)header.numAssets * sizeof(AssetTocEntry);
+        if (header.tocOffset > fileSize || tocSize > fileSize - header.tocOffset
+            || header.namesOffset > fileSize || header.namesSize > fileSize - header.namesOffset)
+            return false;
 
-            // Add the data to the data buffer
-            std::vector<char> data;
-            data.resize(assetHeader.dataLength);
-            inputStream.read(data.data(), assetHeader.dataLength);
-            m_data.insert(m_data.end(), data.begin(), data.end());
+        const char* names = m_file.Data() + header.namesOffset;
+        AssetPackReader reader(m_file.Data() + header.tocOffset, tocSize);
+        for (uint32_t i = 0; i < header.numAssets; i++)
+        {
+            AssetTocEntry entry;
+            reader.Read(&entry, sizeof(AssetTocEntry));
+
+            const bool alignmentValid = entry.alignment != 0 && (entry.alignment & (entry.alignment - 1)) == 0;
+            const bool compressionValid = entry.compression == (uint8_t)AssetCompression::LZ4
+                || (entry.compression == (uint8_t)AssetCompression::None && entry.uncompressedLength == entry.dataLength);
+            if ((uint64_t)entry.nameOffset + entry.nameLength > header.namesSize
+                || entry.dataOffset > fileSize || entry.dataLength > fileSize - entry.dataOffset
+                || !alignmentValid || entry.dataOffset % entry.alignment != 0 || !compressionValid)
+                return false;
+
+            const char* name = names + entry.nameOffset;
+            if (HashName(name, entry.nameLength) != entry.nameHash)
+                return false;
+
+            AssetRecord record;
+            record.id = entry.id;
+            record.type = entry.type;
+            record.name.assign(name, entry.nameLength);
+            record.dataLength = entry.dataLength;
+            record.dataOffset = entry.dataOffset;
+            record.checksum = entry.checksum;
+            record.uncompressedLength = entry.uncompressedLength;
+            record.compression = (AssetCompression)entry.compression;
+
+            AddRecord(std::move(record));
+        }
+
+        return true;
+    }
+
+    void AssetPack::AddRecord(AssetRecord&& record)
+    {
+        // The last asset with an id wins, as it always has
+        if (m_assets.find(record.id) != m_assets.end())
+            Log::Warn("Asset id is not unique:", record.id, record.name);
+
+        m_assetNames[record.name] = record.id;
+        m_assets[record.id] = std::move(record);
+    }
+
+    bool AssetPack::VerifyAsset(const AssetID& id) const
+    {
+        if (m_version == SL_ASSET_PACK_VERSION_1)
+            return true;
+
+        const AssetRecord* record = FindAsset(id);
+        SL_ASSERT(record && "Asset not found!");
+        return Checksum(m_file.Data() + record->dataOffset, record->dataLength) == record->checksum;
+    }
+
+    bool AssetPack::PrepareBlocks(const AssetRecord& record, Vector<CompressedBlock>& blocks)
+    {
+        AssetPackReader reader(m_file.Data() + record.dataOffset, record.dataLength);
+        uint32_t blockSize, blockCount;
+        if (!reader.Read(&blockSize, sizeof(uint32_t)) || !reader.Read(&blockCount, sizeof(uint32_t)) || blockSize == 0
+            || blockCount != (uint32_t)(((uint64_t)record.uncompressedLength + blockSize - 1) / blockSize))
+            return false;
+
+        // The lengths are followed by the blocks
+        AssetPackReader lengths(reader.GetCurrent(), (size_t)blockCount * sizeof(uint32_t));
+        if (!reader.Skip((size_t)blockCount * sizeof(uint32_t)))
+            return false;
+
+        // The blocks are only handed out once the whole table is valid, none may point into an erased buffer
+        const size_t firstBlock = blocks.size();
+        Vector<char>& buffer = m_decompressed[record.id];
+        buffer.resize(record.uncompressedLength);
+        for (uint32_t i = 0; i < blockCount; i++)
+        {
+            CompressedBlock block;
+            lengths.Read(&block.srcLength, sizeof(uint32_t));
+            block.src = reader.GetCurrent();
+            block.dst = buffer.data() + (size_t)i * blockSize;
+            block.dstLength = std::min(blockSize, record.uncompressedLength - i * blockSize);
+            if (!reader.Skip(block.srcLength))
+            {
+                blocks.resize(firstBlock);
+                m_decompressed.erase(record.id);
+                return false;
+            }
+            blocks.push_back(block);
+        }
+
+        return true;
+    }
+
+    bool AssetPack::DecompressAsset(const AssetID& id)
+    {
+        const AssetRecord* record = FindAsset(id);
+        SL_ASSERT(record && "Asset not found!");
+        if (IsDecompressed(id))
+            return true;
+
+        Vector<CompressedBlock> blocks;
+        if (!PrepareBlocks(*record, blocks))
+            return false;
+
+        for (const CompressedBlock& block : blocks)
+        {
+            if (!Compression::DecompressLz4(block.src, block.srcLength, block.dst, block.dstLength))
+            {
+                m_decompressed.erase(id);
+                return false;
+            }
         }
+
+        return true;
+    }
+
+    bool AssetPack::DecompressAssets(JobLane lane)
+    {
+        // The buffers are allocated up front, so that the jobs only write to their own blocks
+        Vector<CompressedBlock> blocks;
+        Vector<AssetID> assets;
+        bool decompressed = true;
+        for (const auto& [id, record] : m_assets)
+        {
+            if (IsDecompressed(id))
+                continue;
+
+            const size_t firstBlock = blocks.size();
+            if (!PrepareBlocks(record, blocks))
+            {
+                Log::Error("Corrupt compressed asset:", record.name);
+                decompressed = false;
+                continue;
+            }
+
+            for (size_t i = firstBlock; i < blocks.size(); i++)
+            {
+                blocks[i].asset = (uint32_t)assets.size();
+            }
+            assets.push_back(id);
+        }
+
+        Unique<std::atomic<bool>[]> failed = std::make_unique<std::atomic<bool>[]>(assets.size());
+        const CompressedBlock* blockData = blocks.data();
+        std::atomic<bool>* failedData = failed.get();
+        JobSystem::Dispatch((uint32_t)blocks.size(), 1, [blockData, failedData](JobDispatchArgs args)
+            {
+                const CompressedBlock& block = blockData[args.jobIndex];
+                if (!Compression::DecompressLz4(block.src, block.srcLength, block.dst, block.dstLength))
+                    failedData[block.asset].store(true, std::memory_order_relaxed);
+            }, lane);
+        JobSystem::Wait(lane);
+
+        // Corrupt assets stay compressed, GetAssetData then fails on them only
+        for (size_t i = 0; i < assets.size(); i++)
+        {
+            if (failed[i].load())
+            {
+                Log::Error("Corrupt compressed asset:", m_assets.at(assets[i]).name);
+                m_decompressed.erase(assets[i]);
+                decompressed = false;
+            }
+        }
+
+        return decompressed;
     }
 
-}
+}
\ No newline at end of file
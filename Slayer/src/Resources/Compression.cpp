@@ -0,0 +1,225 @@
+#include "Resources/Compression.h"
+#include "Core/Containers.h"
+
+#include <cstring>
+
+namespace Slayer
+{
+    namespace Compression
+    {
+        static constexpr size_t minMatch = 4;
+        // The last match has to start this far from the end of the block, the last five bytes are literals
+        static constexpr size_t matchStartLimit = 12;
+        static constexpr size_t lastLiterals = 5;
+        static constexpr size_t maxOffset = 65535;
+        static constexpr uint32_t hashBits = 16;
+
+        static uint32_t Read32(const uint8_t* data)
+        {
+            uint32_t value;
+            memcpy(&value, data, sizeof(uint32_t));
+            return value;
+        }
+
+        size_t GetLz4Bound(size_t size)
+        {
+            return size + size / 255 + 16;
+        }
+
+        // Writes a length that does not fit the token as bytes of 255 and a remainder
+        static bool WriteLength(uint8_t*& op, const uint8_t* oend, size_t length)
+        {
+            for (; length >= 255; length -= 255)
+            {
+                if (op >= oend)
+                    return false;
+                *op++ = 255;
+            }
+            if (op >= oend)
+                return false;
+            *op++ = (uint8_t)length;
+            return true;
+        }
+
+        static bool WriteSequence(uint8_t*& op, const uint8_t* oend, const uint8_t* literals, size_t literalLength, size_t offset, size_t matchLength)
+        {
+            if (op >= oend)
+                return false;
+
+            uint8_t* token = op++;
+            *token = (uint8_t)(std::min<size_t>(literalLength, 15) << 4);
+            if (literalLength >= 15 && !WriteLength(op, oend, literalLength - 15))
+                return false;
+            if ((size_t)(oend - op) < literalLength)
+                return false;
+            if (literalLength > 0)
+                memcpy(op, literals, literalLength);
+            op += literalLength;
+
+            // The last sequence has literals only
+            if (matchLength == 0)
+                return true;
+
+            if (oend - op < 2)
+                return false;
+            *op++ = (uint8_t)(offset & 0xFF);
+            *op++ = (uint8_t)(offset >> 8);
+
+            const size_t length = matchLength - minMatch;
+            *token |= (uint8_t)std::min<size_t>(length, 15);
+            return length < 15 || WriteLength(op, oend, length - 15);
+        }
+
+        size_t CompressLz4(const char* src, size_t srcSize, char* dst, size_t dstCapacity)
+        {
+            const uint8_t* const base = (const uint8_t*)src;
+            uint8_t* op = (uint8_t*)dst;
+            const uint8_t* const oend = op + dstCapacity;
+
+            size_t anchor = 0;
+            if (srcSize > matchStartLimit)
+            {
+                // Last position of each hashed four bytes
+                Vector<uint32_t> table((size_t)1 << hashBits, 0);
+                const size_t matchLimit = srcSize - matchStartLimit;
+                const size_t matchEnd = srcSize - lastLiterals;
+
+                size_t ip = 0;
+                while (ip < matchLimit)
+                {
+                    const uint32_t sequence = Read32(base + ip);
+                    const uint32_t hash = (sequence * 2654435761u) >> (32 - hashBits);
+                    const size_t candidate = table[hash];
+                    table[hash] = (uint32_t)ip;
+
+                    if (candidate >= ip || ip - candidate > maxOffset || Read32(base + candidate) != sequence)
+                    {
+                        // Step faster through data that does not compress
+                        ip += 1 + ((ip - anchor) >> 6);
+                        continue;
+                    }
+
+                    size_t length = minMatch;
+                    while (ip + length < matchEnd && base[candidate + length] == base[ip + length])
+                    {
+                        length++;
+                    }
+
+                    if (!WriteSequence(op, oend, base + anchor, ip - anchor, ip - candidate, length))
+                        return 0;
+
+                    ip += length;
+                    anchor = ip;
+                }
+            }
+
+            if (!WriteSequence(op, oend, base + anchor, srcSize - anchor, 0, 0))
+                return 0;
+
+            return (size_t)(op - (uint8_t*)dst);
+        }
+
+        // Reads the bytes of 255 and the remainder that extend a length of 15
+        static bool ReadLength(const uint8_t*& ip, const uint8_t* iend, size_t& length)
+        {
+            uint8_t value;
+            do
+            {
+                if (ip >= iend)
+                    return false;
+                value = *ip++;
+                length += value;
+            } while (value == 255);
+            return true;
+        }
+
+        // Copies in chunks of eight bytes, which may write up to seven bytes past the end. The source may overlap
+        // the destination as long as it starts at least eight bytes before it.
+        static void CopyChunks(uint8_t* dst, const uint8_t* src, size_t length)
+        {
+            uint8_t* const end = dst + length;
+            do
+            {
+                memcpy(dst, src, 8);
+                dst += 8;
+                src += 8;
+            } while (dst < end);
+        }
+
+        bool DecompressLz4(const char* src, size_t srcSize, char* dst, size_t dstSize)
+        {
+            const uint8_t* ip = (const uint8_t*)src;
+            const uint8_t* const iend = ip + srcSize;
+            uint8_t* op = (uint8_t*)dst;
+            uint8_t* const oend = op + dstSize;
+
+            while (ip < iend)
+            {
+                const uint8_t token = *ip++;
+
+                size_t literalLength = token >> 4;
+                if (literalLength == 15 && !ReadLength(ip, iend, literalLength))
+                    return false;
+                if (literalLength > (size_t)(iend - ip) || literalLength > (size_t)(oend - op))
+                    return false;
+                // Short literals are copied as one chunk where there is room for it
+                if (literalLength <= 16 && iend - ip >= 16 && oend - op >= 16)
+                    memcpy(op, ip, 16);
+                else if (literalLength > 0)
+                    memcpy(op, ip, literalLength);
+                op += literalLength;
+                ip += literalLength;
+
+                // The last sequence ends with its literals
+                if (ip == iend)
+                    break;
+
+                if (iend - ip < 2)
+                    return false;
+                const size_t offset = (size_t)ip[0] | ((size_t)ip[1] << 8);
+                ip += 2;
+                if (offset == 0 || offset > (size_t)(op - (uint8_t*)dst))
+                    return false;
+
+                size_t matchLength = token & 15;
+                if (matchLength == 15 && !ReadLength(ip, iend, matchLength))
+                    return false;
+                matchLength += minMatch;
+                if (matchLength > (size_t)(oend - op))
+                    return false;
+
+                const uint8_t* match = op - offset;
+                if ((size_t)(oend - op) >= matchLength + 8)
+                {
+                    if (offset >= 8)
+                    {
+                        CopyChunks(op, match, matchLength);
+                    }
+                    else
+                    {
+                        // The match repeats a pattern shorter than a chunk. Once eight bytes of it are written, the
+                        // rest is copied from a multiple of the pattern length back, which is at least a chunk.
+                        for (size_t i = 0; i < 8; i++)
+                        {
+                            op[i] = match[i];
+                        }
+                        const size_t period = offset * ((8 + offset - 1) / offset);
+                        if (matchLength > 8)
+                            CopyChunks(op + 8, op + 8 - period, matchLength - 8);
+                    }
+                }
+                else
+                {
+                    // Near the end there is no room for chunks, the match may overlap the bytes it writes
+                    for (size_t i = 0; i < matchLength; i++)
+                    {
+                        op[i] = match[i];
+                    }
+                }
+                op += matchLength;
+            }
+
+            return op == oend;
+        }
+    }
+}
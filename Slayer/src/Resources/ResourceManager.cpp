@@ -10,18 +10,30 @@ namespace Slayer
 		return std::async(std::launch::async, [this, assetPackPath]()
 			{
 				SL_ASSERT(this && "This pointer not valid!");
-				AssetPack assetPack;
+				GPULoadData gpuLoadData;
+				gpuLoadData.assetPack = MakeShared<AssetPack>();
+				AssetPack& assetPack = *gpuLoadData.assetPack;
 				assetPack.Load(assetPackPath);
+				if (!assetPack.IsLoaded())
+				{
+					Log::Error("Failed to load asset pack:", assetPackPath);
+					return gpuLoadData;
+				}
 
-				GPULoadData gpuLoadData;
+				// Decompressing is spread over the loading lane, which has a thread per core and whose jobs may run across frames
+				if (!assetPack.DecompressAssets(JobLane::Loading))
+					Log::Error("Asset pack has corrupt assets, they are skipped:", assetPackPath);
 
 				for (const auto& [id, record] : assetPack.GetAssets())
 				{
+					if (!assetPack.IsDecompressed(id))
+						continue;
+
 					switch (record.type)
 					{
 					case AssetType::SL_ASSET_TYPE_TEXTURE:
 					{
-						TextureAsset ta = assetPack.GetAssetData<TextureAsset>(id);
+						TextureAssetView ta = assetPack.GetAssetData<TextureAssetView>(id);
 						gpuLoadData.textures.push_back({ ta, record });
 						continue;
 					}
@@ -50,19 +62,19 @@ namespace Slayer
 					}
 					case AssetType::SL_ASSET_TYPE_MODEL:
 					{
-						ModelAsset ma = assetPack.GetAssetData<ModelAsset>(id);
+						ModelAssetView ma = assetPack.GetAssetData<ModelAssetView>(id);
 						gpuLoadData.models.push_back({ ma, record });
 						continue;
 					}
 					case AssetType::SL_ASSET_TYPE_SKELETAL_MODEL:
 					{
-						SkeletalModelAsset sma = assetPack.GetAssetData<SkeletalModelAsset>(id);
+						SkeletalModelAssetView sma = assetPack.GetAssetData<SkeletalModelAssetView>(id);
 						gpuLoadData.skeletalModels.push_back({ sma, record });
 						continue;
 					}
 					case AssetType::SL_ASSET_TYPE_ANIMATION:
 					{
-						AnimationAsset aa = assetPack.GetAssetData<AnimationAsset>(id);
+						AnimationAssetView aa = assetPack.GetAssetData<AnimationAssetView>(id);
 						gpuLoadData.animations.push_back({ aa, record });
 						continue;
 					}
@@ -81,12 +93,12 @@ namespace Slayer
 		{
 			if (ta.target == uint32_t(0x8513)) // HDR
 			{
-				Shared<Texture> texture = Texture::LoadTextureHDR((const float*)ta.data.data(), ta.width, ta.height, ta.channels);
+				Shared<Texture> texture = Texture::LoadTextureHDR((const float*)ta.data.Data(), ta.width, ta.height, ta.channels);
 				m_assetStore.AddAsset(record.id, record.name, texture);
 			}
 			else if (ta.target == uint32_t(0x0DE1)) // 2D
 			{
-				Shared<Texture> texture = Texture::LoadTexture(ta.data.data(), ta.width, ta.height, ta.channels, (TextureTarget)ta.target);
+				Shared<Texture> texture = Texture::LoadTexture((const uint8_t*)ta.data.Data(), ta.width, ta.height, ta.channels, (TextureTarget)ta.target);
 				m_assetStore.AddAsset(record.id, record.name, texture);
 			}
 			else
@@ -112,7 +124,7 @@ namespace Slayer
 			Shared<Model> model = MakeShared<Model>();
 			for (auto& meshDesc : ma.meshes)
 			{
-				Shared<Mesh> mesh = Mesh::Create((float*)meshDesc.vertices.data(), (uint32_t)meshDesc.vertices.size() * sizeof(float), (uint32_t*)meshDesc.indices.data(), (uint32_t)meshDesc.indices.size());
+				Shared<Mesh> mesh = Mesh::Create((float*)meshDesc.vertices.Data(), (uint32_t)meshDesc.vertices.SizeInBytes(), (uint32_t*)meshDesc.indices.Data(), (uint32_t)meshDesc.indices.Size());
 				model->AddMesh(mesh);
 			}
 			m_assetStore.AddAsset(record.id, record.name, model);
@@ -129,17 +141,18 @@ namespace Slayer
 
 			static_assert(sizeof(SkeletalVertex) == 64);
 
-			Vector<SkeletalVertex> vertices(mesh.vertices.size());
-			Copy(mesh.vertices.data(), vertices.data(), mesh.vertices.size() * sizeof(SkeletalVertex));
+			Vector<SkeletalVertex> vertices(mesh.vertices.Size());
+			Copy(mesh.vertices.Data(), vertices.data(), mesh.vertices.SizeInBytes());
+			Vector<uint32_t> indices = mesh.indices.ToVector();
 
-			Shared<SkeletalModel> skeletalModel = SkeletalModel::Create(vertices, mesh.indices, bones, mesh.globalInverseTransform);
+			Shared<SkeletalModel> skeletalModel = SkeletalModel::Create(vertices, indices, bones, mesh.globalInverseTransform);
 			skeletalModel->AddSockets(sma.sockets);
 			m_assetStore.AddAsset(record.id, record.name, skeletalModel);
 		}
 
 		for (auto& [aa, record] : gpuLoadData.animations)
 		{
-			Shared<Animation> animation = Animation::Create(aa.data, aa.times, aa.duration);
+			Shared<Animation> animation = Animation::Create(aa.data.ToVector(), aa.times.ToVector(), aa.duration);
 			m_assetStore.AddAsset(record.id, record.name, animation);
 		}
 	}
@@ -0,0 +1,219 @@
+#include "Scene/SystemManager.h"
+#include "Scene/ComponentStore.h"
+#include "Jobs/ThreadManager.h"
+
+#include <chrono>
+
+namespace Slayer {
+
+    SystemManager::SystemManager()
+    {
+        m_groupOrder = {
+            SL_GROUP_NETWORK,
+            SL_GROUP_AI,
+            SL_GROUP_PHYSICS,
+            SL_GROUP_ANIMATION,
+            SL_GROUP_TRANSFORM,
+            SL_GROUP_AUDIO,
+            SL_GROUP_RENDER
+        };
+    }
+
+    SystemManager::~SystemManager() = default;
+
+    void SystemManager::AddSystem(SystemBase* system, const std::string& name)
+    {
+        SL_ASSERT(system != nullptr && "System is null.");
+        SystemNode node;
+        node.system = system;
+        m_systems.push_back(node);
+        m_timings.push_back({ name, 0.0 });
+        m_graphDirty = true;
+    }
+
+    void SystemManager::RemoveSystem(SystemBase* system)
+    {
+        for (size_t i = 0; i < m_systems.size(); i++)
+        {
+            if (m_systems[i].system == system)
+            {
+                m_systems.erase(m_systems.begin() + i);
+                m_timings.erase(m_timings.begin() + i);
+                m_graphDirty = true;
+                return;
+            }
+        }
+    }
+
+    void SystemManager::SetGroupOrder(const Vector<SystemGroup>& order)
+    {
+        m_groupOrder = order;
+        m_graphDirty = true;
+    }
+
+    void SystemManager::Initialize()
+    {
+        for (SystemNode& node : m_systems)
+        {
+            node.system->Initialize();
+        }
+    }
+
+    void SystemManager::Shutdown()
+    {
+        for (auto it = m_systems.rbegin(); it != m_systems.rend(); ++it)
+        {
+            it->system->Shutdown();
+        }
+    }
+
+    // A system in several groups is ordered by the earliest of them
+    uint32_t SystemManager::GetGroupOrder(const SystemBase& system) const
+    {
+        for (uint32_t i = 0; i < m_groupOrder.size(); i++)
+        {
+            if (system.IsInGroup(m_groupOrder[i]))
+                return i;
+        }
+        return (uint32_t)m_groupOrder.size();
+    }
+
+    void SystemManager::BuildGraph()
+    {
+        const uint32_t count = (uint32_t)m_systems.size();
+        m_executionOrder.resize(count);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            m_systems[i].order = GetGroupOrder(*m_systems[i].system);
+            m_systems[i].successors.clear();
+            m_systems[i].dependencyCount = 0;
+            m_executionOrder[i] = i;
+        }
+
+        std::stable_sort(m_executionOrder.begin(), m_executionOrder.end(), [&](uint32_t a, uint32_t b)
+            {
+                return m_systems[a].order < m_systems[b].order;
+            });
+
+        // Every conflicting pair is ordered as in the execution order, the rest is left free
+        for (uint32_t i = 0; i < count; i++)
+        {
+            SystemNode& first = m_systems[m_executionOrder[i]];
+            for (uint32_t j = i + 1; j < count; j++)
+            {
+                SystemNode& second = m_systems[m_executionOrder[j]];
+                if (first.system->ConflictsWith(*second.system))
+                {
+                    first.successors.push_back(m_executionOrder[j]);
+                    second.dependencyCount++;
+                }
+            }
+        }
+
+        m_remainingDependencies = MakeUnique<std::atomic<uint32_t>[]>(count);
+        m_graphDirty = false;
+    }
+
+    void SystemManager::RunSystem(uint32_t node)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        m_systems[node].system->Update(m_frameDelta, *m_frameStore);
+        auto end = std::chrono::high_resolution_clock::now();
+        m_timings[node].updateTime = std::chrono::duration<double, std::milli>(end - start).count();
+    }
+
+    void SystemManager::RunSystemJob(Job& job)
+    {
+        const SystemJobData data = job.GetDataCopy<SystemJobData>();
+        SystemManager* manager = data.manager;
+        manager->RunSystem(data.node);
+
+        // Successors are submitted to the worker that finished their last dependency
+        Worker* worker = ThreadManager::Get()->GetCurrentWorker();
+        for (uint32_t successor : manager->m_systems[data.node].successors)
+        {
+            if (--manager->m_remainingDependencies[successor] == 0)
+                worker->Submit(manager->m_frameJobs[successor]);
+        }
+    }
+
+    void SystemManager::Update(Timespan dt, ComponentStore& store)
+    {
+        SL_EVENT();
+        if (m_graphDirty)
+            BuildGraph();
+
+        m_frameDelta = dt;
+        m_frameStore = &store;
+
+        ThreadManager* threadManager = ThreadManager::Get();
+        Worker* worker = threadManager != nullptr ? threadManager->GetCurrentWorker() : nullptr;
+        if (worker == nullptr || m_systems.size() <= 1)
+        {
+            for (uint32_t node : m_executionOrder)
+                RunSystem(node);
+            return;
+        }
+
+        // Every job is allocated up front from the calling worker, so that the jobs systems create
+        // themselves on other workers can be rewound independently
+        JobPool& pool = worker->Pool();
+        const size_t marker = pool.GetMarker();
+        Job* root = pool.CreateJob([](Job&) {});
+        SL_ASSERT(root != nullptr && "Job pool exhausted.");
+
+        m_frameJobs.resize(m_systems.size());
+        for (uint32_t i = 0; i < m_systems.size(); i++)
+        {
+            m_frameJobs[i] = pool.CreateJobAsChild(&RunSystemJob, SystemJobData{ this, i }, root);
+            SL_ASSERT(m_frameJobs[i] != nullptr && "Job pool exhausted.");
+            m_remainingDependencies[i] = m_systems[i].dependencyCount;
+        }
+
+        for (uint32_t i = 0; i < m_systems.size(); i++)
+        {
+            if (m_systems[i].dependencyCount == 0)
+                worker->Submit(m_frameJobs[i]);
+        }
+
+        worker->Submit(root);
+        worker->Wait(root);
+
+        pool.Rewind(marker);
+    }
+
+    bool SystemManager::RunsBefore(const SystemBase* a, const SystemBase* b)
+    {
+        if (m_graphDirty)
+            BuildGraph();
+
+        uint32_t start = (uint32_t)m_systems.size();
+        for (uint32_t i = 0; i < m_systems.size(); i++)
+        {
+            if (m_systems[i].system == a)
+                start = i;
+        }
+        if (start == m_systems.size())
+            return false;
+
+        Vector<uint32_t> stack = { start };
+        Vector<uint8_t> visited(m_systems.size(), 0);
+        while (!stack.empty())
+        {
+            const uint32_t node = stack.back();
+            stack.pop_back();
+            for (uint32_t successor : m_systems[node].successors)
+            {
+                if (m_systems[successor].system == b)
+                    return true;
+                if (!visited[successor])
+                {
+                    visited[successor] = 1;
+                    stack.push_back(successor);
+                }
+            }
+        }
+        return false;
+    }
+
+}
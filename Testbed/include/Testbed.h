@@ -14,6 +14,7 @@
 #include "Rendering/Animation/AnimationChannel.h"
 
 #include "Scene/TransformSystem.h"
+#include "Scene/SystemManager.h"
 #include "Scene/Components.h"
 #include "Scene/ComponentStore.h"
 #include "Resources/AssetPack.h"
@@ -86,6 +87,7 @@ namespace Testbed
         Slayer::RenderingSystem m_renderingSystem;
         Slayer::AnimationSystem m_animationSystem;
         Slayer::TransformSystem m_transformSystem;
+        Slayer::SystemManager m_systemManager;
 
         template<typename T>
         bool LoadScene(std::future<T>& future)
@@ -97,6 +99,7 @@ namespace Testbed
         void InitializeScene();
         void InitializeRendering();
         void InitializeWindow();
+        void InitializeSystems();
         void ShutdownRendering();
 
         std::future<void> SaveScene(const std::string& filename, Slayer::ComponentStore& store)
@@ -129,6 +132,7 @@ namespace Testbed
             InitializeWindow();
             InitializeResources();
             InitializeScene();
+            InitializeSystems();
 
             PushLayer<class TestbedLayer>();
             PushLayer<Slayer::EditorLayer>();
@@ -163,10 +167,8 @@ namespace Testbed
                 // Update game
             {
                 m_camera->Update(ts);
-                m_animationSystem.Update(ts, m_store);
+                m_systemManager.Update(ts, m_store);
                 m_animationSystem.Render(m_renderer, m_store);
-                m_transformSystem.Update(ts, m_store);
-                m_renderingSystem.Update(ts, m_store);
                 break;
             }
             case AS_Quitting:
@@ -196,6 +198,7 @@ namespace Testbed
 
         virtual void OnShutdown() override
         {
+            m_systemManager.Shutdown();
             Slayer::ResourceManager::Shutdown();
             m_window.Shutdown();
         }
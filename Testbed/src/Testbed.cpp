@@ -26,9 +26,11 @@ namespace Testbed
         Slayer::ForEachComponentType([this]<typename T>() {
             m_store.RegisterComponent<T>();
         });
+        Slayer::RenderingSystem::SetSortKeys(m_store);
 
         Slayer::YamlDeserializer deserializer;
         deserializer.Deserialize(m_store, assetPath + "scene.yml");
+        m_store.ResolveParents();
 
         const int32_t numEntities = SL_MAX_INSTANCES;
         const int32_t side = (int32_t)std::sqrt(numEntities);
@@ -47,6 +49,14 @@ namespace Testbed
 
     }
 
+    void TestbedApplication::InitializeSystems()
+    {
+        m_systemManager.AddSystem(&m_animationSystem, "Animation");
+        m_systemManager.AddSystem(&m_transformSystem, "Transform");
+        m_systemManager.AddSystem(&m_renderingSystem, "Rendering");
+        m_systemManager.Initialize();
+    }
+
     void TestbedApplication::InitializeRendering()
     {
         m_camera = Slayer::MakeShared<SandboxCamera>(100.0f);
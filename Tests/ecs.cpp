@@ -2,6 +2,16 @@
 #include <boost/test/included/unit_test.hpp>
 #include <string> 
 #include "Scene/ComponentStore.h"
+#include "Scene/Query.h"
+#include "Scene/TransformHierarchy.h"
+#include "Core/TransformKernel.h"
+#include "Scene/SystemManager.h"
+#include "Scene/EntityIdIndex.h"
+
+#include <chrono>
+#include <random>
+#include <set>
+#include <thread>
 
 struct Position
 {
@@ -20,6 +30,12 @@ struct Renderable
     std::string texturePath;
 };
 
+template <int N>
+struct Tag
+{
+    int value = N;
+};
+
 BOOST_AUTO_TEST_CASE(AddComponent_Test)
 {
     Slayer::ComponentStore ecs;
@@ -101,7 +117,8 @@ BOOST_AUTO_TEST_CASE(BigNumberEntities_Test)
     ecs.RegisterComponent<Velocity>();
     ecs.RegisterComponent<Renderable>();
 
-    const int numEntities = SL_MAX_ENTITIES;
+    // More than the old fixed limit of 10000 entities
+    const int numEntities = 20000;
 
     std::vector<Slayer::Entity> entities;
 
@@ -121,4 +138,1177 @@ BOOST_AUTO_TEST_CASE(BigNumberEntities_Test)
     std::vector<Slayer::Entity> entitiesWithComponents = ecs.GetEntities<Position, Velocity, Renderable>();
 
     BOOST_TEST(entitiesWithComponents.size() == numEntities);
-}
\ No newline at end of file
+}
+BOOST_AUTO_TEST_CASE(RemoveComponent_Test)
+{
+    Slayer::ComponentStore ecs;
+
+    ecs.RegisterComponent<Position>();
+    ecs.RegisterComponent<Velocity>();
+    ecs.RegisterComponent<Renderable>();
+
+    Slayer::Entity entity = ecs.CreateEntity();
+
+    ecs.AddComponent(entity, Position{ 1.0f, 2.0f });
+    ecs.AddComponent(entity, Velocity{ 3.0f, 4.0f });
+    ecs.AddComponent(entity, Renderable{ "texture.png" });
+
+    ecs.RemoveComponent<Velocity>(entity);
+
+    BOOST_TEST(!ecs.HasComponent<Velocity>(entity));
+    BOOST_TEST(ecs.GetComponent<Position>(entity)->y == 2.0f);
+    BOOST_TEST(ecs.GetComponent<Renderable>(entity)->texturePath == "texture.png");
+    std::vector<Slayer::Entity> moving = ecs.GetEntities<Position, Velocity>();
+    BOOST_TEST(moving.size() == 0);
+}
+
+BOOST_AUTO_TEST_CASE(ChunkedIteration_Test)
+{
+    Slayer::ComponentStore ecs;
+
+    ecs.RegisterComponent<Position>();
+    ecs.RegisterComponent<Velocity>();
+    ecs.RegisterComponent<Renderable>();
+
+    // Enough entities to span several chunks, every third one in a different archetype
+    const int numEntities = 5000;
+    std::vector<Slayer::Entity> entities;
+    for (int i = 0; i < numEntities; ++i)
+    {
+        Slayer::Entity entity = ecs.CreateEntity();
+        ecs.AddComponent(entity, Position{ (float)i, 0.0f });
+        ecs.AddComponent(entity, Velocity{ 1.0f, 0.0f });
+        if (i % 3 == 0)
+            ecs.AddComponent(entity, Renderable{ std::to_string(i) });
+        entities.push_back(entity);
+    }
+
+    // Destroying from the middle moves the last rows into the holes
+    for (int i = 0; i < numEntities; i += 2)
+    {
+        ecs.DestroyEntity(entities[i]);
+    }
+
+    int visited = 0;
+    ecs.ForEach<Position, Velocity>([&](Slayer::Entity entity, Position* position, Velocity* velocity)
+        {
+            position->x += velocity->x;
+            visited++;
+        });
+
+    BOOST_TEST(visited == numEntities / 2);
+    BOOST_TEST(ecs.GetEntityCount() == numEntities / 2);
+
+    for (int i = 1; i < numEntities; i += 2)
+    {
+        BOOST_TEST(ecs.IsValid(entities[i]));
+        BOOST_TEST(ecs.GetComponent<Position>(entities[i])->x == (float)i + 1.0f);
+        if (i % 3 == 0)
+            BOOST_TEST(ecs.GetComponent<Renderable>(entities[i])->texturePath == std::to_string(i));
+        else
+            BOOST_TEST(!ecs.HasComponent<Renderable>(entities[i]));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(ParallelForEach_Test)
+{
+    Slayer::ThreadManager threadManager;
+    threadManager.Initialize();
+
+    Slayer::ComponentStore ecs;
+
+    ecs.RegisterComponent<Position>();
+    ecs.RegisterComponent<Velocity>();
+
+    const int numEntities = 8000;
+    for (int i = 0; i < numEntities; ++i)
+    {
+        Slayer::Entity entity = ecs.CreateEntity();
+        ecs.AddComponent(entity, Position{ (float)i, 0.0f });
+        ecs.AddComponent(entity, Velocity{ 1.0f, 2.0f });
+    }
+
+    ecs.ParallelForEach<Position, Velocity>([](Slayer::Entity entity, Position* position, Velocity* velocity)
+        {
+            position->x += velocity->x;
+            position->y += velocity->y;
+        });
+
+    int visited = 0;
+    ecs.ForEach<Position>([&](Slayer::Entity entity, Position* position)
+        {
+            if (position->y == 2.0f)
+                visited++;
+        });
+    BOOST_TEST(visited == numEntities);
+
+    // Deterministic partitioning produces the same batches on every run
+    auto sumBatches = [&]()
+        {
+            std::vector<double> sums(numEntities / 64 + 64, 0.0);
+            ecs.ParallelForEach<Position>([&](uint32_t batch, Slayer::Entity entity, Position* position)
+                {
+                    sums[batch] += position->x * 0.1;
+                }, 64, Slayer::Partitioning::Deterministic);
+            double total = 0.0;
+            for (double sum : sums)
+                total += sum;
+            return total;
+        };
+
+    const double first = sumBatches();
+    BOOST_TEST(first == sumBatches());
+
+    threadManager.Shutdown();
+}
+
+BOOST_AUTO_TEST_CASE(Query_Test)
+{
+    Slayer::ComponentStore ecs;
+
+    ecs.RegisterComponent<Position>();
+    ecs.RegisterComponent<Velocity>();
+    ecs.RegisterComponent<Renderable>();
+
+    Slayer::Query<Position, Velocity> moving;
+    Slayer::Query<Position, Slayer::Without<Renderable>> hidden;
+
+    Slayer::Entity a = ecs.CreateEntity();
+    ecs.AddComponent(a, Position{ 1.0f, 0.0f });
+    ecs.AddComponent(a, Velocity{ 1.0f, 0.0f });
+
+    BOOST_TEST(moving.Count(ecs) == 1);
+    BOOST_TEST(hidden.Count(ecs) == 1);
+
+    // Archetypes created after the first use are picked up by the cached queries
+    Slayer::Entity b = ecs.CreateEntity();
+    ecs.AddComponent(b, Position{ 2.0f, 0.0f });
+    ecs.AddComponent(b, Velocity{ 1.0f, 0.0f });
+    ecs.AddComponent(b, Renderable{ "texture.png" });
+
+    Slayer::Entity c = ecs.CreateEntity();
+    ecs.AddComponent(c, Position{ 3.0f, 0.0f });
+
+    BOOST_TEST(moving.Count(ecs) == 2);
+    BOOST_TEST(hidden.Count(ecs) == 2);
+
+    moving.ForEach(ecs, [&](Slayer::Entity entity, Position* position, Velocity* velocity)
+        {
+            position->x += velocity->x;
+        });
+
+    BOOST_TEST(ecs.GetComponent<Position>(a)->x == 2.0f);
+    BOOST_TEST(ecs.GetComponent<Position>(b)->x == 3.0f);
+    BOOST_TEST(ecs.GetComponent<Position>(c)->x == 3.0f);
+
+    std::vector<Slayer::Entity> hiddenEntities = hidden.GetEntities(ecs);
+    BOOST_TEST(hiddenEntities.size() == 2);
+    BOOST_TEST((std::find(hiddenEntities.begin(), hiddenEntities.end(), b) == hiddenEntities.end()));
+
+    // A query used with another store rebuilds its cache
+    Slayer::ComponentStore other;
+    other.RegisterComponent<Velocity>();
+    other.RegisterComponent<Position>();
+    Slayer::Entity d = other.CreateEntity();
+    other.AddComponent(d, Position{ 0.0f, 0.0f });
+    other.AddComponent(d, Velocity{ 0.0f, 0.0f });
+
+    BOOST_TEST(moving.Count(other) == 1);
+    BOOST_TEST(moving.Count(ecs) == 2);
+}
+
+BOOST_AUTO_TEST_CASE(EntityRecycling_Test)
+{
+    Slayer::ComponentStore ecs;
+
+    ecs.RegisterComponent<Position>();
+
+    Slayer::Entity first = ecs.CreateEntity();
+    ecs.AddComponent(first, Position{ 1.0f, 0.0f });
+    const Slayer::AssetID firstId = ecs.GetComponent<Slayer::EntityID>(first)->id;
+    ecs.DestroyEntity(first);
+
+    // The slot is reused, but the old handle stays invalid
+    Slayer::Entity second = ecs.CreateEntity();
+    BOOST_TEST(Slayer::GetEntityIndex(second) == Slayer::GetEntityIndex(first));
+    BOOST_TEST(second != first);
+    BOOST_TEST(!ecs.IsValid(first));
+    BOOST_TEST(ecs.IsValid(second));
+    BOOST_TEST(!ecs.HasComponent<Position>(second));
+    BOOST_TEST(ecs.GetEntity(firstId) == SL_INVALID_ENTITY);
+
+    // Destroying a stale handle does not touch the entity that reuses the slot
+    ecs.DestroyEntity(first);
+    BOOST_TEST(ecs.IsValid(second));
+
+    // Churn does not grow the store
+    for (int i = 0; i < 1000; ++i)
+    {
+        Slayer::Entity entity = ecs.CreateEntity();
+        ecs.AddComponent(entity, Position{ (float)i, 0.0f });
+        ecs.DestroyEntity(entity);
+    }
+
+    BOOST_TEST(ecs.GetEntityCount() == 1);
+    BOOST_TEST(Slayer::GetEntityIndex(ecs.CreateEntity()) <= 1);
+}
+
+template <int... Ns>
+void AddTags(Slayer::ComponentStore& ecs, Slayer::Entity entity, std::integer_sequence<int, Ns...>)
+{
+    (ecs.AddComponent(entity, Tag<Ns>{}), ...);
+}
+
+BOOST_AUTO_TEST_CASE(WideSignature_Test)
+{
+    Slayer::ComponentStore ecs;
+
+    // Far more component types than fit in a 64-bit signature
+    Slayer::Entity tagged = ecs.CreateEntity();
+    AddTags(ecs, tagged, std::make_integer_sequence<int, 150>{});
+
+    Slayer::Entity other = ecs.CreateEntity();
+    ecs.AddComponent(other, Tag<149>{});
+    ecs.AddComponent(other, Position{ 1.0f, 2.0f });
+
+    BOOST_TEST(ecs.GetComponentCount(tagged) == 151);
+    BOOST_TEST(ecs.GetComponent<Tag<149>>(tagged)->value == 149);
+    BOOST_TEST(ecs.GetComponent<Tag<70>>(tagged)->value == 70);
+    BOOST_TEST(!ecs.HasComponent<Position>(tagged));
+
+    std::vector<Slayer::Entity> highTag = ecs.GetEntities<Tag<149>>();
+    BOOST_TEST(highTag.size() == 2);
+    std::vector<Slayer::Entity> both = ecs.GetEntities<Tag<3>, Tag<149>>();
+    BOOST_TEST(both.size() == 1);
+
+    Slayer::Query<Tag<149>, Slayer::Without<Tag<100>>> query;
+    BOOST_TEST(query.Count(ecs) == 1);
+    BOOST_TEST(query.GetEntities(ecs)[0] == other);
+
+    ecs.RemoveComponent<Tag<100>>(tagged);
+    BOOST_TEST(query.Count(ecs) == 2);
+    BOOST_TEST(ecs.GetComponent<Tag<120>>(tagged)->value == 120);
+}
+
+BOOST_AUTO_TEST_CASE(ArchetypeSignature_Test)
+{
+    Slayer::Archetype a;
+    a.Set(1);
+    a.Set(64);
+    a.Set(200);
+
+    Slayer::Archetype b = Slayer::Archetype::FromBit(200);
+    BOOST_TEST(a.Contains(b));
+    BOOST_TEST(!b.Contains(a));
+    BOOST_TEST(a.Intersects(b));
+    BOOST_TEST(!a.Intersects(Slayer::Archetype::FromBit(255)));
+    BOOST_TEST(Slayer::Archetype().IsEmpty());
+    BOOST_TEST(a.Count() == 3);
+
+    std::vector<uint32_t> bits;
+    a.ForEachBit([&](uint32_t bit) { bits.push_back(bit); });
+    BOOST_TEST((bits == std::vector<uint32_t>{ 1, 64, 200 }));
+
+    a.Reset(64);
+    BOOST_TEST((a == (Slayer::Archetype::FromBit(1) | b)));
+}
+
+BOOST_AUTO_TEST_CASE(CommandBuffer_Test)
+{
+    Slayer::ComponentStore ecs;
+
+    ecs.RegisterComponent<Position>();
+    ecs.RegisterComponent<Velocity>();
+
+    Slayer::Entity existing = ecs.CreateEntity();
+    ecs.AddComponent(existing, Position{ 1.0f, 1.0f });
+    Slayer::Entity doomed = ecs.CreateEntity();
+    ecs.AddComponent(doomed, Position{ 2.0f, 2.0f });
+
+    Slayer::EntityCommandBuffer& buffer = ecs.GetCommandBuffer();
+
+    Slayer::Entity spawned = buffer.CreateEntity();
+    BOOST_TEST(Slayer::EntityCommandBuffer::IsDeferred(spawned));
+    buffer.AddComponent(spawned, Position{ 5.0f, 0.0f });
+    buffer.AddComponent(spawned, Velocity{ 1.0f, 0.0f });
+    buffer.AddComponent(spawned, Renderable{ "spawned.png" });
+    buffer.RemoveComponent<Velocity>(spawned);
+
+    // Replaces the existing position and adds a velocity
+    buffer.AddComponent(existing, Position{ 10.0f, 10.0f });
+    buffer.AddComponent(existing, Velocity{ 3.0f, 3.0f });
+    buffer.DestroyEntity(doomed);
+
+    // Nothing changes before playback
+    BOOST_TEST(ecs.GetEntityCount() == 2);
+    BOOST_TEST(!ecs.HasComponent<Velocity>(existing));
+
+    ecs.PlaybackCommands();
+    BOOST_TEST(buffer.IsEmpty());
+
+    BOOST_TEST(ecs.GetEntityCount() == 2);
+    BOOST_TEST(!ecs.IsValid(doomed));
+    BOOST_TEST(ecs.GetComponent<Position>(existing)->x == 10.0f);
+    BOOST_TEST(ecs.GetComponent<Velocity>(existing)->x == 3.0f);
+
+    std::vector<Slayer::Entity> renderables = ecs.GetEntities<Renderable>();
+    BOOST_TEST(renderables.size() == 1);
+    Slayer::Entity entity = renderables[0];
+    BOOST_TEST(ecs.GetComponent<Position>(entity)->x == 5.0f);
+    BOOST_TEST(ecs.GetComponent<Renderable>(entity)->texturePath == "spawned.png");
+    BOOST_TEST(!ecs.HasComponent<Velocity>(entity));
+    BOOST_TEST(ecs.GetEntity(ecs.GetComponent<Slayer::EntityID>(entity)->id) == entity);
+}
+
+BOOST_AUTO_TEST_CASE(ParallelCommandBuffer_Test)
+{
+    Slayer::ThreadManager threadManager;
+    threadManager.Initialize();
+
+    Slayer::ComponentStore ecs;
+
+    ecs.RegisterComponent<Position>();
+    ecs.RegisterComponent<Velocity>();
+
+    const int numEntities = 4000;
+    for (int i = 0; i < numEntities; ++i)
+    {
+        Slayer::Entity entity = ecs.CreateEntityWithoutID();
+        ecs.AddComponent(entity, Position{ (float)i, 0.0f });
+    }
+
+    // Every even entity despawns, every odd one gets a velocity and spawns a child
+    ecs.ParallelForEach<Position>([&](Slayer::Entity entity, Position* position)
+        {
+            Slayer::EntityCommandBuffer& buffer = ecs.GetCommandBuffer();
+            if ((int)position->x % 2 == 0)
+            {
+                buffer.DestroyEntity(entity);
+            }
+            else
+            {
+                buffer.AddComponent(entity, Velocity{ 1.0f, 0.0f });
+                Slayer::Entity child = buffer.CreateEntityWithoutID();
+                buffer.AddComponent(child, Renderable{ std::to_string((int)position->x) });
+            }
+        }, 64);
+
+    ecs.PlaybackCommands();
+
+    BOOST_TEST(ecs.GetEntityCount() == numEntities);
+    std::vector<Slayer::Entity> moving = ecs.GetEntities<Position, Velocity>();
+    BOOST_TEST(moving.size() == numEntities / 2);
+    std::vector<Slayer::Entity> renderables = ecs.GetEntities<Renderable>();
+    BOOST_TEST(renderables.size() == numEntities / 2);
+    BOOST_TEST(ecs.GetEntities<Position>().size() == numEntities / 2);
+
+    threadManager.Shutdown();
+}
+
+BOOST_AUTO_TEST_CASE(ChangeDetection_Test)
+{
+    Slayer::ComponentStore ecs;
+
+    ecs.RegisterComponent<Position>();
+    ecs.RegisterComponent<Velocity>();
+
+    const int numEntities = 2000;
+    std::vector<Slayer::Entity> entities;
+    for (int i = 0; i < numEntities; ++i)
+    {
+        Slayer::Entity entity = ecs.CreateEntityWithoutID();
+        ecs.AddComponent(entity, Position{ (float)i, 0.0f });
+        ecs.AddComponent(entity, Velocity{ 1.0f, 0.0f });
+        entities.push_back(entity);
+    }
+
+    Slayer::Query<const Velocity, Slayer::Changed<Position>> changedQuery;
+    auto countChanged = [&]()
+        {
+            int visited = 0;
+            changedQuery.ForEach(ecs, [&](Slayer::Entity entity, const Velocity* velocity) { visited++; });
+            return visited;
+        };
+
+    // Everything is new on the first run, nothing changed since on the second
+    BOOST_TEST(countChanged() == numEntities);
+    BOOST_TEST(countChanged() == 0);
+
+    // Reads through a const type do not mark the component as changed
+    BOOST_TEST(ecs.GetComponent<const Position>(entities[10])->x == 10.0f);
+    BOOST_TEST(countChanged() == 0);
+
+    ecs.GetComponent<Position>(entities[10])->x = 100.0f;
+    ecs.GetComponent<Position>(entities[1500])->x = 200.0f;
+    std::vector<Slayer::Entity> visited;
+    changedQuery.ForEach(ecs, [&](Slayer::Entity entity, const Velocity* velocity) { visited.push_back(entity); });
+    BOOST_TEST(visited.size() == 2);
+    BOOST_TEST((std::find(visited.begin(), visited.end(), entities[10]) != visited.end()));
+    BOOST_TEST((std::find(visited.begin(), visited.end(), entities[1500]) != visited.end()));
+
+    // Writing another component does not mark Position
+    ecs.GetComponent<Velocity>(entities[20])->x = 2.0f;
+    BOOST_TEST(countChanged() == 0);
+
+    // Mutable iteration marks every visited entity, const iteration does not
+    ecs.ForEach<const Position>([](Slayer::Entity entity, const Position* position) {});
+    BOOST_TEST(countChanged() == 0);
+    ecs.ForEach<Position>([](Slayer::Entity entity, Position* position) {});
+    BOOST_TEST(countChanged() == numEntities);
+
+    // A query does not see its own writes
+    Slayer::Query<Position, Slayer::Changed<Position>> selfQuery;
+    int visitedSelf = 0;
+    selfQuery.ForEach(ecs, [&](Slayer::Entity entity, Position* position) { position->y += 1.0f; visitedSelf++; });
+    BOOST_TEST(visitedSelf == numEntities);
+    visitedSelf = 0;
+    selfQuery.ForEach(ecs, [&](Slayer::Entity entity, Position* position) { visitedSelf++; });
+    BOOST_TEST(visitedSelf == 0);
+    BOOST_TEST(countChanged() == numEntities);
+
+    // Removing a component or destroying an entity does not mark the moved rows, added entities are new
+    ecs.DestroyEntity(entities[0]);
+    Slayer::Entity added = ecs.CreateEntityWithoutID();
+    ecs.AddComponent(added, Position{ 0.0f, 0.0f });
+    ecs.AddComponent(added, Velocity{ 0.0f, 0.0f });
+    visited.clear();
+    changedQuery.ForEach(ecs, [&](Slayer::Entity entity, const Velocity* velocity) { visited.push_back(entity); });
+    BOOST_TEST(visited.size() == 1);
+    BOOST_TEST(visited[0] == added);
+}
+
+BOOST_AUTO_TEST_CASE(TransformHierarchy_Test)
+{
+    Slayer::ComponentStore ecs;
+
+    ecs.RegisterComponents<ENGINE_COMPONENTS>();
+
+    auto createNode = [&](Slayer::AssetID parentId, float x)
+        {
+            Slayer::Entity entity = ecs.CreateEntity();
+            Slayer::Transform transform(Slayer::Vec3(x, 0.0f, 0.0f), Slayer::Quat(1.0f, 0.0f, 0.0f, 0.0f), Slayer::Vec3(1.0f));
+            transform.parentId = parentId;
+            ecs.AddComponent(entity, transform);
+            return entity;
+        };
+    auto idOf = [&](Slayer::Entity entity) { return ecs.GetComponent<const Slayer::EntityID>(entity)->id; };
+    auto worldX = [&](Slayer::Entity entity) { return ecs.GetComponent<const Slayer::Transform>(entity)->worldTransform[3].x; };
+
+    // Children are created before their parents to check that the order does not matter
+    Slayer::Entity root = createNode(0, 1.0f);
+    Slayer::Entity grandchild = ecs.CreateEntity();
+    Slayer::Entity child = createNode(idOf(root), 10.0f);
+    Slayer::Transform grandchildTransform(Slayer::Vec3(100.0f, 0.0f, 0.0f), Slayer::Quat(1.0f, 0.0f, 0.0f, 0.0f), Slayer::Vec3(1.0f));
+    grandchildTransform.parentId = idOf(child);
+    ecs.AddComponent(grandchild, grandchildTransform);
+    Slayer::Entity sibling = createNode(idOf(root), 20.0f);
+
+    Slayer::TransformHierarchy hierarchy;
+    hierarchy.Update(ecs);
+
+    BOOST_TEST(hierarchy.GetNodeCount() == 4);
+    BOOST_TEST(hierarchy.GetLevelCount() == 3);
+    BOOST_TEST(hierarchy.GetParent(grandchild) == child);
+    BOOST_TEST(hierarchy.GetParent(root) == SL_INVALID_ENTITY);
+    std::vector<Slayer::Entity> children;
+    hierarchy.ForEachChild(root, [&](Slayer::Entity entity) { children.push_back(entity); });
+    BOOST_TEST(children.size() == 2);
+    BOOST_TEST(worldX(root) == 1.0f);
+    BOOST_TEST(worldX(child) == 11.0f);
+    BOOST_TEST(worldX(grandchild) == 111.0f);
+    BOOST_TEST(worldX(sibling) == 21.0f);
+
+    // Parents always come before their children
+    const auto& nodes = hierarchy.GetNodes();
+    for (uint32_t i = 0; i < nodes.size(); i++)
+    {
+        BOOST_TEST((nodes[i].parentNode == Slayer::TransformHierarchy::InvalidNode || nodes[i].parentNode < i));
+    }
+
+    // Moving the root moves every descendant
+    ecs.GetComponent<Slayer::Transform>(root)->position.x = 2.0f;
+    hierarchy.Update(ecs);
+    BOOST_TEST(worldX(grandchild) == 112.0f);
+    BOOST_TEST(worldX(sibling) == 22.0f);
+
+    // Reparenting the grandchild to the sibling
+    ecs.GetComponent<Slayer::Transform>(grandchild)->parentId = idOf(sibling);
+    hierarchy.Update(ecs);
+    BOOST_TEST(hierarchy.GetParent(grandchild) == sibling);
+    BOOST_TEST(worldX(grandchild) == 122.0f);
+
+    // Children of a destroyed entity become roots
+    ecs.DestroyEntity(sibling);
+    hierarchy.Update(ecs);
+    BOOST_TEST(hierarchy.GetNodeCount() == 3);
+    BOOST_TEST(hierarchy.GetParent(grandchild) == SL_INVALID_ENTITY);
+    BOOST_TEST(worldX(grandchild) == 100.0f);
+    BOOST_TEST(worldX(child) == 12.0f);
+}
+
+BOOST_AUTO_TEST_CASE(ComposeTRS_Test)
+{
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> scale(0.1f, 10.0f);
+
+    // An odd count so that every path also runs its scalar tail
+    const size_t count = 1001;
+    std::vector<Slayer::Transform> transforms;
+    Slayer::TRSBuffer buffer;
+    for (size_t i = 0; i < count; i++)
+    {
+        Slayer::Quat rotation = glm::normalize(Slayer::Quat(unit(rng), unit(rng), unit(rng), unit(rng)));
+        Slayer::Transform transform(Slayer::Vec3(position(rng), position(rng), position(rng)), rotation, Slayer::Vec3(scale(rng), scale(rng), scale(rng)));
+        if (i == 0)
+            transform = Slayer::Transform(Slayer::Vec3(0.0f), Slayer::Quat(1.0f, 0.0f, 0.0f, 0.0f), Slayer::Vec3(1.0f));
+        transforms.push_back(transform);
+        buffer.Push(transform.position, transform.rotation, transform.scale);
+    }
+
+    for (Slayer::SimdLevel level : { Slayer::SimdLevel::Scalar, Slayer::SimdLevel::SSE2, Slayer::SimdLevel::AVX2 })
+    {
+        std::vector<Slayer::Mat4> matrices(count);
+        Slayer::ComposeTRS(buffer.GetArrays(), matrices.data(), level);
+
+        // Within 4 ulp of the largest element of the column, the paths only differ from glm if the compiler contracts operations
+        float maxError = 0.0f;
+        for (size_t i = 0; i < count; i++)
+        {
+            const Slayer::Mat4 expected = transforms[i].GetMatrix();
+            for (int column = 0; column < 4; column++)
+            {
+                const float magnitude = std::max({ 1.0f, std::abs(expected[column].x), std::abs(expected[column].y), std::abs(expected[column].z) });
+                for (int row = 0; row < 4; row++)
+                {
+                    maxError = std::max(maxError, std::abs(matrices[i][column][row] - expected[column][row]) / (magnitude * std::numeric_limits<float>::epsilon()));
+                }
+            }
+        }
+        BOOST_TEST(maxError <= 4.0f);
+    }
+}
+
+template <Slayer::SystemGroup Group>
+class TestSystem : public Slayer::System<Group>
+{
+public:
+    std::function<void(Slayer::ComponentStore&)> update;
+
+    template <typename... Ts>
+    TestSystem& SetReads() { this->template Reads<Ts...>(); return *this; }
+    template <typename... Ts>
+    TestSystem& SetWrites() { this->template Writes<Ts...>(); return *this; }
+
+    virtual void Initialize() {}
+    virtual void Shutdown() {}
+    virtual void Update(Slayer::Timespan dt, Slayer::ComponentStore& store) { update(store); }
+};
+
+BOOST_AUTO_TEST_CASE(SystemScheduler_Test)
+{
+    Slayer::ThreadManager threadManager;
+    threadManager.Initialize();
+
+    Slayer::ComponentStore ecs;
+
+    ecs.RegisterComponent<Position>();
+    ecs.RegisterComponent<Velocity>();
+    ecs.RegisterComponent<Tag<1>>();
+    ecs.RegisterComponent<Tag<2>>();
+
+    const int numEntities = 1000;
+    for (int i = 0; i < numEntities; ++i)
+    {
+        Slayer::Entity entity = ecs.CreateEntityWithoutID();
+        ecs.AddComponent(entity, Position{ 0.0f, 0.0f });
+        ecs.AddComponent(entity, Velocity{ 1.0f, 0.0f });
+        ecs.AddComponent(entity, Tag<1>{ 0 });
+        ecs.AddComponent(entity, Tag<2>{ 0 });
+    }
+
+    Slayer::Query<Position, const Velocity> moveQuery;
+    Slayer::Query<const Position, Tag<1>> copyQuery;
+    Slayer::Query<Tag<2>> countQuery;
+
+    // Added first, but the transform group runs after physics because it reads what the mover writes
+    TestSystem<Slayer::SL_GROUP_TRANSFORM> copier;
+    copier.SetReads<Position>().SetWrites<Tag<1>>();
+    copier.update = [&](Slayer::ComponentStore& store)
+        {
+            copyQuery.ForEach(store, [](Slayer::Entity entity, const Position* position, Tag<1>* tag) { tag->value = (int)position->x; });
+        };
+
+    TestSystem<Slayer::SL_GROUP_PHYSICS> mover;
+    mover.SetReads<Velocity>().SetWrites<Position>();
+    mover.update = [&](Slayer::ComponentStore& store)
+        {
+            moveQuery.ParallelForEach(store, [](Slayer::Entity entity, Position* position, const Velocity* velocity) { position->x += velocity->x; }, 64);
+        };
+
+    TestSystem<Slayer::SL_GROUP_PHYSICS> counter;
+    counter.SetWrites<Tag<2>>();
+    counter.update = [&](Slayer::ComponentStore& store)
+        {
+            countQuery.ForEach(store, [](Slayer::Entity entity, Tag<2>* tag) { tag->value++; });
+        };
+
+    // Declares nothing, so it runs after everything that was ordered before it
+    std::atomic<int> frames = 0;
+    TestSystem<Slayer::SL_GROUP_NONE> exclusive;
+    exclusive.update = [&](Slayer::ComponentStore& store) { frames++; };
+
+    Slayer::SystemManager systems;
+    systems.AddSystem(&copier, "Copier");
+    systems.AddSystem(&mover, "Mover");
+    systems.AddSystem(&counter, "Counter");
+    systems.AddSystem(&exclusive, "Exclusive");
+    systems.Initialize();
+
+    BOOST_TEST(systems.RunsBefore(&mover, &copier));
+    BOOST_TEST(!systems.RunsBefore(&copier, &mover));
+    BOOST_TEST(!systems.RunsBefore(&mover, &counter));
+    BOOST_TEST(!systems.RunsBefore(&counter, &mover));
+    BOOST_TEST(systems.RunsBefore(&counter, &exclusive));
+    BOOST_TEST(systems.RunsBefore(&copier, &exclusive));
+
+    const int numFrames = 50;
+    for (int frame = 0; frame < numFrames; frame++)
+    {
+        systems.Update(0.016f, ecs);
+    }
+
+    BOOST_TEST(frames == numFrames);
+    int copied = 0;
+    ecs.ForEach<const Position, const Tag<1>, const Tag<2>>([&](Slayer::Entity entity, const Position* position, const Tag<1>* copy, const Tag<2>* count)
+        {
+            copied += position->x == (float)numFrames && copy->value == numFrames && count->value == numFrames;
+        });
+    BOOST_TEST(copied == numEntities);
+
+    BOOST_TEST(systems.GetTimings().size() == 4);
+    BOOST_TEST(systems.GetTimings()[1].name == "Mover");
+
+    systems.Shutdown();
+    threadManager.Shutdown();
+}
+
+BOOST_AUTO_TEST_CASE(ConcurrentReaders_Test)
+{
+    // More workers than cores on small machines, so that the readers run on threads of their own
+    Slayer::JobSettings settings;
+    settings.workerCount = 4;
+    Slayer::ThreadManager threadManager;
+    threadManager.Initialize(settings);
+
+    Slayer::ComponentStore ecs;
+    ecs.RegisterComponent<Position>();
+    ecs.RegisterComponent<Velocity>();
+    ecs.RegisterComponent<Tag<1>>();
+
+    for (int i = 0; i < 100; ++i)
+    {
+        Slayer::Entity entity = ecs.CreateEntityWithoutID();
+        ecs.AddComponent(entity, Position{ 1.0f, 0.0f });
+    }
+
+    // Both readers wait for each other before they look up the matching archetypes, so that the lookups overlap
+    std::atomic<int> started = 0;
+    const auto waitForOther = [&]()
+        {
+            const int target = (started.fetch_add(1) / 2 + 1) * 2;
+            const auto timeout = std::chrono::steady_clock::now() + std::chrono::milliseconds(50);
+            while (started.load() < target && std::chrono::steady_clock::now() < timeout)
+            {
+                std::this_thread::yield();
+            }
+        };
+
+    std::atomic<int> firstCount = 0;
+    TestSystem<Slayer::SL_GROUP_PHYSICS> firstReader;
+    firstReader.SetReads<Position>();
+    firstReader.update = [&](Slayer::ComponentStore& store)
+        {
+            waitForOther();
+            int count = 0;
+            store.ForEach<const Position>([&](Slayer::Entity entity, const Position* position) { count += position->x == 1.0f; });
+            firstCount = count;
+        };
+
+    std::atomic<int> secondCount = 0;
+    TestSystem<Slayer::SL_GROUP_PHYSICS> secondReader;
+    secondReader.SetReads<Position>();
+    secondReader.update = [&](Slayer::ComponentStore& store)
+        {
+            waitForOther();
+            int count = 0;
+            store.ForEach<const Position>([&](Slayer::Entity entity, const Position* position) { count += position->x == 1.0f; });
+            secondCount = count;
+        };
+
+    Slayer::SystemManager systems;
+    systems.AddSystem(&firstReader, "FirstReader");
+    systems.AddSystem(&secondReader, "SecondReader");
+    systems.Initialize();
+
+    BOOST_TEST(!systems.RunsBefore(&firstReader, &secondReader));
+    BOOST_TEST(!systems.RunsBefore(&secondReader, &firstReader));
+
+    // Between the first frames the store gains archetypes that the cached lookups have not seen yet
+    int expected = 100;
+    for (int frame = 0; frame < 20; frame++)
+    {
+        systems.Update(0.016f, ecs);
+        BOOST_TEST(firstCount == expected);
+        BOOST_TEST(secondCount == expected);
+
+        Slayer::Entity entity = ecs.CreateEntityWithoutID();
+        ecs.AddComponent(entity, Position{ 1.0f, 0.0f });
+        if (frame % 3 != 1)
+            ecs.AddComponent(entity, Velocity{ 0.0f, 0.0f });
+        if (frame % 3 != 0)
+            ecs.AddComponent(entity, Tag<1>{ frame });
+        expected++;
+    }
+
+    systems.Shutdown();
+    threadManager.Shutdown();
+}
+
+struct GameSettings
+{
+    std::string name;
+    int difficulty = 0;
+
+    GameSettings(const std::string& name, int difficulty) : name(name), difficulty(difficulty) {}
+};
+
+struct PartialSum
+{
+    double sum = 0.0;
+    int count = 0;
+};
+
+BOOST_AUTO_TEST_CASE(Singleton_Test)
+{
+    Slayer::ThreadManager threadManager;
+    threadManager.Initialize();
+
+    Slayer::ComponentStore ecs;
+
+    ecs.RegisterComponent<Position>();
+
+    BOOST_TEST(!ecs.HasSingleton<GameSettings>());
+    GameSettings* settings = ecs.AddSingleton<GameSettings>("hard", 3);
+    BOOST_TEST(ecs.HasSingleton<GameSettings>());
+    BOOST_TEST(ecs.GetSingleton<GameSettings>() == settings);
+    BOOST_TEST(settings->name == "hard");
+    BOOST_TEST(settings->difficulty == 3);
+
+    // Adding other singletons does not move existing ones
+    ecs.AddSingleton<Position>(Position{ 1.0f, 2.0f });
+    BOOST_TEST(ecs.GetSingleton<GameSettings>() == settings);
+    BOOST_TEST(ecs.GetSingleton<Position>()->y == 2.0f);
+
+    ecs.RemoveSingleton<GameSettings>();
+    BOOST_TEST(!ecs.HasSingleton<GameSettings>());
+    BOOST_TEST(ecs.HasSingleton<Position>());
+
+    // Every worker accumulates into its own instance, the instances are merged afterwards
+    const int numEntities = 10000;
+    for (int i = 0; i < numEntities; ++i)
+    {
+        Slayer::Entity entity = ecs.CreateEntityWithoutID();
+        ecs.AddComponent(entity, Position{ (float)i, 0.0f });
+    }
+
+    ecs.AddThreadLocalSingleton<PartialSum>();
+    ecs.ParallelForEach<const Position>([&](Slayer::Entity entity, const Position* position)
+        {
+            PartialSum* partial = ecs.GetThreadLocalSingleton<PartialSum>();
+            partial->sum += position->x;
+            partial->count++;
+        }, 64);
+
+    PartialSum total;
+    ecs.ForEachThreadLocalSingleton<PartialSum>([&](PartialSum* partial)
+        {
+            total.sum += partial->sum;
+            total.count += partial->count;
+        });
+    BOOST_TEST(total.count == numEntities);
+    BOOST_TEST(total.sum == (double)numEntities * (numEntities - 1) / 2);
+
+    threadManager.Shutdown();
+}
+
+BOOST_AUTO_TEST_CASE(BulkSpawn_Test)
+{
+    Slayer::ComponentStore ecs;
+
+    ecs.RegisterComponent<Slayer::EntityID>();
+    ecs.RegisterComponent<Position>();
+    ecs.RegisterComponent<Velocity>();
+    ecs.RegisterComponent<Renderable>();
+
+    // Spans several chunks, and reuses the slots of destroyed entities
+    Slayer::Entity destroyed = ecs.CreateEntityWithoutID();
+    ecs.DestroyEntity(destroyed);
+
+    const uint32_t count = 5000;
+    Slayer::Vector<Slayer::Entity> entities = ecs.CreateEntities<Position, Velocity>(count,
+        [](uint32_t i) { return Position{ (float)i, 2.0f * i }; },
+        Velocity{ 1.0f, -1.0f });
+
+    BOOST_TEST(entities.size() == count);
+    BOOST_TEST(ecs.GetEntityCount() == count);
+    BOOST_TEST(Slayer::GetEntityIndex(entities[0]) == Slayer::GetEntityIndex(destroyed));
+    BOOST_TEST(entities[0] != destroyed);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        BOOST_TEST_REQUIRE(ecs.IsValid(entities[i]));
+        BOOST_TEST(ecs.GetComponent<const Position>(entities[i])->x == (float)i);
+        BOOST_TEST(ecs.GetComponent<const Position>(entities[i])->y == 2.0f * i);
+        BOOST_TEST(ecs.GetComponent<const Velocity>(entities[i])->x == 1.0f);
+        BOOST_TEST(!ecs.HasComponent<Slayer::EntityID>(entities[i]));
+    }
+
+    // Spawned entities are seen by queries and can be destroyed like any other
+    uint32_t visited = 0;
+    ecs.ForEach<const Position, const Velocity>([&](Slayer::Entity entity, const Position* position, const Velocity* velocity) { visited++; });
+    BOOST_TEST(visited == count);
+    ecs.DestroyEntity(entities[10]);
+    BOOST_TEST(!ecs.IsValid(entities[10]));
+    BOOST_TEST(ecs.GetComponent<const Position>(entities[11])->x == 11.0f);
+
+    // EntityIDs given at spawn are registered
+    Slayer::Vector<Slayer::Entity> named = ecs.CreateEntities<Slayer::EntityID, Position>(3,
+        [](uint32_t i) { Slayer::EntityID id; id.id = 100 + i; return id; },
+        Position{ 0.0f, 0.0f });
+    BOOST_TEST(ecs.GetEntity(102) == named[2]);
+
+    // Several components are added with one move
+    Slayer::Entity entity = ecs.CreateEntity();
+    ecs.AddComponents(entity, Position{ 3.0f, 4.0f }, Velocity{ 5.0f, 6.0f }, Renderable{ "tex.png" });
+    BOOST_TEST(ecs.GetComponent<const Position>(entity)->y == 4.0f);
+    BOOST_TEST(ecs.GetComponent<const Velocity>(entity)->x == 5.0f);
+    BOOST_TEST(ecs.GetComponent<const Renderable>(entity)->texturePath == "tex.png");
+
+    // Prefab copies get every component of the prefab and their own EntityID
+    Slayer::Vector<Slayer::Entity> copies = ecs.Instantiate(entity, 1000);
+    BOOST_TEST(copies.size() == 1000);
+    for (Slayer::Entity copy : copies)
+    {
+        BOOST_TEST_REQUIRE(ecs.IsValid(copy));
+        BOOST_TEST(ecs.GetComponent<const Renderable>(copy)->texturePath == "tex.png");
+        BOOST_TEST(ecs.GetComponent<const Velocity>(copy)->y == 6.0f);
+
+        const Slayer::AssetID id = ecs.GetComponent<const Slayer::EntityID>(copy)->id;
+        BOOST_TEST(id != ecs.GetComponent<const Slayer::EntityID>(entity)->id);
+        BOOST_TEST(ecs.GetEntity(id) == copy);
+    }
+
+    // Copies are independent of the prefab
+    ecs.GetComponent<Renderable>(copies[0])->texturePath = "other.png";
+    BOOST_TEST(ecs.GetComponent<const Renderable>(entity)->texturePath == "tex.png");
+    BOOST_TEST(ecs.GetEntityCount() == count - 1 + 3 + 1 + 1000);
+}
+
+BOOST_AUTO_TEST_CASE(SortedRuns_Test)
+{
+    Slayer::ComponentStore ecs;
+
+    ecs.RegisterComponent<Position>();
+    ecs.RegisterComponent<Velocity>();
+    ecs.RegisterComponent<Renderable>();
+    ecs.SetSortKey<Renderable>([](const Renderable& renderable) { return renderable.texturePath; });
+
+    const char* textures[] = { "d.png", "a.png", "c.png", "b.png" };
+    const int numEntities = 3000;
+    std::mt19937 random(7);
+    Slayer::Vector<Slayer::Entity> entities;
+    for (int i = 0; i < numEntities; ++i)
+    {
+        Slayer::Entity entity = ecs.CreateEntityWithoutID();
+        ecs.AddComponents(entity, Position{ (float)i, 0.0f }, Renderable{ textures[random() % 4] });
+        entities.push_back(entity);
+    }
+
+    // Checks that the runs are ordered, hold equal keys, and that the entities can still be found
+    auto checkRuns = [&]()
+        {
+            int visited = 0;
+            std::string previous;
+            ecs.ForEachRun<const Position, const Renderable>([&](const Slayer::Entity* runEntities, uint32_t count, const Position* positions, const Renderable* renderables)
+                {
+                    BOOST_TEST(count > 0u);
+                    BOOST_TEST(renderables[0].texturePath >= previous);
+                    for (uint32_t i = 0; i < count; i++)
+                    {
+                        BOOST_TEST(renderables[i].texturePath == renderables[0].texturePath);
+                        BOOST_TEST(ecs.GetComponent<const Position>(runEntities[i]) == positions + i);
+                    }
+                    previous = renderables[0].texturePath;
+                    visited += count;
+                });
+            return visited;
+        };
+
+    Slayer::Query<const Position, Slayer::Changed<Position>> changedQuery;
+    changedQuery.ForEach(ecs, [](Slayer::Entity entity, const Position* position) {});
+
+    BOOST_TEST(checkRuns() == numEntities);
+    for (int i = 0; i < numEntities; ++i)
+        BOOST_TEST(ecs.GetComponent<const Position>(entities[i])->x == (float)i);
+
+    // Moving rows is not a change of their components
+    int changed = 0;
+    changedQuery.ForEach(ecs, [&](Slayer::Entity entity, const Position* position) { changed++; });
+    BOOST_TEST(changed == 0);
+
+    // Keys that are written, and rows that are added or removed, are sorted again
+    ecs.GetComponent<Renderable>(entities[0])->texturePath = "0.png";
+    ecs.GetComponent<Renderable>(entities[1])->texturePath = "z.png";
+    for (int i = 2; i < 100; ++i)
+        ecs.DestroyEntity(entities[i]);
+    Slayer::Entity added = ecs.CreateEntityWithoutID();
+    ecs.AddComponents(added, Position{ -1.0f, 0.0f }, Renderable{ "a.png" });
+    BOOST_TEST(checkRuns() == numEntities - 98 + 1);
+
+    std::string first;
+    ecs.ForEachRun<const Renderable>([&](const Slayer::Entity* runEntities, uint32_t count, const Renderable* renderables)
+        {
+            if (first.empty())
+                first = renderables[0].texturePath;
+        });
+    BOOST_TEST(first == "0.png");
+    BOOST_TEST(ecs.GetComponent<const Position>(added)->x == -1.0f);
+
+    // Archetypes without a sort key visit every entity as its own run
+    Slayer::Entity unsorted = ecs.CreateEntityWithoutID();
+    ecs.AddComponents(unsorted, Position{ 0.0f, 0.0f }, Velocity{ 0.0f, 0.0f });
+    Slayer::Query<const Position, const Velocity> velocityQuery;
+    velocityQuery.ForEachRun(ecs, [&](const Slayer::Entity* runEntities, uint32_t count, const Position* positions, const Velocity* velocities)
+        {
+            BOOST_TEST(count == 1u);
+            BOOST_TEST(runEntities[0] == unsorted);
+        });
+}
+
+BOOST_AUTO_TEST_CASE(EntityIdIndex_Test)
+{
+    // Random inserts, overwrites and erases checked against a reference map
+    Slayer::EntityIdIndex index;
+    std::unordered_map<Slayer::AssetID, Slayer::Entity> reference;
+    std::mt19937_64 random(11);
+    for (int i = 0; i < 50000; ++i)
+    {
+        // Small ids collide often, which exercises the probing and the backward shift on erase
+        const Slayer::AssetID id = random() % 4096;
+        if (random() % 3 == 0)
+        {
+            index.Erase(id);
+            reference.erase(id);
+        }
+        else
+        {
+            index.Set(id, (Slayer::Entity)i);
+            reference[id] = (Slayer::Entity)i;
+        }
+    }
+
+    BOOST_TEST(index.Size() == reference.size());
+    for (Slayer::AssetID id = 0; id < 4096; ++id)
+    {
+        auto it = reference.find(id);
+        BOOST_TEST(index.Find(id) == (it != reference.end() ? it->second : SL_INVALID_ENTITY));
+    }
+
+    // The store keeps the index consistent when ids go away
+    Slayer::ComponentStore ecs;
+    ecs.RegisterComponent<Slayer::EntityID>();
+    ecs.RegisterComponent<Position>();
+
+    Slayer::Entity destroyed = ecs.CreateEntity();
+    const Slayer::AssetID destroyedId = ecs.GetComponent<const Slayer::EntityID>(destroyed)->id;
+    BOOST_TEST(ecs.GetEntity(destroyedId) == destroyed);
+    ecs.DestroyEntity(destroyed);
+    BOOST_TEST(ecs.GetEntity(destroyedId) == SL_INVALID_ENTITY);
+
+    Slayer::Entity removed = ecs.CreateEntity(42);
+    ecs.RemoveComponent<Slayer::EntityID>(removed);
+    BOOST_TEST(ecs.GetEntity(42) == SL_INVALID_ENTITY);
+
+    // Ids removed or replaced through a command buffer
+    Slayer::Entity renamed = ecs.CreateEntity(43);
+    Slayer::Entity unnamed = ecs.CreateEntity(44);
+    Slayer::EntityID newId;
+    newId.id = 45;
+    ecs.GetCommandBuffer().AddComponent(renamed, newId);
+    ecs.GetCommandBuffer().RemoveComponent<Slayer::EntityID>(unnamed);
+    ecs.GetCommandBuffer().AddComponent(unnamed, Position{ 1.0f, 1.0f });
+    ecs.PlaybackCommands();
+    BOOST_TEST(ecs.GetEntity(43) == SL_INVALID_ENTITY);
+    BOOST_TEST(ecs.GetEntity(44) == SL_INVALID_ENTITY);
+    BOOST_TEST(ecs.GetEntity(45) == renamed);
+}
+
+BOOST_AUTO_TEST_CASE(Relationship_Test)
+{
+    Slayer::ComponentStore ecs;
+    ecs.RegisterComponents<ENGINE_COMPONENTS>();
+
+    auto createNode = [&](float x, Slayer::AssetID parentId = 0)
+        {
+            Slayer::Entity entity = ecs.CreateEntity();
+            Slayer::Transform transform(Slayer::Vec3(x, 0.0f, 0.0f), Slayer::Quat(1.0f, 0.0f, 0.0f, 0.0f), Slayer::Vec3(1.0f));
+            transform.parentId = parentId;
+            ecs.AddComponent(entity, transform);
+            return entity;
+        };
+
+    // Parents given by id are resolved once into handles
+    Slayer::Entity root = createNode(1.0f);
+    const Slayer::AssetID rootId = ecs.GetComponent<const Slayer::EntityID>(root)->id;
+    Slayer::Entity a = createNode(2.0f, rootId);
+    Slayer::Entity b = createNode(3.0f, rootId);
+    Slayer::Entity c = createNode(4.0f);
+    ecs.ResolveParents();
+
+    BOOST_TEST(ecs.GetParent(a) == root);
+    BOOST_TEST(ecs.GetParent(b) == root);
+    BOOST_TEST(ecs.GetParent(c) == SL_INVALID_ENTITY);
+
+    auto children = [&](Slayer::Entity entity)
+        {
+            std::set<Slayer::Entity> result;
+            ecs.ForEachChild(entity, [&](Slayer::Entity child) { result.insert(child); });
+            return result;
+        };
+    BOOST_TEST((children(root) == std::set<Slayer::Entity>{ a, b }));
+
+    // Reparenting moves the child between sibling lists and updates the saved parentId
+    ecs.SetParent(a, c);
+    BOOST_TEST((children(root) == std::set<Slayer::Entity>{ b }));
+    BOOST_TEST((children(c) == std::set<Slayer::Entity>{ a }));
+    BOOST_TEST(ecs.GetComponent<const Slayer::Transform>(a)->parentId == ecs.GetComponent<const Slayer::EntityID>(c)->id);
+
+    // The hierarchy follows the relationships
+    Slayer::TransformHierarchy hierarchy;
+    hierarchy.Update(ecs);
+    BOOST_TEST(hierarchy.GetParent(a) == c);
+    BOOST_TEST(hierarchy.GetWorldMatrix(a)[3].x == 6.0f);
+    BOOST_TEST(hierarchy.GetWorldMatrix(b)[3].x == 4.0f);
+
+    // A parent without an EntityID can only be linked through the relationship
+    Slayer::Entity anonymous = ecs.CreateEntityWithoutID();
+    ecs.AddComponent(anonymous, Slayer::Transform(Slayer::Vec3(10.0f, 0.0f, 0.0f), Slayer::Quat(1.0f, 0.0f, 0.0f, 0.0f), Slayer::Vec3(1.0f)));
+    ecs.SetParent(b, anonymous);
+    BOOST_TEST(ecs.GetComponent<const Slayer::Transform>(b)->parentId == 0u);
+    hierarchy.Update(ecs);
+    BOOST_TEST(hierarchy.GetParent(b) == anonymous);
+    BOOST_TEST(hierarchy.GetWorldMatrix(b)[3].x == 13.0f);
+
+    // Destroying a parent leaves its children as roots
+    ecs.DestroyEntity(c);
+    BOOST_TEST(ecs.GetParent(a) == SL_INVALID_ENTITY);
+    BOOST_TEST(children(root).empty());
+    hierarchy.Update(ecs);
+    BOOST_TEST(hierarchy.GetParent(a) == SL_INVALID_ENTITY);
+    BOOST_TEST(hierarchy.GetWorldMatrix(a)[3].x == 2.0f);
+}
+
+BOOST_AUTO_TEST_CASE(Snapshot_Test)
+{
+    Slayer::ComponentStore ecs;
+    ecs.RegisterComponent<Slayer::EntityID>();
+    ecs.RegisterComponent<Position>();
+    ecs.RegisterComponent<Velocity>();
+    ecs.RegisterComponent<Renderable>();
+
+    const int numEntities = 3000;
+    Slayer::Vector<Slayer::Entity> entities;
+    for (int i = 0; i < numEntities; ++i)
+    {
+        Slayer::Entity entity = ecs.CreateEntity(1000 + i);
+        ecs.AddComponents(entity, Position{ (float)i, 0.0f }, Renderable{ "texture" + std::to_string(i) });
+        entities.push_back(entity);
+    }
+
+    auto checkOriginal = [&](Slayer::ComponentStore& store)
+        {
+            BOOST_TEST(store.GetEntityCount() == (size_t)numEntities);
+            for (int i = 0; i < numEntities; ++i)
+            {
+                BOOST_TEST_REQUIRE(store.IsValid(entities[i]));
+                BOOST_TEST(store.GetComponent<const Position>(entities[i])->x == (float)i);
+                BOOST_TEST(store.GetComponent<const Renderable>(entities[i])->texturePath == "texture" + std::to_string(i));
+                BOOST_TEST(store.GetEntity(1000 + i) == entities[i]);
+            }
+        };
+
+    Slayer::WorldSnapshot snapshot = ecs.CreateSnapshot();
+    BOOST_TEST(snapshot.GetEntityCount() == (size_t)numEntities);
+    BOOST_TEST(snapshot.GetCopiedChunkCount() == snapshot.GetChunkCount());
+
+    // Nothing changed, so a delta snapshot shares every chunk
+    Slayer::WorldSnapshot unchanged = ecs.CreateSnapshot(&snapshot);
+    BOOST_TEST(unchanged.GetCopiedChunkCount() == 0u);
+
+    // One write only copies the chunk it is in
+    ecs.GetComponent<Position>(entities[5])->y = 7.0f;
+    Slayer::WorldSnapshot delta = ecs.CreateSnapshot(&snapshot);
+    BOOST_TEST(delta.GetCopiedChunkCount() == 1u);
+
+    // Changes of every kind are undone by restoring
+    ecs.GetComponent<Renderable>(entities[10])->texturePath = "changed";
+    for (int i = 0; i < 100; ++i)
+        ecs.DestroyEntity(entities[i * 3]);
+    Slayer::Entity added = ecs.CreateEntity(1);
+    ecs.AddComponents(added, Position{ 0.0f, 0.0f }, Velocity{ 1.0f, 1.0f });
+    ecs.GetComponent<Position>(entities[5])->y = 0.0f;
+
+    Slayer::Query<const Position, Slayer::Changed<Position>> changedQuery;
+    changedQuery.ForEach(ecs, [](Slayer::Entity entity, const Position* position) {});
+
+    ecs.Restore(snapshot);
+    checkOriginal(ecs);
+    BOOST_TEST(!ecs.IsValid(added));
+    BOOST_TEST(ecs.GetEntity(1) == SL_INVALID_ENTITY);
+    BOOST_TEST(ecs.GetEntities<Velocity>().empty());
+
+    // Restored components count as changed
+    int changed = 0;
+    changedQuery.ForEach(ecs, [&](Slayer::Entity entity, const Position* position) { changed++; });
+    BOOST_TEST(changed > 0);
+
+    // Delta snapshots restore like full ones
+    ecs.Restore(delta);
+    BOOST_TEST(ecs.GetComponent<const Position>(entities[5])->y == 7.0f);
+    ecs.Restore(snapshot);
+    BOOST_TEST(ecs.GetComponent<const Position>(entities[5])->y == 0.0f);
+
+    // Entity slots freed after the snapshot are not handed out twice after restoring
+    Slayer::Entity created = ecs.CreateEntityWithoutID();
+    BOOST_TEST((std::find(entities.begin(), entities.end(), created) == entities.end()));
+    ecs.DestroyEntity(created);
+
+    // A snapshot restored into another store forks the world
+    Slayer::ComponentStore fork;
+    fork.Restore(snapshot);
+    checkOriginal(fork);
+    fork.GetComponent<Renderable>(entities[0])->texturePath = "forked";
+    fork.DestroyEntity(entities[1]);
+    BOOST_TEST(ecs.GetComponent<const Renderable>(entities[0])->texturePath == "texture0");
+    BOOST_TEST(ecs.IsValid(entities[1]));
+
+    // Taking a snapshot into an earlier one reuses its memory
+    ecs.GetComponent<Renderable>(entities[2])->texturePath = "reused";
+    ecs.CreateSnapshot(delta);
+    BOOST_TEST(delta.GetCopiedChunkCount() == delta.GetChunkCount());
+    Slayer::ComponentStore reused;
+    reused.Restore(delta);
+    BOOST_TEST(reused.GetComponent<const Renderable>(entities[2])->texturePath == "reused");
+    BOOST_TEST(reused.GetEntityCount() == (size_t)numEntities);
+}
@@ -0,0 +1,636 @@
+#define BOOST_TEST_MODULE jobs
+#include <boost/test/included/unit_test.hpp>
+#include "Jobs/JobSystem.h"
+#include "Jobs/MPMCQueue.h"
+#include "Jobs/JobQueue.h"
+#include "Jobs/ThreadManager.h"
+#include "Jobs/ParallelFor.h"
+#include "Jobs/Fiber.h"
+#include "Jobs/JobTrace.h"
+
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+BOOST_AUTO_TEST_CASE(JobClosure_Test)
+{
+    int calls = 0;
+    Slayer::JobClosure closure([&calls]() { calls++; });
+    BOOST_TEST((bool)closure);
+    closure();
+
+    // Moving leaves the source empty
+    Slayer::JobClosure moved = std::move(closure);
+    BOOST_TEST(!closure);
+    moved();
+    BOOST_TEST(calls == 2);
+
+    // Captures that are not trivially copyable are moved and destroyed with the closure
+    auto counter = std::make_shared<int>(0);
+    {
+        Slayer::JobClosure owner([counter]() { (*counter)++; });
+        Slayer::JobClosure other;
+        other = std::move(owner);
+        other();
+        BOOST_TEST(counter.use_count() == 2);
+    }
+    BOOST_TEST(*counter == 1);
+    BOOST_TEST(counter.use_count() == 1);
+}
+
+BOOST_AUTO_TEST_CASE(MPMCQueue_Test)
+{
+    Slayer::MPMCQueue<int> queue(4);
+    for (int i = 0; i < 4; ++i)
+        BOOST_TEST(queue.TryPush(int(i)));
+    BOOST_TEST(!queue.TryPush(4));
+    BOOST_TEST(queue.Size() == 4u);
+
+    int value = -1;
+    for (int i = 0; i < 4; ++i)
+    {
+        BOOST_TEST(queue.TryPop(value));
+        BOOST_TEST(value == i);
+    }
+    BOOST_TEST(!queue.TryPop(value));
+
+    // Every value pushed by any producer is popped exactly once
+    const int numThreads = 8;
+    const int valuesPerThread = 20000;
+    Slayer::MPMCQueue<int> shared(64);
+    std::vector<std::atomic<int>> seen(numThreads * valuesPerThread);
+    std::atomic<int> popped = 0;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < numThreads; ++t)
+    {
+        threads.emplace_back([&, t]()
+            {
+                for (int i = 0; i < valuesPerThread; ++i)
+                {
+                    while (!shared.TryPush(t * valuesPerThread + i))
+                    {
+                        int other;
+                        if (shared.TryPop(other))
+                        {
+                            seen[other]++;
+                            popped++;
+                        }
+                    }
+                }
+                int other;
+                while (popped.load() < numThreads * valuesPerThread)
+                {
+                    if (shared.TryPop(other))
+                    {
+                        seen[other]++;
+                        popped++;
+                    }
+                }
+            });
+    }
+    for (std::thread& thread : threads)
+        thread.join();
+
+    bool exactlyOnce = true;
+    for (std::atomic<int>& count : seen)
+        exactlyOnce &= count.load() == 1;
+    BOOST_TEST(exactlyOnce);
+}
+
+BOOST_AUTO_TEST_CASE(JobSystem_Test)
+{
+    Slayer::ThreadManager threadManager;
+    threadManager.Initialize();
+
+    // More jobs than fit in the queue at once
+    std::atomic<int> executed = 0;
+    for (int i = 0; i < 20000; ++i)
+        Slayer::JobSystem::Execute([&executed]() { executed++; });
+    Slayer::JobSystem::Wait();
+    BOOST_TEST(executed.load() == 20000);
+    BOOST_TEST(!Slayer::JobSystem::IsBusy());
+
+    std::vector<std::atomic<int>> visits(10000);
+    Slayer::JobSystem::Dispatch((uint32_t)visits.size(), 64, [&visits](Slayer::JobDispatchArgs args) { visits[args.jobIndex]++; });
+    Slayer::JobSystem::Wait();
+
+    bool visitedOnce = true;
+    for (std::atomic<int>& count : visits)
+        visitedOnce &= count.load() == 1;
+    BOOST_TEST(visitedOnce);
+
+    // Workers sleep between bursts and are woken by new jobs
+    for (int burst = 0; burst < 50; ++burst)
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+        Slayer::JobSystem::Execute([&executed]() { executed++; });
+        Slayer::JobSystem::Wait();
+    }
+    BOOST_TEST(executed.load() == 20050);
+
+    threadManager.Shutdown();
+}
+
+BOOST_AUTO_TEST_CASE(JobLanes_Test)
+{
+    Slayer::JobSettings settings;
+    settings.workerCount = 3;
+    settings.ioThreads = 2;
+    settings.backgroundThreads = 0;
+    settings.pinWorkers = true;
+    Slayer::ThreadManager threadManager;
+    threadManager.Initialize(settings);
+    BOOST_TEST(threadManager.GetWorkerCount() == 3u);
+    // The loading lane gets a thread per core unless told otherwise
+    BOOST_TEST(threadManager.GetLane(Slayer::JobLane::Loading).GetThreadCount() == Slayer::ThreadTopology::GetCoreCount());
+
+    // IO jobs run on the lane's own threads, or on the main thread while it waits, never on a background worker
+    std::atomic<int> ioJobs = 0;
+    std::atomic<int> ioOnWorker = 0;
+    for (int i = 0; i < 1000; ++i)
+    {
+        Slayer::JobSystem::Execute([&]()
+            {
+                if (Slayer::ThreadManager::Get()->GetCurrentWorkerIndex() > 0)
+                    ioOnWorker++;
+                ioJobs++;
+            }, Slayer::JobLane::IO);
+    }
+
+    // A lane without threads hands its jobs to the workers
+    std::atomic<int> backgroundJobs = 0;
+    for (int i = 0; i < 1000; ++i)
+        Slayer::JobSystem::Execute([&backgroundJobs]() { backgroundJobs++; }, Slayer::JobLane::Background);
+
+    // Dispatched loading jobs are spread over the lane's threads and the waiting thread
+    std::atomic<int> loadingJobs = 0;
+    std::atomic<int> loadingOnWorker = 0;
+    Slayer::JobSystem::Dispatch(1000, 7, [&loadingJobs, &loadingOnWorker](Slayer::JobDispatchArgs args)
+        {
+            if (Slayer::ThreadManager::Get()->GetCurrentWorkerIndex() > 0)
+                loadingOnWorker++;
+            loadingJobs++;
+        }, Slayer::JobLane::Loading);
+
+    Slayer::JobSystem::Wait(Slayer::JobLane::IO);
+    Slayer::JobSystem::Wait(Slayer::JobLane::Background);
+    Slayer::JobSystem::Wait(Slayer::JobLane::Loading);
+    BOOST_TEST(ioJobs.load() == 1000);
+    BOOST_TEST(ioOnWorker.load() == 0);
+    BOOST_TEST(backgroundJobs.load() == 1000);
+    BOOST_TEST(loadingJobs.load() == 1000);
+    BOOST_TEST(loadingOnWorker.load() == 0);
+
+    // Shutting down runs what is still queued
+    for (int i = 0; i < 100; ++i)
+        Slayer::JobSystem::Execute([&ioJobs]() { ioJobs++; }, Slayer::JobLane::IO);
+    threadManager.Shutdown();
+    BOOST_TEST(ioJobs.load() == 1100);
+    BOOST_TEST(Slayer::ThreadManager::Get() == nullptr);
+
+    // Without a scheduler jobs run on the calling thread
+    int ranInline = 0;
+    Slayer::JobSystem::Execute([&ranInline]() { ranInline++; }, Slayer::JobLane::IO);
+    BOOST_TEST(ranInline == 1);
+}
+
+BOOST_AUTO_TEST_CASE(JobQueue_Test)
+{
+    // The owner sees its own jobs last in, first out, and the queue grows past its initial capacity
+    Slayer::JobQueue queue(2);
+    std::vector<Slayer::Job> jobs(100);
+    for (Slayer::Job& job : jobs)
+        queue.Push(&job);
+    BOOST_TEST(queue.Size() == jobs.size());
+    BOOST_TEST(queue.Steal() == &jobs.front());
+    BOOST_TEST(queue.Pop() == &jobs.back());
+
+    while (queue.Pop() != nullptr) {}
+    BOOST_TEST(queue.Size() == 0u);
+    BOOST_TEST(queue.Steal() == nullptr);
+
+    // Stress: the owner pushes and pops while thieves steal, every job is taken exactly once
+    const int numJobs = 200000;
+    const int numThieves = 4;
+    std::vector<Slayer::Job> stressJobs(numJobs);
+    std::vector<std::atomic<int>> taken(numJobs);
+    std::atomic<int> takenCount = 0;
+    std::atomic<bool> done = false;
+    Slayer::JobQueue stressQueue(16);
+
+    auto take = [&](Slayer::Job* job)
+        {
+            taken[job - stressJobs.data()]++;
+            takenCount++;
+        };
+
+    std::vector<std::thread> thieves;
+    for (int t = 0; t < numThieves; ++t)
+    {
+        thieves.emplace_back([&]()
+            {
+                while (!done.load())
+                {
+                    if (Slayer::Job* job = stressQueue.Steal())
+                        take(job);
+                }
+            });
+    }
+
+    for (int i = 0; i < numJobs; ++i)
+    {
+        stressQueue.Push(&stressJobs[i]);
+        // Pop every third push, so the queue both grows and runs down to its last job
+        if (i % 3 == 0)
+        {
+            if (Slayer::Job* job = stressQueue.Pop())
+                take(job);
+        }
+    }
+    while (Slayer::Job* job = stressQueue.Pop())
+        take(job);
+    while (takenCount.load() < numJobs)
+        std::this_thread::yield();
+
+    done = true;
+    for (std::thread& thief : thieves)
+        thief.join();
+
+    bool exactlyOnce = true;
+    for (std::atomic<int>& count : taken)
+        exactlyOnce &= count.load() == 1;
+    BOOST_TEST(exactlyOnce);
+}
+
+struct FibData
+{
+    int n;
+    std::atomic<uint64_t>* result;
+};
+
+static void FibJob(Slayer::Job& job)
+{
+    const FibData data = job.GetDataCopy<FibData>();
+    if (data.n < 2)
+    {
+        data.result->fetch_add(data.n);
+        return;
+    }
+
+    // Children are allocated from the worker running the job and rewound once they finished
+    Slayer::Worker* worker = Slayer::ThreadManager::Get()->GetCurrentWorker();
+    Slayer::JobPool& pool = worker->Pool();
+    const size_t marker = pool.GetMarker();
+    Slayer::Job* root = pool.CreateJob([](Slayer::Job&) {});
+    Slayer::Job* first = pool.CreateJobAsChild(&FibJob, FibData{ data.n - 1, data.result }, root);
+    Slayer::Job* second = pool.CreateJobAsChild(&FibJob, FibData{ data.n - 2, data.result }, root);
+    SL_ASSERT(root != nullptr && first != nullptr && second != nullptr && "Job pool exhausted.");
+
+    worker->Submit(first);
+    worker->Submit(second);
+    worker->Submit(root);
+    worker->Wait(root);
+    pool.Rewind(marker);
+}
+
+BOOST_AUTO_TEST_CASE(NestedJobs_Test)
+{
+    Slayer::ThreadManager threadManager;
+    threadManager.Initialize();
+
+    // Every job of a nested tree runs exactly once, even when workers fall asleep between trees
+    for (int run = 0; run < 20; ++run)
+    {
+        std::atomic<uint64_t> result = 0;
+        Slayer::Job job(&FibJob, nullptr);
+        job.SetData(FibData{ 15, &result });
+
+        Slayer::Worker* worker = threadManager.GetCurrentWorker();
+        worker->Submit(&job);
+        worker->Wait(&job);
+        BOOST_TEST(result.load() == 610u);
+
+        if (run % 5 == 0)
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+
+    threadManager.Shutdown();
+}
+
+struct StepData
+{
+    std::atomic<int>* step;
+    int expected;
+    std::atomic<int>* outOfOrder;
+};
+
+static void StepJob(Slayer::Job& job)
+{
+    const StepData data = job.GetDataCopy<StepData>();
+    if (data.step->fetch_add(1) != data.expected)
+        (*data.outOfOrder)++;
+}
+
+BOOST_AUTO_TEST_CASE(JobGraph_Test)
+{
+    Slayer::ThreadManager threadManager;
+    threadManager.Initialize();
+    Slayer::Worker* worker = threadManager.GetCurrentWorker();
+    Slayer::JobPool& pool = worker->Pool();
+
+    // A chain of continuations runs in order, the last one is a child of the root so that waiting covers it
+    std::atomic<int> step = 0;
+    std::atomic<int> outOfOrder = 0;
+    const size_t marker = pool.GetMarker();
+    Slayer::Job* root = pool.CreateJob([](Slayer::Job&) {});
+    Slayer::Job* first = pool.CreateJob(&StepJob, StepData{ &step, 0, &outOfOrder });
+    Slayer::Job* second = pool.CreateJob(&StepJob, StepData{ &step, 1, &outOfOrder });
+    Slayer::Job* third = pool.CreateJobAsChild(&StepJob, StepData{ &step, 2, &outOfOrder }, root);
+    second->AddContinuation(third);
+    first->AddContinuation(second);
+
+    worker->Submit(first);
+    worker->Submit(root);
+    worker->Wait(root);
+    pool.Rewind(marker);
+    BOOST_TEST(step.load() == 3);
+    BOOST_TEST(outOfOrder.load() == 0);
+
+    // A continuation of a group runs after every job of the group
+    std::atomic<int> groupDone = 0;
+    std::atomic<int> seenByContinuation = -1;
+    struct GroupData { std::atomic<int>* done; std::atomic<int>* seen; };
+    root = pool.CreateJob([](Slayer::Job&) {});
+    Slayer::Job* group = pool.CreateJob([](Slayer::Job&) {});
+    for (int i = 0; i < 64; ++i)
+    {
+        Slayer::Job* job = pool.CreateJobAsChild([](Slayer::Job& job) { (*job.GetDataCopy<GroupData>().done)++; }, GroupData{ &groupDone, &seenByContinuation }, group);
+        worker->Submit(job);
+    }
+    Slayer::Job* continuation = pool.CreateJobAsChild([](Slayer::Job& job)
+        {
+            const GroupData data = job.GetDataCopy<GroupData>();
+            data.seen->store(data.done->load());
+        }, GroupData{ &groupDone, &seenByContinuation }, root);
+    group->AddContinuation(continuation);
+    worker->Submit(group);
+    worker->Submit(root);
+    worker->Wait(root);
+    pool.Rewind(marker);
+    BOOST_TEST(seenByContinuation.load() == 64);
+
+    // ParallelFor covers the range exactly once, in ranges no larger than the grain size
+    std::vector<std::atomic<int>> visits(10007);
+    std::atomic<int> oversized = 0;
+    Slayer::ParallelFor(0, (uint32_t)visits.size(), 100, [&](uint32_t begin, uint32_t end)
+        {
+            if (end - begin > 100)
+                oversized++;
+            for (uint32_t i = begin; i < end; ++i)
+                visits[i]++;
+        });
+
+    bool visitedOnce = true;
+    for (std::atomic<int>& count : visits)
+        visitedOnce &= count.load() == 1;
+    BOOST_TEST(visitedOnce);
+    BOOST_TEST(oversized.load() == 0);
+    BOOST_TEST(pool.GetMarker() == marker);
+
+    threadManager.Shutdown();
+}
+
+struct PingPong
+{
+    Slayer::Fiber* thread;
+    Slayer::Fiber* fiber;
+    std::vector<int>* trace;
+};
+
+BOOST_AUTO_TEST_CASE(Fiber_Test)
+{
+    // Control passes back and forth, and the fiber keeps its stack between switches
+    std::vector<int> trace;
+    Slayer::Fiber thread;
+    PingPong pingPong = { &thread, nullptr, &trace };
+    Slayer::Fiber fiber(64 * 1024, [](void* arg)
+        {
+            PingPong* pingPong = static_cast<PingPong*>(arg);
+            for (int i = 0; ; i += 2)
+            {
+                pingPong->trace->push_back(i);
+                pingPong->fiber->SwitchTo(*pingPong->thread);
+            }
+        }, &pingPong);
+    pingPong.fiber = &fiber;
+
+    for (int i = 0; i < 3; ++i)
+    {
+        thread.SwitchTo(fiber);
+        trace.push_back(i * 2 + 1);
+    }
+    BOOST_TEST((trace == std::vector<int>{ 0, 1, 2, 3, 4, 5 }));
+
+    // Floating point state survives a switch
+    double value = 1.0;
+    for (int i = 0; i < 10; ++i)
+    {
+        value *= 1.5;
+        thread.SwitchTo(fiber);
+    }
+    BOOST_TEST(value == std::pow(1.5, 10));
+}
+
+BOOST_AUTO_TEST_CASE(FiberJobs_Test)
+{
+    Slayer::ThreadManager threadManager;
+    threadManager.Initialize(true);
+    Slayer::Worker* worker = threadManager.GetCurrentWorker();
+    BOOST_TEST(worker->UsesFibers());
+
+    // Nested waits park fibers, every job still runs exactly once
+    for (int run = 0; run < 10; ++run)
+    {
+        std::atomic<uint64_t> result = 0;
+        Slayer::Job job(&FibJob, nullptr);
+        job.SetData(FibData{ 16, &result });
+        worker->Submit(&job);
+        worker->Wait(&job);
+        BOOST_TEST(result.load() == 987u);
+    }
+
+    std::vector<std::atomic<int>> visits(5000);
+    Slayer::ParallelFor(0, (uint32_t)visits.size(), 50, [&](uint32_t begin, uint32_t end)
+        {
+            for (uint32_t i = begin; i < end; ++i)
+                visits[i]++;
+        });
+
+    bool visitedOnce = true;
+    for (std::atomic<int>& count : visits)
+        visitedOnce &= count.load() == 1;
+    BOOST_TEST(visitedOnce);
+
+    threadManager.Shutdown();
+}
+
+struct LargeJobData
+{
+    std::atomic<uint64_t>* sum;
+    uint64_t values[30];
+};
+
+BOOST_AUTO_TEST_CASE(FrameAllocator_Test)
+{
+    Slayer::JobSettings settings;
+    settings.jobsPerWorker = 64;
+    settings.frameArenaSize = 4 * sizeof(LargeJobData);
+    Slayer::ThreadManager threadManager;
+    threadManager.Initialize(settings);
+    Slayer::Worker* worker = threadManager.GetCurrentWorker();
+    Slayer::JobPool& pool = worker->Pool();
+    static_assert(!Slayer::Job::StoresDataInline<LargeJobData>());
+
+    for (int frame = 0; frame < 3; ++frame)
+    {
+        threadManager.BeginFrame();
+
+        // Data too large for a job spills into the frame arena until it is full, nothing is rewound
+        std::atomic<uint64_t> sum = 0;
+        Slayer::Job* root = pool.CreateJob([](Slayer::Job&) {});
+        int created = 0;
+        for (int i = 0; i < 8; ++i)
+        {
+            LargeJobData data = { &sum, {} };
+            for (uint64_t j = 0; j < 30; ++j)
+                data.values[j] = j;
+            Slayer::Job* job = pool.CreateJobAsChild([](Slayer::Job& job)
+                {
+                    const LargeJobData* data = job.GetData<LargeJobData>();
+                    for (uint64_t value : data->values)
+                        data->sum->fetch_add(value);
+                }, data, root);
+            if (job == nullptr)
+                continue;
+            worker->Submit(job);
+            created++;
+        }
+        worker->Submit(root);
+        worker->Wait(root);
+
+        BOOST_TEST(created == 4);
+        BOOST_TEST(sum.load() == 4u * 435u);
+    }
+
+    // The job pool overflows without crashing and the high-water marks show what the worst frame needed
+    threadManager.BeginFrame();
+    for (int i = 0; i < 100; ++i)
+        pool.CreateJob([](Slayer::Job&) {});
+
+    const Slayer::JobStats stats = threadManager.GetJobStats();
+    BOOST_TEST(stats.jobHighWaterMark == 64u);
+    BOOST_TEST(stats.frameArenaHighWaterMark >= 4 * sizeof(LargeJobData));
+    BOOST_TEST(stats.failedAllocations == 3u * 4u + 36u);
+
+    threadManager.BeginFrame();
+    BOOST_TEST(pool.GetMarker() == 0u);
+
+    threadManager.Shutdown();
+}
+
+struct BarrierData
+{
+    std::atomic<uint32_t>* arrived;
+    uint32_t count;
+};
+
+static size_t CountOccurrences(const std::string& text, const std::string& pattern)
+{
+    size_t count = 0;
+    for (size_t position = text.find(pattern); position != std::string::npos; position = text.find(pattern, position + 1))
+        count++;
+    return count;
+}
+
+// Returns once the given number of threads run the job
+static void BarrierJob(Slayer::Job& job)
+{
+    const BarrierData data = job.GetDataCopy<BarrierData>();
+    data.arrived->fetch_add(1);
+    while (data.arrived->load() < data.count)
+    {
+        std::this_thread::yield();
+    }
+}
+
+BOOST_AUTO_TEST_CASE(JobTrace_Test)
+{
+    Slayer::JobTrace::Enable(1 << 12);
+    Slayer::JobSettings settings;
+    settings.workerCount = 2;
+    Slayer::ThreadManager threadManager;
+    threadManager.Initialize(settings);
+    Slayer::Worker* worker = threadManager.GetCurrentWorker();
+
+    // A worker's ring is created by its first event, so both workers run a job before the first frame
+    std::atomic<uint32_t> arrived = 0;
+    Slayer::Job barriers[2] = { Slayer::Job(&BarrierJob, nullptr), Slayer::Job(&BarrierJob, nullptr) };
+    for (Slayer::Job& barrier : barriers)
+    {
+        barrier.SetData(BarrierData{ &arrived, 2 });
+        worker->Submit(&barrier);
+    }
+    for (Slayer::Job& barrier : barriers)
+    {
+        worker->Wait(&barrier);
+    }
+
+    // Frame 1 runs a fib tree of 15 jobs, frames 0 and 2 a tree of 9
+    for (int frame = 0; frame < 3; ++frame)
+    {
+        threadManager.BeginFrame();
+        std::atomic<uint64_t> result = 0;
+        Slayer::Job job(&FibJob, nullptr);
+        job.SetData(FibData{ frame == 1 ? 5 : 4, &result });
+        worker->Submit(&job);
+        worker->Wait(&job);
+    }
+    threadManager.BeginFrame();
+    Slayer::JobTrace::Disable();
+    // Threads that are recording an event when tracing is disabled still finish it, stopping them makes the trace final
+    threadManager.Shutdown();
+
+    // Nothing is recorded while disabled
+    std::ostringstream before;
+    Slayer::JobTrace::WriteChromeTrace(before);
+    Slayer::ThreadManager untracedManager;
+    untracedManager.Initialize(settings);
+    Slayer::Worker* untracedWorker = untracedManager.GetCurrentWorker();
+    std::atomic<uint64_t> result = 0;
+    Slayer::Job job(&FibJob, nullptr);
+    job.SetData(FibData{ 6, &result });
+    untracedWorker->Submit(&job);
+    untracedWorker->Wait(&job);
+    untracedManager.Shutdown();
+    std::ostringstream after;
+    Slayer::JobTrace::WriteChromeTrace(after);
+    BOOST_TEST(CountOccurrences(after.str(), "\"ph\"") == CountOccurrences(before.str(), "\"ph\""));
+
+    // Every job of a tree has an empty root besides its own job, except the leaves
+    std::ostringstream frame1;
+    Slayer::JobTrace::WriteChromeTrace(frame1, 1, 1);
+    const std::string trace = frame1.str();
+    BOOST_TEST(trace.find("\"traceEvents\"") != std::string::npos);
+    BOOST_TEST(trace.find("\"name\":\"Worker 1\"") != std::string::npos);
+    BOOST_TEST(trace.find("\"name\":\"Frame 1\"") != std::string::npos);
+    BOOST_TEST(trace.find("\"name\":\"Frame 0\"") == std::string::npos);
+    BOOST_TEST(CountOccurrences(trace, "\"name\":\"Job ") == 15u + 7u);
+
+    std::ostringstream frames0To2;
+    Slayer::JobTrace::WriteChromeTrace(frames0To2, 0, 2);
+    BOOST_TEST(CountOccurrences(frames0To2.str(), "\"name\":\"Job ") == 2 * (9u + 4u) + 15u + 7u);
+}
@@ -0,0 +1,582 @@
+#define BOOST_TEST_MODULE resources
+#include <boost/test/included/unit_test.hpp>
+#include "Resources/MappedFile.h"
+#include "Resources/AssetPack.h"
+#include "Resources/AssetTypes.h"
+#include "Resources/Compression.h"
+#include "Jobs/ThreadManager.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Path of a scratch file in the temp directory, removed when the test ends
+struct TempFile
+{
+    std::string path;
+
+    TempFile(const std::string& name) : path((std::filesystem::temp_directory_path() / name).string()) {}
+    ~TempFile() { std::filesystem::remove(path); }
+
+    void Write(const std::string& contents) const
+    {
+        Write(std::vector<char>(contents.begin(), contents.end()));
+    }
+
+    void Write(const std::vector<char>& contents) const
+    {
+        std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+        stream.write(contents.data(), contents.size());
+    }
+};
+
+BOOST_AUTO_TEST_CASE(MappedFile_Test)
+{
+    TempFile file("slayer_test_mapped.bin");
+    const std::string contents = "mapped file contents";
+    file.Write(contents);
+
+    Slayer::MappedFile mapped;
+    BOOST_TEST(!mapped.IsOpen());
+    BOOST_TEST(mapped.Open(file.path));
+    BOOST_TEST(mapped.IsOpen());
+    BOOST_TEST(mapped.Size() == contents.size());
+    BOOST_TEST(std::string(mapped.Data(), mapped.Size()) == contents);
+
+    // Moving hands over the mapping and leaves the source closed
+    Slayer::MappedFile moved(std::move(mapped));
+    BOOST_TEST(!mapped.IsOpen());
+    BOOST_TEST(mapped.Size() == 0u);
+    BOOST_TEST(moved.IsOpen());
+    BOOST_TEST(std::string(moved.Data(), moved.Size()) == contents);
+
+    Slayer::MappedFile assigned;
+    assigned = std::move(moved);
+    BOOST_TEST(!moved.IsOpen());
+    BOOST_TEST(std::string(assigned.Data(), assigned.Size()) == contents);
+
+    assigned.Close();
+    BOOST_TEST(!assigned.IsOpen());
+    BOOST_TEST(assigned.Data() == nullptr);
+    BOOST_TEST(assigned.Size() == 0u);
+    // Closing twice is harmless
+    assigned.Close();
+
+    // Files that are missing or empty cannot be mapped
+    BOOST_TEST(!assigned.Open(file.path + ".missing"));
+    TempFile empty("slayer_test_empty.bin");
+    empty.Write("");
+    BOOST_TEST(!assigned.Open(empty.path));
+    BOOST_TEST(!assigned.IsOpen());
+}
+
+struct TestAsset
+{
+    Slayer::AssetID id;
+    Slayer::AssetType type;
+    std::string name;
+    std::vector<char> data;
+};
+
+template<typename T>
+static void Append(std::vector<char>& data, const T& value)
+{
+    const char* bytes = (const char*)&value;
+    data.insert(data.end(), bytes, bytes + sizeof(T));
+}
+
+template<typename T>
+static void Overwrite(std::vector<char>& data, size_t offset, const T& value)
+{
+    std::copy((const char*)&value, (const char*)&value + sizeof(T), data.begin() + offset);
+}
+
+// A serialized TextureAsset of the given size, the texels count up from the seed
+static std::vector<char> TextureData(uint32_t width, uint32_t height, uint8_t seed)
+{
+    std::vector<char> data;
+    Append(data, width);
+    Append(data, height);
+    Append(data, 4u);
+    Append(data, 0x0DE1u);
+    Append(data, width * height * 4);
+    for (uint32_t i = 0; i < width * height * 4; i++)
+    {
+        Append(data, (uint8_t)(seed + i));
+    }
+    return data;
+}
+
+static std::vector<TestAsset> TestAssets()
+{
+    // Names of different lengths, so that the data of a version 1 pack is not aligned
+    return {
+        { 30, Slayer::SL_ASSET_TYPE_TEXTURE, "brick", TextureData(16, 8, 1) },
+        { 10, Slayer::SL_ASSET_TYPE_TEXTURE, "grass_01", TextureData(4, 4, 2) },
+        { 20, Slayer::SL_ASSET_TYPE_TEXTURE, "x", TextureData(32, 32, 3) },
+    };
+}
+
+static std::vector<char> WriteVersion1(const std::vector<TestAsset>& assets)
+{
+    std::vector<char> pack(SL_ASSET_PACK_MAGIC, SL_ASSET_PACK_MAGIC + 6);
+    Append(pack, (uint32_t)SL_ASSET_PACK_VERSION_1);
+    Append(pack, (uint32_t)assets.size());
+    for (const TestAsset& asset : assets)
+    {
+        Append(pack, asset.id);
+        Append(pack, asset.type);
+        Append(pack, (uint32_t)asset.name.size());
+        pack.insert(pack.end(), asset.name.begin(), asset.name.end());
+        Append(pack, (uint32_t)asset.data.size());
+        pack.insert(pack.end(), asset.data.begin(), asset.data.end());
+    }
+    return pack;
+}
+
+// The table of contents starts right after the header, at an offset aligned to 8
+static constexpr size_t s_tocOffset = 40;
+
+static size_t TocFieldOffset(size_t entry, size_t field)
+{
+    return s_tocOffset + entry * sizeof(Slayer::AssetTocEntry) + field;
+}
+
+template<typename T>
+static T ReadTocField(const std::vector<char>& pack, size_t entry, size_t field)
+{
+    T value;
+    std::copy(pack.begin() + TocFieldOffset(entry, field), pack.begin() + TocFieldOffset(entry, field) + sizeof(T), (char*)&value);
+    return value;
+}
+
+// Splits the data into LZ4 blocks of the given size, the pack builder uses SL_ASSET_PACK_BLOCK_SIZE
+static std::vector<char> CompressAsset(const std::vector<char>& data, uint32_t blockSize)
+{
+    std::vector<char> stored;
+    Append(stored, blockSize);
+    Append(stored, (uint32_t)((data.size() + blockSize - 1) / blockSize));
+    std::vector<char> blocks;
+    std::vector<char> block(Slayer::Compression::GetLz4Bound(blockSize));
+    for (size_t offset = 0; offset < data.size(); offset += blockSize)
+    {
+        const size_t size = std::min<size_t>(blockSize, data.size() - offset);
+        const size_t length = Slayer::Compression::CompressLz4(data.data() + offset, size, block.data(), block.size());
+        Append(stored, (uint32_t)length);
+        blocks.insert(blocks.end(), block.begin(), block.begin() + length);
+    }
+    stored.insert(stored.end(), blocks.begin(), blocks.end());
+    return stored;
+}
+
+// Writes a version 2 pack the way the pack builder does. The assets are compressed in blocks of the given size,
+// unless it is 0.
+static std::vector<char> WriteVersion2(std::vector<TestAsset> assets, uint32_t blockSize = 0)
+{
+    std::sort(assets.begin(), assets.end(), [](const TestAsset& a, const TestAsset& b) { return a.id < b.id; });
+
+    std::string names;
+    std::vector<Slayer::AssetTocEntry> toc(assets.size());
+    for (size_t i = 0; i < assets.size(); i++)
+    {
+        Slayer::AssetTocEntry& entry = toc[i];
+        entry = {};
+        entry.id = assets[i].id;
+        entry.type = assets[i].type;
+        entry.alignment = 16;
+        entry.nameOffset = (uint32_t)names.size();
+        entry.nameLength = (uint16_t)assets[i].name.size();
+        entry.nameHash = Slayer::AssetPack::HashName(assets[i].name.data(), assets[i].name.size());
+        entry.uncompressedLength = (uint32_t)assets[i].data.size();
+        names += assets[i].name;
+
+        // The checksum covers the data as stored
+        if (blockSize > 0)
+            assets[i].data = CompressAsset(assets[i].data, blockSize);
+        entry.compression = (uint8_t)(blockSize > 0 ? Slayer::AssetCompression::LZ4 : Slayer::AssetCompression::None);
+        entry.dataLength = (uint32_t)assets[i].data.size();
+        entry.checksum = Slayer::AssetPack::Checksum(assets[i].data.data(), assets[i].data.size());
+    }
+
+    const uint64_t namesOffset = s_tocOffset + toc.size() * sizeof(Slayer::AssetTocEntry);
+    uint64_t offset = namesOffset + names.size();
+    for (size_t i = 0; i < assets.size(); i++)
+    {
+        offset = (offset + 15) / 16 * 16;
+        toc[i].dataOffset = offset;
+        offset += assets[i].data.size();
+    }
+
+    std::vector<char> pack(SL_ASSET_PACK_MAGIC, SL_ASSET_PACK_MAGIC + 6);
+    Append(pack, (uint32_t)SL_ASSET_PACK_VERSION);
+    Append(pack, (uint32_t)assets.size());
+    Append(pack, (uint16_t)0);
+    Append(pack, (uint32_t)names.size());
+    Append(pack, (uint64_t)s_tocOffset);
+    Append(pack, namesOffset);
+    pack.resize(s_tocOffset);
+    pack.insert(pack.end(), (const char*)toc.data(), (const char*)(toc.data() + toc.size()));
+    pack.insert(pack.end(), names.begin(), names.end());
+    for (size_t i = 0; i < assets.size(); i++)
+    {
+        pack.resize(toc[i].dataOffset);
+        pack.insert(pack.end(), assets[i].data.begin(), assets[i].data.end());
+    }
+    return pack;
+}
+
+// Checks that every asset of the pack reads back as written, both copied out and as a view into the mapping
+static void CheckAssets(Slayer::AssetPack& pack, const std::vector<TestAsset>& assets)
+{
+    BOOST_TEST(pack.GetAssets().size() == assets.size());
+    for (const TestAsset& asset : assets)
+    {
+        const Slayer::AssetRecord* record = pack.FindAsset(asset.name);
+        BOOST_TEST_REQUIRE(record != nullptr);
+        BOOST_TEST(record->id == asset.id);
+        BOOST_TEST(record->type == asset.type);
+        BOOST_TEST(pack.FindAsset(asset.id) == record);
+        BOOST_TEST(pack.VerifyAsset(asset.id));
+
+        const Slayer::PackedSpan<char> bytes = pack.GetAssetBytes(asset.id);
+        BOOST_TEST(std::vector<char>((const char*)bytes.Data(), (const char*)bytes.Data() + bytes.Size()) == asset.data, boost::test_tools::per_element());
+
+        const Slayer::TextureAsset texture = pack.GetAssetData<Slayer::TextureAsset>(asset.id);
+        const Slayer::TextureAssetView view = pack.GetAssetData<Slayer::TextureAssetView>(asset.id);
+        BOOST_TEST(texture.data.size() == (size_t)texture.width * texture.height * 4);
+        BOOST_TEST(view.width == texture.width);
+        BOOST_TEST(view.data.ToVector() == texture.data, boost::test_tools::per_element());
+        BOOST_TEST(texture.data[0] == (uint8_t)asset.data[20]);
+    }
+    BOOST_TEST(pack.FindAsset("missing") == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(AssetPackVersion1_Test)
+{
+    TempFile file("slayer_test_v1.slp");
+    const std::vector<TestAsset> assets = TestAssets();
+    file.Write(WriteVersion1(assets));
+
+    Slayer::AssetPack pack;
+    pack.Load(file.path);
+    BOOST_TEST_REQUIRE(pack.IsLoaded());
+    BOOST_TEST(pack.GetVersion() == (uint32_t)SL_ASSET_PACK_VERSION_1);
+    CheckAssets(pack, assets);
+}
+
+BOOST_AUTO_TEST_CASE(AssetPackVersion2_Test)
+{
+    TempFile file("slayer_test_v2.slp");
+    const std::vector<TestAsset> assets = TestAssets();
+    std::vector<char> bytes = WriteVersion2(assets);
+    file.Write(bytes);
+
+    {
+        Slayer::AssetPack pack;
+        pack.Load(file.path);
+        BOOST_TEST_REQUIRE(pack.IsLoaded());
+        BOOST_TEST(pack.GetVersion() == (uint32_t)SL_ASSET_PACK_VERSION);
+        CheckAssets(pack, assets);
+        for (const auto& [id, record] : pack.GetAssets())
+        {
+            BOOST_TEST(record.dataOffset % 16 == 0u);
+        }
+    }
+
+    // A changed byte still loads, only the checksum of its asset fails
+    bytes.back() ^= 1;
+    file.Write(bytes);
+    Slayer::AssetPack pack;
+    pack.Load(file.path);
+    BOOST_TEST_REQUIRE(pack.IsLoaded());
+    BOOST_TEST(!pack.VerifyAsset(30));
+    BOOST_TEST(pack.VerifyAsset(10));
+    BOOST_TEST(pack.VerifyAsset(20));
+}
+
+// Whether the bytes load as a pack, a rejected pack also has no assets left
+static bool LoadsPack(const std::vector<char>& bytes)
+{
+    TempFile file("slayer_test_pack.slp");
+    file.Write(bytes);
+    Slayer::AssetPack pack;
+    pack.Load(file.path);
+    return pack.IsLoaded() || !pack.GetAssets().empty();
+}
+
+BOOST_AUTO_TEST_CASE(AssetPackCorrupt_Test)
+{
+    const std::vector<char> valid = WriteVersion2(TestAssets());
+    BOOST_TEST(LoadsPack(valid));
+    BOOST_TEST(!LoadsPack(std::vector<char>(valid.begin(), valid.begin() + 20)));
+
+    // Fields of the header
+    std::vector<char> bytes = valid;
+    bytes[0] = 'X';
+    BOOST_TEST(!LoadsPack(bytes));
+    bytes = valid;
+    Overwrite(bytes, 6, (uint32_t)SL_ASSET_PACK_VERSION + 1);
+    BOOST_TEST(!LoadsPack(bytes));
+
+    // The table of contents is cut off, or claims more assets than it holds
+    BOOST_TEST(!LoadsPack(std::vector<char>(valid.begin(), valid.begin() + TocFieldOffset(1, 0))));
+    bytes = valid;
+    Overwrite(bytes, 10, (uint32_t)1000);
+    BOOST_TEST(!LoadsPack(bytes));
+
+    // Data outside of the pack
+    bytes = valid;
+    Overwrite(bytes, TocFieldOffset(2, offsetof(Slayer::AssetTocEntry, dataOffset)), (uint64_t)valid.size());
+    BOOST_TEST(!LoadsPack(bytes));
+    bytes = valid;
+    Overwrite(bytes, TocFieldOffset(2, offsetof(Slayer::AssetTocEntry, dataLength)), (uint32_t)valid.size());
+    BOOST_TEST(!LoadsPack(bytes));
+
+    // Data that is not aligned, or an alignment that is not a power of two
+    bytes = valid;
+    const uint64_t dataOffset = ReadTocField<uint64_t>(valid, 0, offsetof(Slayer::AssetTocEntry, dataOffset));
+    Overwrite(bytes, TocFieldOffset(0, offsetof(Slayer::AssetTocEntry, dataOffset)), dataOffset + 4);
+    BOOST_TEST(!LoadsPack(bytes));
+    bytes = valid;
+    Overwrite(bytes, TocFieldOffset(0, offsetof(Slayer::AssetTocEntry, alignment)), (uint16_t)0);
+    BOOST_TEST(!LoadsPack(bytes));
+    bytes = valid;
+    Overwrite(bytes, TocFieldOffset(0, offsetof(Slayer::AssetTocEntry, alignment)), (uint16_t)12);
+    BOOST_TEST(!LoadsPack(bytes));
+
+    // Names outside of the names, or that do not match their hash
+    bytes = valid;
+    Overwrite(bytes, TocFieldOffset(1, offsetof(Slayer::AssetTocEntry, nameOffset)), (uint32_t)1000);
+    BOOST_TEST(!LoadsPack(bytes));
+    bytes = valid;
+    Overwrite(bytes, TocFieldOffset(1, offsetof(Slayer::AssetTocEntry, nameHash)), (uint32_t)0);
+    BOOST_TEST(!LoadsPack(bytes));
+
+    // A version 1 pack cut off in the middle of an asset
+    const std::vector<char> version1 = WriteVersion1(TestAssets());
+    BOOST_TEST(!LoadsPack(std::vector<char>(version1.begin(), version1.end() - 1)));
+}
+
+static std::vector<char> RoundTripLz4(const std::vector<char>& data)
+{
+    std::vector<char> compressed(Slayer::Compression::GetLz4Bound(data.size()));
+    const size_t length = Slayer::Compression::CompressLz4(data.data(), data.size(), compressed.data(), compressed.size());
+    BOOST_TEST(length > 0u);
+    BOOST_TEST(length <= compressed.size());
+
+    // Decompressing into a buffer of a different size fails
+    std::vector<char> decompressed(data.size() + 1);
+    BOOST_TEST(!Slayer::Compression::DecompressLz4(compressed.data(), length, decompressed.data(), data.size() + 1));
+    if (!data.empty())
+        BOOST_TEST(!Slayer::Compression::DecompressLz4(compressed.data(), length, decompressed.data(), data.size() - 1));
+
+    decompressed.resize(data.size());
+    BOOST_TEST(Slayer::Compression::DecompressLz4(compressed.data(), length, decompressed.data(), decompressed.size()));
+    compressed.resize(length);
+    return decompressed;
+}
+
+BOOST_AUTO_TEST_CASE(Compression_Test)
+{
+    std::mt19937 random(3);
+    const size_t sizes[] = { 0, 1, 12, 13, 100, 4096, 300000 };
+    for (size_t size : sizes)
+    {
+        // Runs with short periods overlap the bytes they copy, text repeats at longer distances
+        for (size_t period = 1; period <= 9; period += 2)
+        {
+            std::vector<char> runs(size);
+            for (size_t i = 0; i < size; i++)
+                runs[i] = (char)('a' + i % period);
+            BOOST_TEST(RoundTripLz4(runs) == runs, boost::test_tools::per_element());
+        }
+
+        std::vector<char> text;
+        const std::string words[] = { "slayer ", "asset ", "pack ", "compressed ", "block " };
+        while (text.size() < size)
+        {
+            const std::string& word = words[random() % 5];
+            text.insert(text.end(), word.begin(), word.end());
+        }
+        text.resize(size);
+        BOOST_TEST(RoundTripLz4(text) == text, boost::test_tools::per_element());
+
+        std::vector<char> noise(size);
+        for (char& value : noise)
+            value = (char)random();
+        BOOST_TEST(RoundTripLz4(noise) == noise, boost::test_tools::per_element());
+    }
+
+    // Compressible data shrinks, incompressible data stays within the bound
+    std::vector<char> zeros(100000, 0);
+    std::vector<char> compressed(Slayer::Compression::GetLz4Bound(zeros.size()));
+    BOOST_TEST(Slayer::Compression::CompressLz4(zeros.data(), zeros.size(), compressed.data(), compressed.size()) < zeros.size() / 100);
+    BOOST_TEST(Slayer::Compression::CompressLz4(zeros.data(), zeros.size(), compressed.data(), 10) == 0u);
+
+    // Corrupt blocks are rejected instead of reading or writing out of bounds
+    std::vector<char> output(64);
+    const char literalsPastEnd[] = { (char)0xF0, (char)0xFF, 'a' };
+    BOOST_TEST(!Slayer::Compression::DecompressLz4(literalsPastEnd, sizeof(literalsPastEnd), output.data(), output.size()));
+    const char offsetBeforeStart[] = { 0x10, 'a', 0x05, 0x00 };
+    BOOST_TEST(!Slayer::Compression::DecompressLz4(offsetBeforeStart, sizeof(offsetBeforeStart), output.data(), output.size()));
+    const char zeroOffset[] = { 0x10, 'a', 0x00, 0x00 };
+    BOOST_TEST(!Slayer::Compression::DecompressLz4(zeroOffset, sizeof(zeroOffset), output.data(), output.size()));
+    const char matchPastEnd[] = { 0x1F, 'a', 0x01, 0x00, (char)0xFF, 0x00 };
+    BOOST_TEST(!Slayer::Compression::DecompressLz4(matchPastEnd, sizeof(matchPastEnd), output.data(), output.size()));
+    const char truncatedOffset[] = { 0x10, 'a', 0x01 };
+    BOOST_TEST(!Slayer::Compression::DecompressLz4(truncatedOffset, sizeof(truncatedOffset), output.data(), output.size()));
+
+    std::vector<char> text(10000);
+    for (size_t i = 0; i < text.size(); i++)
+        text[i] = (char)('a' + (i * 7) % 13);
+    compressed.resize(Slayer::Compression::GetLz4Bound(text.size()));
+    const size_t length = Slayer::Compression::CompressLz4(text.data(), text.size(), compressed.data(), compressed.size());
+    output.resize(text.size());
+    BOOST_TEST(!Slayer::Compression::DecompressLz4(compressed.data(), length / 2, output.data(), output.size()));
+    std::fill(compressed.begin(), compressed.begin() + length, (char)0xFF);
+    BOOST_TEST(!Slayer::Compression::DecompressLz4(compressed.data(), length, output.data(), output.size()));
+}
+
+BOOST_AUTO_TEST_CASE(AssetPackCompressed_Test)
+{
+    Slayer::JobSettings settings;
+    settings.workerCount = 2;
+    settings.loadingThreads = 2;
+    Slayer::ThreadManager threadManager;
+    threadManager.Initialize(settings);
+
+    // Small blocks, so that every asset is decompressed by several jobs
+    TempFile file("slayer_test_lz4.slp");
+    const std::vector<TestAsset> assets = TestAssets();
+    const std::vector<char> bytes = WriteVersion2(assets, 256);
+    file.Write(bytes);
+
+    {
+        Slayer::AssetPack pack;
+        pack.Load(file.path);
+        BOOST_TEST_REQUIRE(pack.IsLoaded());
+        for (const TestAsset& asset : assets)
+            BOOST_TEST(!pack.IsDecompressed(asset.id));
+        BOOST_TEST(pack.DecompressAssets());
+        CheckAssets(pack, assets);
+    }
+
+    // Without DecompressAssets, the assets are decompressed when they are read
+    {
+        Slayer::AssetPack pack;
+        pack.Load(file.path);
+        Slayer::TextureAsset texture;
+        BOOST_TEST(pack.GetAssetData(20, texture));
+        BOOST_TEST(pack.IsDecompressed(20));
+        BOOST_TEST(!pack.IsDecompressed(30));
+        BOOST_TEST(texture.width == 32u);
+    }
+
+    // Unknown codecs are rejected when loading
+    std::vector<char> unknownCodec = bytes;
+    Overwrite(unknownCodec, TocFieldOffset(1, offsetof(Slayer::AssetTocEntry, compression)), (uint8_t)7);
+    BOOST_TEST(!LoadsPack(unknownCodec));
+
+    threadManager.Shutdown();
+}
+
+BOOST_AUTO_TEST_CASE(AssetPackDecompressFailure_Test)
+{
+    Slayer::JobSettings settings;
+    settings.workerCount = 2;
+    settings.loadingThreads = 2;
+    Slayer::ThreadManager threadManager;
+    threadManager.Initialize(settings);
+
+    const std::vector<TestAsset> assets = TestAssets();
+    std::vector<char> bytes = WriteVersion2(assets, 256);
+
+    // Asset 20 has a block table that does not match its length, the first block of asset 30 is garbage
+    const uint64_t tableOffset = ReadTocField<uint64_t>(bytes, 1, offsetof(Slayer::AssetTocEntry, dataOffset));
+    Overwrite(bytes, tableOffset + 4, (uint32_t)1000);
+    const uint64_t dataOffset = ReadTocField<uint64_t>(bytes, 2, offsetof(Slayer::AssetTocEntry, dataOffset));
+    uint32_t blockCount, firstBlockLength;
+    std::copy(bytes.begin() + dataOffset + 4, bytes.begin() + dataOffset + 8, (char*)&blockCount);
+    std::copy(bytes.begin() + dataOffset + 8, bytes.begin() + dataOffset + 12, (char*)&firstBlockLength);
+    const size_t firstBlock = dataOffset + 8 + blockCount * sizeof(uint32_t);
+    std::fill(bytes.begin() + firstBlock, bytes.begin() + firstBlock + firstBlockLength, (char)0xFF);
+
+    TempFile file("slayer_test_lz4_corrupt.slp");
+    file.Write(bytes);
+    Slayer::AssetPack pack;
+    pack.Load(file.path);
+    BOOST_TEST_REQUIRE(pack.IsLoaded());
+
+    // The intact asset is still decompressed, the corrupt ones stay compressed and cannot be read
+    BOOST_TEST(!pack.DecompressAssets());
+    BOOST_TEST(pack.IsDecompressed(10));
+    BOOST_TEST(!pack.IsDecompressed(20));
+    BOOST_TEST(!pack.IsDecompressed(30));
+    BOOST_TEST(!pack.VerifyAsset(30));
+
+    Slayer::TextureAsset texture;
+    BOOST_TEST(pack.GetAssetData(10, texture));
+    BOOST_TEST(texture.width == 4u);
+    BOOST_TEST(texture.data.size() == 4u * 4u * 4u);
+    Slayer::TextureAsset corrupt;
+    BOOST_TEST(!pack.GetAssetData(20, corrupt));
+    BOOST_TEST(!pack.GetAssetData(30, corrupt));
+    BOOST_TEST(!pack.GetAssetData(40, corrupt));
+    BOOST_TEST(corrupt.data.empty());
+
+    // Trying again fails the same way
+    BOOST_TEST(!pack.DecompressAssets());
+    BOOST_TEST(pack.IsDecompressed(10));
+    BOOST_TEST(!pack.IsDecompressed(30));
+
+    threadManager.Shutdown();
+}
+
+BOOST_AUTO_TEST_CASE(AssetPackBlockOverrun_Test)
+{
+    Slayer::JobSettings settings;
+    settings.workerCount = 2;
+    settings.loadingThreads = 2;
+    Slayer::ThreadManager threadManager;
+    threadManager.Initialize(settings);
+
+    const std::vector<TestAsset> assets = TestAssets();
+    std::vector<char> bytes = WriteVersion2(assets, 256);
+
+    // The second block of asset 20 claims more bytes than the asset has, after its first block was accepted
+    const uint64_t dataOffset = ReadTocField<uint64_t>(bytes, 1, offsetof(Slayer::AssetTocEntry, dataOffset));
+    const uint32_t dataLength = ReadTocField<uint32_t>(bytes, 1, offsetof(Slayer::AssetTocEntry, dataLength));
+    uint32_t blockCount;
+    std::copy(bytes.begin() + dataOffset + 4, bytes.begin() + dataOffset + 8, (char*)&blockCount);
+    BOOST_TEST_REQUIRE(blockCount > 2u);
+    Overwrite(bytes, dataOffset + 8 + sizeof(uint32_t), dataLength);
+
+    TempFile file("slayer_test_lz4_overrun.slp");
+    file.Write(bytes);
+    Slayer::AssetPack pack;
+    pack.Load(file.path);
+    BOOST_TEST_REQUIRE(pack.IsLoaded());
+
+    // The blocks of the asset that were accepted are dropped with it, the assets around it are intact
+    BOOST_TEST(!pack.DecompressAssets());
+    BOOST_TEST(!pack.IsDecompressed(20));
+    for (const TestAsset& asset : assets)
+    {
+        if (asset.id == 20)
+            continue;
+
+        BOOST_TEST_REQUIRE(pack.IsDecompressed(asset.id));
+        const Slayer::PackedSpan<char> data = pack.GetAssetBytes(asset.id);
+        BOOST_TEST(std::vector<char>((const char*)data.Data(), (const char*)data.Data() + data.Size()) == asset.data, boost::test_tools::per_element());
+    }
+
+    Slayer::TextureAsset corrupt;
+    BOOST_TEST(!pack.GetAssetData(20, corrupt));
+
+    threadManager.Shutdown();
+}
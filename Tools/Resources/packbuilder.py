@@ -2,7 +2,9 @@ from concurrent.futures import ThreadPoolExecutor
 from io import BufferedReader, BufferedWriter
 import os
 import struct
+import zlib
 import argparse
+import lz4.block
 import impasse as assimp
 import numpy as np
 import json
@@ -271,27 +273,22 @@ def serialize_material(name, textures: list, texture_ids: list, meta: dict = {})
 
 def serialize_asset(name, asset_data, type_str: str, meta: dict = {}):
     old_id = meta["old_data"]["id"] if "old_data" in meta and "id" in meta["old_data"] else None
-    data = b""
     type = ASSET_TYPES[type_str]
     asset_id = (np.random.randint(0, 2**64, dtype=np.uint64)
                 if old_id is None else old_id)
     try:
-        data += struct.pack("<Q", asset_id)
+        struct.pack("<Q", asset_id)
     except Exception as e:
         print("Error:", asset_id)
         exit()
-    data += struct.pack("<H", type)
-    data += struct.pack("<I", len(name))
-    data += name.encode("utf-8")
-    data += struct.pack("<I", len(asset_data))
-    data += asset_data
     has_new_id = old_id != asset_id
     print(colored(f"[{'ADDED' if has_new_id else 'UPDATED'}]", "green" if has_new_id else "blue"),
           f"name: {name}, type: {type_str}, id: {asset_id}")
 
     save_meta(meta)
 
-    return asset_id, name, data
+    # The data of an asset is its type and payload, the pack is laid out once every asset is known
+    return asset_id, name, (type, asset_data)
 
 
 def load_pack_meta(f: BufferedReader):
@@ -307,26 +304,46 @@ def load_pack_meta(f: BufferedReader):
         num_assets = struct.unpack("<I", f.read(UINT32_SIZE))[0]
         print("Reading pack file with", num_assets, "assets.")
 
-        # Read assets
-        for _ in range(num_assets):
-            # Read asset id
-            start_pos = f.tell()
-            asset_id = struct.unpack("<Q", f.read(ASSET_ID_SIZE))[0]
-            asset_type = struct.unpack("<H", f.read(ASSET_TYPE_SIZE))[0]
-            name_size = struct.unpack("<I", f.read(UINT32_SIZE))[0]
-            asset_name = f.read(name_size).decode("utf-8")
-            asset_size = struct.unpack("<I", f.read(UINT32_SIZE))[0]
-            asset_data = f.read(asset_size)
-
-            f.seek(start_pos)
-            full_asset_data = f.read(
-                ASSET_ID_SIZE + ASSET_TYPE_SIZE + UINT32_SIZE + name_size + UINT32_SIZE + asset_size)
-
-            assetNameToMeta[asset_name] = {
-                "id": asset_id,
-                "type": asset_type,
-                "data": full_asset_data
-            }
+        if version == 1:
+            # Read assets
+            for _ in range(num_assets):
+                asset_id = struct.unpack("<Q", f.read(ASSET_ID_SIZE))[0]
+                asset_type = struct.unpack("<H", f.read(ASSET_TYPE_SIZE))[0]
+                name_size = struct.unpack("<I", f.read(UINT32_SIZE))[0]
+                asset_name = f.read(name_size).decode("utf-8")
+                asset_size = struct.unpack("<I", f.read(UINT32_SIZE))[0]
+                asset_data = f.read(asset_size)
+
+                assetNameToMeta[asset_name] = {
+                    "id": asset_id,
+                    "type": asset_type,
+                    "data": (asset_type, asset_data)
+                }
+        elif version == PACK_VERSION:
+            f.seek(0)
+            pack = f.read()
+            _, _, _, _, toc_offset, names_offset = struct.unpack_from(
+                PACK_HEADER_FORMAT, pack, len(MAGIC))
+            entry_size = struct.calcsize(TOC_ENTRY_FORMAT)
+            for i in range(num_assets):
+                (asset_id, data_offset, data_length, uncompressed_length, _, name_offset, checksum, asset_type, _, name_size,
+                 compression, _, _) = struct.unpack_from(TOC_ENTRY_FORMAT, pack, toc_offset + i * entry_size)
+                name_start = names_offset + name_offset
+                asset_name = pack[name_start:name_start +
+                                  name_size].decode("utf-8")
+                asset_data = pack[data_offset:data_offset + data_length]
+                if zlib.crc32(asset_data) != checksum:
+                    raise Exception("Invalid asset data: " + asset_name)
+                asset_data = decompress_asset(
+                    compression, asset_data, uncompressed_length)
+
+                assetNameToMeta[asset_name] = {
+                    "id": asset_id,
+                    "type": asset_type,
+                    "data": (asset_type, asset_data)
+                }
+        else:
+            raise Exception("Unsupported pack file version.")
 
         print("Loaded", len(assetNameToMeta), "asset IDs from pack file.")
     except Exception as e:
@@ -342,14 +359,82 @@ def load_pack_meta(f: BufferedReader):
     return assetNameToMeta
 
 
-def serialize_pack(data, num_assets, f: BufferedWriter):
+def compress_asset(type, asset_data):
+    compression = ASSET_COMPRESSION.get(type, COMPRESSION_NONE)
+    if compression == COMPRESSION_NONE:
+        return COMPRESSION_NONE, asset_data
+
+    # Blocks decompress independently, so that large assets are decompressed by several threads
+    blocks = [lz4.block.compress(asset_data[i:i + PACK_BLOCK_SIZE], store_size=False)
+              for i in range(0, len(asset_data), PACK_BLOCK_SIZE)]
+    stored = struct.pack("<II", PACK_BLOCK_SIZE, len(blocks))
+    stored += struct.pack("<" + "I" * len(blocks), *[len(block) for block in blocks])
+    stored += b"".join(blocks)
+
+    # Data that barely shrinks is faster to read than to decompress
+    if len(stored) > len(asset_data) * 7 // 8:
+        return COMPRESSION_NONE, asset_data
+    return compression, stored
+
+
+def decompress_asset(compression, stored, uncompressed_length):
+    if compression == COMPRESSION_NONE:
+        return stored
+    if compression != COMPRESSION_LZ4:
+        raise Exception("Unsupported compression.")
+
+    block_size, block_count = struct.unpack_from("<II", stored)
+    lengths = struct.unpack_from("<" + "I" * block_count, stored, 8)
+    offset = 8 + 4 * block_count
+    data = b""
+    for length in lengths:
+        size = min(block_size, uncompressed_length - len(data))
+        data += lz4.block.decompress(stored[offset:offset + length],
+                                     uncompressed_size=size)
+        offset += length
+    return data
+
+
+def align(offset, alignment):
+    return (offset + alignment - 1) // alignment * alignment
+
+
+def serialize_pack(assets: list, f: BufferedWriter):
+    # Version 2: header, table of contents sorted by id, names, then the data of each asset aligned
+    assets = sorted(assets, key=lambda asset: int(asset[0]))
+    names = b""
+    name_offsets = []
+    for _, name, _ in assets:
+        name_offsets.append(len(names))
+        names += name.encode("utf-8")
+
+    header_size = len(MAGIC) + struct.calcsize(PACK_HEADER_FORMAT)
+    toc_offset = align(header_size, 8)
+    names_offset = toc_offset + \
+        len(assets) * struct.calcsize(TOC_ENTRY_FORMAT)
+    data_offset = align(names_offset + len(names), PACK_ALIGNMENT)
+
+    toc = b""
+    data = b""
+    for (asset_id, name, (type, asset_data)), name_offset in zip(assets, name_offsets):
+        offset = align(data_offset + len(data), PACK_ALIGNMENT)
+        data += b"\0" * (offset - data_offset - len(data))
+        name_data = name.encode("utf-8")
+        compression, stored = compress_asset(type, asset_data)
+        toc += struct.pack(TOC_ENTRY_FORMAT, int(asset_id), offset, len(stored), len(asset_data), name_hash(name),
+                           name_offset, zlib.crc32(stored), type, PACK_ALIGNMENT, len(name_data), compression, 0, 0)
+        data += stored
+
     f.write(MAGIC.encode())
-    # Lengths as unsigned 32 bit integers, in reverse byte order
-    f.write(struct.pack("I", 1))
-    f.write(struct.pack("I", num_assets))
+    f.write(struct.pack(PACK_HEADER_FORMAT, PACK_VERSION, len(assets), 0, len(names),
+                        toc_offset, names_offset))
+    f.write(b"\0" * (toc_offset - header_size))
+    f.write(toc)
+    f.write(names)
+    f.write(b"\0" * (data_offset - names_offset - len(names)))
     f.write(data)
 
-    return len(MAGIC) + UINT32_SIZE * 2 + len(data)
+    return data_offset + len(data)
 
 
 def pack_file(file_tuple: tuple, old_data: dict = {}, skeletons={}, texture_ids={}, force_rebuild=False) -> tuple:
@@ -477,8 +562,7 @@ def main():
 
         skeletons = load_skeletons(model_files)
 
-        pack_data = b""
-        num_assets = 0
+        pack_assets = []
 
         with ThreadPoolExecutor() as executor:
 
@@ -495,8 +579,7 @@ def main():
                     continue
                 if assetId:
                     texture_ids[name] = assetId
-                pack_data += data
-                num_assets += 1
+                pack_assets.append((assetId, name, data))
 
             print("Textures done. Packing other files...")
 
@@ -506,22 +589,20 @@ def main():
             for assetId, name, data in results:
                 if data is None:
                     continue
-                pack_data += data
-                num_assets += 1
+                pack_assets.append((assetId, name, data))
 
             print("Other files done. Packing models...")
             results = [future.result() for future in model_futures]
             for assetId, name, data in results:
                 if data is None:
                     continue
-                pack_data += data
-                num_assets += 1
+                pack_assets.append((assetId, name, data))
 
         # Write pack file
         if args.output:
             pack_size = 0
             with open(args.output, "wb") as f:
-                pack_size = serialize_pack(pack_data, num_assets, f)
+                pack_size = serialize_pack(pack_assets, f)
 
             t1 = time.time()
 
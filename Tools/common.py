@@ -12,6 +12,18 @@ ASSET_ID_SIZE = 8
 ASSET_TYPE_SIZE = 2
 UINT32_SIZE = 4
 MAGIC = "SLPCK\0"
+PACK_VERSION = 2
+# Data of every asset in a version 2 pack starts at a multiple of this
+PACK_ALIGNMENT = 16
+# Version 2 header after the magic: version, asset count, flags, names size, toc offset, names offset
+PACK_HEADER_FORMAT = "<IIHIQQ"
+# Version 2 toc entry: id, data offset, data length, uncompressed length, name hash, name offset, checksum,
+# type, alignment, name length, compression, two reserved fields
+TOC_ENTRY_FORMAT = "<QQIIIIIHHHBBI"
+COMPRESSION_NONE = 0
+COMPRESSION_LZ4 = 1
+# Uncompressed bytes per block of a compressed asset, as SL_ASSET_PACK_BLOCK_SIZE
+PACK_BLOCK_SIZE = 256 * 1024
 
 MATERIAL_TEXTURE_TYPES = {
     "albedo": 4,
@@ -36,6 +48,14 @@ ASSET_TYPES = {
     "compute_shader": 11,
 }
 
+# Codec of each asset type in a version 2 pack, shaders and materials are too small to be worth it
+ASSET_COMPRESSION = {
+    ASSET_TYPES["texture"]: COMPRESSION_LZ4,
+    ASSET_TYPES["model"]: COMPRESSION_LZ4,
+    ASSET_TYPES["skeletal_model"]: COMPRESSION_LZ4,
+    ASSET_TYPES["animation"]: COMPRESSION_LZ4,
+}
+
 TEXTURE_EXTS = [".png", ".jpg", ".jpeg", ".tga", ".bmp", ".hdr"]
 MODEL_EXTS = [".obj", ".fbx"]
 SKELETON_EXTS = [".skeleton"]
@@ -51,6 +71,14 @@ def format_bytes(num_bytes):
     return f"{num_bytes:.1f} YB"
 
 
+def name_hash(name: str):
+    # FNV-1a, as in AssetPack.cpp
+    value = 2166136261
+    for byte in name.encode("utf-8"):
+        value = ((value ^ byte) * 16777619) & 0xFFFFFFFF
+    return value
+
+
 def gen_hash(text):
     return hashlib.sha256(text).hexdigest()
 